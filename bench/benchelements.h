@@ -0,0 +1,83 @@
+#ifndef BENCHELEMENTS_H
+#define BENCHELEMENTS_H
+
+#include <db_cxx.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "persistent-storage/utils/store_primitives.h"
+
+/**
+ * Элемент, который используется в бенчмарках: идентификатор, идентификатор
+ * родителя для ChildStorage и полезная нагрузка заданного размера
+ */
+struct BenchElement {
+  std::string id;
+  std::string parentId;
+  std::string payload;
+};
+
+inline std::string get_id(const BenchElement& elem)
+{
+  return elem.id;
+}
+
+class BenchWatcher {
+ protected:
+  void elementAdded(const BenchElement&) {}
+  void elementRemoved(const BenchElement&) {}
+  void elementUpdated(const BenchElement&) {}
+};
+
+class BenchMarshaller {
+ public:
+  static void restore(BenchElement& elem, const void* src)
+  {
+    src = prstorage::restore_str(elem.id, src);
+    src = prstorage::restore_str(elem.parentId, src);
+    src = prstorage::restore_str(elem.payload, src);
+  }
+  static u_int32_t size(const BenchElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.parentId.length();
+    size += sizeof(std::string::size_type) + element.payload.length();
+    return size;
+  }
+  static void store(void* dest, const BenchElement& elem)
+  {
+    dest = prstorage::save_str(elem.id, dest);
+    dest = prstorage::save_str(elem.parentId, dest);
+    dest = prstorage::save_str(elem.payload, dest);
+  }
+};
+
+/**
+ * @brief Вторичный ключ для ChildStorage - идентификатор родителя
+ */
+inline int benchParentKey(Db* /* secondary */,
+                          const Dbt* /* key */,
+                          const Dbt* data,
+                          Dbt* result)
+{
+  BenchElement el;
+  BenchMarshaller::restore(el, data->get_data());
+
+  if (auto chars = static_cast<char*>(std::malloc(el.parentId.size() + 1))) {
+    result->set_flags(DB_DBT_APPMALLOC);
+    std::strncpy(chars, el.parentId.c_str(), el.parentId.size() + 1);
+    result->set_data(chars);
+    result->set_size(static_cast<u_int32_t>(el.parentId.size()) + 1);
+    return 0;
+  }
+
+  return 1;
+}
+
+inline std::string benchKey(std::size_t i)
+{
+  return "element " + std::to_string(i);
+}
+#endif  // BENCHELEMENTS_H
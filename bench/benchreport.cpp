@@ -0,0 +1,134 @@
+#include "benchreport.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+std::string quoted(const std::string& value)
+{
+  std::ostringstream out;
+  out << '"';
+  for (auto ch : value) {
+    switch (ch) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(ch) < 0x20) {
+          out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+              << static_cast<int>(ch) << std::dec;
+        } else {
+          out << ch;
+        }
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+std::string quoted(std::uint64_t value)
+{
+  return std::to_string(value);
+}
+
+template <typename Value>
+void writeObject(std::ostream& out, const std::map<std::string, Value>& values)
+{
+  out << "{";
+  bool first = true;
+  for (const auto& [key, value] : values) {
+    out << (first ? "" : ", ") << quoted(key) << ": " << quoted(value);
+    first = false;
+  }
+  out << "}";
+}
+}  // namespace
+
+double BenchResult::opsPerSecond() const noexcept
+{
+  return seconds > 0 ? operations / seconds : 0;
+}
+
+BenchReport::BenchReport(std::string name) : mName(std::move(name)) {}
+
+void BenchReport::setContext(const std::string& key, const std::string& value)
+{
+  mContext[key] = value;
+}
+
+void BenchReport::add(BenchResult result)
+{
+  mResults.push_back(std::move(result));
+}
+
+const std::vector<BenchResult>& BenchReport::results() const noexcept
+{
+  return mResults;
+}
+
+void BenchReport::write(std::ostream& out) const
+{
+  auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+
+  out << "{\n";
+  out << "  \"benchmark\": " << quoted(mName) << ",\n";
+  out << "  \"timestamp\": " << timestamp << ",\n";
+  out << "  \"context\": ";
+  writeObject(out, mContext);
+  out << ",\n";
+  out << "  \"results\": [";
+  for (std::size_t i = 0; i < mResults.size(); ++i) {
+    const auto& result = mResults[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"operation\": " << quoted(result.operation)
+        << ", \"labels\": ";
+    writeObject(out, result.labels);
+    out << ", \"records\": " << result.records
+        << ", \"element_size\": " << result.elementSize
+        << ", \"operations\": " << result.operations
+        << ", \"seconds\": " << std::setprecision(9) << result.seconds
+        << ", \"ops_per_second\": " << std::fixed << std::setprecision(1)
+        << result.opsPerSecond() << std::defaultfloat
+        << ", \"p50_ns\": " << result.p50Nanoseconds
+        << ", \"p99_ns\": " << result.p99Nanoseconds
+        << ", \"p999_ns\": " << result.p999Nanoseconds
+        << ", \"max_ns\": " << result.maxNanoseconds;
+    if (!result.counters.empty()) {
+      out << ", \"counters\": ";
+      writeObject(out, result.counters);
+    }
+    out << "}";
+  }
+  out << "\n  ]\n";
+  out << "}\n";
+}
+
+void BenchReport::save(const std::string& path) const
+{
+  if (path.empty()) {
+    write(std::cout);
+    return;
+  }
+  std::ofstream out(path);
+  if (!out) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  write(out);
+}
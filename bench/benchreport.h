@@ -0,0 +1,64 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Результат одного измерения
+ */
+struct BenchResult {
+  /// параметры запуска: хранилище, менеджер транзакций, набор настроек...
+  std::map<std::string, std::string> labels;
+  std::string operation;
+  std::uint64_t records = 0;
+  std::uint64_t elementSize = 0;
+  /// количество выполненных операций
+  std::uint64_t operations = 0;
+  double seconds = 0;
+  std::uint64_t p50Nanoseconds = 0;
+  std::uint64_t p99Nanoseconds = 0;
+  std::uint64_t p999Nanoseconds = 0;
+  std::uint64_t maxNanoseconds = 0;
+  /// дополнительные счетчики, например взаимоблокировки
+  std::map<std::string, std::uint64_t> counters;
+
+  double opsPerSecond() const noexcept;
+};
+
+/**
+ * Отчет бенчмарка в формате JSON. Результаты записываются в порядке
+ * добавления, поэтому отчеты разных версий можно сравнивать построчно.
+ */
+class BenchReport {
+ public:
+  explicit BenchReport(std::string name);
+
+ public:
+  /**
+   * @brief Добавляет описание окружения запуска, например число потоков
+   */
+  void setContext(const std::string& key, const std::string& value);
+  void add(BenchResult result);
+  const std::vector<BenchResult>& results() const noexcept;
+
+  void write(std::ostream& out) const;
+
+  /**
+   * @brief Записывает отчет в файл path, при пустом path - в std::cout
+   * @throws std::runtime_error если файл не удалось открыть
+   */
+  void save(const std::string& path) const;
+
+ private:
+  std::string mName;
+  std::map<std::string, std::string> mContext;
+  std::vector<BenchResult> mResults;
+};
+}  // namespace prstorage
+
+#endif  // BENCHREPORT_H
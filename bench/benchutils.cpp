@@ -0,0 +1,94 @@
+#include "benchutils.h"
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <dbstl_common.h>
+#include <sstream>
+#include <stdexcept>
+
+using namespace prstorage;
+
+std::vector<std::uint64_t> prstorage::parseCounts(const std::string& value)
+{
+  std::vector<std::uint64_t> res;
+  for (const auto& item : parseNames(value)) {
+    std::size_t pos = 0;
+    auto count = std::stoull(item, &pos);
+    auto suffix = item.substr(pos);
+    if (suffix == "K" || suffix == "k") {
+      count *= 1000;
+    } else if (suffix == "M" || suffix == "m") {
+      count *= 1000 * 1000;
+    } else if (!suffix.empty()) {
+      throw std::invalid_argument("Invalid count: " + item);
+    }
+    res.push_back(count);
+  }
+  return res;
+}
+
+std::vector<std::string> prstorage::parseNames(const std::string& value)
+{
+  std::vector<std::string> res;
+  std::istringstream in(value);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    if (!item.empty()) {
+      res.push_back(item);
+    }
+  }
+  return res;
+}
+
+prstorage::Preset prstorage::parsePreset(const std::string& name)
+{
+  for (auto preset : {Preset::Default, Preset::ReadHeavy, Preset::WriteHeavy,
+                      Preset::LowMemory}) {
+    if (name == presetName(preset)) {
+      return preset;
+    }
+  }
+  throw std::invalid_argument("Unknown preset: " + name);
+}
+
+const char* prstorage::presetName(Preset preset)
+{
+  switch (preset) {
+    case Preset::Default:
+      return "default";
+    case Preset::ReadHeavy:
+      return "read-heavy";
+    case Preset::WriteHeavy:
+      return "write-heavy";
+    case Preset::LowMemory:
+      return "low-memory";
+  }
+  return "unknown";
+}
+
+void prstorage::setLatencies(BenchResult& result,
+                             const LatencyHistogram& histogram)
+{
+  result.p50Nanoseconds = histogram.percentileNanoseconds(50);
+  result.p99Nanoseconds = histogram.percentileNanoseconds(99);
+  result.p999Nanoseconds = histogram.percentileNanoseconds(99.9);
+  result.maxNanoseconds = histogram.maxNanoseconds();
+}
+
+void prstorage::makeDirectory(const std::string& path)
+{
+  if (::mkdir(path.c_str(), 0700) != 0 && errno != EEXIST) {
+    throw std::runtime_error("mkdir " + path + ": " + std::strerror(errno));
+  }
+}
+
+void prstorage::closeEnvironment(DbEnv* env, const std::vector<Db*>& databases)
+{
+  for (auto db : databases) {
+    dbstl::close_db(db);
+    delete db;
+  }
+  dbstl::close_db_env(env);
+  delete env;
+}
@@ -0,0 +1,87 @@
+#ifndef BENCHUTILS_H
+#define BENCHUTILS_H
+
+#include <db_cxx.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchreport.h"
+#include "persistent-storage/environment/preset.h"
+#include "persistent-storage/metrics/latencyhistogram.h"
+
+namespace prstorage {
+/**
+ * @brief Разбирает список чисел через запятую, допускаются суффиксы K и M:
+ * "1K,100K,10M"
+ * @throws std::invalid_argument при ошибке разбора
+ */
+std::vector<std::uint64_t> parseCounts(const std::string& value);
+
+/**
+ * @brief Разбирает список через запятую
+ */
+std::vector<std::string> parseNames(const std::string& value);
+
+/**
+ * @brief Разбирает имя набора настроек: default, read-heavy, write-heavy,
+ * low-memory
+ * @throws std::invalid_argument для неизвестного имени
+ */
+Preset parsePreset(const std::string& name);
+const char* presetName(Preset preset);
+
+/**
+ * @brief Создает каталог, если он не существует
+ * @throws std::runtime_error при ошибке
+ */
+void makeDirectory(const std::string& path);
+
+/**
+ * @brief Закрывает базы данных и окружение, зарегистрированные в dbstl, и
+ * освобождает их. Базы данных закрываются в переданном порядке.
+ */
+void closeEnvironment(DbEnv* env, const std::vector<Db*>& databases);
+
+/**
+ * @brief Заполняет перцентили задержек результата по гистограмме
+ */
+void setLatencies(BenchResult& result, const LatencyHistogram& histogram);
+
+/**
+ * Выполняет операцию count раз и собирает гистограмму задержек
+ */
+class Stopwatch {
+ public:
+  template <typename Func>
+  BenchResult run(std::string operation, std::uint64_t count, Func&& func);
+
+ private:
+  LatencyHistogram mHistogram;
+};
+}  // namespace prstorage
+
+template <typename Func>
+prstorage::BenchResult prstorage::Stopwatch::run(std::string operation,
+                                                 std::uint64_t count,
+                                                 Func&& func)
+{
+  mHistogram.reset();
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    auto opStart = std::chrono::steady_clock::now();
+    func(i);
+    mHistogram.record(std::chrono::steady_clock::now() - opStart);
+  }
+  BenchResult result;
+  result.operation = std::move(operation);
+  result.operations = count;
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  setLatencies(result, mHistogram);
+  return result;
+}
+
+#endif  // BENCHUTILS_H
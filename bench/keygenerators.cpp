@@ -0,0 +1,82 @@
+#include "keygenerators.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+std::uint64_t fnv1a(std::uint64_t value) noexcept
+{
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < 8; ++i) {
+    hash ^= value & 0xff;
+    hash *= 0x100000001b3ULL;
+    value >>= 8;
+  }
+  return hash;
+}
+}  // namespace
+
+ZipfianGenerator::ZipfianGenerator(std::uint64_t items, double theta) :
+    mItems(items), mTheta(theta), mZetan(zeta(items, theta)),
+    mAlpha(1.0 / (1.0 - theta)),
+    mEta((1.0 - std::pow(2.0 / items, 1.0 - theta)) /
+         (1.0 - zeta(2, theta) / mZetan))
+{
+  if (items < 2) {
+    throw std::invalid_argument("Zipfian generator needs at least 2 items");
+  }
+}
+
+std::uint64_t ZipfianGenerator::next(std::mt19937_64& random) const
+{
+  auto u = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+  auto uz = u * mZetan;
+  if (uz < 1.0) {
+    return 0;
+  }
+  if (uz < 1.0 + std::pow(0.5, mTheta)) {
+    return 1;
+  }
+  auto res = static_cast<std::uint64_t>(
+      mItems * std::pow(mEta * u - mEta + 1.0, mAlpha));
+  return res < mItems ? res : mItems - 1;
+}
+
+std::uint64_t ZipfianGenerator::items() const noexcept
+{
+  return mItems;
+}
+
+double ZipfianGenerator::zeta(std::uint64_t items, double theta)
+{
+  double sum = 0;
+  for (std::uint64_t i = 1; i <= items; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i), theta);
+  }
+  return sum;
+}
+
+KeyChooser::KeyChooser(KeyDistribution distribution,
+                       std::uint64_t initialItems) :
+    mDistribution(distribution),
+    mZipfian(initialItems)
+{
+}
+
+std::uint64_t KeyChooser::next(std::mt19937_64& random,
+                               std::uint64_t count) const
+{
+  switch (mDistribution) {
+    case KeyDistribution::Uniform:
+      return std::uniform_int_distribution<std::uint64_t>(0, count - 1)(random);
+    case KeyDistribution::Zipfian:
+      return fnv1a(mZipfian.next(random)) % count;
+    case KeyDistribution::Latest: {
+      auto rank = mZipfian.next(random);
+      return rank < count ? count - 1 - rank : 0;
+    }
+  }
+  return 0;
+}
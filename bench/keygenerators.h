@@ -0,0 +1,66 @@
+#ifndef KEYGENERATORS_H
+#define KEYGENERATORS_H
+
+#include <cstdint>
+#include <random>
+
+namespace prstorage {
+/**
+ * Генератор рангов с распределением Ципфа на [0, items) по алгоритму
+ * Gray et al. "Quickly generating billion-record synthetic databases", как в
+ * YCSB. Ранг 0 - самый частый.
+ */
+class ZipfianGenerator {
+ public:
+  static constexpr double DEFAULT_THETA = 0.99;
+
+ public:
+  explicit ZipfianGenerator(std::uint64_t items,
+                            double theta = DEFAULT_THETA);
+
+ public:
+  std::uint64_t next(std::mt19937_64& random) const;
+  std::uint64_t items() const noexcept;
+
+ private:
+  static double zeta(std::uint64_t items, double theta);
+
+ private:
+  std::uint64_t mItems;
+  double mTheta;
+  double mZetan;
+  double mAlpha;
+  double mEta;
+};
+
+/**
+ * Распределение ключей для нагрузок YCSB
+ */
+enum class KeyDistribution {
+  /// все ключи равновероятны
+  Uniform,
+  /// распределение Ципфа, частые ключи разбросаны по всему диапазону
+  Zipfian,
+  /// распределение Ципфа от последнего добавленного ключа
+  Latest
+};
+
+/**
+ * Выбирает индекс существующего ключа в [0, count) с заданным
+ * распределением. Для Zipfian и Latest ранги считаются по initialItems,
+ * добавленные позже ключи попадают в хвост распределения.
+ */
+class KeyChooser {
+ public:
+  KeyChooser(KeyDistribution distribution, std::uint64_t initialItems);
+
+ public:
+  std::uint64_t next(std::mt19937_64& random, std::uint64_t count) const;
+
+ private:
+  KeyDistribution mDistribution;
+  ZipfianGenerator mZipfian;
+};
+}  // namespace prstorage
+
+#endif  // KEYGENERATORS_H
@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "persistent-storage/storages/nativestorage.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+/**
+ * Сравнивает производительность Storage (dbstl) и NativeStorage на одном
+ * окружении. Запуск: NativeStorageBench [каталог окружения] [число записей]
+ */
+
+using namespace prstorage;
+
+struct BenchElement {
+  std::string id;
+  std::string payload;
+};
+
+std::string get_id(const BenchElement& elem)
+{
+  return elem.id;
+}
+
+class BenchWatcher {
+ protected:
+  void elementAdded(const BenchElement&) {}
+  void elementRemoved(const BenchElement&) {}
+  void elementUpdated(const BenchElement&) {}
+};
+
+class BenchMarshaller {
+ public:
+  static void restore(BenchElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.payload, src);
+  }
+  static u_int32_t size(const BenchElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.payload.length();
+    return size;
+  }
+  static void store(void* dest, const BenchElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.payload, dest);
+  }
+};
+
+template <typename Func>
+void measure(const char* engine, const char* operation, int count, Func&& func)
+{
+  auto start = std::chrono::steady_clock::now();
+  func();
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << engine << "\t" << operation << "\t" << count / elapsed
+            << " ops/s" << std::endl;
+}
+
+template <typename StorageType>
+void run(const char* engine, StorageType& store, int count)
+{
+  const std::string payload(128, 'x');
+  auto id = [](int i) { return "element " + std::to_string(i); };
+
+  measure(engine, "add", count, [&] {
+    for (int i = 0; i < count; ++i) {
+      store.add({id(i), payload});
+    }
+  });
+  measure(engine, "get", count, [&] {
+    for (int i = 0; i < count; ++i) {
+      store.get(id(i));
+    }
+  });
+  measure(engine, "has", count, [&] {
+    for (int i = 0; i < count; ++i) {
+      store.has(id(i));
+    }
+  });
+  measure(engine, "update", count, [&] {
+    for (int i = 0; i < count; ++i) {
+      store.update({id(i), payload});
+    }
+  });
+  measure(engine, "getAllElements", count,
+          [&] { store.getAllElements(); });
+  measure(engine, "remove", count, [&] {
+    for (int i = 0; i < count; ++i) {
+      store.remove(id(i));
+    }
+  });
+}
+
+Db* openDb(DbEnv* env, const char* name)
+{
+  auto db = new Db(env, DB_CXX_NO_EXCEPTIONS);
+  if (db->open(nullptr, "NativeStorageBench.db", name, DB_BTREE,
+               DB_CREATE | DB_THREAD | DB_AUTO_COMMIT, 0600) != 0) {
+    std::cerr << "Failed to open database " << name << std::endl;
+    std::exit(1);
+  }
+  db->truncate(nullptr, nullptr, DB_AUTO_COMMIT);
+  return db;
+}
+
+int main(int argc, char** argv)
+{
+  const char* home = argc > 1 ? argv[1] : ".";
+  const int count = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+  dbstl::dbstl_startup();
+  auto penv = new DbEnv(DB_CXX_NO_EXCEPTIONS);
+  if (penv->open(home,
+                 DB_INIT_LOCK | DB_INIT_LOG | DB_INIT_MPOOL | DB_INIT_TXN |
+                     DB_CREATE | DB_PRIVATE | DB_RECOVER | DB_THREAD,
+                 0600) != 0) {
+    std::cerr << "Failed to open environment " << home << std::endl;
+    return 1;
+  }
+  dbstl::register_db_env(penv);
+
+  auto dbstlDb = openDb(penv, "dbstl");
+  dbstl::register_db(dbstlDb);
+  auto nativeDb = openDb(penv, "native");
+
+  {
+    Storage<BenchElement, BenchMarshaller, BenchWatcher> store(dbstlDb, penv);
+    run("dbstl", store, count);
+  }
+  {
+    NativeStorage<BenchElement, BenchMarshaller, BenchWatcher> store(nativeDb,
+                                                                     penv);
+    run("native", store, count);
+  }
+
+  nativeDb->close(0);
+  delete nativeDb;
+  dbstl::dbstl_exit();
+  delete penv;
+  return 0;
+}
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchreport.h"
+#include "benchutils.h"
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/metrics/latencyhistogram.h"
+#include "persistent-storage/storages/registertransactionmanager.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/trace/tracereader.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+/**
+ * Воспроизводит трассу, записанную TracedStorage, на новом окружении и
+ * выводит распределение задержек по операциям в JSON.
+ *
+ * Ключи трассы используются как есть, значения заменяются строками
+ * записанного размера. Операции выполняются в одном потоке в порядке
+ * записи, с исходными интервалами или с максимальной скоростью. Операции
+ * ChildStorage воспроизводятся на обычном хранилище: чтение и удаление
+ * потомков заменяются чтением и удалением того же количества элементов,
+ * следующих за ключом родителя.
+ */
+
+using namespace prstorage;
+
+struct ReplayElement {
+  std::string key;
+  std::string value;
+};
+
+std::string get_id(const ReplayElement& elem)
+{
+  return elem.key;
+}
+
+class ReplayWatcher {
+ protected:
+  void elementAdded(const ReplayElement&) {}
+  void elementRemoved(const ReplayElement&) {}
+  void elementUpdated(const ReplayElement&) {}
+};
+
+class ReplayMarshaller {
+ public:
+  static void restore(ReplayElement& elem, const void* src)
+  {
+    src = restore_str(elem.key, src);
+    src = restore_str(elem.value, src);
+  }
+  static u_int32_t size(const ReplayElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.key.length();
+    size += sizeof(std::string::size_type) + element.value.length();
+    return size;
+  }
+  static void store(void* dest, const ReplayElement& elem)
+  {
+    dest = save_str(elem.key, dest);
+    dest = save_str(elem.value, dest);
+  }
+};
+
+namespace {
+struct ReplayOptions {
+  std::string trace;
+  std::string home = "prstorage-replay";
+  bool originalSpeed = false;
+  Preset preset = Preset::Default;
+  std::string txManager = "default";
+  std::string output;
+};
+
+struct OperationStats {
+  LatencyHistogram latency;
+  std::uint64_t count = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t tracedMisses = 0;
+  std::uint64_t errors = 0;
+};
+
+void usage()
+{
+  std::cerr << "Usage: prstorage_replay TRACE [options]\n"
+               "  --home DIR      environment directory (prstorage-replay)\n"
+               "  --speed MODE    original or max (max)\n"
+               "  --preset NAME   environment preset (default)\n"
+               "  --tx NAME       transaction manager: default,register\n"
+               "  --out FILE      write JSON to FILE instead of stdout\n";
+}
+
+ReplayOptions parseOptions(int argc, char** argv)
+{
+  if (argc < 2 || std::string(argv[1]) == "--help") {
+    usage();
+    std::exit(argc < 2 ? 1 : 0);
+  }
+  ReplayOptions options;
+  options.trace = argv[1];
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 == argc) {
+      usage();
+      std::exit(1);
+    }
+    std::string value = argv[++i];
+    if (arg == "--home") {
+      options.home = value;
+    } else if (arg == "--speed" && (value == "original" || value == "max")) {
+      options.originalSpeed = value == "original";
+    } else if (arg == "--preset") {
+      options.preset = parsePreset(value);
+    } else if (arg == "--tx") {
+      options.txManager = value;
+    } else if (arg == "--out") {
+      options.output = value;
+    } else {
+      usage();
+      std::exit(1);
+    }
+  }
+  return options;
+}
+
+/**
+ * @brief Ключи простых типов могут содержать нулевые байты, а dbstl хранит
+ * строковые ключи до завершающего нуля, поэтому такие ключи заменяются
+ * шестнадцатеричным представлением
+ */
+std::string replayKey(const std::string& key)
+{
+  if (key.find('\0') == std::string::npos) {
+    return key;
+  }
+  static const char digits[] = "0123456789abcdef";
+  std::string res;
+  res.reserve(key.size() * 2);
+  for (auto ch : key) {
+    res.push_back(digits[(static_cast<unsigned char>(ch) >> 4) & 0xf]);
+    res.push_back(digits[static_cast<unsigned char>(ch) & 0xf]);
+  }
+  return res;
+}
+
+/**
+ * @brief Читает курсором record.valueSize элементов, следующих за ключом
+ * родителя. Связи потомков с родителями в трассу не записываются, поэтому
+ * операции над потомками воспроизводятся обходом того же количества
+ * соседних элементов
+ */
+template <typename StorageType>
+std::vector<ReplayElement> readAfter(const StorageType& store,
+                                     const TraceRecord& record)
+{
+  // маркер страницы - ключ в формате dbstl, с завершающим нулем
+  std::string token;
+  if (!record.key.empty()) {
+    token = record.key;
+    token.push_back('\0');
+  }
+  return store.page(token, record.valueSize).elements;
+}
+
+template <typename StorageType>
+bool execute(StorageType& store, TraceRecord& record)
+{
+  record.key = replayKey(record.key);
+  auto value = [&record] { return std::string(record.valueSize, 'x'); };
+  switch (record.operation) {
+    case TraceOperation::Add:
+      return store.add({record.key, value()});
+    case TraceOperation::Get:
+      try {
+        store.get(record.key);
+        return true;
+      } catch (const std::range_error&) {
+        return false;
+      }
+    case TraceOperation::Has:
+      return store.has(record.key);
+    case TraceOperation::Update:
+      store.update({record.key, value()});
+      return true;
+    case TraceOperation::StrictUpdate:
+      return store.strictUpdate({record.key, value()});
+    case TraceOperation::Remove:
+      return store.remove(record.key);
+    case TraceOperation::GetAll:
+      store.getAllElements();
+      return true;
+    case TraceOperation::GetIf:
+      // предикат не записывается в трассу, воспроизводится стоимость обхода
+      store.get_if([](const ReplayElement&) { return false; });
+      return true;
+    case TraceOperation::ChildrenOf:
+    case TraceOperation::ChildrenPage:
+      return !readAfter(store, record).empty() || record.valueSize == 0;
+    case TraceOperation::RemoveChildrenOf: {
+      // удаляются столько же элементов, сколько потомков было удалено
+      std::size_t removed = 0;
+      for (const auto& elem : readAfter(store, record)) {
+        removed += store.remove(elem.key) ? 1 : 0;
+      }
+      return removed == record.valueSize;
+    }
+  }
+  return true;
+}
+
+template <typename TxManager>
+void replay(BenchReport& report, const ReplayOptions& options)
+{
+  using StorageType =
+      Storage<ReplayElement, ReplayMarshaller, ReplayWatcher, TxManager>;
+
+  makeDirectory(options.home);
+  auto env = EnvironmentBuilder(options.home)
+                 .preset(options.preset)
+                 .privateEnvironment()
+                 .recover()
+                 .open();
+  StorageFactory factory(env, options.preset);
+  auto db = factory.openDatabase("replay.db", "elements");
+  u_int32_t discarded = 0;
+  db->truncate(nullptr, &discarded, DB_AUTO_COMMIT);
+
+  std::array<OperationStats, TRACE_OPERATION_COUNT> stats;
+  std::uint64_t maxLagNanoseconds = 0;
+  double seconds = 0;
+  try {
+    StorageType store(db, env);
+    TraceReader reader(options.trace);
+    auto start = std::chrono::steady_clock::now();
+    for (TraceRecord record; reader.next(record);) {
+      auto scheduled =
+          start + std::chrono::nanoseconds(record.startNanoseconds);
+      if (options.originalSpeed) {
+        std::this_thread::sleep_until(scheduled);
+      }
+
+      auto& operation = stats[static_cast<std::size_t>(record.operation)];
+      auto opStart = std::chrono::steady_clock::now();
+      if (options.originalSpeed && opStart > scheduled) {
+        maxLagNanoseconds = std::max<std::uint64_t>(
+            maxLagNanoseconds,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(opStart -
+                                                                 scheduled)
+                .count());
+      }
+      try {
+        if (!execute(store, record)) {
+          ++operation.misses;
+        }
+      } catch (const std::exception&) {
+        ++operation.errors;
+      }
+      operation.latency.record(std::chrono::steady_clock::now() - opStart);
+      ++operation.count;
+      if (record.status == TraceStatus::Miss) {
+        ++operation.tracedMisses;
+      }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+  } catch (...) {
+    closeEnvironment(env, {db});
+    throw;
+  }
+  closeEnvironment(env, {db});
+
+  LatencyHistogram total;
+  std::uint64_t totalCount = 0;
+  for (std::size_t i = 0; i < TRACE_OPERATION_COUNT; ++i) {
+    const auto& operation = stats[i];
+    if (operation.count == 0) {
+      continue;
+    }
+    total.merge(operation.latency);
+    totalCount += operation.count;
+
+    BenchResult result;
+    result.operation = traceOperationName(static_cast<TraceOperation>(i));
+    result.operations = operation.count;
+    result.seconds = operation.latency.totalNanoseconds() / 1e9;
+    setLatencies(result, operation.latency);
+    // расхождение misses и traced_misses означает, что состояние базы при
+    // воспроизведении отличается от исходного
+    result.counters["misses"] = operation.misses;
+    result.counters["traced_misses"] = operation.tracedMisses;
+    result.counters["errors"] = operation.errors;
+    report.add(std::move(result));
+  }
+
+  BenchResult result;
+  result.operation = "total";
+  result.operations = totalCount;
+  result.seconds = seconds;
+  setLatencies(result, total);
+  if (options.originalSpeed) {
+    result.counters["max_lag_ns"] = maxLagNanoseconds;
+  }
+  report.add(std::move(result));
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parseOptions(argc, argv);
+
+  BenchReport report("prstorage_replay");
+  report.setContext("trace", options.trace);
+  report.setContext("speed", options.originalSpeed ? "original" : "max");
+  report.setContext("preset", presetName(options.preset));
+  report.setContext("tx_manager", options.txManager);
+
+  try {
+    dbstl::dbstl_startup();
+    if (options.txManager == "default") {
+      replay<DefaultTransactionManager>(report, options);
+    } else if (options.txManager == "register") {
+      replay<RegisterTransactionManager>(report, options);
+    } else {
+      throw std::invalid_argument("Unknown transaction manager: " +
+                                  options.txManager);
+    }
+    dbstl::dbstl_exit();
+    report.save(options.output);
+  } catch (const std::exception& ex) {
+    std::cerr << "prstorage_replay: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,447 @@
+#include <dbstl_common.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchelements.h"
+#include "benchreport.h"
+#include "benchutils.h"
+#include "keygenerators.h"
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/metrics/dbstatistics.h"
+#include "persistent-storage/storages/registertransactionmanager.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/storages/threadregistry.h"
+#include "persistent-storage/utils/keydbt.h"
+
+/**
+ * Проверяет масштабируемость Storage по числу потоков на нагрузках YCSB A-F
+ * с равномерным распределением ключей и распределением Ципфа. Для каждого
+ * сочетания выводятся пропускная способность, перцентили задержек и
+ * счетчики блокировок Berkeley DB.
+ */
+
+using namespace prstorage;
+
+namespace {
+/// количество ключей, которые читает короткий обход нагрузки E
+constexpr std::uint64_t SCAN_LENGTH = 10;
+
+/**
+ * Менеджер транзакций без сброса журнала на диск при фиксации, позволяет
+ * отделить стоимость DB_TXN_SYNC от стоимости блокировок
+ */
+class NoSyncTransactionManager {
+ public:
+  explicit NoSyncTransactionManager(DbEnv* env) :
+      mEnv(env),
+      mTxn(env ? dbstl::begin_txn(DB_TXN_NOSYNC | DB_TXN_WAIT, env) : nullptr)
+  {
+  }
+  ~NoSyncTransactionManager()
+  {
+    if (mEnv && mTxn) {
+      dbstl::abort_txn(mEnv, mTxn);
+    }
+  }
+  void commit()
+  {
+    if (mEnv && mTxn) {
+      dbstl::commit_txn(mEnv, mTxn);
+      mEnv = nullptr;
+      mTxn = nullptr;
+    }
+  }
+  void abort()
+  {
+    if (mEnv && mTxn) {
+      dbstl::abort_txn(mEnv, mTxn);
+      mEnv = nullptr;
+      mTxn = nullptr;
+    }
+  }
+
+ private:
+  DbEnv* mEnv;
+  DbTxn* mTxn;
+};
+
+/**
+ * Доли операций нагрузки YCSB, в сумме 100
+ */
+struct Workload {
+  char name;
+  int read;
+  int update;
+  int insert;
+  int scan;
+  int readModifyWrite;
+  KeyDistribution readDistribution;
+};
+
+const std::vector<Workload>& allWorkloads()
+{
+  static const std::vector<Workload> workloads{
+      {'A', 50, 50, 0, 0, 0, KeyDistribution::Zipfian},
+      {'B', 95, 5, 0, 0, 0, KeyDistribution::Zipfian},
+      {'C', 100, 0, 0, 0, 0, KeyDistribution::Zipfian},
+      {'D', 95, 0, 5, 0, 0, KeyDistribution::Latest},
+      {'E', 0, 0, 5, 95, 0, KeyDistribution::Zipfian},
+      {'F', 50, 0, 0, 0, 50, KeyDistribution::Zipfian},
+  };
+  return workloads;
+}
+
+struct ScaleOptions {
+  std::string home = "prstorage-scale-bench";
+  std::uint64_t records = 100000;
+  std::uint64_t size = 1024;
+  std::vector<std::uint64_t> threads{1, 2, 4, 8, 16, 32};
+  std::string workloads = "ABCDEF";
+  std::vector<std::string> distributions{"uniform", "zipfian"};
+  std::vector<std::string> txManagers{"default", "register", "nosync"};
+  Preset preset = Preset::Default;
+  double seconds = 5;
+  std::string output;
+};
+
+struct ThreadStats {
+  LatencyHistogram latency;
+  std::uint64_t operations = 0;
+  std::uint64_t deadlocks = 0;
+  std::uint64_t errors = 0;
+};
+
+void usage()
+{
+  std::cerr
+      << "Usage: prstorage_scale_bench [options]\n"
+         "  --home DIR            environment directory\n"
+         "  --records N           records loaded before the runs (100K)\n"
+         "  --size N              element payload size in bytes (1024)\n"
+         "  --threads LIST        thread counts (1,2,4,8,16,32)\n"
+         "  --workloads LETTERS   YCSB workloads (ABCDEF)\n"
+         "  --distributions LIST  uniform,zipfian\n"
+         "  --tx LIST             default,register,nosync\n"
+         "  --preset NAME         environment preset (default)\n"
+         "  --seconds N           duration of every run (5)\n"
+         "  --out FILE            write JSON to FILE instead of stdout\n";
+}
+
+ScaleOptions parseOptions(int argc, char** argv)
+{
+  ScaleOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || i + 1 == argc) {
+      usage();
+      std::exit(arg == "--help" ? 0 : 1);
+    }
+    std::string value = argv[++i];
+    if (arg == "--home") {
+      options.home = value;
+    } else if (arg == "--records") {
+      options.records = parseCounts(value).at(0);
+    } else if (arg == "--size") {
+      options.size = parseCounts(value).at(0);
+    } else if (arg == "--threads") {
+      options.threads = parseCounts(value);
+    } else if (arg == "--workloads") {
+      options.workloads = value;
+    } else if (arg == "--distributions") {
+      options.distributions = parseNames(value);
+    } else if (arg == "--tx") {
+      options.txManagers = parseNames(value);
+    } else if (arg == "--preset") {
+      options.preset = parsePreset(value);
+    } else if (arg == "--seconds") {
+      options.seconds = std::stod(value);
+    } else if (arg == "--out") {
+      options.output = value;
+    } else {
+      usage();
+      std::exit(1);
+    }
+  }
+  if (options.records < 2 || options.threads.empty()) {
+    usage();
+    std::exit(1);
+  }
+  return options;
+}
+
+KeyDistribution parseDistribution(const std::string& name)
+{
+  if (name == "uniform") {
+    return KeyDistribution::Uniform;
+  }
+  if (name == "zipfian") {
+    return KeyDistribution::Zipfian;
+  }
+  throw std::invalid_argument("Unknown distribution: " + name);
+}
+
+/**
+ * Одно сочетание нагрузки, распределения и числа потоков на общей базе
+ */
+template <typename TxManager>
+class ScaleRun {
+ public:
+  using StorageType =
+      Storage<BenchElement, BenchMarshaller, BenchWatcher, TxManager>;
+
+ public:
+  ScaleRun(DbEnv* env,
+           Db* db,
+           std::atomic<std::uint64_t>& keyCount,
+           const ScaleOptions& options) :
+      mEnv(env),
+      mDb(db), mStore(db, env), mKeyCount(keyCount), mOptions(options),
+      mPayload(options.size, 'x')
+  {
+  }
+
+ public:
+  BenchResult run(const Workload& workload,
+                  KeyDistribution distribution,
+                  std::uint64_t threadCount)
+  {
+    // распределение Latest задается нагрузкой D и не зависит от параметра
+    auto readDistribution =
+        workload.readDistribution == KeyDistribution::Latest
+            ? KeyDistribution::Latest
+            : distribution;
+    KeyChooser chooser(readDistribution, mKeyCount.load());
+
+    std::vector<std::unique_ptr<ThreadStats>> stats;
+    for (std::uint64_t i = 0; i < threadCount; ++i) {
+      stats.push_back(std::make_unique<ThreadStats>());
+    }
+
+    auto before = EnvironmentStats::collect(mEnv);
+    std::atomic<bool> stopped{false};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < threadCount; ++i) {
+      threads.emplace_back([this, &workload, &chooser, &stopped,
+                            stats = stats[i].get(), seed = i + 1] {
+        worker(workload, chooser, stopped, *stats, seed);
+      });
+    }
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(mOptions.seconds));
+    stopped = true;
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    auto after = EnvironmentStats::collect(mEnv);
+
+    LatencyHistogram latency;
+    BenchResult result;
+    result.operation = std::string("workload") + workload.name;
+    result.seconds = seconds;
+    for (const auto& threadStats : stats) {
+      latency.merge(threadStats->latency);
+      result.operations += threadStats->operations;
+      result.counters["deadlock_retries"] += threadStats->deadlocks;
+      result.counters["errors"] += threadStats->errors;
+    }
+    setLatencies(result, latency);
+    result.counters["deadlocks"] = after.deadlocks - before.deadlocks;
+    result.counters["lock_waits"] = after.lockWaits - before.lockWaits;
+    result.counters["lock_requests"] =
+        after.lockRequests - before.lockRequests;
+    result.counters["txn_commits"] = after.txnCommits - before.txnCommits;
+    result.counters["txn_aborts"] = after.txnAborts - before.txnAborts;
+    result.counters["log_syncs"] = after.logSyncs - before.logSyncs;
+    return result;
+  }
+
+ private:
+  void worker(const Workload& workload,
+              const KeyChooser& chooser,
+              const std::atomic<bool>& stopped,
+              ThreadStats& stats,
+              std::uint64_t seed)
+  {
+    // каждый поток, работающий с dbstl, регистрирует окружение и базу
+    ThreadRegistry::registerAll(mEnv, {mDb});
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    while (!stopped.load(std::memory_order_relaxed)) {
+      auto choice = percent(random);
+      auto start = std::chrono::steady_clock::now();
+      try {
+        execute(workload, chooser, random, choice);
+        stats.latency.record(std::chrono::steady_clock::now() - start);
+        ++stats.operations;
+      } catch (const DbDeadlockException&) {
+        ++stats.deadlocks;
+      } catch (const std::exception&) {
+        ++stats.errors;
+      }
+    }
+    ThreadRegistry::threadExit();
+  }
+
+  void execute(const Workload& workload,
+               const KeyChooser& chooser,
+               std::mt19937_64& random,
+               int choice)
+  {
+    auto existing = [&] {
+      return benchKey(chooser.next(random, mKeyCount.load()));
+    };
+
+    if ((choice -= workload.read) < 0) {
+      read(existing());
+    } else if ((choice -= workload.update) < 0) {
+      mStore.update({existing(), std::string(), mPayload});
+    } else if ((choice -= workload.insert) < 0) {
+      mStore.add({benchKey(mKeyCount.fetch_add(1)), std::string(), mPayload});
+    } else if ((choice -= workload.scan) < 0) {
+      // короткий обход курсором от выбранного ключа в порядке хранения:
+      // ключи benchKey не дополнены нулями, поэтому соседние номера не
+      // являются соседними записями B-дерева
+      auto first = existing();
+      auto length = std::uniform_int_distribution<std::uint64_t>(
+          1, SCAN_LENGTH)(random);
+      // маркер страницы - закодированный ключ, обход начинается после него
+      KeyDbt<std::string> encoded(first);
+      auto dbt = encoded.get();
+      std::string token(static_cast<const char*>(dbt->get_data()),
+                        dbt->get_size());
+      mStore.page(token, length);
+    } else {
+      if (auto elem = read(existing())) {
+        elem->payload = mPayload;
+        mStore.strictUpdate(*elem);
+      }
+    }
+  }
+
+  std::optional<BenchElement> read(const std::string& key)
+  {
+    try {
+      return mStore.get(key);
+    } catch (const std::range_error&) {
+      // ключ выбран, но еще не добавлен другим потоком
+      return {};
+    }
+  }
+
+ private:
+  DbEnv* mEnv;
+  Db* mDb;
+  StorageType mStore;
+  std::atomic<std::uint64_t>& mKeyCount;
+  const ScaleOptions& mOptions;
+  const std::string mPayload;
+};
+
+template <typename TxManager>
+void runTxManager(BenchReport& report,
+                  const ScaleOptions& options,
+                  const std::string& txManager)
+{
+  auto home = options.home + "/" + txManager;
+  makeDirectory(home);
+  auto env = EnvironmentBuilder(home)
+                 .preset(options.preset)
+                 .privateEnvironment()
+                 .recover()
+                 .open();
+  env->set_lk_detect(DB_LOCK_DEFAULT);
+  StorageFactory factory(env, options.preset);
+  auto db = factory.openDatabase("scale.db", "elements");
+
+  try {
+    // загрузка без сброса журнала, чтобы не зависеть от скорости диска
+    Storage<BenchElement, BenchMarshaller, BenchWatcher,
+            NoSyncTransactionManager>
+        loader(db, env);
+    const std::string payload(options.size, 'x');
+    for (std::uint64_t i = 0; i < options.records; ++i) {
+      loader.update({benchKey(i), std::string(), payload});
+    }
+
+    std::atomic<std::uint64_t> keyCount{options.records};
+    ScaleRun<TxManager> scaleRun(env, db, keyCount, options);
+    for (auto name : options.workloads) {
+      auto workload = std::find_if(
+          allWorkloads().begin(), allWorkloads().end(),
+          [name](const Workload& w) { return w.name == std::toupper(name); });
+      if (workload == allWorkloads().end()) {
+        throw std::invalid_argument(std::string("Unknown workload: ") + name);
+      }
+      for (const auto& distributionName : options.distributions) {
+        for (auto threads : options.threads) {
+          std::cerr << txManager << " workload " << workload->name << " "
+                    << distributionName << " " << threads << " threads"
+                    << std::endl;
+          auto result = scaleRun.run(
+              *workload, parseDistribution(distributionName), threads);
+          result.labels["tx_manager"] = txManager;
+          result.labels["preset"] = presetName(options.preset);
+          result.labels["distribution"] = distributionName;
+          result.labels["threads"] = std::to_string(threads);
+          result.records = options.records;
+          result.elementSize = options.size;
+          report.add(std::move(result));
+        }
+      }
+    }
+  } catch (...) {
+    closeEnvironment(env, {db});
+    throw;
+  }
+  closeEnvironment(env, {db});
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parseOptions(argc, argv);
+
+  BenchReport report("prstorage_scale_bench");
+  report.setContext("home", options.home);
+  report.setContext("seconds", std::to_string(options.seconds));
+  report.setContext("hardware_threads",
+                    std::to_string(std::thread::hardware_concurrency()));
+
+  try {
+    dbstl::dbstl_startup();
+    makeDirectory(options.home);
+    for (const auto& txManager : options.txManagers) {
+      if (txManager == "default") {
+        runTxManager<DefaultTransactionManager>(report, options, txManager);
+      } else if (txManager == "register") {
+        runTxManager<RegisterTransactionManager>(report, options, txManager);
+      } else if (txManager == "nosync") {
+        runTxManager<NoSyncTransactionManager>(report, options, txManager);
+      } else {
+        throw std::invalid_argument("Unknown transaction manager: " +
+                                    txManager);
+      }
+    }
+    dbstl::dbstl_exit();
+    report.save(options.output);
+  } catch (const std::exception& ex) {
+    std::cerr << "prstorage_scale_bench: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
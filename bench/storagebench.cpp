@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchelements.h"
+#include "benchreport.h"
+#include "benchutils.h"
+#include "persistent-storage/deleters/parentsdeleter.h"
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/childstorage.h"
+#include "persistent-storage/storages/registertransactionmanager.h"
+#include "persistent-storage/storages/storage.h"
+
+/**
+ * Измеряет все операции Storage и ChildStorage для каждого сочетания
+ * количества записей, размера элемента, менеджера транзакций и набора
+ * настроек окружения. Результаты выводятся в JSON.
+ */
+
+using namespace prstorage;
+
+namespace {
+/// полные обходы пропускаются, если данные не помещаются в этот объем
+constexpr std::uint64_t SCAN_LIMIT_BYTES = 1024 * 1024 * 1024;
+constexpr std::uint64_t CHILDREN_PER_PARENT = 10;
+
+struct BenchOptions {
+  std::string home = "prstorage-bench";
+  std::vector<std::uint64_t> records{1000, 10000, 100000};
+  std::vector<std::uint64_t> sizes{128, 1024, 16384};
+  std::vector<Preset> presets{Preset::Default};
+  std::vector<std::string> txManagers{"default", "register"};
+  std::string output;
+};
+
+struct BenchCase {
+  Preset preset;
+  std::string txManager;
+  std::uint64_t records;
+  std::uint64_t size;
+};
+
+void usage()
+{
+  std::cerr
+      << "Usage: prstorage_bench [options]\n"
+         "  --home DIR        directory for environments (prstorage-bench)\n"
+         "  --records LIST    record counts, e.g. 1K,100K,10M\n"
+         "  --sizes LIST      element payload sizes in bytes\n"
+         "  --presets LIST    default,read-heavy,write-heavy,low-memory\n"
+         "  --tx LIST         transaction managers: default,register\n"
+         "  --out FILE        write JSON to FILE instead of stdout\n";
+}
+
+BenchOptions parseOptions(int argc, char** argv)
+{
+  BenchOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || i + 1 == argc) {
+      usage();
+      std::exit(arg == "--help" ? 0 : 1);
+    }
+    std::string value = argv[++i];
+    if (arg == "--home") {
+      options.home = value;
+    } else if (arg == "--records") {
+      options.records = parseCounts(value);
+    } else if (arg == "--sizes") {
+      options.sizes = parseCounts(value);
+    } else if (arg == "--presets") {
+      options.presets.clear();
+      for (const auto& name : parseNames(value)) {
+        options.presets.push_back(parsePreset(name));
+      }
+    } else if (arg == "--tx") {
+      options.txManagers = parseNames(value);
+    } else if (arg == "--out") {
+      options.output = value;
+    } else {
+      usage();
+      std::exit(1);
+    }
+  }
+  if (options.records.empty() || options.sizes.empty()) {
+    usage();
+    std::exit(1);
+  }
+  return options;
+}
+
+BenchResult labeled(BenchResult result, const BenchCase& bench)
+{
+  result.labels["preset"] = presetName(bench.preset);
+  result.labels["tx_manager"] = bench.txManager;
+  result.records = bench.records;
+  result.elementSize = bench.size;
+  return result;
+}
+
+std::vector<std::uint64_t> shuffledIndexes(std::uint64_t count)
+{
+  std::vector<std::uint64_t> res(count);
+  std::iota(res.begin(), res.end(), 0);
+  std::shuffle(res.begin(), res.end(), std::mt19937_64(42));
+  return res;
+}
+
+template <typename TxManager>
+void runStorage(BenchReport& report,
+                const BenchCase& bench,
+                const StorageFactory& factory,
+                std::vector<Db*>& databases)
+{
+  using StorageType =
+      Storage<BenchElement, BenchMarshaller, BenchWatcher, TxManager>;
+
+  auto db = factory.openDatabase("storage.db", "storage");
+  databases.push_back(db);
+  auto store = std::make_shared<StorageType>(db, factory.env());
+
+  const std::string payload(bench.size, 'x');
+  const std::string changed(bench.size, 'y');
+  const auto order = shuffledIndexes(bench.records);
+  auto element = [&](std::uint64_t i, const std::string& data) {
+    return BenchElement{benchKey(i), std::string(), data};
+  };
+  auto add = [&report, &bench](BenchResult result) {
+    result.labels["storage"] = "Storage";
+    report.add(labeled(std::move(result), bench));
+  };
+
+  Stopwatch stopwatch;
+  add(stopwatch.run("add", bench.records, [&](std::uint64_t i) {
+    store->add(element(i, payload));
+  }));
+  add(stopwatch.run("get", bench.records,
+                    [&](std::uint64_t i) { store->get(benchKey(order[i])); }));
+  add(stopwatch.run("has", bench.records,
+                    [&](std::uint64_t i) { store->has(benchKey(order[i])); }));
+  add(stopwatch.run("update", bench.records, [&](std::uint64_t i) {
+    store->update(element(order[i], changed));
+  }));
+  add(stopwatch.run("strictUpdate", bench.records, [&](std::uint64_t i) {
+    store->strictUpdate(element(order[i], payload));
+  }));
+  add(stopwatch.run("wrapper.save", bench.records, [&](std::uint64_t i) {
+    auto wrapper = store->wrapper(benchKey(order[i]));
+    wrapper->payload = changed;
+    wrapper.save();
+  }));
+
+  if (bench.records * bench.size <= SCAN_LIMIT_BYTES) {
+    auto scan = stopwatch.run("getAllElements", 1,
+                              [&](std::uint64_t) { store->getAllElements(); });
+    scan.operations = bench.records;
+    add(std::move(scan));
+
+    // предикат отбирает около 1% элементов
+    auto filter = stopwatch.run("get_if", 1, [&](std::uint64_t) {
+      store->get_if([](const BenchElement& elem) {
+        return elem.id.back() == '7' && elem.id[elem.id.size() - 2] == '7';
+      });
+    });
+    filter.operations = bench.records;
+    add(std::move(filter));
+  }
+
+  add(stopwatch.run("remove", bench.records, [&](std::uint64_t i) {
+    store->remove(benchKey(order[i]));
+  }));
+}
+
+template <typename TxManager>
+void runCascade(BenchReport& report,
+                const BenchCase& bench,
+                const StorageFactory& factory,
+                std::vector<Db*>& databases)
+{
+  using ChildStorageType =
+      ChildStorage<BenchElement, BenchElement, BenchMarshaller, BenchWatcher,
+                   TxManager>;
+  using ParentDeleterType =
+      ParentsDeleter<std::string, BenchElement, ChildStorageType>;
+  using ParentStorageType = Storage<BenchElement, BenchMarshaller,
+                                    BenchWatcher, TxManager, ParentDeleterType>;
+
+  auto childDb = factory.openDatabase("cascade.db", "children");
+  auto secondaryDb = factory.openSecondary(
+      childDb, "cascade.db", "children_by_parent", benchParentKey);
+  auto parentDb = factory.openDatabase("cascade.db", "parents");
+  databases.insert(databases.end(), {secondaryDb, childDb, parentDb});
+
+  auto children = std::make_shared<ChildStorageType>(childDb, secondaryDb,
+                                                     factory.env());
+  auto parents = std::make_shared<ParentStorageType>(
+      parentDb, factory.env(), ParentDeleterType(children));
+
+  const std::string payload(bench.size, 'x');
+  const auto parentCount =
+      std::max<std::uint64_t>(bench.records / CHILDREN_PER_PARENT, 1);
+  auto parentKey = [](std::uint64_t i) {
+    return "parent " + std::to_string(i);
+  };
+  auto add = [&report, &bench](BenchResult result) {
+    result.labels["storage"] = "ChildStorage";
+    result.labels["children_per_parent"] = std::to_string(CHILDREN_PER_PARENT);
+    report.add(labeled(std::move(result), bench));
+  };
+
+  Stopwatch stopwatch;
+  for (std::uint64_t i = 0; i < parentCount; ++i) {
+    parents->add({parentKey(i), std::string(), std::string()});
+  }
+  add(stopwatch.run("child.add", bench.records, [&](std::uint64_t i) {
+    children->add({benchKey(i), parentKey(i % parentCount), payload});
+  }));
+  add(stopwatch.run("childrenOf", parentCount, [&](std::uint64_t i) {
+    children->childrenOf(parentKey(i), CHILDREN_PER_PARENT);
+  }));
+  add(stopwatch.run("cascade.remove", parentCount, [&](std::uint64_t i) {
+    parents->remove(parentKey(i));
+  }));
+}
+
+void runMarshalling(BenchReport& report,
+                    std::uint64_t records,
+                    std::uint64_t size)
+{
+  const BenchElement elem{benchKey(records), "parent", std::string(size, 'x')};
+  std::vector<char> buffer(BenchMarshaller::size(elem));
+  auto add = [&report, records, size](BenchResult result) {
+    result.labels["storage"] = "Marshaller";
+    result.records = records;
+    result.elementSize = size;
+    report.add(std::move(result));
+  };
+
+  Stopwatch stopwatch;
+  add(stopwatch.run("marshal.store", records, [&](std::uint64_t) {
+    BenchMarshaller::store(buffer.data(), elem);
+  }));
+  add(stopwatch.run("marshal.restore", records, [&](std::uint64_t) {
+    BenchElement restored;
+    BenchMarshaller::restore(restored, buffer.data());
+  }));
+}
+
+template <typename TxManager>
+void runCase(BenchReport& report,
+             const BenchOptions& options,
+             const BenchCase& bench)
+{
+  auto home = options.home + "/" + presetName(bench.preset) + "-" +
+              bench.txManager + "-" + std::to_string(bench.records) + "-" +
+              std::to_string(bench.size);
+  makeDirectory(home);
+
+  auto env = EnvironmentBuilder(home)
+                 .preset(bench.preset)
+                 .privateEnvironment()
+                 .recover()
+                 .open();
+  StorageFactory factory(env, bench.preset);
+  std::vector<Db*> databases;
+  try {
+    runStorage<TxManager>(report, bench, factory, databases);
+    runCascade<TxManager>(report, bench, factory, databases);
+  } catch (...) {
+    closeEnvironment(env, databases);
+    throw;
+  }
+  closeEnvironment(env, databases);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parseOptions(argc, argv);
+
+  BenchReport report("prstorage_bench");
+  report.setContext("home", options.home);
+  report.setContext("scan_limit_bytes", std::to_string(SCAN_LIMIT_BYTES));
+
+  try {
+    dbstl::dbstl_startup();
+    makeDirectory(options.home);
+    for (auto size : options.sizes) {
+      runMarshalling(report,
+                     *std::max_element(options.records.begin(),
+                                       options.records.end()),
+                     size);
+    }
+    for (auto preset : options.presets) {
+      for (const auto& txManager : options.txManagers) {
+        for (auto records : options.records) {
+          for (auto size : options.sizes) {
+            BenchCase bench{preset, txManager, records, size};
+            std::cerr << presetName(preset) << " " << txManager << " "
+                      << records << " x " << size << std::endl;
+            if (txManager == "default") {
+              runCase<DefaultTransactionManager>(report, options, bench);
+            } else if (txManager == "register") {
+              runCase<RegisterTransactionManager>(report, options, bench);
+            } else {
+              throw std::invalid_argument("Unknown transaction manager: " +
+                                          txManager);
+            }
+          }
+        }
+      }
+    }
+    dbstl::dbstl_exit();
+    report.save(options.output);
+  } catch (const std::exception& ex) {
+    std::cerr << "prstorage_bench: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
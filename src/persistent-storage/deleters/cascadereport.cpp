@@ -0,0 +1,39 @@
+#include "cascadereport.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace prstorage;
+
+CascadeReport::CascadeReport(std::size_t chunkSize) :
+    mChunkSize(std::max<std::size_t>(chunkSize, 1))
+{
+}
+
+std::size_t CascadeReport::chunkSize() const noexcept
+{
+  return mChunkSize;
+}
+
+void CascadeReport::addRemoved(std::size_t level, std::size_t count)
+{
+  if (mRemovedOnLevels.size() <= level) {
+    mRemovedOnLevels.resize(level + 1, 0);
+  }
+  mRemovedOnLevels[level] += count;
+}
+
+std::size_t CascadeReport::removedOnLevel(std::size_t level) const noexcept
+{
+  return level < mRemovedOnLevels.size() ? mRemovedOnLevels[level] : 0;
+}
+
+std::size_t CascadeReport::levels() const noexcept
+{
+  return mRemovedOnLevels.size();
+}
+
+std::size_t CascadeReport::totalRemoved() const noexcept
+{
+  return std::accumulate(std::cbegin(mRemovedOnLevels),
+                         std::cend(mRemovedOnLevels), std::size_t{0});
+}
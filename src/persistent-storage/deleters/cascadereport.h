@@ -0,0 +1,48 @@
+#ifndef CASCADEREPORT_H
+#define CASCADEREPORT_H
+
+#include <cstddef>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Результат каскадного удаления дочерних элементов.
+ *
+ * Хранит размер порции, которой удаляются элементы, и количество удаленных
+ * элементов на каждом уровне иерархии. Уровень 0 - непосредственные потомки
+ * удаляемого родителя.
+ */
+class CascadeReport {
+ public:
+  static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1024;
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param chunkSize максимальное количество элементов, которые одновременно
+   * находятся в памяти на одном уровне каскада
+   */
+  explicit CascadeReport(std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+ public:
+  std::size_t chunkSize() const noexcept;
+  void addRemoved(std::size_t level, std::size_t count);
+
+  /**
+   * @brief Возвращает количество удаленных элементов на уровне level
+   */
+  std::size_t removedOnLevel(std::size_t level) const noexcept;
+
+  /**
+   * @brief Возвращает количество уровней, на которых были удалены элементы
+   */
+  std::size_t levels() const noexcept;
+  std::size_t totalRemoved() const noexcept;
+
+ private:
+  std::size_t mChunkSize;
+  std::vector<std::size_t> mRemovedOnLevels;
+};
+}  // namespace prstorage
+
+#endif  // CASCADEREPORT_H
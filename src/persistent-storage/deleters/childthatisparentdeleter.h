@@ -12,10 +12,9 @@ struct ChildThatIsParentDeleter
 
   using ParentDeleter::DefaultChildDeleter;
 
+  template <typename Secondary>
   std::vector<typename ChildThatIsParentDeleter::ValueType> removeChilds(
-      dbstl::db_multimap<typename ChildThatIsParentDeleter::ParentIdType,
-                         typename ChildThatIsParentDeleter::ValueType>&
-          secondary,
+      Secondary& secondary,
       const typename ChildThatIsParentDeleter::ParentType& parent)
   {
     std::vector<typename ChildThatIsParentDeleter::ValueType> deletedElements =
@@ -24,10 +23,9 @@ struct ChildThatIsParentDeleter
     return deletedElements;
   }
 
+  template <typename Secondary>
   std::vector<typename ChildThatIsParentDeleter::ValueType> removeChilds(
-      dbstl::db_multimap<typename ChildThatIsParentDeleter::ParentIdType,
-                         typename ChildThatIsParentDeleter::ValueType>&
-          secondary,
+      Secondary& secondary,
       const std::vector<typename ChildThatIsParentDeleter::ParentType>& parents)
   {
     std::vector<typename ChildThatIsParentDeleter::ValueType> deletedElements =
@@ -35,6 +33,35 @@ struct ChildThatIsParentDeleter
     this->getChild()->parentRemoved(deletedElements);
     return deletedElements;
   }
+
+  /**
+   * @brief Удаляет дочерние элементы порциями. Идентификаторы каждой порции
+   * сразу передаются на следующий уровень, поэтому в памяти одновременно
+   * находится не больше одной порции на каждый уровень иерархии.
+   */
+  template <typename Secondary, typename Handler>
+  void removeChildsByIds(
+      Secondary& secondary,
+      const std::vector<typename ChildThatIsParentDeleter::ParentIdType>&
+          parentIds,
+      CascadeReport& report,
+      std::size_t level,
+      Handler&& handler)
+  {
+    std::vector<typename ChildThatIsParentDeleter::KeyType> ids;
+    ParentDeleter::removeChildsByIds(
+        secondary, parentIds, report, level,
+        [this, &ids, &report, level, &handler](
+            const std::vector<typename ChildThatIsParentDeleter::ValueType>&
+                removed) {
+          handler(removed);
+          ids.clear();
+          std::transform(std::cbegin(removed), std::cend(removed),
+                         std::back_inserter(ids),
+                         [](const auto& el) { return get_id(el); });
+          this->getChild()->parentIdsRemoved(ids, report, level + 1);
+        });
+  }
 };
 }  // namespace prstorage
 #endif  // CHILDTHATISPARENTDELETER_H
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <vector>
 
+#include "cascadereport.h"
+
 namespace prstorage {
 template <typename K, typename V, typename P, typename D>
 struct DefaultChildDeleter : public D {
@@ -17,9 +19,9 @@ struct DefaultChildDeleter : public D {
   {
   }
 
+  template <typename Secondary>
   std::vector<typename DefaultChildDeleter::ValueType> removeChilds(
-      dbstl::db_multimap<ParentIdType, typename DefaultChildDeleter::ValueType>&
-          secondary,
+      Secondary& secondary,
       const ParentType& parent)
   {
     std::vector<typename DefaultChildDeleter::ValueType> deletedElements;
@@ -31,9 +33,9 @@ struct DefaultChildDeleter : public D {
     return deletedElements;
   }
 
+  template <typename Secondary>
   std::vector<typename DefaultChildDeleter::ValueType> removeChilds(
-      dbstl::db_multimap<ParentIdType, typename DefaultChildDeleter::ValueType>&
-          secondary,
+      Secondary& secondary,
       const std::vector<ParentType>& parents)
   {
     std::vector<typename DefaultChildDeleter::ValueType> deletedElements;
@@ -45,6 +47,38 @@ struct DefaultChildDeleter : public D {
     }
     return deletedElements;
   }
+
+  /**
+   * @brief Удаляет дочерние элементы родителей parentIds. Удаленные элементы
+   * передаются в handler порциями не больше report.chunkSize().
+   * @param secondary dbstl::db_multimap или вторичный индекс с тем же
+   * интерфейсом, например MemorySecondaryIndex
+   */
+  template <typename Secondary, typename Handler>
+  void removeChildsByIds(
+      Secondary& secondary,
+      const std::vector<ParentIdType>& parentIds,
+      CascadeReport& report,
+      std::size_t /* level */,
+      Handler&& handler)
+  {
+    std::vector<typename DefaultChildDeleter::ValueType> chunk;
+    chunk.reserve(report.chunkSize());
+    for (const auto& parentId : parentIds) {
+      auto [begin, end] = secondary.equal_range(parentId);
+      for (; begin != end; ++begin) {
+        chunk.push_back((*begin).second);
+        if (chunk.size() >= report.chunkSize()) {
+          handler(chunk);
+          chunk.clear();
+        }
+      }
+      secondary.erase(parentId);
+    }
+    if (!chunk.empty()) {
+      handler(chunk);
+    }
+  }
 };
 }  // namespace prstorage
 
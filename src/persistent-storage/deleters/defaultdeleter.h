@@ -3,6 +3,9 @@
 
 #include <dbstl_map.h>
 #include <optional>
+#include <stdexcept>
+
+#include "persistent-storage/utils/keydbt.h"
 
 namespace prstorage {
 template <typename K, typename V>
@@ -10,9 +13,13 @@ struct DefaultDeleter {
   using KeyType = K;
   using ValueType = V;
 
-  std::optional<ValueType> operator()(
-      dbstl::db_map<KeyType, ValueType>& elements,
-      const KeyType& id)
+  /**
+   * @brief Удаляет элемент и возвращает его значение
+   * @param elements dbstl::db_map или контейнер с тем же интерфейсом,
+   * например MemoryMap
+   */
+  template <typename Map>
+  std::optional<ValueType> operator()(Map& elements, const KeyType& id)
   {
     if (auto iter = elements.find(id); iter != elements.end()) {
       auto elem = *iter;
@@ -21,6 +28,47 @@ struct DefaultDeleter {
     }
     return {};
   }
+
+  /**
+   * @brief Удаляет элемент одной операцией DB->del, не читая его значение
+   * @return true, если элемент существовал
+   */
+  bool erase(dbstl::db_map<KeyType, ValueType>& elements, const KeyType& id)
+  {
+    KeyDbt<KeyType> key(id);
+    auto env = elements.get_db_env_handle();
+    auto txn = env ? dbstl::current_txn(env) : nullptr;
+    auto ret = elements.get_db_handle()->del(txn, key.get(), 0);
+    if (ret == DB_NOTFOUND) {
+      return false;
+    }
+    if (ret != 0) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Удаляет элемент из контейнера в памяти, например MemoryMap
+   * @return true, если элемент существовал
+   */
+  template <typename Map>
+  bool erase(Map& elements, const KeyType& id)
+  {
+    return elements.erase(id) > 0;
+  }
+};
+
+/**
+ * DefaultDeleter, который разрешает удаление без чтения значения элемента
+ * через erase (см. removed_value_needed). Используется хранилищами по
+ * умолчанию. Удалители, которые переопределяют operator() и используют
+ * удаляемое значение, наследуются от DefaultDeleter: у него значение
+ * нужно, пока наследник явно не откажется от него.
+ */
+template <typename K, typename V>
+struct KeyOnlyDeleter : public DefaultDeleter<K, V> {
+  static constexpr bool removed_value_needed = false;
 };
 }  // namespace prstorage
 #endif  // DEFAULTDELETER_H
@@ -0,0 +1,30 @@
+#ifndef LOGDELETER_H
+#define LOGDELETER_H
+
+#include <optional>
+
+namespace prstorage {
+/**
+ * Удаляет элементы из LogStorage. Аналог DefaultDeleter для LogTable.
+ */
+template <typename K, typename V>
+struct LogDeleter {
+  using KeyType = K;
+  using ValueType = V;
+
+  static constexpr bool removed_value_needed = false;
+
+  template <typename Table>
+  std::optional<ValueType> operator()(Table& elements, const KeyType& id)
+  {
+    return elements.take(id);
+  }
+
+  template <typename Table>
+  bool erase(Table& elements, const KeyType& id)
+  {
+    return elements.del(id);
+  }
+};
+}  // namespace prstorage
+#endif  // LOGDELETER_H
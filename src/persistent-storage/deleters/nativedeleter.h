@@ -0,0 +1,34 @@
+#ifndef NATIVEDELETER_H
+#define NATIVEDELETER_H
+
+#include <db_cxx.h>
+#include <optional>
+
+namespace prstorage {
+/**
+ * Удаляет элементы из NativeStorage. Аналог DefaultDeleter для таблиц,
+ * которые работают без dbstl.
+ */
+template <typename K, typename V>
+struct NativeDeleter {
+  using KeyType = K;
+  using ValueType = V;
+
+  static constexpr bool removed_value_needed = false;
+
+  template <typename Table>
+  std::optional<ValueType> operator()(Table& elements,
+                                      DbTxn* txn,
+                                      const KeyType& id)
+  {
+    return elements.take(txn, id);
+  }
+
+  template <typename Table>
+  bool erase(Table& elements, DbTxn* txn, const KeyType& id)
+  {
+    return elements.del(txn, id);
+  }
+};
+}  // namespace prstorage
+#endif  // NATIVEDELETER_H
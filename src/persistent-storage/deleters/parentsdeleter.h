@@ -1,31 +1,75 @@
 #ifndef PARENTSDELETER_H
 #define PARENTSDELETER_H
 
+#include <functional>
 #include <memory>
+#include "cascadereport.h"
 #include "defaultdeleter.h"
 
 namespace prstorage {
-template <typename K, typename V, typename C>
-class ParentsDeleter : public DefaultDeleter<K, V> {
+/**
+ * Удаляет родительский элемент и каскадно удаляет его потомков из C.
+ *
+ * Для каскада достаточно ключа родителя, поэтому с базовым удалителем
+ * KeyOnlyDeleter<K, V> удалитель отказывается от значения элемента
+ * (см. removed_value_needed) и хранилище удаляет родителя через erase без
+ * чтения записи:
+ *
+ * using Deleter = ParentsDeleter<K, V, C, KeyOnlyDeleter<K, V>>;
+ *
+ * @tparam Base базовый удалитель, по умолчанию DefaultDeleter<K, V>
+ */
+template <typename K,
+          typename V,
+          typename C,
+          typename Base = DefaultDeleter<K, V>>
+class ParentsDeleter : public Base {
  public:
-  using ParentDeleter = DefaultDeleter<K, V>;
+  using ParentDeleter = Base;
   using ChildContainer = C;
+  using CascadeCallback = std::function<void(const CascadeReport&)>;
 
  public:
-  ParentsDeleter(std::shared_ptr<ChildContainer> child) :
-      mChild(std::move(child))
+  /**
+   * @brief Конструктор класса
+   * @param child контейнер дочерних элементов
+   * @param chunkSize размер порции, которой удаляются дочерние элементы
+   * @param onCascade вызывается с результатом каждого каскадного удаления
+   */
+  ParentsDeleter(
+      std::shared_ptr<ChildContainer> child,
+      std::size_t chunkSize = CascadeReport::DEFAULT_CHUNK_SIZE,
+      CascadeCallback onCascade = CascadeCallback()) :
+      mChild(std::move(child)),
+      mChunkSize(chunkSize), mOnCascade(std::move(onCascade))
   {
   }
 
  public:
+  template <typename Map>
   std::optional<typename ParentDeleter::ValueType> operator()(
-      dbstl::db_map<typename ParentDeleter::KeyType,
-                    typename ParentDeleter::ValueType>& elements,
+      Map& elements,
       const typename ParentDeleter::KeyType& id)
   {
     auto res = ParentDeleter::operator()(elements, id);
     if (res) {
-      mChild->parentRemoved(*res);
+      removeChildsOf(id);
+    }
+    return res;
+  }
+
+  /**
+   * @brief Удаляет элемент без чтения значения и каскадно удаляет его
+   * потомков. Используется хранилищем, только если ни Watcher, ни удалитель
+   * не требуют значения, например с базовым KeyOnlyDeleter.
+   * @return true, если элемент существовал
+   */
+  template <typename Map>
+  bool erase(Map& elements, const typename ParentDeleter::KeyType& id)
+  {
+    auto res = ParentDeleter::erase(elements, id);
+    if (res) {
+      removeChildsOf(id);
     }
     return res;
   }
@@ -33,8 +77,20 @@ class ParentsDeleter : public DefaultDeleter<K, V> {
  protected:
   std::shared_ptr<ChildContainer> getChild() const { return mChild; }
 
+ private:
+  void removeChildsOf(const typename ParentDeleter::KeyType& id)
+  {
+    CascadeReport report(mChunkSize);
+    mChild->parentIdsRemoved({id}, report);
+    if (mOnCascade) {
+      mOnCascade(report);
+    }
+  }
+
  private:
   std::shared_ptr<ChildContainer> mChild;
+  std::size_t mChunkSize;
+  CascadeCallback mOnCascade;
 };
 }  // namespace prstorage
 
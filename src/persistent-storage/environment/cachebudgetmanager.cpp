@@ -0,0 +1,180 @@
+#include "cachebudgetmanager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+constexpr std::uint64_t GB = 1024 * 1024 * 1024;
+/// размер страницы, если в кеше нет ни одного файла
+constexpr std::uint64_t DEFAULT_PAGE_SIZE = 4096;
+
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+double ratio(std::uint64_t hits, std::uint64_t misses)
+{
+  auto total = hits + misses;
+  return total ? static_cast<double>(hits) / static_cast<double>(total) : 1.0;
+}
+
+std::uint64_t delta(std::uint64_t current, std::uint64_t previous)
+{
+  // счетчики могут быть сброшены, например DB_STAT_CLEAR
+  return current >= previous ? current - previous : current;
+}
+}  // namespace
+
+double FileCacheStats::hitRatio() const noexcept
+{
+  return ratio(hits, misses);
+}
+
+double CacheSnapshot::hitRatio() const noexcept
+{
+  return ratio(hits, misses);
+}
+
+CacheBudgetManager::CacheBudgetManager(DbEnv* env, Options options) :
+    mEnv(env), mOptions(options)
+{
+  if (mOptions.minCacheSize == 0) {
+    mOptions.minCacheSize = cacheSizeLocked();
+  }
+  if (mOptions.maxCacheSize == 0) {
+    std::uint32_t gbytes = 0, bytes = 0;
+    check(mEnv->get_cache_max(&gbytes, &bytes));
+    mOptions.maxCacheSize = gbytes * GB + bytes;
+  }
+  mOptions.maxCacheSize =
+      std::max(mOptions.maxCacheSize, mOptions.minCacheSize);
+}
+
+CacheBudgetManager::CacheBudgetManager(DbEnv* env) :
+    CacheBudgetManager(env, Options())
+{
+}
+
+void CacheBudgetManager::setPriority(Db* db, DB_CACHE_PRIORITY priority)
+{
+  check(db->set_priority(priority));
+}
+
+CacheSnapshot CacheBudgetManager::sample()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return sampleLocked();
+}
+
+std::optional<std::uint64_t> CacheBudgetManager::rebalance()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto snapshot = sampleLocked();
+  if (snapshot.hits + snapshot.misses == 0) {
+    return {};
+  }
+
+  auto size = snapshot.cacheSize;
+  auto target = size;
+  if (snapshot.hitRatio() < mOptions.targetHitRatio) {
+    target = static_cast<std::uint64_t>(size * mOptions.growFactor);
+  } else if (snapshot.residentBytes < size * mOptions.shrinkUsage) {
+    // рабочий набор с запасом на рост
+    target = std::max(
+        static_cast<std::uint64_t>(size / mOptions.growFactor),
+        static_cast<std::uint64_t>(snapshot.residentBytes *
+                                   mOptions.growFactor));
+  }
+  target = std::clamp(target, mOptions.minCacheSize, mOptions.maxCacheSize);
+  if (target == size) {
+    return {};
+  }
+
+  std::uint32_t gbytes = 0, bytes = 0;
+  int ncache = 0;
+  check(mEnv->get_cachesize(&gbytes, &bytes, &ncache));
+  check(mEnv->set_cachesize(static_cast<std::uint32_t>(target / GB),
+                            static_cast<std::uint32_t>(target % GB), ncache));
+  return cacheSizeLocked();
+}
+
+std::uint64_t CacheBudgetManager::cacheSize() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return cacheSizeLocked();
+}
+
+CacheSnapshot CacheBudgetManager::sampleLocked()
+{
+  DB_MPOOL_STAT* stat = nullptr;
+  DB_MPOOL_FSTAT** fileStats = nullptr;
+  check(mEnv->memp_stat(&stat, &fileStats, 0));
+  std::unique_ptr<DB_MPOOL_STAT, decltype(&std::free)> statGuard(stat,
+                                                                  &std::free);
+  std::unique_ptr<DB_MPOOL_FSTAT*, decltype(&std::free)> filesGuard(
+      fileStats, &std::free);
+
+  Counters current;
+  current.hits = stat->st_cache_hit;
+  current.misses = stat->st_cache_miss;
+  current.pagesIn = stat->st_page_in;
+  current.evictions = stat->st_ro_evict + stat->st_rw_evict;
+
+  CacheSnapshot snapshot;
+  snapshot.cacheSize = stat->st_gbytes * GB + stat->st_bytes;
+  snapshot.hits = delta(current.hits, mPrevious.hits);
+  snapshot.misses = delta(current.misses, mPrevious.misses);
+  snapshot.pagesIn = delta(current.pagesIn, mPrevious.pagesIn);
+  snapshot.evictions = delta(current.evictions, mPrevious.evictions);
+  snapshot.dirtyPages = stat->st_page_dirty;
+  mPrevious = current;
+
+  // у баз данных в одном файле одинаковое имя: сначала счетчики файла
+  // суммируются, затем из суммы вычитается сумма предыдущего замера
+  std::map<std::string, Counters> files;
+  std::map<std::string, std::uint32_t> pageSizes;
+  std::uint64_t pageSizeSum = 0;
+  std::size_t fileCount = 0;
+  for (auto it = fileStats; it && *it; ++it) {
+    auto fileStat = *it;
+    std::string name = fileStat->file_name ? fileStat->file_name : "";
+    Counters& counters = files[name];
+    counters.hits += fileStat->st_cache_hit;
+    counters.misses += fileStat->st_cache_miss;
+    counters.pagesIn += fileStat->st_page_in;
+    pageSizes[name] = fileStat->st_pagesize;
+    pageSizeSum += fileStat->st_pagesize;
+    ++fileCount;
+  }
+
+  for (const auto& [name, counters] : files) {
+    const auto& previous = mPreviousFiles[name];
+    FileCacheStats fileSnapshot;
+    fileSnapshot.file = name;
+    fileSnapshot.pageSize = pageSizes[name];
+    fileSnapshot.hits = delta(counters.hits, previous.hits);
+    fileSnapshot.misses = delta(counters.misses, previous.misses);
+    fileSnapshot.pagesIn = delta(counters.pagesIn, previous.pagesIn);
+    snapshot.files.push_back(std::move(fileSnapshot));
+  }
+  mPreviousFiles = std::move(files);
+
+  auto pageSize = fileCount ? pageSizeSum / fileCount : DEFAULT_PAGE_SIZE;
+  snapshot.residentBytes = stat->st_pages * pageSize;
+  return snapshot;
+}
+
+std::uint64_t CacheBudgetManager::cacheSizeLocked() const
+{
+  std::uint32_t gbytes = 0, bytes = 0;
+  int ncache = 0;
+  check(mEnv->get_cachesize(&gbytes, &bytes, &ncache));
+  return gbytes * GB + bytes;
+}
@@ -0,0 +1,125 @@
+#ifndef CACHEBUDGETMANAGER_H
+#define CACHEBUDGETMANAGER_H
+
+#include <db_cxx.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Статистика кеша по одному файлу базы данных за интервал между замерами.
+ * Базы данных, которые хранятся в одном файле, учитываются вместе.
+ */
+struct FileCacheStats {
+  std::string file;
+  std::uint32_t pageSize = 0;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t pagesIn = 0;
+
+  /**
+   * @brief Доля обращений, обслуженных из кеша, 1 - если обращений не было
+   */
+  double hitRatio() const noexcept;
+};
+
+/**
+ * Статистика кеша окружения за интервал между замерами
+ */
+struct CacheSnapshot {
+  /// текущий размер кеша
+  std::uint64_t cacheSize = 0;
+  /// оценка объема страниц, находящихся в кеше
+  std::uint64_t residentBytes = 0;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t pagesIn = 0;
+  std::uint64_t evictions = 0;
+  std::uint64_t dirtyPages = 0;
+  std::vector<FileCacheStats> files;
+
+  double hitRatio() const noexcept;
+};
+
+/**
+ * Управляет общим кешем окружения, в котором работают несколько хранилищ.
+ *
+ * Задает приоритеты страниц баз данных: страницы часто используемых таблиц
+ * (DB_PRIORITY_VERY_HIGH) остаются в кеше, страницы таблиц полного обхода
+ * (DB_PRIORITY_VERY_LOW) вытесняются первыми. Периодически снимает
+ * memp_stat и по доле попаданий и объему рабочего набора меняет размер
+ * кеша открытого окружения в пределах, заданных EnvironmentSettings.
+ *
+ * Замеры выполняются вызовом sample() или rebalance(), например по таймеру
+ * приложения.
+ */
+class CacheBudgetManager {
+ public:
+  struct Options {
+    /// доля попаданий, ниже которой кеш увеличивается
+    double targetHitRatio = 0.95;
+    /// множитель изменения размера кеша за один шаг
+    double growFactor = 1.25;
+    /// доля кеша, занятая страницами, ниже которой кеш уменьшается
+    double shrinkUsage = 0.5;
+    /// нижняя граница размера кеша, 0 - размер при создании менеджера
+    std::uint64_t minCacheSize = 0;
+    /// верхняя граница размера кеша, 0 - DbEnv::get_cache_max
+    std::uint64_t maxCacheSize = 0;
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param env открытое окружение
+   * @param options параметры изменения размера кеша
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  CacheBudgetManager(DbEnv* env, Options options);
+  explicit CacheBudgetManager(DbEnv* env);
+
+ public:
+  /**
+   * @brief Устанавливает приоритет страниц базы данных в кеше
+   */
+  void setPriority(Db* db, DB_CACHE_PRIORITY priority);
+
+  /**
+   * @brief Снимает статистику кеша за интервал с предыдущего замера
+   */
+  CacheSnapshot sample();
+
+  /**
+   * @brief Снимает статистику и при необходимости меняет размер кеша
+   * @return новый размер кеша, если он изменился
+   */
+  std::optional<std::uint64_t> rebalance();
+
+  std::uint64_t cacheSize() const;
+
+ private:
+  struct Counters {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t pagesIn = 0;
+    std::uint64_t evictions = 0;
+  };
+
+ private:
+  CacheSnapshot sampleLocked();
+  std::uint64_t cacheSizeLocked() const;
+
+ private:
+  DbEnv* mEnv;
+  Options mOptions;
+  mutable std::mutex mMutex;
+  Counters mPrevious;
+  std::map<std::string, Counters> mPreviousFiles;
+};
+}  // namespace prstorage
+
+#endif  // CACHEBUDGETMANAGER_H
@@ -0,0 +1,21 @@
+#include "cachepriorityguard.h"
+
+#include <stdexcept>
+
+using namespace prstorage;
+
+CachePriorityGuard::CachePriorityGuard(Db* db, DB_CACHE_PRIORITY priority) :
+    mDb(db), mPrevious(DB_PRIORITY_UNCHANGED)
+{
+  if (auto ret = mDb->get_priority(&mPrevious); ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+  if (auto ret = mDb->set_priority(priority); ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+CachePriorityGuard::~CachePriorityGuard()
+{
+  mDb->set_priority(mPrevious);
+}
@@ -0,0 +1,38 @@
+#ifndef CACHEPRIORITYGUARD_H
+#define CACHEPRIORITYGUARD_H
+
+#include <db_cxx.h>
+
+namespace prstorage {
+/**
+ * Меняет приоритет страниц базы данных в кеше на время жизни объекта и
+ * восстанавливает прежний приоритет в деструкторе.
+ *
+ * Используется для разовых полных обходов, чтобы прочитанные страницы
+ * вытеснялись из кеша первыми и не вытесняли страницы других баз.
+ * Приоритет относится к дескриптору Db, поэтому на время обхода он
+ * действует и на другие операции с этим дескриптором.
+ */
+class CachePriorityGuard {
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param db открытая база данных
+   * @param priority приоритет на время жизни объекта
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  explicit CachePriorityGuard(Db* db,
+                              DB_CACHE_PRIORITY priority = DB_PRIORITY_VERY_LOW);
+  ~CachePriorityGuard();
+
+ private:
+  CachePriorityGuard(const CachePriorityGuard&) = delete;
+  CachePriorityGuard& operator=(const CachePriorityGuard&) = delete;
+
+ private:
+  Db* mDb;
+  DB_CACHE_PRIORITY mPrevious;
+};
+}  // namespace prstorage
+
+#endif  // CACHEPRIORITYGUARD_H
@@ -0,0 +1,220 @@
+#include "databasecompactor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "persistent-storage/utils/page.h"
+
+using namespace prstorage;
+
+namespace {
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+/**
+ * @brief Находит ключ, который отстоит на count ключей от from (от начала
+ * базы, если from пуст), обходя только ключи. Если база заканчивается
+ * раньше, res остается пустым.
+ * @return 0 или код ошибки Berkeley DB, например DB_LOCK_DEADLOCK
+ */
+int slice_end(Db* db,
+              const std::vector<char>& from,
+              std::uint32_t count,
+              std::vector<char>& res)
+{
+  Dbc* cursor = nullptr;
+  if (auto ret = db->cursor(nullptr, &cursor, 0); ret != 0) {
+    return ret;
+  }
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  ReallocDbt key;
+  Dbt data;
+  // значения не читаются: dlen == 0
+  data.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+  int ret = 0;
+  if (from.empty()) {
+    ret = cursor->get(&key, &data, DB_FIRST);
+  } else {
+    key.assign(std::string(from.begin(), from.end()));
+    ret = cursor->get(&key, &data, DB_SET_RANGE);
+  }
+  for (std::uint32_t i = 0; ret == 0 && i < count; ++i) {
+    ret = cursor->get(&key, &data, DB_NEXT_NODUP);
+  }
+  if (ret == 0) {
+    auto bytes = static_cast<const char*>(key.get_data());
+    res.assign(bytes, bytes + key.get_size());
+  }
+  return ret == DB_NOTFOUND ? 0 : ret;
+}
+}  // namespace
+
+DatabaseCompactor::DatabaseCompactor(Options options) : mOptions(options)
+{
+  if (mOptions.interval.count() > 0) {
+    mThread = std::thread(&DatabaseCompactor::compactionLoop, this);
+  }
+}
+
+DatabaseCompactor::DatabaseCompactor() : DatabaseCompactor(Options()) {}
+
+DatabaseCompactor::~DatabaseCompactor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mStopMutex);
+    mStopped = true;
+  }
+  mStopCondition.notify_all();
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+}
+
+void DatabaseCompactor::add(Db* db)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDatabases.push_back(db);
+  mPending.insert(db);
+}
+
+void DatabaseCompactor::scheduleCheck(Db* db)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (std::find(mDatabases.begin(), mDatabases.end(), db) !=
+      mDatabases.end()) {
+    mPending.insert(db);
+  }
+}
+
+void DatabaseCompactor::setReportHandler(ReportHandler handler)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mReportHandler = std::move(handler);
+}
+
+CompactionReport DatabaseCompactor::compact(Db* db)
+{
+  return compact(db, DatabaseStats::collect(db, false));
+}
+
+CompactionReport DatabaseCompactor::compact(Db* db, DatabaseStats before)
+{
+  auto start = std::chrono::steady_clock::now();
+  CompactionReport report;
+  report.before = std::move(before);
+
+  // ключ, на котором остановилась предыдущая часть
+  std::vector<char> position;
+  while (true) {
+    // compact_pages ограничивает только освобожденные страницы, поэтому
+    // часть дополнительно ограничивается ключом stop
+    std::vector<char> stopKey;
+    auto ret = mOptions.keysPerSlice
+                   ? slice_end(db, position, mOptions.keysPerSlice, stopKey)
+                   : 0;
+
+    DB_COMPACT data;
+    std::memset(&data, 0, sizeof(data));
+    data.compact_fillpercent = mOptions.fillPercent;
+    data.compact_timeout = mOptions.lockTimeout;
+    data.compact_pages = mOptions.pagesPerSlice;
+
+    Dbt begin(position.data(), static_cast<u_int32_t>(position.size()));
+    Dbt stop(stopKey.data(), static_cast<u_int32_t>(stopKey.size()));
+    Dbt end;
+    end.set_flags(DB_DBT_MALLOC);
+    if (ret == 0) {
+      ret = db->compact(nullptr, position.empty() ? nullptr : &begin,
+                        stopKey.empty() ? nullptr : &stop, &data,
+                        mOptions.freeSpace ? DB_FREE_SPACE : 0, &end);
+    }
+    std::unique_ptr<void, decltype(&std::free)> guard(end.get_data(),
+                                                      &std::free);
+    if (ret == DB_LOCK_DEADLOCK) {
+      // часть откатывается целиком и повторяется после паузы
+      ++report.deadlocks;
+    } else {
+      check(ret);
+      ++report.slices;
+      report.pagesExamined += data.compact_pages_examine;
+      report.pagesFreed += data.compact_pages_free;
+      report.pagesTruncated += data.compact_pages_truncated;
+      report.levelsRemoved += data.compact_levels;
+      report.deadlocks += data.compact_deadlock;
+      auto key = static_cast<const char*>(end.get_data());
+      std::vector<char> next(key, key + end.get_size());
+      if (stopKey.empty()) {
+        if (next.empty() || data.compact_pages_examine == 0) {
+          report.finished = true;
+          break;
+        }
+        position = std::move(next);
+      } else {
+        // часть дошла до stop, если не достигнут предел compact_pages
+        position = next.empty() || next == position ? std::move(stopKey)
+                                                    : std::move(next);
+      }
+    }
+    if (waitStop(mOptions.pause)) {
+      break;
+    }
+  }
+
+  report.after = DatabaseStats::collect(db, false);
+  report.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  return report;
+}
+
+bool DatabaseCompactor::waitStop(std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mStopMutex);
+  if (timeout.count() > 0) {
+    mStopCondition.wait_for(lock, timeout, [this] { return mStopped; });
+  }
+  return mStopped;
+}
+
+void DatabaseCompactor::compactionLoop()
+{
+  while (!waitStop(mOptions.interval)) {
+    // полная статистика обходит базу целиком, поэтому снимается только
+    // для баз, о проверке которых попросили
+    std::set<Db*> pending;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      pending.swap(mPending);
+    }
+    for (auto db : pending) {
+      try {
+        // быстрая статистика не содержит свободного места на страницах
+        auto stats = DatabaseStats::collect(db, false);
+        if (1.0 - stats.fillFactor() < mOptions.minFreeRatio) {
+          continue;
+        }
+        auto report = compact(db, std::move(stats));
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mReportHandler) {
+          mReportHandler(db, report);
+        }
+      } catch (const std::exception& ex) {
+        std::cerr << "Get exception when try to compact database : "
+                  << ex.what() << std::endl;
+      }
+      if (waitStop(std::chrono::milliseconds(0))) {
+        return;
+      }
+    }
+  }
+}
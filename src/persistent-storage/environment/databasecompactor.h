@@ -0,0 +1,141 @@
+#ifndef DATABASECOMPACTOR_H
+#define DATABASECOMPACTOR_H
+
+#include <db_cxx.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "persistent-storage/metrics/dbstatistics.h"
+
+namespace prstorage {
+/**
+ * Итог сжатия одной базы данных
+ */
+struct CompactionReport {
+  /// полная статистика до и после сжатия, включая заполненность страниц
+  DatabaseStats before;
+  DatabaseStats after;
+  /// количество вызовов DB->compact
+  std::uint64_t slices = 0;
+  std::uint64_t pagesExamined = 0;
+  /// страницы, освобожденные слиянием
+  std::uint64_t pagesFreed = 0;
+  /// страницы, возвращенные файловой системе (DB_FREE_SPACE)
+  std::uint64_t pagesTruncated = 0;
+  std::uint64_t levelsRemoved = 0;
+  std::uint64_t deadlocks = 0;
+  std::chrono::milliseconds duration{0};
+  /// база обойдена целиком, false - сжатие прервано остановкой
+  bool finished = false;
+};
+
+/**
+ * Сжимает базы данных после массового удаления (например каскадного
+ * удаления в ChildStorage): сливает полупустые страницы B-дерева и
+ * возвращает освободившееся место файловой системе (DB->compact с
+ * DB_FREE_SPACE).
+ *
+ * Сжатие выполняется частями: каждая часть охватывает не больше
+ * keysPerSlice ключей (граница передается в DB->compact как stop) и
+ * освобождает не больше pagesPerSlice страниц, поэтому время части не
+ * зависит от размера базы, даже если освобождать нечего. Каждая часть
+ * выполняется в своих неявных транзакциях, поэтому блокировки не
+ * удерживаются дольше одной части, а между частями выдерживается пауза.
+ *
+ * Базы данных, добавленные через add(), проверяются в фоновом потоке с
+ * периодом interval и сжимаются, когда доля свободного места на страницах
+ * превышает minFreeRatio. Доля свободного места есть только в полной
+ * статистике, которая обходит базу целиком, поэтому база проверяется один
+ * раз после add() и затем только после вызова scheduleCheck(), например
+ * после каскадного удаления.
+ */
+class DatabaseCompactor {
+ public:
+  using ReportHandler =
+      std::function<void(Db* db, const CompactionReport& report)>;
+
+  struct Options {
+    /// максимальное количество страниц, освобождаемых за одну часть
+    /// (DB_COMPACT::compact_pages), 0 - без ограничения
+    std::uint32_t pagesPerSlice = 1000;
+    /// количество ключей, которое охватывает одна часть, 0 - без
+    /// ограничения
+    std::uint32_t keysPerSlice = 10000;
+    /// пауза между частями
+    std::chrono::milliseconds pause{10};
+    /// целевая заполненность страниц в процентах, 0 - по умолчанию
+    /// Berkeley DB
+    std::uint32_t fillPercent = 0;
+    /// таймаут блокировок неявных транзакций в микросекундах, 0 - таймаут
+    /// окружения
+    std::uint32_t lockTimeout = 0;
+    /// возвращать свободные страницы файловой системе
+    bool freeSpace = true;
+    /// доля свободного места, при которой фоновый поток сжимает базу
+    double minFreeRatio = 0.3;
+    /// период фоновой проверки, 0 - фоновый поток не запускается
+    std::chrono::milliseconds interval{0};
+  };
+
+ public:
+  explicit DatabaseCompactor(Options options);
+  DatabaseCompactor();
+  ~DatabaseCompactor();
+
+ private:
+  DatabaseCompactor(const DatabaseCompactor&) = delete;
+  DatabaseCompactor& operator=(const DatabaseCompactor&) = delete;
+
+ public:
+  /**
+   * @brief Добавляет базу данных для фонового сжатия. База должна
+   * оставаться открытой, пока существует объект.
+   */
+  void add(Db* db);
+
+  /**
+   * @brief Просит фоновый поток проверить базу данных, добавленную через
+   * add(), при следующем проходе
+   */
+  void scheduleCheck(Db* db);
+
+  /**
+   * @brief Устанавливает обработчик, который получает итог каждого
+   * фонового сжатия
+   */
+  void setReportHandler(ReportHandler handler);
+
+  /**
+   * @brief Сжимает базу данных целиком частями по keysPerSlice ключей
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  CompactionReport compact(Db* db);
+
+ private:
+  CompactionReport compact(Db* db, DatabaseStats before);
+  bool waitStop(std::chrono::milliseconds timeout);
+  void compactionLoop();
+
+ private:
+  Options mOptions;
+
+  std::mutex mMutex;
+  std::vector<Db*> mDatabases;
+  /// базы данных, которые фоновый поток проверит при следующем проходе
+  std::set<Db*> mPending;
+  ReportHandler mReportHandler;
+
+  std::mutex mStopMutex;
+  std::condition_variable mStopCondition;
+  bool mStopped = false;
+  std::thread mThread;
+};
+}  // namespace prstorage
+
+#endif  // DATABASECOMPACTOR_H
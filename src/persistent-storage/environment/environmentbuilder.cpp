@@ -0,0 +1,211 @@
+#include "environmentbuilder.h"
+
+#include <dbstl_common.h>
+#include <memory>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+constexpr std::uint64_t KB = 1024;
+constexpr std::uint64_t MB = 1024 * KB;
+constexpr std::uint64_t GB = 1024 * MB;
+
+/// минимальный размер кеша, который принимает Berkeley DB
+constexpr std::uint64_t MIN_CACHE_SIZE = 20 * KB;
+/// размер файла журнала Berkeley DB по умолчанию
+constexpr std::uint64_t DEFAULT_LOG_FILE_SIZE = 10 * MB;
+
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+}  // namespace
+
+EnvironmentSettings EnvironmentSettings::forPreset(Preset preset)
+{
+  EnvironmentSettings settings;
+  switch (preset) {
+    case Preset::Default:
+      break;
+    case Preset::ReadHeavy:
+      settings.cacheSize = 512 * MB;
+      settings.mmapSize = 256 * MB;
+      break;
+    case Preset::WriteHeavy:
+      settings.cacheSize = 256 * MB;
+      settings.logBufferSize = 8 * MB;
+      settings.logFileSize = 64 * MB;
+      settings.maxLocks = 10000;
+      settings.maxLockers = 10000;
+      settings.maxLockObjects = 10000;
+      settings.maxTransactions = 1000;
+      break;
+    case Preset::LowMemory:
+      settings.cacheSize = 4 * MB;
+      settings.logBufferSize = 64 * KB;
+      break;
+  }
+  return settings;
+}
+
+void EnvironmentSettings::validate() const
+{
+  if (cacheCount < 1) {
+    throw std::invalid_argument("cache count must be positive");
+  }
+  if (cacheSize < MIN_CACHE_SIZE * static_cast<std::uint64_t>(cacheCount)) {
+    throw std::invalid_argument("cache size is less than 20KB per cache");
+  }
+  if (maxCacheSize != 0 && maxCacheSize < cacheSize) {
+    throw std::invalid_argument("max cache size is less than cache size");
+  }
+  // файл журнала должен вмещать не меньше четырех буферов журнала
+  auto fileSize = logFileSize ? logFileSize : DEFAULT_LOG_FILE_SIZE;
+  if (static_cast<std::uint64_t>(logBufferSize) * 4 > fileSize) {
+    throw std::invalid_argument(
+        "log file size must be at least four times the log buffer size");
+  }
+}
+
+EnvironmentBuilder::EnvironmentBuilder(std::string home) :
+    mHome(std::move(home))
+{
+}
+
+EnvironmentBuilder& EnvironmentBuilder::preset(Preset preset)
+{
+  mSettings = EnvironmentSettings::forPreset(preset);
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::cacheSize(std::uint64_t bytes,
+                                                  int caches)
+{
+  mSettings.cacheSize = bytes;
+  mSettings.cacheCount = caches;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::maxCacheSize(std::uint64_t bytes)
+{
+  mSettings.maxCacheSize = bytes;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::logBufferSize(std::uint32_t bytes)
+{
+  mSettings.logBufferSize = bytes;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::logFileSize(std::uint32_t bytes)
+{
+  mSettings.logFileSize = bytes;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::mmapSize(std::size_t bytes)
+{
+  mSettings.mmapSize = bytes;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::lockLimits(std::uint32_t locks,
+                                                   std::uint32_t lockers,
+                                                   std::uint32_t objects)
+{
+  mSettings.maxLocks = locks;
+  mSettings.maxLockers = lockers;
+  mSettings.maxLockObjects = objects;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::maxTransactions(std::uint32_t count)
+{
+  mSettings.maxTransactions = count;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::privateEnvironment(bool enabled)
+{
+  mFlags = enabled ? (mFlags | DB_PRIVATE) : (mFlags & ~DB_PRIVATE);
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::recover(bool enabled)
+{
+  mFlags = enabled ? (mFlags | DB_RECOVER) : (mFlags & ~DB_RECOVER);
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::flags(std::uint32_t flags)
+{
+  mFlags |= flags;
+  return *this;
+}
+
+EnvironmentBuilder& EnvironmentBuilder::registerInDbstl(bool enabled)
+{
+  mRegister = enabled;
+  return *this;
+}
+
+const EnvironmentSettings& EnvironmentBuilder::settings() const noexcept
+{
+  return mSettings;
+}
+
+std::uint32_t EnvironmentBuilder::openFlags() const noexcept
+{
+  return mFlags;
+}
+
+DbEnv* EnvironmentBuilder::open() const
+{
+  mSettings.validate();
+
+  auto env = std::make_unique<DbEnv>(DB_CXX_NO_EXCEPTIONS);
+  check(env->set_cachesize(
+      static_cast<std::uint32_t>(mSettings.cacheSize / GB),
+      static_cast<std::uint32_t>(mSettings.cacheSize % GB),
+      mSettings.cacheCount));
+  if (mSettings.maxCacheSize) {
+    check(env->set_cache_max(
+        static_cast<std::uint32_t>(mSettings.maxCacheSize / GB),
+        static_cast<std::uint32_t>(mSettings.maxCacheSize % GB)));
+  }
+  if (mSettings.logBufferSize) {
+    check(env->set_lg_bsize(mSettings.logBufferSize));
+  }
+  if (mSettings.logFileSize) {
+    check(env->set_lg_max(mSettings.logFileSize));
+  }
+  if (mSettings.mmapSize) {
+    check(env->set_mp_mmapsize(mSettings.mmapSize));
+  }
+  if (mSettings.maxLocks) {
+    check(env->set_lk_max_locks(mSettings.maxLocks));
+  }
+  if (mSettings.maxLockers) {
+    check(env->set_lk_max_lockers(mSettings.maxLockers));
+  }
+  if (mSettings.maxLockObjects) {
+    check(env->set_lk_max_objects(mSettings.maxLockObjects));
+  }
+  if (mSettings.maxTransactions) {
+    check(env->set_tx_max(mSettings.maxTransactions));
+  }
+
+  if (auto ret = env->open(mHome.c_str(), mFlags, 0600); ret != 0) {
+    env->close(0);
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+
+  if (mRegister) {
+    dbstl::register_db_env(env.get());
+  }
+  return env.release();
+}
@@ -0,0 +1,127 @@
+#ifndef ENVIRONMENTBUILDER_H
+#define ENVIRONMENTBUILDER_H
+
+#include <db_cxx.h>
+#include <cstdint>
+#include <string>
+
+#include "preset.h"
+
+namespace prstorage {
+/**
+ * Параметры окружения Berkeley DB. Нулевое значение означает значение
+ * Berkeley DB по умолчанию.
+ */
+struct EnvironmentSettings {
+  /// суммарный размер кеша
+  std::uint64_t cacheSize = 64 * 1024 * 1024;
+  /// количество областей, на которые делится кеш
+  int cacheCount = 1;
+  /// предел, до которого можно увеличить кеш открытого окружения
+  std::uint64_t maxCacheSize = 0;
+  /// размер буфера журнала в памяти
+  std::uint32_t logBufferSize = 1024 * 1024;
+  /// максимальный размер файла журнала
+  std::uint32_t logFileSize = 0;
+  /// максимальный размер файла, открытого только на чтение, который
+  /// отображается в память вместо чтения через кеш
+  std::size_t mmapSize = 0;
+  std::uint32_t maxLocks = 0;
+  std::uint32_t maxLockers = 0;
+  std::uint32_t maxLockObjects = 0;
+  /// максимальное количество одновременных транзакций
+  std::uint32_t maxTransactions = 0;
+
+  /**
+   * @brief Возвращает параметры для набора настроек preset
+   */
+  static EnvironmentSettings forPreset(Preset preset);
+
+  /**
+   * @brief Проверяет согласованность параметров
+   * @throws std::invalid_argument при недопустимом значении
+   */
+  void validate() const;
+};
+
+/**
+ * Открывает транзакционное окружение Berkeley DB с проверенными
+ * параметрами кеша, журнала и блокировок.
+ *
+ * Пример:
+ *   DbEnv* env = EnvironmentBuilder(".")
+ *                    .preset(Preset::ReadHeavy)
+ *                    .cacheSize(128 * 1024 * 1024)
+ *                    .open();
+ *
+ * Открытое окружение регистрируется в dbstl и закрывается вызовом
+ * dbstl::dbstl_exit(), как и при ручной регистрации.
+ */
+class EnvironmentBuilder {
+ public:
+  static constexpr std::uint32_t DEFAULT_FLAGS =
+      DB_CREATE | DB_INIT_LOCK | DB_INIT_LOG | DB_INIT_MPOOL | DB_INIT_TXN |
+      DB_THREAD;
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param home домашний каталог окружения
+   */
+  explicit EnvironmentBuilder(std::string home);
+
+ public:
+  /**
+   * @brief Заменяет все параметры значениями набора настроек
+   */
+  EnvironmentBuilder& preset(Preset preset);
+  EnvironmentBuilder& cacheSize(std::uint64_t bytes, int caches = 1);
+  EnvironmentBuilder& maxCacheSize(std::uint64_t bytes);
+  EnvironmentBuilder& logBufferSize(std::uint32_t bytes);
+  EnvironmentBuilder& logFileSize(std::uint32_t bytes);
+  EnvironmentBuilder& mmapSize(std::size_t bytes);
+  EnvironmentBuilder& lockLimits(std::uint32_t locks,
+                                 std::uint32_t lockers,
+                                 std::uint32_t objects);
+  EnvironmentBuilder& maxTransactions(std::uint32_t count);
+
+  /**
+   * @brief Окружение только для текущего процесса (DB_PRIVATE)
+   */
+  EnvironmentBuilder& privateEnvironment(bool enabled = true);
+
+  /**
+   * @brief Выполнять восстановление при открытии (DB_RECOVER)
+   */
+  EnvironmentBuilder& recover(bool enabled = true);
+
+  /**
+   * @brief Дополнительные флаги DbEnv::open
+   */
+  EnvironmentBuilder& flags(std::uint32_t flags);
+
+  /**
+   * @brief Регистрировать ли окружение в dbstl, по умолчанию - да
+   */
+  EnvironmentBuilder& registerInDbstl(bool enabled);
+
+  const EnvironmentSettings& settings() const noexcept;
+  std::uint32_t openFlags() const noexcept;
+
+ public:
+  /**
+   * @brief Проверяет параметры и открывает окружение
+   * @throws std::invalid_argument при недопустимых параметрах
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  DbEnv* open() const;
+
+ private:
+  std::string mHome;
+  EnvironmentSettings mSettings;
+  std::uint32_t mFlags = DEFAULT_FLAGS;
+  bool mRegister = true;
+};
+}  // namespace prstorage
+
+#endif  // ENVIRONMENTBUILDER_H
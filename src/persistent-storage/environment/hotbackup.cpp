@@ -0,0 +1,257 @@
+#include "hotbackup.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "environmentbuilder.h"
+#include "logmaintenance.h"
+
+using namespace prstorage;
+
+namespace {
+/// максимальный размер страницы Berkeley DB, блок копирования кратен ему,
+/// чтобы страницы не читались частично
+constexpr std::size_t MAX_PAGE_SIZE = 64 * 1024;
+
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+[[noreturn]] void throw_errno(const std::string& operation,
+                              const std::string& path)
+{
+  throw std::runtime_error(operation + " " + path + ": " +
+                           std::strerror(errno));
+}
+
+std::vector<std::string> list_files(DbEnv* env, std::uint32_t flags)
+{
+  char** list = nullptr;
+  check(env->log_archive(&list, flags | DB_ARCH_ABS));
+  std::unique_ptr<char*, decltype(&std::free)> guard(list, &std::free);
+
+  std::vector<std::string> res;
+  for (auto it = list; it && *it; ++it) {
+    res.emplace_back(*it);
+  }
+  return res;
+}
+
+std::string base_name(const std::string& path)
+{
+  auto pos = path.rfind('/');
+  return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+std::uint64_t file_size(const std::string& path)
+{
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0 ? static_cast<std::uint64_t>(st.st_size)
+                                        : 0;
+}
+
+std::uint64_t total_size(const std::vector<std::string>& files)
+{
+  std::uint64_t res = 0;
+  for (const auto& file : files) {
+    res += file_size(file);
+  }
+  return res;
+}
+
+/**
+ * Сообщает окружению о резервном копировании на время существования
+ * объекта (DB_HOTBACKUP_IN_PROGRESS), если версия Berkeley DB его
+ * поддерживает: операции без записи в журнал, например массовая загрузка,
+ * тогда записывают его полностью
+ */
+class HotBackupInProgress {
+ public:
+  explicit HotBackupInProgress(DbEnv* env) : mEnv(env)
+  {
+#ifdef DB_HOTBACKUP_IN_PROGRESS
+    check(mEnv->set_flags(DB_HOTBACKUP_IN_PROGRESS, 1));
+#endif
+  }
+  ~HotBackupInProgress()
+  {
+#ifdef DB_HOTBACKUP_IN_PROGRESS
+    mEnv->set_flags(DB_HOTBACKUP_IN_PROGRESS, 0);
+#endif
+  }
+  HotBackupInProgress(const HotBackupInProgress&) = delete;
+  HotBackupInProgress& operator=(const HotBackupInProgress&) = delete;
+
+ private:
+  DbEnv* mEnv;
+};
+
+class FileDescriptor {
+ public:
+  explicit FileDescriptor(int fd) : mFd(fd) {}
+  ~FileDescriptor()
+  {
+    if (mFd >= 0) {
+      ::close(mFd);
+    }
+  }
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  int get() const noexcept { return mFd; }
+
+ private:
+  int mFd;
+};
+}  // namespace
+
+HotBackup::HotBackup(DbEnv* env, Options options) :
+    mEnv(env), mOptions(options)
+{
+  if (mOptions.blockSize == 0 || mOptions.blockSize % MAX_PAGE_SIZE != 0) {
+    throw std::invalid_argument("block size must be a multiple of 64KB");
+  }
+}
+
+HotBackup::HotBackup(DbEnv* env) : HotBackup(env, Options()) {}
+
+void HotBackup::setProgressHandler(ProgressHandler handler)
+{
+  mProgressHandler = std::move(handler);
+}
+
+BackupReport HotBackup::backup(const std::string& directory)
+{
+  if (::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+    throw_errno("mkdir", directory);
+  }
+  mStart = std::chrono::steady_clock::now();
+  mBytesRead = 0;
+
+  BackupReport report;
+  BackupProgress progress;
+  // журнал не архивируется, пока не скопирован: восстановлению копии нужны
+  // все файлы журнала с начала копирования баз данных
+  LogArchiveGuard archiveGuard(mEnv);
+  HotBackupInProgress inProgress(mEnv);
+  auto databases = list_files(mEnv, DB_ARCH_DATA);
+  progress.filesTotal = databases.size();
+  progress.bytesTotal = total_size(databases);
+  for (const auto& path : databases) {
+    copyFile(path, directory + "/" + base_name(path), progress);
+  }
+  report.databaseFiles = databases.size();
+
+  // список журнала берется после копирования баз данных, чтобы в копию
+  // попали все записи, сделанные во время копирования
+  progress.stage = BackupProgress::Stage::Logs;
+  auto logs = list_files(mEnv, DB_ARCH_LOG);
+  progress.filesTotal += logs.size();
+  progress.bytesTotal += total_size(logs);
+  for (const auto& path : logs) {
+    copyFile(path, directory + "/" + base_name(path), progress);
+  }
+  report.logFiles = logs.size();
+  report.bytes = progress.bytesCopied;
+
+  if (mOptions.recover) {
+    progress.stage = BackupProgress::Stage::Recovery;
+    progress.file.clear();
+    notify(progress);
+    std::unique_ptr<DbEnv> copy(EnvironmentBuilder(directory)
+                                    .privateEnvironment()
+                                    .flags(DB_RECOVER_FATAL)
+                                    .registerInDbstl(false)
+                                    .open());
+    check(copy->close(0));
+  }
+
+  progress.stage = BackupProgress::Stage::Done;
+  notify(progress);
+  report.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - mStart);
+  return report;
+}
+
+void HotBackup::copyFile(const std::string& from,
+                         const std::string& to,
+                         BackupProgress& progress)
+{
+  progress.file = base_name(from);
+  FileDescriptor input(::open(from.c_str(), O_RDONLY));
+  if (input.get() < 0) {
+    throw_errno("open", from);
+  }
+  FileDescriptor output(::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600));
+  if (output.get() < 0) {
+    throw_errno("open", to);
+  }
+
+  std::vector<char> buffer(mOptions.blockSize);
+  while (true) {
+    auto count = ::read(input.get(), buffer.data(), buffer.size());
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_errno("read", from);
+    }
+    if (count == 0) {
+      break;
+    }
+    for (ssize_t written = 0; written < count;) {
+      auto ret =
+          ::write(output.get(), buffer.data() + written, count - written);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw_errno("write", to);
+      }
+      written += ret;
+    }
+    progress.bytesCopied += static_cast<std::uint64_t>(count);
+    // файл журнала растет во время копирования
+    progress.bytesTotal = std::max(progress.bytesTotal, progress.bytesCopied);
+    notify(progress);
+    throttle(static_cast<std::uint64_t>(count));
+  }
+  if (::fsync(output.get()) != 0) {
+    throw_errno("fsync", to);
+  }
+  ++progress.filesCopied;
+}
+
+void HotBackup::throttle(std::uint64_t bytes)
+{
+  mBytesRead += bytes;
+  if (mOptions.bytesPerSecond == 0) {
+    return;
+  }
+  auto expected = std::chrono::microseconds(mBytesRead * 1000000 /
+                                            mOptions.bytesPerSecond);
+  auto elapsed = std::chrono::steady_clock::now() - mStart;
+  if (elapsed < expected) {
+    std::this_thread::sleep_for(expected - elapsed);
+  }
+}
+
+void HotBackup::notify(const BackupProgress& progress) const
+{
+  if (mProgressHandler) {
+    mProgressHandler(progress);
+  }
+}
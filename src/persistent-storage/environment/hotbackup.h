@@ -0,0 +1,117 @@
+#ifndef HOTBACKUP_H
+#define HOTBACKUP_H
+
+#include <db_cxx.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace prstorage {
+/**
+ * Состояние резервного копирования, передается в обработчик прогресса
+ * после каждого скопированного блока
+ */
+struct BackupProgress {
+  enum class Stage {
+    /// копирование файлов баз данных
+    Databases,
+    /// копирование файлов журнала
+    Logs,
+    /// катастрофическое восстановление копии
+    Recovery,
+    Done
+  };
+
+  Stage stage = Stage::Databases;
+  /// файл, который копируется сейчас, относительно домашнего каталога
+  std::string file;
+  std::size_t filesCopied = 0;
+  std::size_t filesTotal = 0;
+  std::uint64_t bytesCopied = 0;
+  /// оценка общего объема, известна после получения списка файлов
+  std::uint64_t bytesTotal = 0;
+};
+
+/**
+ * Итог резервного копирования
+ */
+struct BackupReport {
+  std::size_t databaseFiles = 0;
+  std::size_t logFiles = 0;
+  std::uint64_t bytes = 0;
+  std::chrono::milliseconds duration{0};
+};
+
+/**
+ * Создает согласованную копию транзакционного окружения без остановки
+ * записи (hot backup по процедуре Berkeley DB):
+ *   1. копирует файлы баз данных, которые возвращает log_archive
+ *      (DB_ARCH_DATA), блоками, кратными размеру страницы;
+ *   2. копирует все файлы журнала (DB_ARCH_LOG), включая записанные во время
+ *      первого шага;
+ *   3. выполняет катастрофическое восстановление (DB_RECOVER_FATAL) в
+ *      каталоге копии, которое применяет журнал к скопированным страницам.
+ *
+ * На время копирования создается LogArchiveGuard, поэтому LogMaintenance
+ * того же процесса не удаляет и не переносит файлы журнала, пока они не
+ * скопированы.
+ *
+ * Скорость чтения ограничивается bytesPerSecond, чтобы копирование не
+ * вытесняло ввод-вывод рабочих запросов. Копия открывается как обычное
+ * окружение.
+ */
+class HotBackup {
+ public:
+  using ProgressHandler = std::function<void(const BackupProgress&)>;
+
+  struct Options {
+    /// ограничение скорости копирования, 0 - без ограничения
+    std::uint64_t bytesPerSecond = 0;
+    /// размер блока копирования
+    std::size_t blockSize = 1024 * 1024;
+    /// выполнять восстановление копии, без него копия требует
+    /// DB_RECOVER_FATAL при открытии
+    bool recover = true;
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param env открытое транзакционное окружение
+   * @param options параметры копирования
+   * @throws std::invalid_argument при нулевом размере блока
+   */
+  HotBackup(DbEnv* env, Options options);
+  explicit HotBackup(DbEnv* env);
+
+ public:
+  /**
+   * @brief Устанавливает обработчик прогресса
+   */
+  void setProgressHandler(ProgressHandler handler);
+
+  /**
+   * @brief Копирует окружение в каталог directory. Каталог создается, если
+   * его нет, файлы с совпадающими именами перезаписываются.
+   * @throws std::runtime_error при ошибке Berkeley DB или ввода-вывода
+   */
+  BackupReport backup(const std::string& directory);
+
+ private:
+  void copyFile(const std::string& from,
+                const std::string& to,
+                BackupProgress& progress);
+  void throttle(std::uint64_t bytes);
+  void notify(const BackupProgress& progress) const;
+
+ private:
+  DbEnv* mEnv;
+  Options mOptions;
+  ProgressHandler mProgressHandler;
+  std::chrono::steady_clock::time_point mStart;
+  std::uint64_t mBytesRead = 0;
+};
+}  // namespace prstorage
+
+#endif  // HOTBACKUP_H
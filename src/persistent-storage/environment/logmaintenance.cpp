@@ -0,0 +1,257 @@
+#include "logmaintenance.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace prstorage;
+
+namespace {
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+[[noreturn]] void throw_errno(const std::string& operation,
+                              const std::string& path)
+{
+  throw std::runtime_error(operation + " " + path + ": " +
+                           std::strerror(errno));
+}
+
+/**
+ * @brief Возвращает список файлов log_archive с абсолютными путями
+ */
+std::vector<std::string> list_logs(DbEnv* env, std::uint32_t flags)
+{
+  char** list = nullptr;
+  check(env->log_archive(&list, flags | DB_ARCH_ABS));
+  std::unique_ptr<char*, decltype(&std::free)> guard(list, &std::free);
+
+  std::vector<std::string> res;
+  for (auto it = list; it && *it; ++it) {
+    res.emplace_back(*it);
+  }
+  return res;
+}
+
+std::string base_name(const std::string& path)
+{
+  auto pos = path.rfind('/');
+  return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+void move_file(const std::string& from, const std::string& to)
+{
+  if (::rename(from.c_str(), to.c_str()) == 0) {
+    return;
+  }
+  if (errno != EXDEV) {
+    throw_errno("rename", from);
+  }
+
+  // каталог архива на другой файловой системе
+  {
+    std::ifstream input(from, std::ios::binary);
+    std::ofstream output(to, std::ios::binary | std::ios::trunc);
+    if (!input || !output) {
+      throw std::runtime_error("Failed to copy " + from + " to " + to);
+    }
+    output << input.rdbuf();
+    output.flush();
+    if (!output) {
+      throw std::runtime_error("Failed to copy " + from + " to " + to);
+    }
+  }
+  if (::unlink(from.c_str()) != 0) {
+    throw_errno("unlink", from);
+  }
+}
+
+/// защищает archive_guards и архивацию журнала от создания LogArchiveGuard
+std::mutex archive_mutex;
+/// количество LogArchiveGuard для каждого окружения
+std::map<DbEnv*, std::size_t> archive_guards;
+}  // namespace
+
+LogArchiveGuard::LogArchiveGuard(DbEnv* env) : mEnv(env)
+{
+  std::lock_guard<std::mutex> lock(archive_mutex);
+  ++archive_guards[mEnv];
+}
+
+LogArchiveGuard::~LogArchiveGuard()
+{
+  std::lock_guard<std::mutex> lock(archive_mutex);
+  if (--archive_guards[mEnv] == 0) {
+    archive_guards.erase(mEnv);
+  }
+}
+
+LogMaintenance::LogMaintenance(DbEnv* env, Options options) :
+    mEnv(env), mOptions(std::move(options))
+{
+  if (mOptions.archiveMode == LogArchiveMode::Move &&
+      mOptions.archiveDirectory.empty()) {
+    throw std::invalid_argument("archive directory is not set");
+  }
+  if (mOptions.recoveryBytesPerSecond == 0) {
+    throw std::invalid_argument("recovery speed must be positive");
+  }
+
+  if (mOptions.interval.count() > 0) {
+    mThread = std::thread(&LogMaintenance::maintenanceLoop, this);
+  }
+}
+
+LogMaintenance::LogMaintenance(DbEnv* env) : LogMaintenance(env, Options()) {}
+
+LogMaintenance::~LogMaintenance()
+{
+  {
+    std::lock_guard<std::mutex> lock(mStopMutex);
+    mStopped = true;
+  }
+  mStopCondition.notify_all();
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+}
+
+MaintenanceReport LogMaintenance::maintain()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  bool force = false;
+  if (mOptions.maxRecoveryTime.count() > 0) {
+    force = recoveryEstimate().expectedRecoveryTime >= mOptions.maxRecoveryTime;
+  }
+
+  MaintenanceReport report;
+  report.checkpointed = checkpointLocked(force);
+  report.archivedLogFiles = archiveLogsLocked();
+  report.estimate = recoveryEstimate();
+  return report;
+}
+
+bool LogMaintenance::checkpoint(bool force)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return checkpointLocked(force);
+}
+
+std::size_t LogMaintenance::archiveLogs()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return archiveLogsLocked();
+}
+
+RecoveryEstimate LogMaintenance::recoveryEstimate() const
+{
+  DB_LOG_STAT* logStat = nullptr;
+  check(mEnv->log_stat(&logStat, 0));
+  std::unique_ptr<DB_LOG_STAT, decltype(&std::free)> logGuard(logStat,
+                                                              &std::free);
+  DB_TXN_STAT* txnStat = nullptr;
+  check(mEnv->txn_stat(&txnStat, 0));
+  std::unique_ptr<DB_TXN_STAT, decltype(&std::free)> txnGuard(txnStat,
+                                                              &std::free);
+
+  RecoveryEstimate estimate;
+  // без контрольной точки восстановление читает журнал с первого файла
+  const auto& checkpoint = txnStat->st_last_ckp;
+  std::uint32_t file = checkpoint.file ? checkpoint.file : 1;
+  std::uint32_t offset = checkpoint.file ? checkpoint.offset : 0;
+  if (logStat->st_cur_file >= file) {
+    std::uint64_t end =
+        static_cast<std::uint64_t>(logStat->st_cur_file - file) *
+            logStat->st_lg_size +
+        logStat->st_cur_offset;
+    estimate.logBytesSinceCheckpoint = end >= offset ? end - offset : 0;
+  }
+  if (checkpoint.file != 0 && txnStat->st_time_ckp != 0) {
+    auto elapsed = std::time(nullptr) - txnStat->st_time_ckp;
+    estimate.sinceCheckpoint = std::chrono::seconds(elapsed > 0 ? elapsed : 0);
+  }
+
+  auto all = list_logs(mEnv, DB_ARCH_LOG).size();
+  estimate.archivableLogFiles = list_logs(mEnv, 0).size();
+  estimate.activeLogFiles =
+      all > estimate.archivableLogFiles ? all - estimate.archivableLogFiles
+                                        : 0;
+  estimate.expectedRecoveryTime = std::chrono::milliseconds(
+      estimate.logBytesSinceCheckpoint * 1000 /
+      mOptions.recoveryBytesPerSecond);
+  return estimate;
+}
+
+bool LogMaintenance::checkpointLocked(bool force)
+{
+  auto before = lastCheckpoint();
+  check(mEnv->txn_checkpoint(mOptions.checkpointKBytes,
+                             mOptions.checkpointMinutes,
+                             force ? DB_FORCE : 0));
+  auto after = lastCheckpoint();
+  return before.file != after.file || before.offset != after.offset;
+}
+
+std::size_t LogMaintenance::archiveLogsLocked()
+{
+  if (mOptions.archiveMode == LogArchiveMode::Keep) {
+    return 0;
+  }
+
+  // файлы обрабатываются под archive_mutex, поэтому LogArchiveGuard,
+  // созданный во время прохода, дожидается его завершения
+  std::lock_guard<std::mutex> lock(archive_mutex);
+  if (archive_guards.count(mEnv)) {
+    return 0;
+  }
+  auto logs = list_logs(mEnv, 0);
+  for (const auto& path : logs) {
+    if (mOptions.archiveMode == LogArchiveMode::Move) {
+      move_file(path, mOptions.archiveDirectory + "/" + base_name(path));
+    } else if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+      throw_errno("unlink", path);
+    }
+  }
+  return logs.size();
+}
+
+DB_LSN LogMaintenance::lastCheckpoint() const
+{
+  DB_TXN_STAT* stat = nullptr;
+  check(mEnv->txn_stat(&stat, 0));
+  std::unique_ptr<DB_TXN_STAT, decltype(&std::free)> guard(stat, &std::free);
+  return stat->st_last_ckp;
+}
+
+void LogMaintenance::maintenanceLoop()
+{
+  std::unique_lock<std::mutex> lock(mStopMutex);
+  while (!mStopped) {
+    mStopCondition.wait_for(lock, mOptions.interval);
+    if (mStopped) {
+      break;
+    }
+    lock.unlock();
+    try {
+      maintain();
+    } catch (const std::exception& ex) {
+      std::cerr << "Get exception when try to maintain environment log : "
+                << ex.what() << std::endl;
+    }
+    lock.lock();
+  }
+}
@@ -0,0 +1,176 @@
+#ifndef LOGMAINTENANCE_H
+#define LOGMAINTENANCE_H
+
+#include <db_cxx.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace prstorage {
+/**
+ * Что делать с файлами журнала, которые не нужны для восстановления
+ */
+enum class LogArchiveMode {
+  /// оставить на месте
+  Keep,
+  /// удалить
+  Remove,
+  /// перенести в каталог архива
+  Move
+};
+
+/**
+ * Оценка стоимости восстановления окружения при следующем открытии с
+ * DB_RECOVER. Восстановление читает журнал от последней контрольной точки.
+ */
+struct RecoveryEstimate {
+  /// объем журнала, записанный после последней контрольной точки
+  std::uint64_t logBytesSinceCheckpoint = 0;
+  /// время с последней контрольной точки, 0 - контрольных точек не было
+  std::chrono::seconds sinceCheckpoint{0};
+  /// количество файлов журнала, которые еще нужны для восстановления
+  std::size_t activeLogFiles = 0;
+  /// количество файлов журнала, которые можно архивировать
+  std::size_t archivableLogFiles = 0;
+  /// ожидаемое время восстановления
+  std::chrono::milliseconds expectedRecoveryTime{0};
+};
+
+/**
+ * Результат одного прохода обслуживания
+ */
+struct MaintenanceReport {
+  /// была ли записана контрольная точка
+  bool checkpointed = false;
+  /// количество удаленных или перенесенных файлов журнала
+  std::size_t archivedLogFiles = 0;
+  /// оценка после прохода
+  RecoveryEstimate estimate;
+};
+
+/**
+ * Запрещает архивацию журнала окружения, пока существует объект.
+ *
+ * LogMaintenance пропускает удаление и перенос файлов журнала, если для
+ * окружения создан хотя бы один LogArchiveGuard, и выполняет их при
+ * следующем проходе. HotBackup удерживает его на время копирования, иначе
+ * файлы журнала, нужные для восстановления копии, могут быть удалены между
+ * копированием баз данных и копированием журнала. Архивацию внешними
+ * средствами (db_archive -d) LogArchiveGuard не останавливает.
+ */
+class LogArchiveGuard {
+ public:
+  /**
+   * @brief Конструктор класса, дожидается завершения архивации, которая
+   * уже выполняется
+   */
+  explicit LogArchiveGuard(DbEnv* env);
+  ~LogArchiveGuard();
+
+ private:
+  LogArchiveGuard(const LogArchiveGuard&) = delete;
+  LogArchiveGuard& operator=(const LogArchiveGuard&) = delete;
+
+ private:
+  DbEnv* mEnv;
+};
+
+/**
+ * Обслуживает журнал транзакционного окружения: записывает контрольные
+ * точки по порогам объема журнала и времени (txn_checkpoint) и удаляет или
+ * переносит в архив файлы журнала, которые больше не нужны для
+ * восстановления (log_archive).
+ *
+ * Без контрольных точек восстановление при DB_RECOVER читает весь журнал с
+ * момента создания окружения, а файлы журнала накапливаются на диске.
+ * Ограничение maxRecoveryTime принудительно записывает контрольную точку,
+ * если оценка времени восстановления превышает его, поэтому время запуска
+ * после сбоя не зависит от времени работы приложения.
+ *
+ * Проход выполняется вызовом maintain() или в фоновом потоке, если задан
+ * interval.
+ */
+class LogMaintenance {
+ public:
+  struct Options {
+    /// объем журнала в КБ, после которого записывается контрольная точка
+    std::uint32_t checkpointKBytes = 8 * 1024;
+    /// время в минутах, после которого записывается контрольная точка
+    std::uint32_t checkpointMinutes = 5;
+    /// предел оценки времени восстановления, 0 - без ограничения
+    std::chrono::milliseconds maxRecoveryTime{0};
+    /// скорость чтения журнала при восстановлении, используется для оценки
+    std::uint64_t recoveryBytesPerSecond = 32 * 1024 * 1024;
+    LogArchiveMode archiveMode = LogArchiveMode::Remove;
+    /// каталог архива для LogArchiveMode::Move
+    std::string archiveDirectory;
+    /// период фонового обслуживания, 0 - фоновый поток не запускается
+    std::chrono::milliseconds interval{0};
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param env открытое транзакционное окружение
+   * @param options пороги и режим архивации
+   * @throws std::invalid_argument, если для LogArchiveMode::Move не задан
+   * каталог архива или скорость восстановления равна 0
+   */
+  LogMaintenance(DbEnv* env, Options options);
+  explicit LogMaintenance(DbEnv* env);
+  ~LogMaintenance();
+
+ private:
+  LogMaintenance(const LogMaintenance&) = delete;
+  LogMaintenance& operator=(const LogMaintenance&) = delete;
+
+ public:
+  /**
+   * @brief Записывает контрольную точку, если превышен один из порогов или
+   * оценка времени восстановления, затем архивирует журнал
+   * @throws std::runtime_error при ошибке Berkeley DB или ввода-вывода
+   */
+  MaintenanceReport maintain();
+
+  /**
+   * @brief Записывает контрольную точку
+   * @param force записать независимо от порогов
+   * @return true, если контрольная точка была записана
+   */
+  bool checkpoint(bool force = false);
+
+  /**
+   * @brief Удаляет или переносит файлы журнала, не нужные для
+   * восстановления, в соответствии с Options::archiveMode. Пока для
+   * окружения существует LogArchiveGuard, файлы не обрабатываются.
+   * @return количество обработанных файлов
+   */
+  std::size_t archiveLogs();
+
+  /**
+   * @brief Оценивает стоимость восстановления по текущему состоянию журнала
+   */
+  RecoveryEstimate recoveryEstimate() const;
+
+ private:
+  bool checkpointLocked(bool force);
+  std::size_t archiveLogsLocked();
+  DB_LSN lastCheckpoint() const;
+  void maintenanceLoop();
+
+ private:
+  DbEnv* mEnv;
+  Options mOptions;
+  std::mutex mMutex;
+
+  std::mutex mStopMutex;
+  std::condition_variable mStopCondition;
+  bool mStopped = false;
+  std::thread mThread;
+};
+}  // namespace prstorage
+
+#endif  // LOGMAINTENANCE_H
@@ -0,0 +1,20 @@
+#ifndef PRESET_H
+#define PRESET_H
+
+namespace prstorage {
+/**
+ * Набор настроек окружения и баз данных под характер нагрузки
+ */
+enum class Preset {
+  /// умеренный кеш, размеры страниц Berkeley DB по умолчанию
+  Default,
+  /// большой кеш, крупные страницы и отображение файлов в память
+  ReadHeavy,
+  /// большой буфер журнала и увеличенные таблицы блокировок
+  WriteHeavy,
+  /// минимальный кеш для встраиваемых систем и тестов
+  LowMemory
+};
+}  // namespace prstorage
+
+#endif  // PRESET_H
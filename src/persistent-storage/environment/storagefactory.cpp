@@ -0,0 +1,139 @@
+#include "storagefactory.h"
+
+#include <dbstl_common.h>
+#include <stdexcept>
+
+#include "persistent-storage/storages/threadregistry.h"
+
+using namespace prstorage;
+
+namespace {
+constexpr std::uint32_t MIN_PAGE_SIZE = 512;
+constexpr std::uint32_t MAX_PAGE_SIZE = 64 * 1024;
+
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+}  // namespace
+
+DatabaseSettings DatabaseSettings::forPreset(Preset preset)
+{
+  DatabaseSettings settings;
+  switch (preset) {
+    case Preset::Default:
+      break;
+    case Preset::ReadHeavy:
+      // меньше уровней B-дерева и чтений на один поиск
+      settings.pageSize = 16 * 1024;
+      break;
+    case Preset::WriteHeavy:
+    case Preset::LowMemory:
+      // меньше данных переписывается и блокируется на одну запись
+      settings.pageSize = 4 * 1024;
+      break;
+  }
+  return settings;
+}
+
+void DatabaseSettings::validate() const
+{
+  if (pageSize != 0 &&
+      (pageSize < MIN_PAGE_SIZE || pageSize > MAX_PAGE_SIZE ||
+       (pageSize & (pageSize - 1)) != 0)) {
+    throw std::invalid_argument(
+        "page size must be a power of two between 512 and 65536");
+  }
+  if (minKeysPerPage != 0 && (type != DB_BTREE || minKeysPerPage < 2)) {
+    throw std::invalid_argument(
+        "min keys per page requires a btree and must be at least 2");
+  }
+  if (fillFactor != 0 && type != DB_HASH) {
+    throw std::invalid_argument("fill factor requires a hash database");
+  }
+}
+
+StorageFactory::StorageFactory(DbEnv* env, DatabaseSettings defaults) :
+    mEnv(env), mDefaults(std::move(defaults))
+{
+  mDefaults.validate();
+}
+
+StorageFactory::StorageFactory(DbEnv* env, Preset preset) :
+    StorageFactory(env, DatabaseSettings::forPreset(preset))
+{
+}
+
+Db* StorageFactory::openDatabase(const std::string& file,
+                                 const std::string& name) const
+{
+  return openDatabase(file, name, mDefaults);
+}
+
+Db* StorageFactory::openDatabase(const std::string& file,
+                                 const std::string& name,
+                                 const DatabaseSettings& settings) const
+{
+  settings.validate();
+
+  auto db = std::make_unique<Db>(mEnv, DB_CXX_NO_EXCEPTIONS);
+  if (settings.pageSize) {
+    check(db->set_pagesize(settings.pageSize));
+  }
+  if (settings.minKeysPerPage) {
+    check(db->set_bt_minkey(settings.minKeysPerPage));
+  }
+  if (settings.fillFactor) {
+    check(db->set_h_ffactor(settings.fillFactor));
+  }
+  if (settings.flags) {
+    check(db->set_flags(settings.flags));
+  }
+
+  if (auto ret = db->open(nullptr, file.c_str(), name.c_str(), settings.type,
+                          settings.openFlags, 0600);
+      ret != 0) {
+    db->close(0);
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+  if (settings.priority != DB_PRIORITY_UNCHANGED) {
+    if (auto ret = db->set_priority(settings.priority); ret != 0) {
+      db->close(0);
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+  }
+
+  dbstl::register_db(db.get());
+  return db.release();
+}
+
+Db* StorageFactory::openSecondary(
+    Db* primary,
+    const std::string& file,
+    const std::string& name,
+    int (*callback)(Db*, const Dbt*, const Dbt*, Dbt*)) const
+{
+  auto settings = mDefaults;
+  settings.flags |= DB_DUP;
+  auto secondary = openDatabase(file, name, settings);
+  if (auto ret = primary->associate(nullptr, secondary, callback, DB_CREATE);
+      ret != 0) {
+    // handle уже зарегистрирован в dbstl, поэтому закрывается через close_db
+    ThreadRegistry::invalidate();
+    dbstl::close_db(secondary);
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+  return secondary;
+}
+
+DbEnv* StorageFactory::env() const noexcept
+{
+  return mEnv;
+}
+
+const DatabaseSettings& StorageFactory::defaults() const noexcept
+{
+  return mDefaults;
+}
@@ -0,0 +1,143 @@
+#ifndef STORAGEFACTORY_H
+#define STORAGEFACTORY_H
+
+#include <db_cxx.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "preset.h"
+
+namespace prstorage {
+/**
+ * Параметры базы данных. Нулевое значение означает значение Berkeley DB по
+ * умолчанию.
+ */
+struct DatabaseSettings {
+  DBTYPE type = DB_BTREE;
+  /// размер страницы, степень двойки от 512 до 65536
+  std::uint32_t pageSize = 0;
+  /// минимальное количество ключей на странице B-дерева
+  std::uint32_t minKeysPerPage = 0;
+  /// желаемое количество элементов в ячейке хеш-таблицы
+  std::uint32_t fillFactor = 0;
+  /// флаги Db::set_flags, например DB_DUP
+  std::uint32_t flags = 0;
+  /// приоритет страниц базы в кеше, для таблиц, которые читаются только
+  /// полным обходом, - DB_PRIORITY_VERY_LOW
+  DB_CACHE_PRIORITY priority = DB_PRIORITY_UNCHANGED;
+  /// флаги Db::open
+  std::uint32_t openFlags = DB_CREATE | DB_THREAD | DB_AUTO_COMMIT;
+
+  /**
+   * @brief Возвращает параметры для набора настроек preset
+   */
+  static DatabaseSettings forPreset(Preset preset);
+
+  /**
+   * @brief Проверяет согласованность параметров
+   * @throws std::invalid_argument при недопустимом значении
+   */
+  void validate() const;
+};
+
+/**
+ * Открывает базы данных в окружении с заданными параметрами, регистрирует
+ * их в dbstl и создает хранилища.
+ *
+ * Пример:
+ *   StorageFactory factory(env, Preset::ReadHeavy);
+ *   auto contacts = factory.makeStorage<ContactStorage>("app.db", "contacts");
+ *
+ * Базы данных закрываются вызовом dbstl::dbstl_exit().
+ */
+class StorageFactory {
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param env открытое окружение
+   * @param defaults параметры баз данных по умолчанию
+   */
+  explicit StorageFactory(DbEnv* env,
+                          DatabaseSettings defaults = DatabaseSettings());
+  StorageFactory(DbEnv* env, Preset preset);
+
+ public:
+  /**
+   * @brief Открывает базу данных с параметрами по умолчанию
+   * @throws std::invalid_argument при недопустимых параметрах
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  Db* openDatabase(const std::string& file, const std::string& name) const;
+  Db* openDatabase(const std::string& file,
+                   const std::string& name,
+                   const DatabaseSettings& settings) const;
+
+  /**
+   * @brief Открывает вторичную базу данных с дубликатами и связывает ее с
+   * primary
+   * @param callback возвращает вторичный ключ записи primary
+   * @throws std::runtime_error при ошибке Berkeley DB; если связать базы
+   * данных не удалось, открытая вторичная база данных закрывается
+   */
+  Db* openSecondary(Db* primary,
+                    const std::string& file,
+                    const std::string& name,
+                    int (*callback)(Db*, const Dbt*, const Dbt*, Dbt*)) const;
+
+  /**
+   * @brief Открывает базу данных и создает хранилище StorageType(db, env,
+   * args...), например Storage или NativeStorage
+   */
+  template <typename StorageType, typename... Args>
+  std::shared_ptr<StorageType> makeStorage(const std::string& file,
+                                           const std::string& name,
+                                           Args&&... args) const;
+
+  /**
+   * @brief Открывает основную и вторичную базы данных и создает хранилище
+   * ChildStorageType(db, secondary, env, args...)
+   */
+  template <typename ChildStorageType, typename... Args>
+  std::shared_ptr<ChildStorageType> makeChildStorage(
+      const std::string& file,
+      const std::string& name,
+      const std::string& secondaryName,
+      int (*callback)(Db*, const Dbt*, const Dbt*, Dbt*),
+      Args&&... args) const;
+
+  DbEnv* env() const noexcept;
+  const DatabaseSettings& defaults() const noexcept;
+
+ private:
+  DbEnv* mEnv;
+  DatabaseSettings mDefaults;
+};
+}  // namespace prstorage
+
+template <typename StorageType, typename... Args>
+std::shared_ptr<StorageType> prstorage::StorageFactory::makeStorage(
+    const std::string& file,
+    const std::string& name,
+    Args&&... args) const
+{
+  return std::make_shared<StorageType>(openDatabase(file, name), mEnv,
+                                       std::forward<Args>(args)...);
+}
+
+template <typename ChildStorageType, typename... Args>
+std::shared_ptr<ChildStorageType> prstorage::StorageFactory::makeChildStorage(
+    const std::string& file,
+    const std::string& name,
+    const std::string& secondaryName,
+    int (*callback)(Db*, const Dbt*, const Dbt*, Dbt*),
+    Args&&... args) const
+{
+  auto db = openDatabase(file, name);
+  auto secondary = openSecondary(db, file, secondaryName, callback);
+  return std::make_shared<ChildStorageType>(db, secondary, mEnv,
+                                            std::forward<Args>(args)...);
+}
+
+#endif  // STORAGEFACTORY_H
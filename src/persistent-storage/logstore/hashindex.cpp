@@ -0,0 +1,117 @@
+#include "hashindex.h"
+
+using namespace prstorage;
+
+namespace {
+constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+std::size_t round_capacity(std::size_t capacity)
+{
+  std::size_t res = 16;
+  while (res < capacity) {
+    res <<= 1;
+  }
+  return res;
+}
+}  // namespace
+
+HashIndex::HashIndex(std::size_t capacity) : mSlots(round_capacity(capacity))
+{
+}
+
+const RecordLocation* HashIndex::find(std::string_view key) const
+{
+  auto pos = findSlot(key, hash(key));
+  return pos == NOT_FOUND ? nullptr : &mSlots[pos].location;
+}
+
+void HashIndex::assign(std::string_view key, const RecordLocation& location)
+{
+  auto keyHash = hash(key);
+  if (auto pos = findSlot(key, keyHash); pos != NOT_FOUND) {
+    mSlots[pos].location = location;
+    return;
+  }
+
+  // коэффициент заполнения вместе с удаленными ячейками не превышает 0.7
+  if ((mUsed + 1) * 10 > mSlots.size() * 7) {
+    rehash(mSize * 2 >= mSlots.size() / 2 ? mSlots.size() * 2
+                                          : mSlots.size());
+  }
+
+  const auto mask = mSlots.size() - 1;
+  auto pos = keyHash & mask;
+  while (mSlots[pos].state == SlotState::FULL) {
+    pos = (pos + 1) & mask;
+  }
+  if (mSlots[pos].state == SlotState::EMPTY) {
+    ++mUsed;
+  }
+  mSlots[pos].state = SlotState::FULL;
+  mSlots[pos].hash = keyHash;
+  mSlots[pos].key.assign(key.data(), key.size());
+  mSlots[pos].location = location;
+  ++mSize;
+}
+
+bool HashIndex::erase(std::string_view key)
+{
+  if (auto pos = findSlot(key, hash(key)); pos != NOT_FOUND) {
+    mSlots[pos].state = SlotState::DELETED;
+    mSlots[pos].key.clear();
+    mSlots[pos].key.shrink_to_fit();
+    --mSize;
+    return true;
+  }
+  return false;
+}
+
+std::size_t HashIndex::size() const noexcept
+{
+  return mSize;
+}
+
+std::uint64_t HashIndex::hash(std::string_view key) noexcept
+{
+  // FNV-1a
+  std::uint64_t res = 14695981039346656037ull;
+  for (auto ch : key) {
+    res ^= static_cast<unsigned char>(ch);
+    res *= 1099511628211ull;
+  }
+  return res;
+}
+
+std::size_t HashIndex::findSlot(std::string_view key,
+                                std::uint64_t keyHash) const
+{
+  const auto mask = mSlots.size() - 1;
+  auto pos = keyHash & mask;
+  while (mSlots[pos].state != SlotState::EMPTY) {
+    const auto& slot = mSlots[pos];
+    if (slot.state == SlotState::FULL && slot.hash == keyHash &&
+        slot.key == key) {
+      return pos;
+    }
+    pos = (pos + 1) & mask;
+  }
+  return NOT_FOUND;
+}
+
+void HashIndex::rehash(std::size_t capacity)
+{
+  std::vector<Slot> slots(round_capacity(capacity));
+  const auto mask = slots.size() - 1;
+  for (auto& slot : mSlots) {
+    if (slot.state != SlotState::FULL) {
+      continue;
+    }
+    auto pos = slot.hash & mask;
+    while (slots[pos].state == SlotState::FULL) {
+      pos = (pos + 1) & mask;
+    }
+    slots[pos] = std::move(slot);
+  }
+  mSlots = std::move(slots);
+  mUsed = mSize;
+}
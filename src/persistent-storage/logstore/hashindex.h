@@ -0,0 +1,98 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Положение записи в файлах сегментов LogStore
+ */
+struct RecordLocation {
+  std::uint32_t segment;
+  std::uint64_t offset;
+  std::uint32_t size;
+};
+
+inline bool operator==(const RecordLocation& first,
+                       const RecordLocation& second)
+{
+  return first.segment == second.segment && first.offset == second.offset &&
+         first.size == second.size;
+}
+
+/**
+ * Хеш-таблица с открытой адресацией и линейным пробированием, которая
+ * сопоставляет ключу положение его последней записи.
+ */
+class HashIndex {
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param capacity начальное количество ячеек, округляется до степени двойки
+   */
+  explicit HashIndex(std::size_t capacity = 1024);
+
+ public:
+  /**
+   * @brief Ищет положение записи по ключу
+   * @return указатель на положение или nullptr, если ключ отсутствует.
+   * Указатель действителен до следующего изменения таблицы.
+   */
+  const RecordLocation* find(std::string_view key) const;
+
+  /**
+   * @brief Добавляет ключ или обновляет его положение
+   */
+  void assign(std::string_view key, const RecordLocation& location);
+
+  /**
+   * @brief Удаляет ключ
+   * @return true, если ключ присутствовал
+   */
+  bool erase(std::string_view key);
+
+  std::size_t size() const noexcept;
+
+  /**
+   * @brief Обходит все ключи таблицы
+   * @param callback функция void(std::string_view, const RecordLocation&)
+   */
+  template <typename Callback>
+  void forEach(Callback&& callback) const;
+
+ private:
+  enum class SlotState : unsigned char { EMPTY, FULL, DELETED };
+
+  struct Slot {
+    SlotState state = SlotState::EMPTY;
+    std::uint64_t hash = 0;
+    std::string key;
+    RecordLocation location{};
+  };
+
+ private:
+  static std::uint64_t hash(std::string_view key) noexcept;
+  std::size_t findSlot(std::string_view key, std::uint64_t keyHash) const;
+  void rehash(std::size_t capacity);
+
+ private:
+  std::vector<Slot> mSlots;
+  std::size_t mSize = 0;
+  std::size_t mUsed = 0;
+};
+}  // namespace prstorage
+
+template <typename Callback>
+void prstorage::HashIndex::forEach(Callback&& callback) const
+{
+  for (const auto& slot : mSlots) {
+    if (slot.state == SlotState::FULL) {
+      callback(std::string_view(slot.key), slot.location);
+    }
+  }
+}
+
+#endif  // HASHINDEX_H
@@ -0,0 +1,623 @@
+#include "logstore.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "persistent-storage/utils/crc32.h"
+
+using namespace prstorage;
+
+namespace {
+/**
+ * Формат записи:
+ *   crc32 (4 байта) - контрольная сумма всех последующих байт записи
+ *   flags (1 байт) - RECORD_TOMBSTONE для удаленных ключей
+ *   размер ключа (4 байта)
+ *   размер значения (4 байта)
+ *   ключ
+ *   значение
+ */
+constexpr std::size_t RECORD_HEADER_SIZE = 13;
+constexpr unsigned char RECORD_TOMBSTONE = 0x01;
+
+/**
+ * Файл подсказок состоит из записей
+ *   размер ключа (4 байта), смещение (8 байт), размер записи (4 байта), ключ
+ * и завершается crc32 всего предыдущего содержимого.
+ */
+constexpr std::size_t HINT_HEADER_SIZE = 16;
+
+constexpr const char* SEGMENT_EXT = ".seg";
+constexpr const char* HINT_EXT = ".hint";
+constexpr const char* COMPACTED_SEGMENT_EXT = ".cseg";
+constexpr const char* COMPACTED_HINT_EXT = ".chint";
+constexpr const char* TMP_EXT = ".tmp";
+
+template <typename T>
+T read_value(const char* src)
+{
+  T value;
+  std::memcpy(&value, src, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void append_value(std::string& dest, T value)
+{
+  dest.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+[[noreturn]] void throw_errno(const std::string& operation,
+                              const std::string& path)
+{
+  throw std::runtime_error(operation + " " + path + ": " +
+                           std::strerror(errno));
+}
+
+void remove_file(const std::string& path)
+{
+  if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+    throw_errno("unlink", path);
+  }
+}
+
+bool file_exists(const std::string& path)
+{
+  struct stat info;
+  return ::stat(path.c_str(), &info) == 0;
+}
+
+void rename_file(const std::string& from, const std::string& to)
+{
+  if (::rename(from.c_str(), to.c_str()) != 0) {
+    throw_errno("rename", from);
+  }
+}
+
+void sync_directory(const std::string& directory)
+{
+  auto fd = ::open(directory.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw_errno("open", directory);
+  }
+  ::fsync(fd);
+  ::close(fd);
+}
+
+void write_file(const std::string& path, const std::string& content)
+{
+  auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    throw_errno("create", path);
+  }
+  std::size_t written = 0;
+  while (written < content.size()) {
+    auto res =
+        ::write(fd, content.data() + written, content.size() - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      throw_errno("write", path);
+    }
+    written += static_cast<std::size_t>(res);
+  }
+  if (::fsync(fd) != 0) {
+    ::close(fd);
+    throw_errno("sync", path);
+  }
+  ::close(fd);
+}
+
+std::string read_file(const std::string& path)
+{
+  std::string res;
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw_errno("open", path);
+  }
+  char buffer[64 * 1024];
+  while (true) {
+    auto count = ::read(fd, buffer, sizeof(buffer));
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      throw_errno("read", path);
+    }
+    if (count == 0) {
+      break;
+    }
+    res.append(buffer, static_cast<std::size_t>(count));
+  }
+  ::close(fd);
+  return res;
+}
+
+bool ends_with(const std::string& str, const std::string& suffix)
+{
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * Возвращает имена файлов каталога
+ */
+std::vector<std::string> list_directory(const std::string& directory)
+{
+  std::vector<std::string> res;
+  auto dir = ::opendir(directory.c_str());
+  if (!dir) {
+    throw_errno("opendir", directory);
+  }
+  while (auto entry = ::readdir(dir)) {
+    res.emplace_back(entry->d_name);
+  }
+  ::closedir(dir);
+  return res;
+}
+
+/**
+ * Возвращает идентификаторы файлов с расширением extension
+ */
+std::set<std::uint32_t> list_ids(const std::vector<std::string>& files,
+                                 const std::string& extension)
+{
+  std::set<std::uint32_t> res;
+  for (const auto& file : files) {
+    if (ends_with(file, extension) && file.size() > extension.size()) {
+      auto name = file.substr(0, file.size() - extension.size());
+      auto digit = [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c)) != 0;
+      };
+      if (std::all_of(name.begin(), name.end(), digit)) {
+        res.insert(static_cast<std::uint32_t>(std::stoul(name)));
+      }
+    }
+  }
+  return res;
+}
+}  // namespace
+
+LogStore::LogStore(std::string directory, Options options) :
+    mDirectory(std::move(directory)), mOptions(options)
+{
+  if (::mkdir(mDirectory.c_str(), 0700) != 0 && errno != EEXIST) {
+    throw_errno("mkdir", mDirectory);
+  }
+  load();
+
+  if (mOptions.compactionInterval.count() > 0) {
+    mCompactionThread = std::thread(&LogStore::compactionLoop, this);
+  }
+}
+
+LogStore::LogStore(std::string directory) :
+    LogStore(std::move(directory), Options())
+{
+}
+
+LogStore::~LogStore()
+{
+  {
+    std::lock_guard<std::mutex> lock(mStopMutex);
+    mStopped = true;
+  }
+  mStopCondition.notify_all();
+  if (mCompactionThread.joinable()) {
+    mCompactionThread.join();
+  }
+}
+
+bool LogStore::insert(std::string_view key, std::string_view value)
+{
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (mIndex.find(key)) {
+    return false;
+  }
+  indexRecord(key, appendRecord(key, value, false));
+  return true;
+}
+
+void LogStore::put(std::string_view key, std::string_view value)
+{
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  indexRecord(key, appendRecord(key, value, false));
+}
+
+bool LogStore::replace(std::string_view key, std::string_view value)
+{
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (!mIndex.find(key)) {
+    return false;
+  }
+  indexRecord(key, appendRecord(key, value, false));
+  return true;
+}
+
+bool LogStore::remove(std::string_view key)
+{
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (!mIndex.find(key)) {
+    return false;
+  }
+  appendRecord(key, std::string_view(), true);
+  unindexRecord(key);
+  return true;
+}
+
+bool LogStore::read(std::string_view key, const Reader& reader) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  auto location = mIndex.find(key);
+  if (!location) {
+    return false;
+  }
+  auto record = mSegments.at(location->segment)->data() + location->offset;
+  auto keySize = read_value<std::uint32_t>(record + 5);
+  auto valueSize = read_value<std::uint32_t>(record + 9);
+  reader(record + RECORD_HEADER_SIZE + keySize, valueSize);
+  return true;
+}
+
+bool LogStore::contains(std::string_view key) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mIndex.find(key) != nullptr;
+}
+
+std::size_t LogStore::size() const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mIndex.size();
+}
+
+void LogStore::forEach(const Visitor& visitor) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  bool proceed = true;
+  mIndex.forEach([this, &visitor, &proceed](std::string_view key,
+                                            const RecordLocation& location) {
+    if (!proceed) {
+      return;
+    }
+    auto record = mSegments.at(location.segment)->data() + location.offset;
+    auto keySize = read_value<std::uint32_t>(record + 5);
+    auto valueSize = read_value<std::uint32_t>(record + 9);
+    proceed = visitor(key, record + RECORD_HEADER_SIZE + keySize, valueSize);
+  });
+}
+
+void LogStore::compact()
+{
+  std::lock_guard<std::mutex> compactionLock(mCompactionMutex);
+
+  std::vector<std::pair<std::string, RecordLocation>> live;
+  std::map<std::uint32_t, std::shared_ptr<Segment>> merged;
+  std::uint64_t liveBytes = 0;
+  {
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    if (mActive->size() > 0) {
+      rotate(mOptions.maxSegmentSize);
+    }
+    for (const auto& [id, segment] : mSegments) {
+      if (segment != mActive) {
+        merged.emplace(id, segment);
+      }
+    }
+    if (merged.empty()) {
+      return;
+    }
+    mIndex.forEach([&live, &liveBytes](std::string_view key,
+                                       const RecordLocation& location) {
+      live.emplace_back(std::string(key), location);
+      liveBytes += location.size;
+    });
+  }
+
+  // все записи индекса, кроме новых, находятся в сегментах merged
+  const auto target = merged.rbegin()->first;
+  live.erase(std::remove_if(live.begin(), live.end(),
+                            [target](const auto& entry) {
+                              return entry.second.segment > target;
+                            }),
+             live.end());
+
+  if (live.empty()) {
+    // сжатый сегмент и подсказки не создаются: пустая пара файлов могла бы
+    // остаться после перезапуска и подменить записи сегмента, который
+    // получит тот же идентификатор
+    {
+      std::unique_lock<std::shared_mutex> lock(mMutex);
+      for (const auto& entry : merged) {
+        mTotalBytes -= entry.second->size();
+        mSegments.erase(entry.first);
+      }
+    }
+    // сегменты удаляются от старых к новым, поэтому после сбоя остаются
+    // только более новые записи и удаленные ключи не восстанавливаются
+    for (const auto& entry : merged) {
+      remove_file(segmentPath(entry.first, HINT_EXT));
+      remove_file(segmentPath(entry.first, SEGMENT_EXT));
+    }
+    sync_directory(mDirectory);
+    return;
+  }
+
+  auto output = std::make_shared<Segment>(
+      segmentPath(target, COMPACTED_SEGMENT_EXT), target, liveBytes);
+  std::vector<RecordLocation> locations;
+  locations.reserve(live.size());
+  std::string hint;
+  for (const auto& [key, location] : live) {
+    auto offset = output->append(
+        merged.at(location.segment)->data() + location.offset, location.size);
+    locations.push_back({target, offset, location.size});
+
+    append_value(hint, static_cast<std::uint32_t>(key.size()));
+    append_value(hint, offset);
+    append_value(hint, location.size);
+    hint.append(key);
+  }
+  append_value(hint, crc32(hint.data(), hint.size()));
+  output->sync();
+
+  // файл подсказок записывается последним и подтверждает сжатие
+  auto hintPath = segmentPath(target, COMPACTED_HINT_EXT);
+  write_file(hintPath + TMP_EXT, hint);
+  rename_file(hintPath + TMP_EXT, hintPath);
+  sync_directory(mDirectory);
+
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  for (std::size_t i = 0; i < live.size(); ++i) {
+    const auto& [key, location] = live[i];
+    if (auto current = mIndex.find(key); current && *current == location) {
+      mIndex.assign(key, locations[i]);
+    }
+  }
+  for (const auto& entry : merged) {
+    mTotalBytes -= entry.second->size();
+    mSegments.erase(entry.first);
+  }
+  finishCompaction(target);
+  output->renamed(segmentPath(target, SEGMENT_EXT));
+  mSegments.emplace(target, output);
+  mTotalBytes += output->size();
+}
+
+double LogStore::garbageRatio() const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  if (mTotalBytes == 0) {
+    return 0.0;
+  }
+  return 1.0 - static_cast<double>(mLiveBytes) / mTotalBytes;
+}
+
+void LogStore::load()
+{
+  auto files = list_directory(mDirectory);
+
+  // завершение сжатия, прерванного после записи файла подсказок; если
+  // .cseg уже переименован, остается только удалить исходные сегменты
+  for (auto id : list_ids(files, COMPACTED_HINT_EXT)) {
+    finishCompaction(id);
+  }
+  files = list_directory(mDirectory);
+  for (const auto& file : files) {
+    if (ends_with(file, COMPACTED_SEGMENT_EXT) || ends_with(file, TMP_EXT)) {
+      remove_file(mDirectory + "/" + file);
+    }
+  }
+
+  auto ids = list_ids(files, SEGMENT_EXT);
+  auto hints = list_ids(files, HINT_EXT);
+  for (auto it = ids.begin(); it != ids.end(); ++it) {
+    auto segment = std::make_shared<Segment>(segmentPath(*it, SEGMENT_EXT), *it);
+    if (segment->size() == 0) {
+      segment.reset();
+      // подсказки пустого сегмента не должны достаться сегменту, который
+      // получит тот же идентификатор
+      remove_file(segmentPath(*it, HINT_EXT));
+      remove_file(segmentPath(*it, SEGMENT_EXT));
+      continue;
+    }
+    if (!hints.count(*it) ||
+        !loadHint(*segment, segmentPath(*it, HINT_EXT))) {
+      scanSegment(*segment, std::next(it) == ids.end());
+    }
+    mTotalBytes += segment->size();
+    mSegments.emplace(*it, std::move(segment));
+  }
+
+  rotate(mOptions.maxSegmentSize);
+}
+
+void LogStore::finishCompaction(std::uint32_t target)
+{
+  // переименование .cseg в .seg - единственная точка подтверждения сжатия:
+  // до него на диске остаются исходные сегменты, после него выполняется
+  // только удаление устаревших файлов, которое можно повторить
+  auto compacted = segmentPath(target, COMPACTED_SEGMENT_EXT);
+  if (file_exists(compacted)) {
+    // подсказки исходного сегмента target не подходят для сжатых данных
+    remove_file(segmentPath(target, HINT_EXT));
+    rename_file(compacted, segmentPath(target, SEGMENT_EXT));
+    sync_directory(mDirectory);
+  }
+  for (auto id : list_ids(list_directory(mDirectory), SEGMENT_EXT)) {
+    if (id < target) {
+      remove_file(segmentPath(id, SEGMENT_EXT));
+      remove_file(segmentPath(id, HINT_EXT));
+    }
+  }
+  // .chint удаляется последним: пока он существует, load повторяет очистку
+  rename_file(segmentPath(target, COMPACTED_HINT_EXT),
+              segmentPath(target, HINT_EXT));
+  sync_directory(mDirectory);
+}
+
+bool LogStore::loadHint(const Segment& segment, const std::string& hintPath)
+{
+  auto hint = read_file(hintPath);
+  if (hint.size() < sizeof(std::uint32_t) ||
+      read_value<std::uint32_t>(hint.data() + hint.size() -
+                                sizeof(std::uint32_t)) !=
+          crc32(hint.data(), hint.size() - sizeof(std::uint32_t))) {
+    std::cerr << "Hint file " << hintPath
+              << " is corrupted, segment will be scanned" << std::endl;
+    remove_file(hintPath);
+    return false;
+  }
+
+  const auto end = hint.size() - sizeof(std::uint32_t);
+  std::size_t pos = 0;
+  while (pos + HINT_HEADER_SIZE <= end) {
+    auto keySize = read_value<std::uint32_t>(hint.data() + pos);
+    auto offset = read_value<std::uint64_t>(hint.data() + pos + 4);
+    auto size = read_value<std::uint32_t>(hint.data() + pos + 12);
+    indexRecord(std::string_view(hint.data() + pos + HINT_HEADER_SIZE, keySize),
+                {segment.id(), offset, size});
+    pos += HINT_HEADER_SIZE + keySize;
+  }
+  return true;
+}
+
+void LogStore::scanSegment(Segment& segment, bool last)
+{
+  const auto data = segment.data();
+  const auto size = segment.size();
+  std::uint64_t offset = 0;
+  while (offset < size) {
+    bool valid = offset + RECORD_HEADER_SIZE <= size;
+    std::uint32_t keySize = 0;
+    std::uint32_t valueSize = 0;
+    std::uint64_t recordSize = 0;
+    if (valid) {
+      keySize = read_value<std::uint32_t>(data + offset + 5);
+      valueSize = read_value<std::uint32_t>(data + offset + 9);
+      recordSize = RECORD_HEADER_SIZE + std::uint64_t{keySize} + valueSize;
+      valid = offset + recordSize <= size &&
+              read_value<std::uint32_t>(data + offset) ==
+                  crc32(data + offset + 4, recordSize - 4);
+    }
+
+    if (!valid) {
+      if (!last) {
+        throw std::runtime_error("corrupted segment " + segment.path());
+      }
+      std::cerr << "Segment " << segment.path() << " truncated at " << offset
+                << " after incomplete write" << std::endl;
+      segment.truncate(offset);
+      return;
+    }
+
+    std::string_view key(data + offset + RECORD_HEADER_SIZE, keySize);
+    if (data[offset + 4] & RECORD_TOMBSTONE) {
+      unindexRecord(key);
+    } else {
+      indexRecord(key, {segment.id(), offset,
+                        static_cast<std::uint32_t>(recordSize)});
+    }
+    offset += recordSize;
+  }
+}
+
+RecordLocation LogStore::appendRecord(std::string_view key,
+                                      std::string_view value,
+                                      bool tombstone)
+{
+  static thread_local std::string record;
+  record.clear();
+  append_value(record, std::uint32_t{0});
+  record.push_back(static_cast<char>(tombstone ? RECORD_TOMBSTONE : 0));
+  append_value(record, static_cast<std::uint32_t>(key.size()));
+  append_value(record, static_cast<std::uint32_t>(value.size()));
+  record.append(key.data(), key.size());
+  record.append(value.data(), value.size());
+  auto crc = crc32(record.data() + 4, record.size() - 4);
+  std::memcpy(&record[0], &crc, sizeof(crc));
+
+  if (!mActive->fits(record.size())) {
+    rotate(std::max<std::uint64_t>(mOptions.maxSegmentSize, record.size()));
+  }
+  auto offset = mActive->append(record.data(), record.size());
+  if (mOptions.syncWrites) {
+    mActive->sync();
+  }
+  mTotalBytes += record.size();
+  return {mActive->id(), offset, static_cast<std::uint32_t>(record.size())};
+}
+
+void LogStore::rotate(std::uint64_t minCapacity)
+{
+  if (mActive) {
+    mActive->sync();
+  }
+  std::uint32_t id = mSegments.empty() ? 1 : mSegments.rbegin()->first + 1;
+  mActive = std::make_shared<Segment>(segmentPath(id, SEGMENT_EXT), id,
+                                      minCapacity);
+  mSegments.emplace(id, mActive);
+  sync_directory(mDirectory);
+}
+
+void LogStore::indexRecord(std::string_view key,
+                           const RecordLocation& location)
+{
+  if (auto current = mIndex.find(key)) {
+    mLiveBytes -= current->size;
+  }
+  mIndex.assign(key, location);
+  mLiveBytes += location.size;
+}
+
+void LogStore::unindexRecord(std::string_view key)
+{
+  if (auto current = mIndex.find(key)) {
+    mLiveBytes -= current->size;
+    mIndex.erase(key);
+  }
+}
+
+std::string LogStore::segmentPath(std::uint32_t id,
+                                  const char* extension) const
+{
+  char name[16];
+  std::snprintf(name, sizeof(name), "%010u", id);
+  return mDirectory + "/" + name + extension;
+}
+
+void LogStore::compactionLoop()
+{
+  std::unique_lock<std::mutex> lock(mStopMutex);
+  while (!mStopped) {
+    mStopCondition.wait_for(lock, mOptions.compactionInterval);
+    if (mStopped) {
+      break;
+    }
+    lock.unlock();
+    try {
+      if (garbageRatio() >= mOptions.compactionThreshold) {
+        compact();
+      }
+    } catch (const std::exception& ex) {
+      std::cerr << "Get exception when try to compact log store : "
+                << ex.what() << std::endl;
+    }
+    lock.lock();
+  }
+}
@@ -0,0 +1,148 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "hashindex.h"
+#include "segment.h"
+
+namespace prstorage {
+/**
+ * Хранилище ключ/значение со структурой журнала (по образцу Bitcask).
+ *
+ * Записи дописываются в активный сегмент, каждая запись защищена CRC-32.
+ * Чтение выполняется через отображение сегментов в память, положение
+ * последней записи каждого ключа хранится в HashIndex. Удаление записывает
+ * в журнал запись-надгробие.
+ *
+ * Сжатие переписывает живые записи всех неактивных сегментов в один сегмент
+ * и создает для него файл подсказок (hint), по которому индекс
+ * восстанавливается при запуске без чтения самих записей. Сжатие может
+ * выполняться в фоновом потоке, когда доля устаревших данных превышает
+ * порог.
+ *
+ * После сбоя недописанная запись в конце последнего сегмента отбрасывается.
+ */
+class LogStore {
+ public:
+  struct Options {
+    /// максимальный размер одного сегмента
+    std::uint64_t maxSegmentSize = 64 * 1024 * 1024;
+    /// выполнять fdatasync после каждой записи
+    bool syncWrites = true;
+    /// доля устаревших данных, при которой фоновый поток выполняет сжатие
+    double compactionThreshold = 0.5;
+    /// период проверки в фоновом потоке, 0 - фоновое сжатие выключено
+    std::chrono::milliseconds compactionInterval{0};
+  };
+
+  using Reader = std::function<void(const char* data, std::size_t size)>;
+  using Visitor = std::function<
+      bool(std::string_view key, const char* data, std::size_t size)>;
+
+ public:
+  /**
+   * @brief Открывает или создает хранилище в каталоге directory
+   * @throws std::runtime_error при ошибке ввода-вывода или повреждении
+   * сегмента, который не является последним
+   */
+  explicit LogStore(std::string directory, Options options);
+  explicit LogStore(std::string directory);
+  ~LogStore();
+
+ private:
+  LogStore(const LogStore&) = delete;
+  LogStore& operator=(const LogStore&) = delete;
+
+ public:
+  /**
+   * @brief Добавляет значение, если ключ отсутствует
+   * @return false, если ключ уже существует
+   */
+  bool insert(std::string_view key, std::string_view value);
+
+  /**
+   * @brief Добавляет или перезаписывает значение
+   */
+  void put(std::string_view key, std::string_view value);
+
+  /**
+   * @brief Перезаписывает значение, только если ключ существует
+   */
+  bool replace(std::string_view key, std::string_view value);
+
+  /**
+   * @brief Удаляет ключ
+   * @return true, если ключ существовал
+   */
+  bool remove(std::string_view key);
+
+  /**
+   * @brief Передает значение ключа в reader без копирования
+   * @return false, если ключ отсутствует
+   */
+  bool read(std::string_view key, const Reader& reader) const;
+  bool contains(std::string_view key) const;
+  std::size_t size() const;
+
+  /**
+   * @brief Обходит все живые записи. visitor не должен изменять хранилище,
+   * обход прекращается, когда visitor возвращает false.
+   */
+  void forEach(const Visitor& visitor) const;
+
+  /**
+   * @brief Переписывает живые записи неактивных сегментов в один сегмент и
+   * удаляет старые сегменты
+   */
+  void compact();
+
+  /**
+   * @brief Возвращает долю устаревших данных в сегментах
+   */
+  double garbageRatio() const;
+
+ private:
+  void load();
+  void finishCompaction(std::uint32_t target);
+  bool loadHint(const Segment& segment, const std::string& hintPath);
+  void scanSegment(Segment& segment, bool last);
+  RecordLocation appendRecord(std::string_view key,
+                              std::string_view value,
+                              bool tombstone);
+  void rotate(std::uint64_t minCapacity);
+  void indexRecord(std::string_view key, const RecordLocation& location);
+  void unindexRecord(std::string_view key);
+  std::string segmentPath(std::uint32_t id, const char* extension) const;
+  void compactionLoop();
+
+ private:
+  std::string mDirectory;
+  Options mOptions;
+
+  mutable std::shared_mutex mMutex;
+  HashIndex mIndex;
+  std::map<std::uint32_t, std::shared_ptr<Segment>> mSegments;
+  std::shared_ptr<Segment> mActive;
+  std::uint64_t mLiveBytes = 0;
+  std::uint64_t mTotalBytes = 0;
+
+  std::mutex mCompactionMutex;
+  std::mutex mStopMutex;
+  std::condition_variable mStopCondition;
+  bool mStopped = false;
+  std::thread mCompactionThread;
+};
+}  // namespace prstorage
+
+#endif  // LOGSTORE_H
@@ -0,0 +1,166 @@
+#ifndef LOGTABLE_H
+#define LOGTABLE_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "logstore.h"
+#include "persistent-storage/utils/keycodec.h"
+
+namespace prstorage {
+/**
+ * Типизированная обертка над LogStore: кодирует ключи через KeyCodec, а
+ * значения - экземпляром Marshaller.
+ */
+template <typename Key, typename Element, typename Marshaller>
+class LogTable {
+ public:
+  LogTable(std::shared_ptr<LogStore> store,
+           Marshaller marshaller = Marshaller());
+
+ public:
+  bool insert(const Key& key, const Element& elem);
+  void put(const Key& key, const Element& elem);
+  bool replace(const Key& key, const Element& elem);
+  std::optional<Element> get(const Key& key) const;
+  bool exists(const Key& key) const;
+  bool del(const Key& key);
+  std::optional<Element> take(const Key& key);
+
+  /**
+   * @brief Обходит все элементы
+   * @param callback функция bool(const Element&), обход прекращается, когда
+   * она возвращает false
+   */
+  template <typename Callback>
+  void forEach(Callback&& callback) const;
+  std::size_t count() const;
+
+  const std::shared_ptr<LogStore>& store() const noexcept;
+
+ private:
+  std::string_view encode(const Element& elem) const;
+  Element decode(const char* data) const;
+
+ private:
+  std::shared_ptr<LogStore> mStore;
+  Marshaller mMarshaller;
+};
+}  // namespace prstorage
+
+template <typename Key, typename Element, typename Marshaller>
+prstorage::LogTable<Key, Element, Marshaller>::LogTable(
+    std::shared_ptr<LogStore> store,
+    Marshaller marshaller) :
+    mStore(std::move(store)),
+    mMarshaller(std::move(marshaller))
+{
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::LogTable<Key, Element, Marshaller>::insert(const Key& key,
+                                                           const Element& elem)
+{
+  return mStore->insert(KeyCodec<Key>::encode(key), encode(elem));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+void prstorage::LogTable<Key, Element, Marshaller>::put(const Key& key,
+                                                        const Element& elem)
+{
+  mStore->put(KeyCodec<Key>::encode(key), encode(elem));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::LogTable<Key, Element, Marshaller>::replace(
+    const Key& key,
+    const Element& elem)
+{
+  return mStore->replace(KeyCodec<Key>::encode(key), encode(elem));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::optional<Element> prstorage::LogTable<Key, Element, Marshaller>::get(
+    const Key& key) const
+{
+  std::optional<Element> res;
+  mStore->read(KeyCodec<Key>::encode(key),
+               [this, &res](const char* data, std::size_t /* size */) {
+                 res = decode(data);
+               });
+  return res;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::LogTable<Key, Element, Marshaller>::exists(
+    const Key& key) const
+{
+  return mStore->contains(KeyCodec<Key>::encode(key));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::LogTable<Key, Element, Marshaller>::del(const Key& key)
+{
+  return mStore->remove(KeyCodec<Key>::encode(key));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::optional<Element> prstorage::LogTable<Key, Element, Marshaller>::take(
+    const Key& key)
+{
+  auto res = get(key);
+  if (res && !del(key)) {
+    return {};
+  }
+  return res;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+template <typename Callback>
+void prstorage::LogTable<Key, Element, Marshaller>::forEach(
+    Callback&& callback) const
+{
+  mStore->forEach([this, &callback](std::string_view /* key */,
+                                    const char* data, std::size_t /* size */) {
+    return callback(decode(data));
+  });
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::size_t prstorage::LogTable<Key, Element, Marshaller>::count() const
+{
+  return mStore->size();
+}
+
+template <typename Key, typename Element, typename Marshaller>
+const std::shared_ptr<prstorage::LogStore>&
+prstorage::LogTable<Key, Element, Marshaller>::store() const noexcept
+{
+  return mStore;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::string_view prstorage::LogTable<Key, Element, Marshaller>::encode(
+    const Element& elem) const
+{
+  static thread_local std::string buffer;
+  auto size = mMarshaller.size(elem);
+  if (buffer.size() < size) {
+    buffer.resize(size);
+  }
+  mMarshaller.store(&buffer[0], elem);
+  return std::string_view(buffer.data(), size);
+}
+
+template <typename Key, typename Element, typename Marshaller>
+Element prstorage::LogTable<Key, Element, Marshaller>::decode(
+    const char* data) const
+{
+  Element elem;
+  mMarshaller.restore(elem, data);
+  return elem;
+}
+
+#endif  // LOGTABLE_H
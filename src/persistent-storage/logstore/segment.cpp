@@ -0,0 +1,140 @@
+#include "segment.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+[[noreturn]] void throw_errno(const std::string& operation,
+                              const std::string& path)
+{
+  throw std::runtime_error(operation + " " + path + ": " +
+                           std::strerror(errno));
+}
+}  // namespace
+
+Segment::Segment(std::string path, std::uint32_t id) :
+    mPath(std::move(path)), mId(id)
+{
+  mFd = ::open(mPath.c_str(), O_RDWR);
+  if (mFd < 0) {
+    throw_errno("open", mPath);
+  }
+  struct stat st;
+  if (::fstat(mFd, &st) != 0) {
+    ::close(mFd);
+    throw_errno("stat", mPath);
+  }
+  mSize = static_cast<std::uint64_t>(st.st_size);
+  map(mSize);
+}
+
+Segment::Segment(std::string path, std::uint32_t id, std::uint64_t capacity) :
+    mPath(std::move(path)), mId(id)
+{
+  mFd = ::open(mPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (mFd < 0) {
+    throw_errno("create", mPath);
+  }
+  map(capacity);
+}
+
+Segment::~Segment()
+{
+  if (mData) {
+    ::munmap(mData, mMapSize);
+  }
+  if (mFd >= 0) {
+    ::close(mFd);
+  }
+}
+
+std::uint32_t Segment::id() const noexcept
+{
+  return mId;
+}
+
+const std::string& Segment::path() const noexcept
+{
+  return mPath;
+}
+
+std::uint64_t Segment::size() const noexcept
+{
+  return mSize;
+}
+
+const char* Segment::data() const noexcept
+{
+  return mData;
+}
+
+bool Segment::fits(std::uint64_t size) const noexcept
+{
+  return mSize + size <= mMapSize;
+}
+
+std::uint64_t Segment::append(const void* data, std::size_t size)
+{
+  if (!fits(size)) {
+    throw std::length_error("segment " + mPath + " is full");
+  }
+  auto offset = mSize;
+  auto src = static_cast<const char*>(data);
+  std::size_t written = 0;
+  while (written < size) {
+    auto res = ::pwrite(mFd, src + written, size - written,
+                        static_cast<off_t>(offset + written));
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_errno("write", mPath);
+    }
+    written += static_cast<std::size_t>(res);
+  }
+  mSize += size;
+  return offset;
+}
+
+void Segment::sync()
+{
+  if (::fdatasync(mFd) != 0) {
+    throw_errno("sync", mPath);
+  }
+}
+
+void Segment::truncate(std::uint64_t size)
+{
+  if (::ftruncate(mFd, static_cast<off_t>(size)) != 0) {
+    throw_errno("truncate", mPath);
+  }
+  mSize = size;
+}
+
+void Segment::renamed(std::string path)
+{
+  mPath = std::move(path);
+}
+
+void Segment::map(std::uint64_t length)
+{
+  mMapSize = length;
+  if (length == 0) {
+    return;
+  }
+  auto addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, mFd, 0);
+  if (addr == MAP_FAILED) {
+    ::close(mFd);
+    mFd = -1;
+    throw_errno("mmap", mPath);
+  }
+  mData = static_cast<char*>(addr);
+}
@@ -0,0 +1,83 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <cstdint>
+#include <string>
+
+namespace prstorage {
+/**
+ * Файл сегмента LogStore. Данные дописываются в конец файла, чтение
+ * выполняется через отображение файла в память.
+ */
+class Segment {
+ public:
+  /**
+   * @brief Открывает существующий сегмент только для чтения
+   * @param path путь к файлу
+   * @param id идентификатор сегмента
+   * @throws std::runtime_error при ошибке открытия или отображения файла
+   */
+  Segment(std::string path, std::uint32_t id);
+
+  /**
+   * @brief Создает новый сегмент для записи
+   * @param path путь к файлу
+   * @param id идентификатор сегмента
+   * @param capacity максимальный размер сегмента, на который отображается
+   * файл
+   * @throws std::runtime_error при ошибке создания или отображения файла
+   */
+  Segment(std::string path, std::uint32_t id, std::uint64_t capacity);
+  ~Segment();
+
+ private:
+  Segment(const Segment&) = delete;
+  Segment& operator=(const Segment&) = delete;
+
+ public:
+  std::uint32_t id() const noexcept;
+  const std::string& path() const noexcept;
+  std::uint64_t size() const noexcept;
+  const char* data() const noexcept;
+
+  /**
+   * @brief Проверяет, поместятся ли в сегмент еще size байт
+   */
+  bool fits(std::uint64_t size) const noexcept;
+
+  /**
+   * @brief Дописывает данные в конец сегмента
+   * @return смещение записанных данных
+   */
+  std::uint64_t append(const void* data, std::size_t size);
+
+  /**
+   * @brief Сбрасывает записанные данные на диск
+   */
+  void sync();
+
+  /**
+   * @brief Обрезает файл до размера size, используется для удаления
+   * недописанной записи после сбоя
+   */
+  void truncate(std::uint64_t size);
+
+  /**
+   * @brief Сообщает сегменту, что его файл был переименован
+   */
+  void renamed(std::string path);
+
+ private:
+  void map(std::uint64_t length);
+
+ private:
+  std::string mPath;
+  std::uint32_t mId;
+  int mFd = -1;
+  char* mData = nullptr;
+  std::uint64_t mMapSize = 0;
+  std::uint64_t mSize = 0;
+};
+}  // namespace prstorage
+
+#endif  // SEGMENT_H
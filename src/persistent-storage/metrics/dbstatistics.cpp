@@ -0,0 +1,155 @@
+#include "dbstatistics.h"
+
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+constexpr std::uint64_t MB = 1024 * 1024;
+constexpr std::uint64_t GB = 1024 * MB;
+
+void check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+/**
+ * Освобождает структуры статистики, которые Berkeley DB выделяет через
+ * malloc
+ */
+template <typename T>
+using StatPtr = std::unique_ptr<T, decltype(&std::free)>;
+
+template <typename T>
+StatPtr<T> own(T* stat)
+{
+  return StatPtr<T>(stat, &std::free);
+}
+}  // namespace
+
+EnvironmentStats EnvironmentStats::collect(DbEnv* env)
+{
+  EnvironmentStats res;
+
+  DB_MPOOL_STAT* mpool = nullptr;
+  check(env->memp_stat(&mpool, nullptr, 0));
+  auto mpoolGuard = own(mpool);
+  res.cacheSize = mpool->st_gbytes * GB + mpool->st_bytes;
+  res.cacheHits = mpool->st_cache_hit;
+  res.cacheMisses = mpool->st_cache_miss;
+  res.pagesIn = mpool->st_page_in;
+  res.pagesOut = mpool->st_page_out;
+  res.evictions = mpool->st_ro_evict + mpool->st_rw_evict;
+  res.dirtyPages = mpool->st_page_dirty;
+
+  DB_LOCK_STAT* lock = nullptr;
+  check(env->lock_stat(&lock, 0));
+  auto lockGuard = own(lock);
+  res.locks = lock->st_nlocks;
+  res.maxLocks = lock->st_maxnlocks;
+  res.lockers = lock->st_nlockers;
+  res.lockRequests = lock->st_nrequests;
+  res.lockWaits = lock->st_lock_wait;
+  res.deadlocks = lock->st_ndeadlocks;
+
+  DB_LOG_STAT* log = nullptr;
+  check(env->log_stat(&log, 0));
+  auto logGuard = own(log);
+  res.logBytesWritten = log->st_w_mbytes * MB + log->st_w_bytes;
+  res.logWrites = log->st_wcount;
+  res.logSyncs = log->st_scount;
+
+  DB_TXN_STAT* txn = nullptr;
+  check(env->txn_stat(&txn, 0));
+  auto txnGuard = own(txn);
+  res.txnBegins = txn->st_nbegins;
+  res.txnCommits = txn->st_ncommits;
+  res.txnAborts = txn->st_naborts;
+  res.txnActive = txn->st_nactive;
+
+  return res;
+}
+
+void EnvironmentStats::visit(const Visitor& visitor) const
+{
+  visitor("cache.size", cacheSize);
+  visitor("cache.hits", cacheHits);
+  visitor("cache.misses", cacheMisses);
+  visitor("cache.pages_in", pagesIn);
+  visitor("cache.pages_out", pagesOut);
+  visitor("cache.evictions", evictions);
+  visitor("cache.dirty_pages", dirtyPages);
+  visitor("lock.locks", locks);
+  visitor("lock.max_locks", maxLocks);
+  visitor("lock.lockers", lockers);
+  visitor("lock.requests", lockRequests);
+  visitor("lock.waits", lockWaits);
+  visitor("lock.deadlocks", deadlocks);
+  visitor("log.bytes_written", logBytesWritten);
+  visitor("log.writes", logWrites);
+  visitor("log.syncs", logSyncs);
+  visitor("txn.begins", txnBegins);
+  visitor("txn.commits", txnCommits);
+  visitor("txn.aborts", txnAborts);
+  visitor("txn.active", txnActive);
+}
+
+DatabaseStats DatabaseStats::collect(Db* db, bool fast)
+{
+  DBTYPE type;
+  check(db->get_type(&type));
+
+  DatabaseStats res;
+  if (type == DB_HASH) {
+    DB_HASH_STAT* stat = nullptr;
+    check(db->stat(nullptr, &stat, fast ? DB_FAST_STAT : 0));
+    auto guard = own(stat);
+    res.keys = stat->hash_nkeys;
+    res.records = stat->hash_ndata;
+    res.pageSize = stat->hash_pagesize;
+    res.leafPages = stat->hash_buckets;
+    res.overflowPages = stat->hash_bigpages + stat->hash_overflows;
+    res.freePages = stat->hash_free;
+    res.bytesFree = stat->hash_bfree;
+  } else if (type == DB_BTREE) {
+    DB_BTREE_STAT* stat = nullptr;
+    check(db->stat(nullptr, &stat, fast ? DB_FAST_STAT : 0));
+    auto guard = own(stat);
+    res.keys = stat->bt_nkeys;
+    res.records = stat->bt_ndata;
+    res.pageSize = stat->bt_pagesize;
+    res.levels = stat->bt_levels;
+    res.leafPages = stat->bt_leaf_pg;
+    res.internalPages = stat->bt_int_pg;
+    res.overflowPages = stat->bt_over_pg;
+    res.freePages = stat->bt_free;
+    res.bytesFree = stat->bt_leaf_pgfree + stat->bt_int_pgfree;
+  }
+  return res;
+}
+
+double DatabaseStats::fillFactor() const noexcept
+{
+  auto capacity = (leafPages + internalPages) * pageSize;
+  if (capacity == 0 || bytesFree > capacity) {
+    return 1.0;
+  }
+  return 1.0 - static_cast<double>(bytesFree) / static_cast<double>(capacity);
+}
+
+void DatabaseStats::visit(const Visitor& visitor) const
+{
+  visitor("db.keys", keys);
+  visitor("db.records", records);
+  visitor("db.page_size", pageSize);
+  visitor("db.levels", levels);
+  visitor("db.leaf_pages", leafPages);
+  visitor("db.internal_pages", internalPages);
+  visitor("db.overflow_pages", overflowPages);
+  visitor("db.free_pages", freePages);
+  visitor("db.bytes_free", bytesFree);
+}
@@ -0,0 +1,91 @@
+#ifndef DBSTATISTICS_H
+#define DBSTATISTICS_H
+
+#include <db_cxx.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace prstorage {
+/**
+ * Снимок статистики окружения Berkeley DB: кеш (memp_stat), блокировки
+ * (lock_stat), журнал (log_stat) и транзакции (txn_stat). Значения
+ * накопленные с момента открытия окружения.
+ */
+struct EnvironmentStats {
+  using Visitor =
+      std::function<void(const std::string& name, std::uint64_t value)>;
+
+  std::uint64_t cacheSize = 0;
+  std::uint64_t cacheHits = 0;
+  std::uint64_t cacheMisses = 0;
+  std::uint64_t pagesIn = 0;
+  std::uint64_t pagesOut = 0;
+  std::uint64_t evictions = 0;
+  std::uint64_t dirtyPages = 0;
+
+  std::uint64_t locks = 0;
+  std::uint64_t maxLocks = 0;
+  std::uint64_t lockers = 0;
+  std::uint64_t lockRequests = 0;
+  std::uint64_t lockWaits = 0;
+  std::uint64_t deadlocks = 0;
+
+  std::uint64_t logBytesWritten = 0;
+  std::uint64_t logWrites = 0;
+  std::uint64_t logSyncs = 0;
+
+  std::uint64_t txnBegins = 0;
+  std::uint64_t txnCommits = 0;
+  std::uint64_t txnAborts = 0;
+  std::uint64_t txnActive = 0;
+
+  /**
+   * @brief Снимает статистику окружения
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  static EnvironmentStats collect(DbEnv* env);
+
+  /**
+   * @brief Передает все значения в visitor с именами вида "lock.deadlocks"
+   */
+  void visit(const Visitor& visitor) const;
+};
+
+/**
+ * Снимок статистики базы данных (DB->stat) для B-дерева и хеш-таблицы
+ */
+struct DatabaseStats {
+  using Visitor = EnvironmentStats::Visitor;
+
+  std::uint64_t keys = 0;
+  std::uint64_t records = 0;
+  std::uint64_t pageSize = 0;
+  std::uint64_t levels = 0;
+  std::uint64_t leafPages = 0;
+  std::uint64_t internalPages = 0;
+  std::uint64_t overflowPages = 0;
+  std::uint64_t freePages = 0;
+  /// свободное место на листовых и внутренних страницах, заполняется только
+  /// при полной статистике
+  std::uint64_t bytesFree = 0;
+
+  /**
+   * @brief Доля занятого места на листовых и внутренних страницах,
+   * 1 - если страниц нет. Имеет смысл только при полной статистике.
+   */
+  double fillFactor() const noexcept;
+
+  /**
+   * @brief Снимает статистику базы данных
+   * @param fast при true используется DB_FAST_STAT: база не обходится,
+   * а количество ключей может быть неточным
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  static DatabaseStats collect(Db* db, bool fast = true);
+
+  void visit(const Visitor& visitor) const;
+};
+}  // namespace prstorage
+
+#endif  // DBSTATISTICS_H
@@ -0,0 +1,105 @@
+#include "latencyhistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace prstorage;
+
+namespace {
+std::size_t bucketOf(std::uint64_t value) noexcept
+{
+  std::size_t bucket = 0;
+  while (value > 1 && bucket + 1 < LatencyHistogram::BUCKETS) {
+    value >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+std::uint64_t upperBound(std::size_t bucket) noexcept
+{
+  return bucket + 1 < 64 ? (std::uint64_t{2} << bucket) - 1 : UINT64_MAX;
+}
+}  // namespace
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) noexcept
+{
+  auto value = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      latency.count(), 0));
+  mBuckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  mTotal.fetch_add(value, std::memory_order_relaxed);
+
+  auto max = mMax.load(std::memory_order_relaxed);
+  while (value > max &&
+         !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept
+{
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    mBuckets[i].fetch_add(other.mBuckets[i].load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+  }
+  mTotal.fetch_add(other.totalNanoseconds(), std::memory_order_relaxed);
+
+  auto value = other.maxNanoseconds();
+  auto max = mMax.load(std::memory_order_relaxed);
+  while (value > max &&
+         !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+std::uint64_t LatencyHistogram::count() const noexcept
+{
+  std::uint64_t res = 0;
+  for (const auto& bucket : mBuckets) {
+    res += bucket.load(std::memory_order_relaxed);
+  }
+  return res;
+}
+
+std::uint64_t LatencyHistogram::totalNanoseconds() const noexcept
+{
+  return mTotal.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::maxNanoseconds() const noexcept
+{
+  return mMax.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::percentileNanoseconds(
+    double percentile) const noexcept
+{
+  std::array<std::uint64_t, BUCKETS> buckets;
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+    total += buckets[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  auto rank = static_cast<std::uint64_t>(
+      std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * total));
+  rank = std::max<std::uint64_t>(rank, 1);
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return std::min(upperBound(i), maxNanoseconds());
+    }
+  }
+  return maxNanoseconds();
+}
+
+void LatencyHistogram::reset() noexcept
+{
+  for (auto& bucket : mBuckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  mTotal.store(0, std::memory_order_relaxed);
+  mMax.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,55 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace prstorage {
+/**
+ * Гистограмма задержек с интервалами, границы которых - степени двойки
+ * наносекунд. Запись выполняется без блокировок и может вызываться из
+ * нескольких потоков.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr std::size_t BUCKETS = 64;
+
+ public:
+  LatencyHistogram() = default;
+
+ private:
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+ public:
+  void record(std::chrono::nanoseconds latency) noexcept;
+
+  /**
+   * @brief Добавляет значения другой гистограммы, например собранной
+   * отдельным потоком
+   */
+  void merge(const LatencyHistogram& other) noexcept;
+
+  std::uint64_t count() const noexcept;
+  std::uint64_t totalNanoseconds() const noexcept;
+  std::uint64_t maxNanoseconds() const noexcept;
+
+  /**
+   * @brief Возвращает верхнюю границу интервала, в который попадает
+   * перцентиль
+   * @param percentile значение от 0 до 100
+   */
+  std::uint64_t percentileNanoseconds(double percentile) const noexcept;
+
+  void reset() noexcept;
+
+ private:
+  std::array<std::atomic<std::uint64_t>, BUCKETS> mBuckets{};
+  std::atomic<std::uint64_t> mTotal{0};
+  std::atomic<std::uint64_t> mMax{0};
+};
+}  // namespace prstorage
+
+#endif  // LATENCYHISTOGRAM_H
@@ -0,0 +1,144 @@
+#include "storagemetrics.h"
+
+#include <exception>
+
+using namespace prstorage;
+
+const char* prstorage::operationName(Operation operation) noexcept
+{
+  switch (operation) {
+    case Operation::Add:
+      return "add";
+    case Operation::Get:
+      return "get";
+    case Operation::Has:
+      return "has";
+    case Operation::Update:
+      return "update";
+    case Operation::Remove:
+      return "remove";
+    case Operation::Scan:
+      return "scan";
+  }
+  return "unknown";
+}
+
+const OperationSnapshot& MetricsSnapshot::operator[](
+    Operation operation) const noexcept
+{
+  return operations[static_cast<std::size_t>(operation)];
+}
+
+void MetricsSnapshot::visit(const Visitor& visitor) const
+{
+  for (std::size_t i = 0; i < OPERATION_COUNT; ++i) {
+    std::string prefix = operationName(static_cast<Operation>(i));
+    const auto& operation = operations[i];
+    visitor(prefix + ".count", operation.count);
+    visitor(prefix + ".errors", operation.errors);
+    visitor(prefix + ".misses", operation.misses);
+    visitor(prefix + ".bytes", operation.bytes);
+    visitor(prefix + ".mean_ns", operation.meanNanoseconds);
+    visitor(prefix + ".p50_ns", operation.p50Nanoseconds);
+    visitor(prefix + ".p90_ns", operation.p90Nanoseconds);
+    visitor(prefix + ".p99_ns", operation.p99Nanoseconds);
+    visitor(prefix + ".max_ns", operation.maxNanoseconds);
+  }
+  visitor("txn.commits", commits);
+  visitor("txn.aborts", aborts);
+  visitor("lock.deadlocks", deadlocks);
+  visitor("watcher.queue_depth", watcherQueueDepth);
+}
+
+StorageMetrics::Scope::Scope(StorageMetrics& metrics,
+                             Operation operation) noexcept :
+    mMetrics(metrics),
+    mOperation(operation), mExceptions(std::uncaught_exceptions()),
+    mStart(std::chrono::steady_clock::now())
+{
+}
+
+StorageMetrics::Scope::~Scope()
+{
+  mMetrics.record(mOperation, std::chrono::steady_clock::now() - mStart,
+                  std::uncaught_exceptions() > mExceptions);
+}
+
+StorageMetrics::Scope StorageMetrics::measure(Operation operation) noexcept
+{
+  return Scope(*this, operation);
+}
+
+void StorageMetrics::addBytes(Operation operation,
+                              std::uint64_t bytes) noexcept
+{
+  mOperations[static_cast<std::size_t>(operation)].bytes.fetch_add(
+      bytes, std::memory_order_relaxed);
+}
+
+void StorageMetrics::missed(Operation operation) noexcept
+{
+  mOperations[static_cast<std::size_t>(operation)].misses.fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void StorageMetrics::committed() noexcept
+{
+  mCommits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StorageMetrics::aborted() noexcept
+{
+  mAborts.fetch_add(1, std::memory_order_relaxed);
+}
+
+MetricsSnapshot StorageMetrics::snapshot() const
+{
+  MetricsSnapshot res;
+  for (std::size_t i = 0; i < OPERATION_COUNT; ++i) {
+    const auto& counters = mOperations[i];
+    auto& operation = res.operations[i];
+    operation.count = counters.latency.count();
+    operation.errors = counters.errors.load(std::memory_order_relaxed);
+    operation.misses = counters.misses.load(std::memory_order_relaxed);
+    operation.bytes = counters.bytes.load(std::memory_order_relaxed);
+    operation.meanNanoseconds =
+        operation.count ? counters.latency.totalNanoseconds() / operation.count
+                        : 0;
+    operation.p50Nanoseconds = counters.latency.percentileNanoseconds(50);
+    operation.p90Nanoseconds = counters.latency.percentileNanoseconds(90);
+    operation.p99Nanoseconds = counters.latency.percentileNanoseconds(99);
+    operation.maxNanoseconds = counters.latency.maxNanoseconds();
+  }
+  res.commits = mCommits.load(std::memory_order_relaxed);
+  res.aborts = mAborts.load(std::memory_order_relaxed);
+  return res;
+}
+
+void StorageMetrics::reset() noexcept
+{
+  for (auto& counters : mOperations) {
+    counters.errors.store(0, std::memory_order_relaxed);
+    counters.misses.store(0, std::memory_order_relaxed);
+    counters.bytes.store(0, std::memory_order_relaxed);
+    counters.latency.reset();
+  }
+  mCommits.store(0, std::memory_order_relaxed);
+  mAborts.store(0, std::memory_order_relaxed);
+}
+
+void StorageMetrics::record(Operation operation,
+                            std::chrono::nanoseconds latency,
+                            bool failed) noexcept
+{
+  auto& counters = mOperations[static_cast<std::size_t>(operation)];
+  counters.latency.record(latency);
+  if (failed) {
+    counters.errors.fetch_add(1, std::memory_order_relaxed);
+    // транзакция записи откатывается TransactionManager при раскрутке стека
+    if (operation == Operation::Add || operation == Operation::Update ||
+        operation == Operation::Remove) {
+      aborted();
+    }
+  }
+}
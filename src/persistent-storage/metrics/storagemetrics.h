@@ -0,0 +1,151 @@
+#ifndef STORAGEMETRICS_H
+#define STORAGEMETRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "latencyhistogram.h"
+
+namespace prstorage {
+/**
+ * Операции хранилища, для которых собираются метрики
+ */
+enum class Operation : std::size_t { Add, Get, Has, Update, Remove, Scan };
+
+constexpr std::size_t OPERATION_COUNT = 6;
+
+const char* operationName(Operation operation) noexcept;
+
+/**
+ * Значения метрик одной операции
+ */
+struct OperationSnapshot {
+  std::uint64_t count = 0;
+  /// операции, завершившиеся исключением
+  std::uint64_t errors = 0;
+  /// операции без результата: элемент не найден или добавление отклонено
+  /// из-за существующего ключа
+  std::uint64_t misses = 0;
+  /// объем элементов после маршалинга
+  std::uint64_t bytes = 0;
+  std::uint64_t meanNanoseconds = 0;
+  std::uint64_t p50Nanoseconds = 0;
+  std::uint64_t p90Nanoseconds = 0;
+  std::uint64_t p99Nanoseconds = 0;
+  std::uint64_t maxNanoseconds = 0;
+};
+
+/**
+ * Снимок метрик хранилища
+ */
+struct MetricsSnapshot {
+  using Visitor =
+      std::function<void(const std::string& name, std::uint64_t value)>;
+
+  std::array<OperationSnapshot, OPERATION_COUNT> operations{};
+  std::uint64_t commits = 0;
+  /// транзакции записи, откатанные из-за исключения
+  std::uint64_t aborts = 0;
+  /// взаимоблокировки окружения хранилища (lock_stat), общие для всех
+  /// хранилищ окружения
+  std::uint64_t deadlocks = 0;
+  /// количество событий в очереди Watcher, если он ее предоставляет
+  std::uint64_t watcherQueueDepth = 0;
+
+  const OperationSnapshot& operator[](Operation operation) const noexcept;
+
+  /**
+   * @brief Передает все значения в visitor с именами вида "get.p99_ns",
+   * например для экспорта в систему мониторинга
+   */
+  void visit(const Visitor& visitor) const;
+};
+
+/**
+ * Политика метрик для хранилищ: считает операции, задержки, объем
+ * данных после маршалинга и завершения транзакций. Исключение в add,
+ * update или remove считается и ошибкой операции, и откатом транзакции.
+ * Все счетчики атомарные.
+ */
+class StorageMetrics {
+ public:
+  static constexpr bool enabled = true;
+
+  /**
+   * Измеряет время операции от создания до уничтожения объекта. Операция
+   * считается ошибочной, если объект уничтожается при раскрутке стека.
+   */
+  class Scope {
+   public:
+    Scope(StorageMetrics& metrics, Operation operation) noexcept;
+    ~Scope();
+
+   private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    StorageMetrics& mMetrics;
+    Operation mOperation;
+    int mExceptions;
+    std::chrono::steady_clock::time_point mStart;
+  };
+
+ public:
+  StorageMetrics() = default;
+
+ private:
+  StorageMetrics(const StorageMetrics&) = delete;
+  StorageMetrics& operator=(const StorageMetrics&) = delete;
+
+ public:
+  Scope measure(Operation operation) noexcept;
+  void addBytes(Operation operation, std::uint64_t bytes) noexcept;
+  void missed(Operation operation) noexcept;
+  void committed() noexcept;
+  void aborted() noexcept;
+
+  MetricsSnapshot snapshot() const;
+  void reset() noexcept;
+
+ private:
+  void record(Operation operation,
+              std::chrono::nanoseconds latency,
+              bool failed) noexcept;
+
+ private:
+  struct OperationCounters {
+    std::atomic<std::uint64_t> errors{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> bytes{0};
+    LatencyHistogram latency;
+  };
+
+ private:
+  std::array<OperationCounters, OPERATION_COUNT> mOperations;
+  std::atomic<std::uint64_t> mCommits{0};
+  std::atomic<std::uint64_t> mAborts{0};
+};
+
+/**
+ * Политика метрик по умолчанию: все функции пустые и встраиваются, время
+ * не измеряется, поэтому хранилище без метрик не несет накладных расходов.
+ */
+struct NoMetrics {
+  static constexpr bool enabled = false;
+
+  struct Scope {};
+
+  Scope measure(Operation) const noexcept { return {}; }
+  void addBytes(Operation, std::uint64_t) const noexcept {}
+  void missed(Operation) const noexcept {}
+  void committed() const noexcept {}
+  void aborted() const noexcept {}
+};
+}  // namespace prstorage
+
+#endif  // STORAGEMETRICS_H
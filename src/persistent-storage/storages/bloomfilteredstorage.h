@@ -0,0 +1,385 @@
+#ifndef BLOOMFILTEREDSTORAGE_H
+#define BLOOMFILTEREDSTORAGE_H
+
+#include <db_cxx.h>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "persistent-storage/storages/orderedindex.h"
+#include "persistent-storage/utils/aggregates.h"
+#include "persistent-storage/utils/bloomfilter.h"
+#include "persistent-storage/utils/keydbt.h"
+#include "persistent-storage/utils/keysrange.h"
+#include "persistent-storage/utils/page.h"
+
+namespace prstorage {
+/**
+ * Хранилище с фильтром Блума по ключам. Проверка отсутствующего ключа
+ * (has, get, tryGet) в большинстве случаев выполняется по фильтру в памяти
+ * без спуска по B-дереву, остальные операции передаются StorageType.
+ *
+ * Фильтр заполняется при создании объекта обходом ключей базы данных без
+ * чтения значений и пополняется при add и update. Удаленные ключи остаются
+ * в фильтре и только увеличивают долю ложноположительных ответов, для их
+ * очистки используется rebuild().
+ *
+ * Фильтр корректен, только если все элементы добавляются через этот
+ * объект: элемент, добавленный в базу данных в обход него (другим
+ * хранилищем или процессом), будет считаться отсутствующим до rebuild().
+ *
+ * @tparam StorageType тип хранилища, например Storage<...> или
+ * ExpiringStorage<...>
+ */
+template <typename StorageType>
+class BloomFilteredStorage {
+ public:
+  using storage_type = StorageType;
+  using element = typename StorageType::element;
+  using key = typename StorageType::key;
+  using wrapper_type = typename StorageType::wrapper_type;
+
+ public:
+  /**
+   * @brief Конструктор класса, заполняет фильтр ключами базы данных
+   * @param storage хранилище, которому передаются операции
+   * @param db база данных хранилища
+   * @param options размер фильтра и допустимая доля ложноположительных
+   * ответов
+   * @throws std::invalid_argument при недопустимых параметрах фильтра
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  BloomFilteredStorage(std::shared_ptr<StorageType> storage,
+                       Db* db,
+                       BloomFilter::Options options = BloomFilter::Options());
+
+ public:
+  bool add(const element& elem);
+  bool remove(const key& id);
+  bool strictUpdate(const element& elem);
+  void update(const element& elem);
+  wrapper_type wrapper(const key& id);
+
+ public:
+  element get(const key& id) const;
+
+  /**
+   * @brief Возвращает элемент без исключения при его отсутствии
+   */
+  std::optional<element> tryGet(const key& id) const;
+  bool has(const key& id) const;
+  std::vector<element> getAllElements() const;
+  int size() const;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+  Page<element> page(const std::string& afterToken, std::size_t limit) const;
+  KeysRange<key> keys() const;
+
+  template <typename Callback>
+  void forEachKey(Callback&& callback) const;
+  std::vector<key> getAllKeys() const;
+
+ public:
+  template <typename T, typename BinaryOp>
+  T reduce(T init, BinaryOp op) const;
+  std::size_t count_if(std::function<bool(const element&)> p) const;
+  template <typename KeyFn>
+  std::optional<element> min_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  std::optional<element> max_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  GroupCounts<element, KeyFn> group_count(KeyFn keyFn) const;
+  template <typename Index>
+  std::vector<element> orderedBy(
+      const std::optional<typename Index::key_type>& from,
+      std::size_t limit,
+      Direction direction = Direction::Forward,
+      std::function<bool(const typename Index::key_type&)> inRange = {})
+      const;
+
+ public:
+  /**
+   * @brief Очищает фильтр и заполняет его ключами базы данных. Не должен
+   * выполняться одновременно с другими операциями.
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  void rebuild();
+
+  const BloomFilter& filter() const noexcept;
+  std::shared_ptr<StorageType> storage() const noexcept;
+
+ private:
+  void addKey(const key& id);
+  bool mayContain(const key& id) const;
+  static void check(int ret);
+
+ private:
+  std::shared_ptr<StorageType> mStorage;
+  Db* mDb;
+  BloomFilter mFilter;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename StorageType>
+prstorage::BloomFilteredStorage<StorageType>::BloomFilteredStorage(
+    std::shared_ptr<StorageType> storage,
+    Db* db,
+    BloomFilter::Options options) :
+    mStorage(std::move(storage)),
+    mDb(db), mFilter(options)
+{
+  rebuild();
+}
+
+template <typename StorageType>
+bool prstorage::BloomFilteredStorage<StorageType>::add(const element& elem)
+{
+  // ключ добавляется в фильтр до записи, чтобы параллельная проверка не
+  // пропустила уже записанный элемент
+  addKey(get_id(elem));
+  return mStorage->add(elem);
+}
+
+template <typename StorageType>
+bool prstorage::BloomFilteredStorage<StorageType>::remove(const key& id)
+{
+  if (!mayContain(id)) {
+    return false;
+  }
+  return mStorage->remove(id);
+}
+
+template <typename StorageType>
+bool prstorage::BloomFilteredStorage<StorageType>::strictUpdate(
+    const element& elem)
+{
+  if (!mayContain(get_id(elem))) {
+    return false;
+  }
+  return mStorage->strictUpdate(elem);
+}
+
+template <typename StorageType>
+void prstorage::BloomFilteredStorage<StorageType>::update(const element& elem)
+{
+  addKey(get_id(elem));
+  mStorage->update(elem);
+}
+
+template <typename StorageType>
+typename prstorage::BloomFilteredStorage<StorageType>::wrapper_type
+prstorage::BloomFilteredStorage<StorageType>::wrapper(const key& id)
+{
+  if (!mayContain(id)) {
+    throw std::range_error("not found element");
+  }
+  return mStorage->wrapper(id);
+}
+
+template <typename StorageType>
+typename prstorage::BloomFilteredStorage<StorageType>::element
+prstorage::BloomFilteredStorage<StorageType>::get(const key& id) const
+{
+  if (!mayContain(id)) {
+    throw std::range_error("not found element");
+  }
+  return mStorage->get(id);
+}
+
+template <typename StorageType>
+std::optional<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::tryGet(const key& id) const
+{
+  if (!mayContain(id)) {
+    return {};
+  }
+  try {
+    return mStorage->get(id);
+  } catch (const std::range_error&) {
+    // ложноположительный ответ фильтра
+    return {};
+  }
+}
+
+template <typename StorageType>
+bool prstorage::BloomFilteredStorage<StorageType>::has(const key& id) const
+{
+  return mayContain(id) && mStorage->has(id);
+}
+
+template <typename StorageType>
+std::vector<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::getAllElements() const
+{
+  return mStorage->getAllElements();
+}
+
+template <typename StorageType>
+int prstorage::BloomFilteredStorage<StorageType>::size() const
+{
+  return mStorage->size();
+}
+
+template <typename StorageType>
+std::vector<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::get_if(
+    std::function<bool(const element&)> p) const
+{
+  return mStorage->get_if(std::move(p));
+}
+
+template <typename StorageType>
+prstorage::Page<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::page(
+    const std::string& afterToken,
+    std::size_t limit) const
+{
+  return mStorage->page(afterToken, limit);
+}
+
+template <typename StorageType>
+prstorage::KeysRange<typename prstorage::BloomFilteredStorage<StorageType>::key>
+prstorage::BloomFilteredStorage<StorageType>::keys() const
+{
+  return mStorage->keys();
+}
+
+template <typename StorageType>
+template <typename Callback>
+void prstorage::BloomFilteredStorage<StorageType>::forEachKey(
+    Callback&& callback) const
+{
+  mStorage->forEachKey(std::forward<Callback>(callback));
+}
+
+template <typename StorageType>
+std::vector<typename prstorage::BloomFilteredStorage<StorageType>::key>
+prstorage::BloomFilteredStorage<StorageType>::getAllKeys() const
+{
+  return mStorage->getAllKeys();
+}
+
+template <typename StorageType>
+template <typename T, typename BinaryOp>
+T prstorage::BloomFilteredStorage<StorageType>::reduce(T init,
+                                                       BinaryOp op) const
+{
+  return mStorage->reduce(std::move(init), std::move(op));
+}
+
+template <typename StorageType>
+std::size_t prstorage::BloomFilteredStorage<StorageType>::count_if(
+    std::function<bool(const element&)> p) const
+{
+  return mStorage->count_if(std::move(p));
+}
+
+template <typename StorageType>
+template <typename KeyFn>
+std::optional<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::min_by(KeyFn keyFn) const
+{
+  return mStorage->min_by(std::move(keyFn));
+}
+
+template <typename StorageType>
+template <typename KeyFn>
+std::optional<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::max_by(KeyFn keyFn) const
+{
+  return mStorage->max_by(std::move(keyFn));
+}
+
+template <typename StorageType>
+template <typename KeyFn>
+prstorage::GroupCounts<
+    typename prstorage::BloomFilteredStorage<StorageType>::element,
+    KeyFn>
+prstorage::BloomFilteredStorage<StorageType>::group_count(KeyFn keyFn) const
+{
+  return mStorage->group_count(std::move(keyFn));
+}
+
+template <typename StorageType>
+template <typename Index>
+std::vector<typename prstorage::BloomFilteredStorage<StorageType>::element>
+prstorage::BloomFilteredStorage<StorageType>::orderedBy(
+    const std::optional<typename Index::key_type>& from,
+    std::size_t limit,
+    Direction direction,
+    std::function<bool(const typename Index::key_type&)> inRange) const
+{
+  return mStorage->template orderedBy<Index>(from, limit, direction,
+                                             std::move(inRange));
+}
+
+template <typename StorageType>
+void prstorage::BloomFilteredStorage<StorageType>::rebuild()
+{
+  mFilter.clear();
+
+  Dbc* cursor = nullptr;
+  check(mDb->cursor(nullptr, &cursor, 0));
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  Dbt key, data;
+  key.set_flags(DB_DBT_REALLOC);
+  // значения элементов не читаются: dlen == 0
+  data.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+  std::unique_ptr<void, decltype(&std::free)> keyData(nullptr, &std::free);
+  while (true) {
+    auto ret = cursor->get(&key, &data, DB_NEXT);
+    // DB_DBT_REALLOC мог переместить буфер ключа
+    keyData.release();
+    keyData.reset(key.get_data());
+    if (ret == DB_NOTFOUND) {
+      return;
+    }
+    check(ret);
+    mFilter.add(key.get_data(), key.get_size());
+  }
+}
+
+template <typename StorageType>
+const prstorage::BloomFilter&
+prstorage::BloomFilteredStorage<StorageType>::filter() const noexcept
+{
+  return mFilter;
+}
+
+template <typename StorageType>
+std::shared_ptr<StorageType>
+prstorage::BloomFilteredStorage<StorageType>::storage() const noexcept
+{
+  return mStorage;
+}
+
+template <typename StorageType>
+void prstorage::BloomFilteredStorage<StorageType>::addKey(const key& id)
+{
+  // ключ хешируется в том же формате, в котором он хранится в базе данных
+  KeyDbt<key> dbt(id);
+  mFilter.add(dbt.get()->get_data(), dbt.get()->get_size());
+}
+
+template <typename StorageType>
+bool prstorage::BloomFilteredStorage<StorageType>::mayContain(
+    const key& id) const
+{
+  KeyDbt<key> dbt(id);
+  return mFilter.mayContain(dbt.get()->get_data(), dbt.get()->get_size());
+}
+
+template <typename StorageType>
+void prstorage::BloomFilteredStorage<StorageType>::check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+#endif  // BLOOMFILTEREDSTORAGE_H
@@ -6,6 +6,12 @@
 #include <optional>
 #include "storage.h"
 
+#include "persistent-storage/deleters/cascadereport.h"
+#include "persistent-storage/utils/elementsrange.h"
+#include "persistent-storage/utils/keydbt.h"
+#include "persistent-storage/utils/page.h"
+#include "persistent-storage/watchers/watchertraits.h"
+
 #include "persistent-storage/deleters/defaultchilddeleter.h"
 #include "persistent-storage/deleters/defaultdeleter.h"
 
@@ -20,13 +26,20 @@ template <
         decltype(get_id(std::declval<Element>())),
         Element,
         Parent,
-        DefaultDeleter<decltype(get_id(std::declval<Element>())), Element>>>
-class ChildStorage
-    : public Storage<Element, Marshaller, Watcher, TxManager, Deleter> {
+        KeyOnlyDeleter<decltype(get_id(std::declval<Element>())), Element>>,
+    typename Metrics = NoMetrics>
+class ChildStorage : public Storage<Element,
+                                    Marshaller,
+                                    Watcher,
+                                    TxManager,
+                                    Deleter,
+                                    Metrics> {
  public:
   using ParentContainer =
-      Storage<Element, Marshaller, Watcher, TxManager, Deleter>;
+      Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>;
   using ParentElementId = decltype(get_id(std::declval<Parent>()));
+  using ChildrenRange = ElementsRange<
+      typename dbstl::db_multimap<ParentElementId, Element>::iterator>;
 
  public:
   ChildStorage(Db* db,
@@ -38,9 +51,92 @@ class ChildStorage
   void parentRemoved(const Parent& parent);
   void parentRemoved(const std::vector<Parent>& parents);
 
+  /**
+   * @brief Удаляет потомков родителей parentIds порциями размера
+   * report.chunkSize() и передает идентификаторы удаленных элементов на
+   * следующий уровень иерархии. Выполняется в текущей транзакции.
+   * @param parentIds идентификаторы удаленных родителей
+   * @param report накапливает количество удаленных элементов по уровням
+   * @param level уровень иерархии, к которому относится хранилище
+   */
+  void parentIdsRemoved(const std::vector<ParentElementId>& parentIds,
+                        CascadeReport& report,
+                        std::size_t level = 0);
+
+  /**
+   * @brief Удаляет в одной транзакции всех потомков родителей parentIds на
+   * всех уровнях иерархии.
+   * @param parentIds идентификаторы родителей
+   * @param chunkSize размер порции, которой удаляются элементы
+   * @return количество удаленных элементов по уровням
+   */
+  CascadeReport removeChildrenOf(
+      const std::vector<ParentElementId>& parentIds,
+      std::size_t chunkSize = CascadeReport::DEFAULT_CHUNK_SIZE);
+
+ public:
+  /**
+   * @brief Возвращает дочерние элементы родителя с указанным идентификатором.
+   * Элементы читаются из вторичного индекса по мере обхода диапазона.
+   * @param parentId идентификатор родительского элемента
+   * @return диапазон дочерних элементов
+   */
+  ChildrenRange childrenOf(const ParentElementId& parentId) const;
+
+  /**
+   * @brief Возвращает страницу дочерних элементов родителя. Курсор
+   * устанавливается на afterKey так же, как в page(), поэтому стоимость
+   * страницы пропорциональна limit.
+   * @param parentId идентификатор родительского элемента
+   * @param limit максимальное количество элементов на странице
+   * @param afterKey идентификатор последнего элемента предыдущей страницы,
+   * если не задан - возвращается первая страница
+   * @return дочерние элементы, следующие за afterKey
+   * @throws std::out_of_range, если элемент afterKey удален из вторичной
+   * базы данных без сортировки дубликатов
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  std::vector<Element> childrenOf(
+      const ParentElementId& parentId,
+      std::size_t limit,
+      const std::optional<typename ParentContainer::key>& afterKey = {}) const;
+
+  /**
+   * @brief Возвращает страницу дочерних элементов родителя в порядке
+   * вторичного индекса. Курсор устанавливается на продолжение по паре
+   * (parentId, первичный ключ) через DB_GET_BOTH_RANGE, поэтому стоимость
+   * страницы пропорциональна limit.
+   *
+   * Если вторичная база данных создана с DB_DUPSORT, маркер остается
+   * действительным после удаления последнего элемента страницы; с DB_DUP
+   * (по умолчанию StorageFactory) такой маркер не может быть
+   * восстановлен.
+   * @param parentId идентификатор родительского элемента
+   * @param afterToken маркер продолжения предыдущей страницы, пустая строка
+   * для первой страницы
+   * @param limit максимальное количество элементов на странице
+   * @throws std::out_of_range, если элемент маркера удален из вторичной базы
+   * данных без сортировки дубликатов
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  Page<Element> page(const ParentElementId& parentId,
+                     const std::string& afterToken,
+                     std::size_t limit) const;
+  using ParentContainer::page;
+
+  /**
+   * @brief Возвращает количество дочерних элементов родителя
+   * @param parentId идентификатор родительского элемента
+   * @return количество дочерних элементов
+   */
+  std::size_t childCount(const ParentElementId& parentId) const;
+
+ protected:
+  void notifyRemoved(const std::vector<Element>& elements);
+
  private:
   Db* mSecondaryDb;
-  dbstl::db_multimap<ParentElementId, Element> mSecondaryKeys;
+  mutable dbstl::db_multimap<ParentElementId, Element> mSecondaryKeys;
 };
 
 }  // namespace prstorage
@@ -50,12 +146,18 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
+          typename Deleter,
+          typename Metrics>
 prstorage::
-    ChildStorage<Element, Parent, Marshaller, Watcher, TxManager, Deleter>::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
         ChildStorage(Db* db, Db* secondary, DbEnv* env, Deleter&& deleter) :
-    ChildStorage<Element, Parent, Marshaller, Watcher, TxManager, Deleter>::
-        ParentContainer(db, env, std::move(deleter)),
+    ParentContainer(db, env, std::move(deleter)),
     mSecondaryDb(secondary), mSecondaryKeys(secondary, env)
 {
 }
@@ -65,17 +167,20 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
+          typename Deleter,
+          typename Metrics>
 void prstorage::
-    ChildStorage<Element, Parent, Marshaller, Watcher, TxManager, Deleter>::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
         parentRemoved(const Parent& parent)
 {
-  auto deletedElements =
-      this->getDeleter().removeChilds(mSecondaryKeys, parent);
-  std::for_each(std::cbegin(deletedElements), std::cend(deletedElements),
-                [this](const Element& element) {
-                  ParentContainer::watcher_type::elementRemoved(element);
-                });
+  CascadeReport report;
+  parentIdsRemoved({get_id(parent)}, report);
 }
 
 template <typename Element,
@@ -83,17 +188,262 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
+          typename Deleter,
+          typename Metrics>
 void prstorage::
-    ChildStorage<Element, Parent, Marshaller, Watcher, TxManager, Deleter>::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
         parentRemoved(const std::vector<Parent>& parents)
 {
-  auto deletedElements =
-      this->getDeleter().removeChilds(mSecondaryKeys, parents);
-  std::for_each(std::cbegin(deletedElements), std::cend(deletedElements),
-                [this](const Element& element) {
-                  ParentContainer::watcher_type::elementRemoved(element);
-                });
+  std::vector<ParentElementId> parentIds;
+  parentIds.reserve(parents.size());
+  std::transform(std::cbegin(parents), std::cend(parents),
+                 std::back_inserter(parentIds),
+                 [](const Parent& parent) { return get_id(parent); });
+  CascadeReport report;
+  parentIdsRemoved(parentIds, report);
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+void prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        parentIdsRemoved(const std::vector<ParentElementId>& parentIds,
+                         CascadeReport& report,
+                         std::size_t level)
+{
+  this->getDeleter().removeChildsByIds(
+      mSecondaryKeys, parentIds, report, level,
+      [this, &report, level](const std::vector<Element>& removed) {
+        report.addRemoved(level, removed.size());
+        notifyRemoved(removed);
+      });
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+prstorage::CascadeReport prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        removeChildrenOf(const std::vector<ParentElementId>& parentIds,
+                         std::size_t chunkSize)
+{
+  typename ParentContainer::TransactionManager manager(this->getEnv());
+  CascadeReport report(chunkSize);
+  parentIdsRemoved(parentIds, report);
+  manager.commit();
+  return report;
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+void prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        notifyRemoved(const std::vector<Element>& elements)
+{
+  if constexpr (supports_batch_removal<Watcher>::value) {
+    ParentContainer::watcher_type::elementsRemoved(elements);
+  } else {
+    std::for_each(std::cbegin(elements), std::cend(elements),
+                  [this](const Element& element) {
+                    ParentContainer::watcher_type::elementRemoved(element);
+                  });
+  }
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+typename prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        ChildrenRange
+        prstorage::ChildStorage<Element,
+                                Parent,
+                                Marshaller,
+                                Watcher,
+                                TxManager,
+                                Deleter,
+                                Metrics>::childrenOf(const ParentElementId&
+                                                         parentId) const
+{
+  auto [begin, end] = mSecondaryKeys.equal_range(parentId, true);
+  return ChildrenRange(begin, end);
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<Element> prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        childrenOf(
+            const ParentElementId& parentId,
+            std::size_t limit,
+            const std::optional<typename ParentContainer::key>& afterKey) const
+{
+  // маркер page() - первичный ключ в формате dbstl
+  std::string afterToken;
+  if (afterKey) {
+    KeyDbt<typename ParentContainer::key> keyDbt(*afterKey);
+    afterToken.assign(static_cast<const char*>(keyDbt.get()->get_data()),
+                      keyDbt.get()->get_size());
+  }
+  return page(parentId, afterToken, limit).elements;
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        childCount(const ParentElementId& parentId) const
+{
+  return mSecondaryKeys.count(parentId);
+}
+
+template <typename Element,
+          typename Parent,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+prstorage::Page<Element> prstorage::
+    ChildStorage<Element,
+                 Parent,
+                 Marshaller,
+                 Watcher,
+                 TxManager,
+                 Deleter,
+                 Metrics>::
+        page(const ParentElementId& parentId,
+             const std::string& afterToken,
+             std::size_t limit) const
+{
+  Page<Element> res;
+  if (limit == 0) {
+    res.nextToken = afterToken;
+    return res;
+  }
+
+  auto check = [](int ret) {
+    if (ret != 0 && ret != DB_NOTFOUND) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+    return ret == 0;
+  };
+  auto env = this->getEnv();
+  Dbc* cursor = nullptr;
+  check(mSecondaryDb->cursor(env ? dbstl::current_txn(env) : nullptr, &cursor,
+                             0));
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  KeyDbt<ParentElementId> parentDbt(parentId);
+  ReallocDbt key, primary, data;
+  key.assign(std::string(static_cast<const char*>(parentDbt.get()->get_data()),
+                         parentDbt.get()->get_size()));
+  bool found = false;
+  if (afterToken.empty()) {
+    found = check(cursor->pget(&key, &primary, &data, DB_SET));
+  } else {
+    primary.assign(afterToken);
+    found = check(cursor->pget(&key, &primary, &data, DB_GET_BOTH_RANGE));
+    if (found && primary.equals(afterToken)) {
+      found = check(cursor->pget(&key, &primary, &data, DB_NEXT_DUP));
+    } else if (!found) {
+      u_int32_t flags = 0;
+      check(mSecondaryDb->get_flags(&flags));
+      if (!(flags & DB_DUPSORT)) {
+        throw std::out_of_range("page token not found");
+      }
+    }
+  }
+
+  while (found) {
+    Element elem;
+    Marshaller::restore(elem, data.get_data());
+    res.elements.push_back(std::move(elem));
+    if (res.elements.size() == limit) {
+      // маркер возвращается, только если за страницей есть элементы
+      auto last = primary.bytes();
+      Dbt peek;
+      // значения не читаются: dlen == 0
+      peek.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+      if (check(cursor->pget(&key, &primary, &peek, DB_NEXT_DUP))) {
+        res.nextToken = std::move(last);
+      }
+      break;
+    }
+    found = check(cursor->pget(&key, &primary, &data, DB_NEXT_DUP));
+  }
+  return res;
 }
 
 #endif  // CHILDSTORAGE_H
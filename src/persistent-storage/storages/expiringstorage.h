@@ -0,0 +1,636 @@
+#ifndef EXPIRINGSTORAGE_H
+#define EXPIRINGSTORAGE_H
+
+#include <db_cxx.h>
+#include <dbstl_common.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "storage.h"
+
+#include "persistent-storage/utils/keydbt.h"
+
+namespace prstorage {
+/// размер ключа индекса времени истечения
+constexpr u_int32_t EXPIRY_KEY_SIZE = 8;
+
+/**
+ * @brief Записывает время истечения в ключ индекса: миллисекунды от начала
+ * эпохи (с округлением вверх) в порядке big-endian с инвертированным знаковым
+ * битом. Побайтовое сравнение таких ключей совпадает с порядком времени.
+ */
+inline void encode_expiry(std::chrono::system_clock::time_point expiry,
+                          unsigned char* dest)
+{
+  auto ms = std::chrono::ceil<std::chrono::milliseconds>(
+      expiry.time_since_epoch());
+  auto value = static_cast<std::uint64_t>(ms.count()) ^ (1ull << 63);
+  for (int i = EXPIRY_KEY_SIZE - 1; i >= 0; --i) {
+    dest[i] = static_cast<unsigned char>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+inline std::chrono::system_clock::time_point decode_expiry(
+    const unsigned char* src)
+{
+  std::uint64_t value = 0;
+  for (u_int32_t i = 0; i < EXPIRY_KEY_SIZE; ++i) {
+    value = (value << 8) | src[i];
+  }
+  auto ms = static_cast<std::int64_t>(value ^ (1ull << 63));
+  return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+}
+
+/**
+ * @brief Функция обратного вызова Db::associate для индекса времени
+ * истечения ExpiringStorage. Элементы без времени истечения не индексируются.
+ *
+ * Пример:
+ * factory.makeChildStorage<ExpiringStorage<Session, SessionMarshaller,
+ *                                          SessionWatcher>>(
+ *     "sessions.db", "sessions", "expiry",
+ *     expiry_index_key<Session, SessionMarshaller>);
+ */
+template <typename Element, typename Marshaller>
+int expiry_index_key(Db* /* secondary */,
+                     const Dbt* /* key */,
+                     const Dbt* data,
+                     Dbt* result)
+{
+  Element elem;
+  Marshaller::restore(elem, data->get_data());
+  auto expiry = get_expiry(elem);
+  if (expiry == std::chrono::system_clock::time_point()) {
+    return DB_DONOTINDEX;
+  }
+
+  if (auto bytes = static_cast<unsigned char*>(malloc(EXPIRY_KEY_SIZE))) {
+    encode_expiry(expiry, bytes);
+    result->set_flags(DB_DBT_APPMALLOC);
+    result->set_data(bytes);
+    result->set_size(EXPIRY_KEY_SIZE);
+    return 0;
+  }
+  return ENOMEM;
+}
+
+/**
+ * Хранилище элементов с ограниченным временем жизни, например сессий или
+ * аренд.
+ *
+ * Время истечения элемента возвращает свободная функция
+ * std::chrono::system_clock::time_point get_expiry(const Element&), значение
+ * по умолчанию (начало эпохи) означает, что элемент не истекает. Время
+ * истечения хранится во вторичном индексе, упорядоченном по времени (см.
+ * expiry_index_key), поэтому removeExpired читает только истекшие записи
+ * индекса: стоимость удаления пропорциональна количеству истекших элементов,
+ * а не размеру хранилища.
+ *
+ * Истекшие, но еще не удаленные элементы не возвращаются операциями чтения
+ * (get, has, getAllElements, get_if), add заменяет такой элемент, а
+ * strictUpdate и wrapper().save() его не обновляют. size() и обход ключей
+ * (keys, forEachKey, getAllKeys) учитывают еще не удаленные элементы, так
+ * как не читают значения; orderedBy и page их тоже не отфильтровывают.
+ *
+ * Удаление выполняется через remove, то есть через Deleter хранилища, поэтому
+ * каскадное удаление потомков и уведомления Watcher работают так же, как при
+ * явном удалении. Для периодического удаления используется ExpiryReaper.
+ */
+template <
+    typename Element,
+    typename Marshaller,
+    typename Watcher,
+    typename TxManager = DefaultTransactionManager,
+    typename Deleter =
+        KeyOnlyDeleter<decltype(get_id(std::declval<Element>())), Element>,
+    typename Metrics = NoMetrics>
+class ExpiringStorage : public Storage<Element,
+                                       Marshaller,
+                                       Watcher,
+                                       TxManager,
+                                       Deleter,
+                                       Metrics> {
+ public:
+  using ParentContainer =
+      Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>;
+  using element = typename ParentContainer::element;
+  using key = typename ParentContainer::key;
+  // обертка сохраняет и перечитывает элемент через ExpiringStorage
+  using wrapper_type = TransparentContainerElementWrapper<ExpiringStorage>;
+  using lazy_element = typename ParentContainer::lazy_element;
+  using time_point = std::chrono::system_clock::time_point;
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param db база данных элементов
+   * @param expiryIndex вторичная база данных с дубликатами, связанная с db
+   * функцией expiry_index_key
+   * @param env окружение для db и expiryIndex
+   * @param deleter объект, который выполняет удаление элементов из БД
+   */
+  ExpiringStorage(Db* db,
+                  Db* expiryIndex,
+                  DbEnv* env,
+                  Deleter&& deleter = Deleter());
+
+ public:
+  bool add(const element& elem);
+  bool strictUpdate(const element& elem);
+  wrapper_type wrapper(const key& id);
+
+ public:
+  element get(const key& id) const;
+  bool has(const key& id) const;
+  std::vector<element> getAllElements() const;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+
+  /**
+   * @brief get_if_lazy Storage без истекших элементов. Время истечения
+   * проверяется только у элементов, которые прошли предикат, поэтому
+   * восстанавливаются только они.
+   */
+  std::vector<element> get_if_lazy(
+      std::function<bool(const lazy_element&)> p) const;
+
+ public:
+  /**
+   * @brief Агрегаты Storage, которые не учитывают истекшие элементы
+   */
+  template <typename T, typename BinaryOp>
+  T reduce(T init, BinaryOp op) const;
+  std::size_t count_if(std::function<bool(const element&)> p) const;
+  std::size_t count_if_lazy(
+      std::function<bool(const lazy_element&)> p) const;
+  template <typename KeyFn>
+  std::optional<element> min_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  std::optional<element> max_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  GroupCounts<Element, KeyFn> group_count(KeyFn keyFn) const;
+
+ public:
+  /**
+   * @brief Удаляет в одной транзакции не более batchSize элементов, время
+   * истечения которых не позже now. Элементы удаляются в порядке времени
+   * истечения.
+   * @return количество удаленных элементов; оно может быть меньше
+   * batchSize, если часть элементов одновременно удалил другой поток
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  std::size_t removeExpired(
+      std::size_t batchSize,
+      time_point now = std::chrono::system_clock::now());
+
+  /**
+   * @brief removeExpired, сообщающий количество прочитанных записей индекса
+   * @param scanned количество истекших записей индекса, прочитанных в
+   * порции; если оно меньше batchSize - истекших элементов больше нет
+   */
+  std::size_t removeExpired(std::size_t batchSize,
+                            time_point now,
+                            std::size_t& scanned);
+
+  /**
+   * @brief Возвращает базы данных элементов и индекса, например для
+   * регистрации в потоках через ThreadRegistry
+   */
+  std::vector<Db*> databases() const;
+
+  using ParentContainer::getEnv;
+
+ private:
+  static bool expired(const element& elem, time_point now);
+  static void check(int ret);
+
+ private:
+  Db* mDb;
+  Db* mExpiryDb;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        ExpiringStorage(Db* db,
+                        Db* expiryIndex,
+                        DbEnv* env,
+                        Deleter&& deleter) :
+    ParentContainer(db, env, std::move(deleter)),
+    mDb(db), mExpiryDb(expiryIndex)
+{
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        add(const element& elem)
+{
+  typename ParentContainer::TransactionManager manager(getEnv());
+  auto id = get_id(elem);
+  // истекший элемент еще не удален и занимает ключ; элемент читается один
+  // раз, без предварительной проверки has
+  bool stale = false;
+  try {
+    stale = expired(ParentContainer::get(id), std::chrono::system_clock::now());
+  } catch (const std::range_error&) {
+    // ключ свободен
+  }
+  if (stale) {
+    ParentContainer::remove(id);
+  }
+  if (ParentContainer::add(elem)) {
+    manager.commit();
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        strictUpdate(const element& elem)
+{
+  typename ParentContainer::TransactionManager manager(getEnv());
+  if (has(get_id(elem)) && ParentContainer::strictUpdate(elem)) {
+    manager.commit();
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+typename prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        wrapper_type
+        prstorage::ExpiringStorage<Element,
+                                   Marshaller,
+                                   Watcher,
+                                   TxManager,
+                                   Deleter,
+                                   Metrics>::wrapper(const key& id)
+{
+  return wrapper_type(
+      std::static_pointer_cast<ExpiringStorage>(this->shared_from_this()),
+      get(id));
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+typename prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        element
+        prstorage::ExpiringStorage<Element,
+                                   Marshaller,
+                                   Watcher,
+                                   TxManager,
+                                   Deleter,
+                                   Metrics>::get(const key& id) const
+{
+  auto elem = ParentContainer::get(id);
+  if (expired(elem, std::chrono::system_clock::now())) {
+    throw std::range_error("not found element");
+  }
+  return elem;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        has(const key& id) const
+{
+  if (!ParentContainer::has(id)) {
+    return false;
+  }
+  try {
+    return !expired(ParentContainer::get(id),
+                    std::chrono::system_clock::now());
+  } catch (const std::range_error&) {
+    // элемент удален между проверкой и чтением
+    return false;
+  }
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::ExpiringStorage<Element,
+                                                Marshaller,
+                                                Watcher,
+                                                TxManager,
+                                                Deleter,
+                                                Metrics>::element>
+prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        getAllElements() const
+{
+  auto now = std::chrono::system_clock::now();
+  return ParentContainer::get_if(
+      [now](const element& elem) { return !expired(elem, now); });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::ExpiringStorage<Element,
+                                                Marshaller,
+                                                Watcher,
+                                                TxManager,
+                                                Deleter,
+                                                Metrics>::element>
+prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        get_if(std::function<bool(const element&)> p) const
+{
+  auto now = std::chrono::system_clock::now();
+  return ParentContainer::get_if([now, &p](const element& elem) {
+    return !expired(elem, now) && p(elem);
+  });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::ExpiringStorage<Element,
+                                                Marshaller,
+                                                Watcher,
+                                                TxManager,
+                                                Deleter,
+                                                Metrics>::element>
+prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        get_if_lazy(std::function<bool(const lazy_element&)> p) const
+{
+  auto now = std::chrono::system_clock::now();
+  return ParentContainer::get_if_lazy([now, &p](const lazy_element& elem) {
+    return p(elem) && !expired(elem.get(), now);
+  });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename T, typename BinaryOp>
+T prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        reduce(T init, BinaryOp op) const
+{
+  auto now = std::chrono::system_clock::now();
+  return ParentContainer::reduce(
+      std::move(init), [now, &op](T current, const element& elem) {
+        return expired(elem, now) ? std::move(current)
+                                  : op(std::move(current), elem);
+      });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        count_if(std::function<bool(const element&)> p) const
+{
+  return count_elements_if(*this, p);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        count_if_lazy(std::function<bool(const lazy_element&)> p) const
+{
+  auto now = std::chrono::system_clock::now();
+  return ParentContainer::count_if_lazy([now, &p](const lazy_element& elem) {
+    return p(elem) && !expired(elem.get(), now);
+  });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename KeyFn>
+std::optional<typename prstorage::ExpiringStorage<Element,
+                                                  Marshaller,
+                                                  Watcher,
+                                                  TxManager,
+                                                  Deleter,
+                                                  Metrics>::element>
+prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        min_by(KeyFn keyFn) const
+{
+  return best_element_by(*this, keyFn, std::less<>());
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename KeyFn>
+std::optional<typename prstorage::ExpiringStorage<Element,
+                                                  Marshaller,
+                                                  Watcher,
+                                                  TxManager,
+                                                  Deleter,
+                                                  Metrics>::element>
+prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        max_by(KeyFn keyFn) const
+{
+  return best_element_by(*this, keyFn, std::greater<>());
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename KeyFn>
+prstorage::GroupCounts<Element, KeyFn> prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        group_count(KeyFn keyFn) const
+{
+  return group_count_elements(*this, keyFn);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        removeExpired(std::size_t batchSize, time_point now)
+{
+  std::size_t scanned = 0;
+  return removeExpired(batchSize, now, scanned);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        removeExpired(std::size_t batchSize,
+                      time_point now,
+                      std::size_t& scanned)
+{
+  typename ParentContainer::TransactionManager manager(getEnv());
+  auto env = getEnv();
+
+  std::vector<key> ids;
+  {
+    Dbc* cursor = nullptr;
+    check(mExpiryDb->cursor(env ? dbstl::current_txn(env) : nullptr, &cursor,
+                            0));
+    auto closer = [](Dbc* c) { c->close(); };
+    std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+    unsigned char expiryBytes[EXPIRY_KEY_SIZE];
+    Dbt expiry, primary, data;
+    expiry.set_data(expiryBytes);
+    expiry.set_ulen(EXPIRY_KEY_SIZE);
+    expiry.set_flags(DB_DBT_USERMEM);
+    primary.set_flags(DB_DBT_REALLOC);
+    // значение элемента не читается: dlen == 0
+    data.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+    std::unique_ptr<void, decltype(&std::free)> primaryData(nullptr,
+                                                            &std::free);
+
+    auto flags = DB_FIRST;
+    while (ids.size() < batchSize) {
+      auto ret = cursor->pget(&expiry, &primary, &data, flags);
+      // DB_DBT_REALLOC мог переместить буфер ключа
+      primaryData.release();
+      primaryData.reset(primary.get_data());
+      if (ret == DB_NOTFOUND) {
+        break;
+      }
+      check(ret);
+      if (decode_expiry(expiryBytes) > now) {
+        break;
+      }
+      ids.push_back(KeyDbt<key>::decode(primary));
+      flags = DB_NEXT;
+    }
+  }
+
+  // курсор закрыт до начала вложенных транзакций remove
+  scanned = ids.size();
+  std::size_t res = 0;
+  for (const auto& id : ids) {
+    if (this->remove(id)) {
+      ++res;
+    }
+  }
+  manager.commit();
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<Db*> prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        databases() const
+{
+  return {mDb, mExpiryDb};
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        expired(const element& elem, time_point now)
+{
+  auto expiry = get_expiry(elem);
+  return expiry != time_point() && expiry <= now;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+void prstorage::
+    ExpiringStorage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+#endif  // EXPIRINGSTORAGE_H
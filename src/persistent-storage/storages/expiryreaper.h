@@ -0,0 +1,181 @@
+#ifndef EXPIRYREAPER_H
+#define EXPIRYREAPER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "threadregistry.h"
+
+namespace prstorage {
+/**
+ * Фоновое удаление истекших элементов ExpiringStorage.
+ *
+ * С периодом interval поток удаляет истекшие элементы порциями по batchSize
+ * элементов, каждая порция удаляется в своей транзакции, поэтому блокировки
+ * не удерживаются дольше одной порции, а между порциями выдерживается пауза.
+ * Поток регистрирует окружение и базы данных хранилища в dbstl через
+ * ThreadRegistry; если регистрация не удалась, ошибка выводится в std::cerr
+ * и поток завершается.
+ *
+ * @tparam StorageType тип хранилища, например ExpiringStorage<...>
+ */
+template <typename StorageType>
+class ExpiryReaper {
+ public:
+  struct Options {
+    /// максимальное количество элементов, удаляемых в одной транзакции
+    std::size_t batchSize = 1000;
+    /// пауза между транзакциями
+    std::chrono::milliseconds pause{10};
+    /// период фонового удаления, 0 - фоновый поток не запускается
+    std::chrono::milliseconds interval{1000};
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса, запускает фоновый поток
+   * @throws std::invalid_argument, если batchSize равен 0
+   */
+  ExpiryReaper(std::shared_ptr<StorageType> storage, Options options);
+  explicit ExpiryReaper(std::shared_ptr<StorageType> storage);
+  ~ExpiryReaper();
+
+ private:
+  ExpiryReaper(const ExpiryReaper&) = delete;
+  ExpiryReaper& operator=(const ExpiryReaper&) = delete;
+
+ public:
+  /**
+   * @brief Удаляет все элементы, истекшие к моменту вызова, порциями по
+   * batchSize элементов. Вызывающий поток должен быть зарегистрирован в
+   * dbstl.
+   * @return количество удаленных элементов
+   */
+  std::size_t reap();
+
+  /**
+   * @brief Возвращает количество элементов, удаленных объектом
+   */
+  std::uint64_t removedCount() const noexcept;
+
+ private:
+  bool waitStop(std::chrono::milliseconds timeout);
+  void reaperLoop();
+
+ private:
+  std::shared_ptr<StorageType> mStorage;
+  Options mOptions;
+  std::atomic<std::uint64_t> mRemoved{0};
+
+  std::mutex mStopMutex;
+  std::condition_variable mStopCondition;
+  bool mStopped = false;
+  std::thread mThread;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename StorageType>
+prstorage::ExpiryReaper<StorageType>::ExpiryReaper(
+    std::shared_ptr<StorageType> storage,
+    Options options) :
+    mStorage(std::move(storage)),
+    mOptions(options)
+{
+  if (mOptions.batchSize == 0) {
+    throw std::invalid_argument("batch size must be positive");
+  }
+  if (mOptions.interval.count() > 0) {
+    mThread = std::thread(&ExpiryReaper::reaperLoop, this);
+  }
+}
+
+template <typename StorageType>
+prstorage::ExpiryReaper<StorageType>::ExpiryReaper(
+    std::shared_ptr<StorageType> storage) :
+    ExpiryReaper(std::move(storage), Options())
+{
+}
+
+template <typename StorageType>
+prstorage::ExpiryReaper<StorageType>::~ExpiryReaper()
+{
+  {
+    std::lock_guard<std::mutex> lock(mStopMutex);
+    mStopped = true;
+  }
+  mStopCondition.notify_all();
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+}
+
+template <typename StorageType>
+std::size_t prstorage::ExpiryReaper<StorageType>::reap()
+{
+  auto now = std::chrono::system_clock::now();
+  std::size_t res = 0;
+  while (true) {
+    // элементы, удаленные другим потоком между чтением индекса и remove, не
+    // означают, что истекших элементов больше нет
+    std::size_t scanned = 0;
+    auto removed = mStorage->removeExpired(mOptions.batchSize, now, scanned);
+    res += removed;
+    mRemoved += removed;
+    if (scanned < mOptions.batchSize || waitStop(mOptions.pause)) {
+      break;
+    }
+  }
+  return res;
+}
+
+template <typename StorageType>
+std::uint64_t prstorage::ExpiryReaper<StorageType>::removedCount()
+    const noexcept
+{
+  return mRemoved;
+}
+
+template <typename StorageType>
+bool prstorage::ExpiryReaper<StorageType>::waitStop(
+    std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mStopMutex);
+  if (timeout.count() > 0) {
+    mStopCondition.wait_for(lock, timeout, [this] { return mStopped; });
+  }
+  return mStopped;
+}
+
+template <typename StorageType>
+void prstorage::ExpiryReaper<StorageType>::reaperLoop()
+{
+  // исключение за пределами потока привело бы к std::terminate
+  try {
+    ThreadRegistry::registerAll(mStorage->getEnv(), mStorage->databases());
+  } catch (const std::exception& ex) {
+    std::cerr << "Get exception when try to register reaper thread : "
+              << ex.what() << std::endl;
+    // фоновое удаление не выполняется, reap() остается доступным
+    ThreadRegistry::threadExit();
+    return;
+  }
+  while (!waitStop(mOptions.interval)) {
+    try {
+      reap();
+    } catch (const std::exception& ex) {
+      std::cerr << "Get exception when try to remove expired elements : "
+                << ex.what() << std::endl;
+    }
+  }
+  ThreadRegistry::threadExit();
+}
+
+#endif  // EXPIRYREAPER_H
@@ -0,0 +1,287 @@
+#ifndef LOGSTORAGE_H
+#define LOGSTORAGE_H
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "persistent-storage/deleters/logdeleter.h"
+#include "persistent-storage/logstore/logtable.h"
+#include "persistent-storage/watchers/watchertraits.h"
+#include "persistent-storage/wrappers/transparentcontainerelementwrapper.h"
+
+namespace prstorage {
+/**
+ * Шаблонный класс-контейнер с тем же интерфейсом, что и Storage, но
+ * хранящий элементы во встроенном журнальном хранилище LogStore вместо
+ * Berkeley DB.
+ *
+ * Каждая запись в LogStore атомарна, поэтому политика TxManager не
+ * используется. Marshaller передается экземпляром в конструктор, Deleter
+ * работает с LogTable, например LogDeleter.
+ *
+ * Требования к Element, Marshaller и Watcher такие же, как у Storage.
+ */
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter =
+              LogDeleter<decltype(get_id(std::declval<Element>())), Element>>
+class LogStorage
+    : public std::enable_shared_from_this<
+          LogStorage<Element, Marshaller, Watcher, Deleter>>,
+      public Watcher {
+ public:
+  using element = Element;
+  using watcher_type = Watcher;
+  using key = decltype(get_id(std::declval<Element>()));
+  using wrapper_type = TransparentContainerElementWrapper<
+      LogStorage<Element, Marshaller, Watcher, Deleter>>;
+  using table_type = LogTable<key, Element, Marshaller>;
+
+ public:
+  /**
+   * @brief Контруктор класса
+   * @param store открытое журнальное хранилище, в котором хранятся элементы
+   * @param deleter объект, который выполняет удаление элементов
+   * @param marshaller объект, который выполняет маршалинг элементов
+   */
+  explicit LogStorage(std::shared_ptr<LogStore> store,
+                      Deleter&& deleter = Deleter(),
+                      Marshaller marshaller = Marshaller());
+
+ public:
+  bool add(const element& elem);
+  bool remove(const key& id);
+  bool strictUpdate(const element& elem);
+  void update(const element& elem);
+  wrapper_type wrapper(const key& id);
+
+ public:
+  /**
+   * @throws std::range_error при отсутствии ключа
+   */
+  element get(const key& id) const;
+  bool has(const key& id) const;
+  std::vector<element> getAllElements() const;
+  int size() const noexcept;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+
+ protected:
+  element find(std::function<bool(const element&)> is) const;
+  Deleter& getDeleter();
+  table_type& getTable() const;
+
+ private:
+  mutable table_type mTable;
+  Deleter mDeleter;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::LogStorage(
+    std::shared_ptr<LogStore> store,
+    Deleter&& deleter,
+    Marshaller marshaller) :
+    mTable(std::move(store), std::move(marshaller)),
+    mDeleter(std::forward<Deleter>(deleter))
+{
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+bool prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::add(
+    const LogStorage::element& elem)
+{
+  if (mTable.insert(get_id(elem), elem)) {
+    watcher_type::elementAdded(elem);
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+bool prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::remove(
+    const key& id)
+{
+  if constexpr (!removed_value_needed<Watcher>::value &&
+                !removed_value_needed<Deleter>::value) {
+    if (mDeleter.erase(mTable, id)) {
+      watcher_type::keyRemoved(id);
+      return true;
+    }
+  } else if (auto res = mDeleter(mTable, id); res) {
+    watcher_type::elementRemoved(*res);
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+bool prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::
+    strictUpdate(const LogStorage::element& elem)
+{
+  if (mTable.replace(get_id(elem), elem)) {
+    watcher_type::elementUpdated(elem);
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+void prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::update(
+    const LogStorage::element& elem)
+{
+  mTable.put(get_id(elem), elem);
+  watcher_type::elementUpdated(elem);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+typename prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::
+    wrapper_type
+    prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::wrapper(
+        const key& id)
+{
+  return wrapper_type(this->shared_from_this(), get(id));
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+typename prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::element
+prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::get(
+    const key& id) const
+{
+  if (auto res = mTable.get(id)) {
+    return *res;
+  }
+  throw std::range_error("not found element");
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+bool prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::has(
+    const key& id) const
+{
+  return mTable.exists(id);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+std::vector<
+    typename prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::
+        element>
+prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::getAllElements()
+    const
+{
+  std::vector<element> res;
+  res.reserve(mTable.count());
+  mTable.forEach([&res](const element& elem) {
+    res.push_back(elem);
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+int prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::size()
+    const noexcept
+{
+  return static_cast<int>(mTable.count());
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+std::vector<
+    typename prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::
+        element>
+prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::get_if(
+    std::function<bool(const element&)> p) const
+{
+  std::vector<element> res;
+  mTable.forEach([&res, &p](const element& elem) {
+    if (p(elem)) {
+      res.push_back(elem);
+    }
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+typename prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::element
+prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::find(
+    std::function<bool(const LogStorage::element&)> is) const
+{
+  std::optional<element> res;
+  mTable.forEach([&res, &is](const element& elem) {
+    if (is(elem)) {
+      res = elem;
+      return false;
+    }
+    return true;
+  });
+
+  if (res) {
+    return *res;
+  }
+
+  throw std::range_error("not found element");
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+Deleter&
+prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::getDeleter()
+{
+  return mDeleter;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename Deleter>
+typename prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::
+    table_type&
+    prstorage::LogStorage<Element, Marshaller, Watcher, Deleter>::getTable()
+        const
+{
+  return mTable;
+}
+
+#endif  // LOGSTORAGE_H
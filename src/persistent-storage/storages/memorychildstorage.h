@@ -0,0 +1,269 @@
+#ifndef MEMORYCHILDSTORAGE_H
+#define MEMORYCHILDSTORAGE_H
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+
+#include "memorysecondaryindex.h"
+#include "memorystorage.h"
+
+#include "persistent-storage/deleters/cascadereport.h"
+#include "persistent-storage/watchers/watchertraits.h"
+
+#include "persistent-storage/deleters/defaultchilddeleter.h"
+#include "persistent-storage/deleters/defaultdeleter.h"
+
+namespace prstorage {
+/**
+ * Аналог ChildStorage для MemoryStorage. Вместо вторичной базы Berkeley DB
+ * используется MemorySecondaryIndex, поэтому подходят те же удалители:
+ * DefaultChildDeleter и ChildThatIsParentDeleter.
+ *
+ * childrenOf возвращает копии элементов, сделанные под блокировкой
+ * контейнера. Уведомления Watcher об удаленных потомках выполняются после
+ * снятия блокировки; удаление на следующем уровне иерархии выполняется под
+ * ней, блокировки захватываются от родителя к потомку.
+ */
+template <
+    typename Element,
+    typename Parent,
+    typename Watcher,
+    typename Deleter = DefaultChildDeleter<
+        decltype(get_id(std::declval<Element>())),
+        Element,
+        Parent,
+        KeyOnlyDeleter<decltype(get_id(std::declval<Element>())), Element>>,
+    typename Index =
+        std::map<decltype(get_id(std::declval<Element>())), Element>>
+class MemoryChildStorage
+    : public MemoryStorage<Element, Watcher, Deleter, Index> {
+ public:
+  using ParentContainer = MemoryStorage<Element, Watcher, Deleter, Index>;
+  using ParentElementId = decltype(get_id(std::declval<Parent>()));
+  using SecondaryIndex =
+      MemorySecondaryIndex<ParentElementId,
+                           typename ParentContainer::map_type>;
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param parentId возвращает идентификатор родителя элемента
+   * @param deleter объект, который выполняет удаление элементов
+   */
+  explicit MemoryChildStorage(
+      std::function<ParentElementId(const Element&)> parentId,
+      Deleter&& deleter = Deleter());
+
+ public:
+  void parentRemoved(const Parent& parent);
+  void parentRemoved(const std::vector<Parent>& parents);
+
+  /**
+   * @brief Удаляет потомков родителей parentIds порциями размера
+   * report.chunkSize() и передает идентификаторы удаленных элементов на
+   * следующий уровень иерархии.
+   * @param parentIds идентификаторы удаленных родителей
+   * @param report накапливает количество удаленных элементов по уровням
+   * @param level уровень иерархии, к которому относится хранилище
+   */
+  void parentIdsRemoved(const std::vector<ParentElementId>& parentIds,
+                        CascadeReport& report,
+                        std::size_t level = 0);
+
+  /**
+   * @brief Удаляет всех потомков родителей parentIds на всех уровнях
+   * иерархии.
+   * @param parentIds идентификаторы родителей
+   * @param chunkSize размер порции, которой удаляются элементы
+   * @return количество удаленных элементов по уровням
+   */
+  CascadeReport removeChildrenOf(
+      const std::vector<ParentElementId>& parentIds,
+      std::size_t chunkSize = CascadeReport::DEFAULT_CHUNK_SIZE);
+
+ public:
+  std::vector<Element> childrenOf(const ParentElementId& parentId) const;
+
+  /**
+   * @brief Возвращает страницу дочерних элементов родителя в порядке
+   * первичного ключа. Продолжение находится поиском в индексе, поэтому
+   * стоимость страницы пропорциональна limit.
+   * @param parentId идентификатор родительского элемента
+   * @param limit максимальное количество элементов на странице
+   * @param afterKey идентификатор последнего элемента предыдущей страницы,
+   * если не задан - возвращается первая страница
+   * @throws std::out_of_range, если элемента afterKey среди потомков
+   * родителя нет, как и в ChildStorage со вторичной базой данных по
+   * умолчанию
+   */
+  std::vector<Element> childrenOf(
+      const ParentElementId& parentId,
+      std::size_t limit,
+      const std::optional<typename ParentContainer::key>& afterKey = {}) const;
+  std::size_t childCount(const ParentElementId& parentId) const;
+
+ protected:
+  void notifyRemoved(const std::vector<Element>& elements);
+
+ private:
+  mutable SecondaryIndex mSecondaryKeys;
+};
+}  // namespace prstorage
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    MemoryChildStorage(std::function<ParentElementId(const Element&)> parentId,
+                       Deleter&& deleter) :
+    ParentContainer(std::move(deleter)),
+    mSecondaryKeys(this->getElements(), std::move(parentId))
+{
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+void prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    parentRemoved(const Parent& parent)
+{
+  CascadeReport report;
+  parentIdsRemoved({get_id(parent)}, report);
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+void prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    parentRemoved(const std::vector<Parent>& parents)
+{
+  std::vector<ParentElementId> parentIds;
+  parentIds.reserve(parents.size());
+  std::transform(std::cbegin(parents), std::cend(parents),
+                 std::back_inserter(parentIds),
+                 [](const Parent& parent) { return get_id(parent); });
+  CascadeReport report;
+  parentIdsRemoved(parentIds, report);
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+void prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    parentIdsRemoved(const std::vector<ParentElementId>& parentIds,
+                     CascadeReport& report,
+                     std::size_t level)
+{
+  std::vector<std::vector<Element>> chunks;
+  {
+    std::unique_lock<std::shared_mutex> lock(this->getMutex());
+    this->getDeleter().removeChildsByIds(
+        mSecondaryKeys, parentIds, report, level,
+        [&chunks, &report, level](const std::vector<Element>& removed) {
+          report.addRemoved(level, removed.size());
+          chunks.push_back(removed);
+        });
+  }
+  // Watcher может обращаться к контейнеру, поэтому уведомления выполняются
+  // без блокировки
+  for (const auto& removed : chunks) {
+    notifyRemoved(removed);
+  }
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+prstorage::CascadeReport
+prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    removeChildrenOf(const std::vector<ParentElementId>& parentIds,
+                     std::size_t chunkSize)
+{
+  CascadeReport report(chunkSize);
+  parentIdsRemoved(parentIds, report);
+  return report;
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+void prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    notifyRemoved(const std::vector<Element>& elements)
+{
+  if constexpr (supports_batch_removal<Watcher>::value) {
+    ParentContainer::watcher_type::elementsRemoved(elements);
+  } else {
+    std::for_each(std::cbegin(elements), std::cend(elements),
+                  [this](const Element& element) {
+                    ParentContainer::watcher_type::elementRemoved(element);
+                  });
+  }
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+std::vector<Element>
+prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    childrenOf(const ParentElementId& parentId) const
+{
+  std::shared_lock<std::shared_mutex> lock(this->getMutex());
+  std::vector<Element> res;
+  auto [begin, end] = mSecondaryKeys.equal_range(parentId);
+  std::transform(begin, end, std::back_inserter(res),
+                 [](const auto& val) { return val.second; });
+  return res;
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+std::vector<Element>
+prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    childrenOf(
+        const ParentElementId& parentId,
+        std::size_t limit,
+        const std::optional<typename ParentContainer::key>& afterKey) const
+{
+  std::shared_lock<std::shared_mutex> lock(this->getMutex());
+  std::vector<Element> res;
+  auto [it, end] = afterKey
+                       ? mSecondaryKeys.equal_range_after(parentId, *afterKey)
+                       : mSecondaryKeys.equal_range(parentId);
+  for (; it != end && res.size() < limit; ++it) {
+    res.push_back((*it).second);
+  }
+  return res;
+}
+
+template <typename Element,
+          typename Parent,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+std::size_t
+prstorage::MemoryChildStorage<Element, Parent, Watcher, Deleter, Index>::
+    childCount(const ParentElementId& parentId) const
+{
+  std::shared_lock<std::shared_mutex> lock(this->getMutex());
+  return mSecondaryKeys.count(parentId);
+}
+
+#endif  // MEMORYCHILDSTORAGE_H
@@ -0,0 +1,175 @@
+#ifndef MEMORYMAP_H
+#define MEMORYMAP_H
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Интерфейс вторичного индекса, который связывается с MemoryMap. Аналог
+ * Db::associate для хранилищ в памяти.
+ */
+template <typename K, typename V>
+class MemoryAssociation {
+ public:
+  virtual ~MemoryAssociation() = default;
+
+  virtual void added(const K& key, const V& value) = 0;
+  virtual void removed(const K& key, const V& value) = 0;
+};
+
+/**
+ * Ассоциативный контейнер в памяти с подмножеством интерфейса
+ * dbstl::db_map, которое используют удалители. Элементы хранятся в
+ * декодированном виде, маршалинг не выполняется.
+ *
+ * Изменение элементов выполняется только через методы контейнера, чтобы
+ * поддерживать связанные вторичные индексы, поэтому итераторы константные.
+ *
+ * @tparam Index контейнер, в котором хранятся элементы, например
+ * std::map<K, V> (упорядоченный обход, как у DB_BTREE) или
+ * std::unordered_map<K, V> (поиск за константное время)
+ */
+template <typename K, typename V, typename Index = std::map<K, V>>
+class MemoryMap {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = typename Index::value_type;
+  using size_type = typename Index::size_type;
+  using iterator = typename Index::const_iterator;
+  using const_iterator = typename Index::const_iterator;
+
+ public:
+  MemoryMap() = default;
+
+ private:
+  MemoryMap(const MemoryMap&) = delete;
+  MemoryMap& operator=(const MemoryMap&) = delete;
+
+ public:
+  const_iterator begin() const noexcept { return mIndex.cbegin(); }
+  const_iterator end() const noexcept { return mIndex.cend(); }
+  const_iterator cbegin() const noexcept { return mIndex.cbegin(); }
+  const_iterator cend() const noexcept { return mIndex.cend(); }
+
+  const_iterator find(const K& key) const { return mIndex.find(key); }
+  size_type count(const K& key) const { return mIndex.count(key); }
+  size_type size() const noexcept { return mIndex.size(); }
+
+  /**
+   * @brief Добавляет элемент, если ключ отсутствует
+   */
+  std::pair<const_iterator, bool> insert(const value_type& value);
+
+  /**
+   * @brief Добавляет или перезаписывает элемент
+   */
+  void put(const K& key, const V& value);
+
+  /**
+   * @brief Перезаписывает элемент, только если ключ присутствует
+   */
+  bool replace(const K& key, const V& value);
+
+  const_iterator erase(const_iterator it);
+  size_type erase(const K& key);
+
+  /**
+   * @brief Связывает контейнер со вторичным индексом. Индекс заполняется
+   * существующими элементами и далее получает уведомления об изменениях.
+   */
+  void associate(MemoryAssociation<K, V>* secondary);
+
+ private:
+  void notifyAdded(const K& key, const V& value);
+  void notifyRemoved(const K& key, const V& value);
+
+ private:
+  Index mIndex;
+  std::vector<MemoryAssociation<K, V>*> mSecondaries;
+};
+}  // namespace prstorage
+
+template <typename K, typename V, typename Index>
+std::pair<typename prstorage::MemoryMap<K, V, Index>::const_iterator, bool>
+prstorage::MemoryMap<K, V, Index>::insert(const value_type& value)
+{
+  auto res = mIndex.insert(value);
+  if (res.second) {
+    notifyAdded(value.first, value.second);
+  }
+  return {res.first, res.second};
+}
+
+template <typename K, typename V, typename Index>
+void prstorage::MemoryMap<K, V, Index>::put(const K& key, const V& value)
+{
+  if (!replace(key, value)) {
+    insert(value_type(key, value));
+  }
+}
+
+template <typename K, typename V, typename Index>
+bool prstorage::MemoryMap<K, V, Index>::replace(const K& key, const V& value)
+{
+  auto it = mIndex.find(key);
+  if (it == mIndex.end()) {
+    return false;
+  }
+  notifyRemoved(key, it->second);
+  it->second = value;
+  notifyAdded(key, it->second);
+  return true;
+}
+
+template <typename K, typename V, typename Index>
+typename prstorage::MemoryMap<K, V, Index>::const_iterator
+prstorage::MemoryMap<K, V, Index>::erase(const_iterator it)
+{
+  notifyRemoved(it->first, it->second);
+  return mIndex.erase(it);
+}
+
+template <typename K, typename V, typename Index>
+typename prstorage::MemoryMap<K, V, Index>::size_type
+prstorage::MemoryMap<K, V, Index>::erase(const K& key)
+{
+  if (auto it = mIndex.find(key); it != mIndex.end()) {
+    erase(const_iterator(it));
+    return 1;
+  }
+  return 0;
+}
+
+template <typename K, typename V, typename Index>
+void prstorage::MemoryMap<K, V, Index>::associate(
+    MemoryAssociation<K, V>* secondary)
+{
+  mSecondaries.push_back(secondary);
+  for (const auto& [key, value] : mIndex) {
+    secondary->added(key, value);
+  }
+}
+
+template <typename K, typename V, typename Index>
+void prstorage::MemoryMap<K, V, Index>::notifyAdded(const K& key,
+                                                    const V& value)
+{
+  for (auto secondary : mSecondaries) {
+    secondary->added(key, value);
+  }
+}
+
+template <typename K, typename V, typename Index>
+void prstorage::MemoryMap<K, V, Index>::notifyRemoved(const K& key,
+                                                      const V& value)
+{
+  for (auto secondary : mSecondaries) {
+    secondary->removed(key, value);
+  }
+}
+
+#endif  // MEMORYMAP_H
@@ -0,0 +1,214 @@
+#ifndef MEMORYSECONDARYINDEX_H
+#define MEMORYSECONDARYINDEX_H
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+#include "memorymap.h"
+
+namespace prstorage {
+/**
+ * Вторичный индекс в памяти над MemoryMap с подмножеством интерфейса
+ * dbstl::db_multimap, которое используют удалители дочерних элементов.
+ *
+ * Как и вторичная база Berkeley DB, индекс обновляется автоматически при
+ * изменении основного контейнера, а удаление по вторичному ключу удаляет
+ * элементы из основного контейнера. Элементы одного вторичного ключа
+ * обходятся в порядке возрастания первичного ключа.
+ */
+template <typename SecKey, typename Map>
+class MemorySecondaryIndex
+    : public MemoryAssociation<typename Map::key_type,
+                               typename Map::mapped_type> {
+ public:
+  using key_type = SecKey;
+  using primary_key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using value_type = std::pair<SecKey, mapped_type>;
+  using KeyExtractor = std::function<SecKey(const mapped_type&)>;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = MemorySecondaryIndex::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = value_type;
+
+   public:
+    const_iterator() = default;
+    const_iterator(const Map* primary,
+                   const SecKey* key,
+                   typename std::set<primary_key_type>::const_iterator it) :
+        mPrimary(primary),
+        mKey(key), mIt(it)
+    {
+    }
+
+   public:
+    value_type operator*() const
+    {
+      return value_type(*mKey, mPrimary->find(*mIt)->second);
+    }
+    const_iterator& operator++()
+    {
+      ++mIt;
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      auto res = *this;
+      ++mIt;
+      return res;
+    }
+    bool operator==(const const_iterator& other) const
+    {
+      return mIt == other.mIt;
+    }
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+   private:
+    const Map* mPrimary = nullptr;
+    const SecKey* mKey = nullptr;
+    typename std::set<primary_key_type>::const_iterator mIt;
+  };
+  using iterator = const_iterator;
+
+ public:
+  /**
+   * @brief Конструктор класса, связывает индекс с основным контейнером
+   * @param primary основной контейнер
+   * @param extractor возвращает вторичный ключ элемента, аналог функции
+   * обратного вызова Db::associate
+   */
+  MemorySecondaryIndex(Map& primary, KeyExtractor extractor);
+
+ private:
+  MemorySecondaryIndex(const MemorySecondaryIndex&) = delete;
+  MemorySecondaryIndex& operator=(const MemorySecondaryIndex&) = delete;
+
+ public:
+  std::pair<const_iterator, const_iterator> equal_range(
+      const SecKey& key) const;
+  std::size_t count(const SecKey& key) const;
+
+  /**
+   * @brief Возвращает элементы со вторичным ключом key, следующие за
+   * элементом с первичным ключом after, аналог DB_GET_BOTH_RANGE
+   * @throws std::out_of_range, если элемента after со вторичным ключом key
+   * нет
+   */
+  std::pair<const_iterator, const_iterator> equal_range_after(
+      const SecKey& key,
+      const primary_key_type& after) const;
+
+  /**
+   * @brief Удаляет из основного контейнера все элементы со вторичным ключом
+   * key
+   * @return количество удаленных элементов
+   */
+  std::size_t erase(const SecKey& key);
+
+ protected:
+  void added(const primary_key_type& key, const mapped_type& value) override;
+  void removed(const primary_key_type& key,
+               const mapped_type& value) override;
+
+ private:
+  Map& mPrimary;
+  KeyExtractor mExtractor;
+  std::map<SecKey, std::set<primary_key_type>> mKeys;
+};
+}  // namespace prstorage
+
+template <typename SecKey, typename Map>
+prstorage::MemorySecondaryIndex<SecKey, Map>::MemorySecondaryIndex(
+    Map& primary,
+    KeyExtractor extractor) :
+    mPrimary(primary),
+    mExtractor(std::move(extractor))
+{
+  mPrimary.associate(this);
+}
+
+template <typename SecKey, typename Map>
+std::pair<typename prstorage::MemorySecondaryIndex<SecKey, Map>::const_iterator,
+          typename prstorage::MemorySecondaryIndex<SecKey, Map>::const_iterator>
+prstorage::MemorySecondaryIndex<SecKey, Map>::equal_range(
+    const SecKey& key) const
+{
+  auto it = mKeys.find(key);
+  if (it == mKeys.end()) {
+    return {const_iterator(), const_iterator()};
+  }
+  return {const_iterator(&mPrimary, &it->first, it->second.cbegin()),
+          const_iterator(&mPrimary, &it->first, it->second.cend())};
+}
+
+template <typename SecKey, typename Map>
+std::pair<typename prstorage::MemorySecondaryIndex<SecKey, Map>::const_iterator,
+          typename prstorage::MemorySecondaryIndex<SecKey, Map>::const_iterator>
+prstorage::MemorySecondaryIndex<SecKey, Map>::equal_range_after(
+    const SecKey& key,
+    const primary_key_type& after) const
+{
+  auto it = mKeys.find(key);
+  if (it == mKeys.end() || !it->second.count(after)) {
+    throw std::out_of_range("page token not found");
+  }
+  return {const_iterator(&mPrimary, &it->first, it->second.upper_bound(after)),
+          const_iterator(&mPrimary, &it->first, it->second.cend())};
+}
+
+template <typename SecKey, typename Map>
+std::size_t prstorage::MemorySecondaryIndex<SecKey, Map>::count(
+    const SecKey& key) const
+{
+  auto it = mKeys.find(key);
+  return it == mKeys.end() ? 0 : it->second.size();
+}
+
+template <typename SecKey, typename Map>
+std::size_t prstorage::MemorySecondaryIndex<SecKey, Map>::erase(
+    const SecKey& key)
+{
+  auto node = mKeys.extract(key);
+  if (node.empty()) {
+    return 0;
+  }
+  for (const auto& primaryKey : node.mapped()) {
+    mPrimary.erase(primaryKey);
+  }
+  return node.mapped().size();
+}
+
+template <typename SecKey, typename Map>
+void prstorage::MemorySecondaryIndex<SecKey, Map>::added(
+    const primary_key_type& key,
+    const mapped_type& value)
+{
+  mKeys[mExtractor(value)].insert(key);
+}
+
+template <typename SecKey, typename Map>
+void prstorage::MemorySecondaryIndex<SecKey, Map>::removed(
+    const primary_key_type& key,
+    const mapped_type& value)
+{
+  if (auto it = mKeys.find(mExtractor(value)); it != mKeys.end()) {
+    it->second.erase(key);
+    if (it->second.empty()) {
+      mKeys.erase(it);
+    }
+  }
+}
+
+#endif  // MEMORYSECONDARYINDEX_H
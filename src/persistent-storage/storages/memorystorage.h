@@ -0,0 +1,319 @@
+#ifndef MEMORYSTORAGE_H
+#define MEMORYSTORAGE_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "memorymap.h"
+#include "persistent-storage/deleters/defaultdeleter.h"
+#include "persistent-storage/watchers/watchertraits.h"
+#include "persistent-storage/wrappers/transparentcontainerelementwrapper.h"
+
+namespace prstorage {
+/**
+ * Шаблонный класс-контейнер с тем же интерфейсом, что и Storage, который
+ * хранит декодированные элементы в памяти процесса. Предназначен для
+ * горячих кешей и тестов: Berkeley DB и маршалинг не используются.
+ *
+ * @tparam Element тип хранимого элемента
+ * @tparam Watcher тип, который получает уведомления об изменениях, как у
+ * Storage
+ * @tparam Deleter отвечает за удаление элемента из контейнера, подходят те
+ * же удалители, что и для Storage, например DefaultDeleter или
+ * ParentsDeleter
+ * @tparam Index контейнер, в котором хранятся элементы: std::map
+ * (упорядоченный обход) или std::unordered_map (поиск за константное время)
+ *
+ * Операции над контейнером защищены std::shared_mutex, уведомления Watcher
+ * выполняются после снятия блокировки. Каскадное удаление дочерних
+ * элементов выполняется под блокировкой родительского контейнера.
+ */
+template <typename Element,
+          typename Watcher,
+          typename Deleter =
+              KeyOnlyDeleter<decltype(get_id(std::declval<Element>())),
+                             Element>,
+          typename Index =
+              std::map<decltype(get_id(std::declval<Element>())), Element>>
+class MemoryStorage
+    : public std::enable_shared_from_this<
+          MemoryStorage<Element, Watcher, Deleter, Index>>,
+      public Watcher {
+ public:
+  using element = Element;
+  using watcher_type = Watcher;
+  using key = decltype(get_id(std::declval<Element>()));
+  using wrapper_type = TransparentContainerElementWrapper<
+      MemoryStorage<Element, Watcher, Deleter, Index>>;
+  using map_type = MemoryMap<key, Element, Index>;
+
+ public:
+  /**
+   * @brief Контруктор класса
+   * @param deleter объект, который выполняет удаление элементов
+   */
+  explicit MemoryStorage(Deleter&& deleter = Deleter());
+
+ public:
+  bool add(const element& elem);
+  bool remove(const key& id);
+  bool strictUpdate(const element& elem);
+  void update(const element& elem);
+  wrapper_type wrapper(const key& id);
+
+ public:
+  /**
+   * @throws std::range_error при отсутствии ключа
+   */
+  element get(const key& id) const;
+  bool has(const key& id) const;
+  std::vector<element> getAllElements() const;
+  int size() const noexcept;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+
+ protected:
+  element find(std::function<bool(const element&)> is) const;
+  Deleter& getDeleter();
+  map_type& getElements() const;
+  std::shared_mutex& getMutex() const;
+
+ private:
+  mutable std::shared_mutex mMutex;
+  mutable map_type mElements;
+  Deleter mDeleter;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::MemoryStorage(
+    Deleter&& deleter) :
+    mDeleter(std::forward<Deleter>(deleter))
+{
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+bool prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::add(
+    const MemoryStorage::element& elem)
+{
+  {
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    if (!mElements.insert(std::make_pair(get_id(elem), elem)).second) {
+      return false;
+    }
+  }
+  watcher_type::elementAdded(elem);
+  return true;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+bool prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::remove(
+    const key& id)
+{
+  if constexpr (!removed_value_needed<Watcher>::value &&
+                !removed_value_needed<Deleter>::value) {
+    bool res = false;
+    {
+      std::unique_lock<std::shared_mutex> lock(mMutex);
+      res = mDeleter.erase(mElements, id);
+    }
+    if (res) {
+      watcher_type::keyRemoved(id);
+    }
+    return res;
+  } else {
+    std::optional<element> res;
+    {
+      std::unique_lock<std::shared_mutex> lock(mMutex);
+      res = mDeleter(mElements, id);
+    }
+    if (res) {
+      watcher_type::elementRemoved(*res);
+    }
+    return res.has_value();
+  }
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+bool prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::strictUpdate(
+    const MemoryStorage::element& elem)
+{
+  {
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    if (!mElements.replace(get_id(elem), elem)) {
+      return false;
+    }
+  }
+  watcher_type::elementUpdated(elem);
+  return true;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+void prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::update(
+    const MemoryStorage::element& elem)
+{
+  {
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    mElements.put(get_id(elem), elem);
+  }
+  watcher_type::elementUpdated(elem);
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+typename prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::
+    wrapper_type
+    prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::wrapper(
+        const key& id)
+{
+  return wrapper_type(this->shared_from_this(), get(id));
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+typename prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::element
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::get(
+    const key& id) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  if (auto iter = mElements.find(id); iter != mElements.end()) {
+    return iter->second;
+  }
+  throw std::range_error("not found element");
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+bool prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::has(
+    const key& id) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mElements.count(id) > 0;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+std::vector<
+    typename prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::
+        element>
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::getAllElements()
+    const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  std::vector<element> res;
+  res.reserve(mElements.size());
+  std::transform(mElements.begin(), mElements.end(), std::back_inserter(res),
+                 [](const auto& elem) { return elem.second; });
+  return res;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+int prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::size()
+    const noexcept
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return static_cast<int>(mElements.size());
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+std::vector<
+    typename prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::
+        element>
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::get_if(
+    std::function<bool(const element&)> p) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  std::vector<element> res;
+  for (const auto& elem : mElements) {
+    if (p(elem.second)) {
+      res.push_back(elem.second);
+    }
+  }
+  return res;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+typename prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::element
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::find(
+    std::function<bool(const MemoryStorage::element&)> is) const
+{
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  auto it = std::find_if(mElements.begin(), mElements.end(),
+                         [&is](const auto& elem) { return is(elem.second); });
+  if (it != mElements.end()) {
+    return it->second;
+  }
+
+  throw std::range_error("not found element");
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+Deleter&
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::getDeleter()
+{
+  return mDeleter;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+typename prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::map_type&
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::getElements() const
+{
+  return mElements;
+}
+
+template <typename Element,
+          typename Watcher,
+          typename Deleter,
+          typename Index>
+std::shared_mutex&
+prstorage::MemoryStorage<Element, Watcher, Deleter, Index>::getMutex() const
+{
+  return mMutex;
+}
+
+#endif  // MEMORYSTORAGE_H
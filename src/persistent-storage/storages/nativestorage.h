@@ -0,0 +1,497 @@
+#ifndef NATIVESTORAGE_H
+#define NATIVESTORAGE_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#include <db_cxx.h>
+#include <optional>
+#include "nativetable.h"
+#include "nativetransactionmanager.h"
+#include "persistent-storage/deleters/nativedeleter.h"
+#include "persistent-storage/utils/keysrange.h"
+#include "persistent-storage/watchers/watchertraits.h"
+#include "persistent-storage/wrappers/transparentcontainerelementwrapper.h"
+
+namespace prstorage {
+/**
+ * Шаблонный класс-контейнер с тем же интерфейсом, что и Storage, но
+ * работающий напрямую с Db/Dbc/DbTxn без dbstl.
+ *
+ * Отличия от Storage:
+ * - Marshaller передается экземпляром в конструктор, поэтому два хранилища
+ *   с одним типом Element могут использовать разные маршалеры;
+ * - не требуется регистрация окружения и баз в dbstl;
+ * - TxManager должен предоставлять дескриптор транзакции через txn(),
+ *   например NativeTransactionManager;
+ * - Deleter работает с NativeTable, например NativeDeleter.
+ *
+ * Требования к Element, Marshaller и Watcher такие же, как у Storage.
+ */
+template <
+    typename Element,
+    typename Marshaller,
+    typename Watcher,
+    typename TxManager = NativeTransactionManager,
+    typename Deleter =
+        NativeDeleter<decltype(get_id(std::declval<Element>())), Element>>
+class NativeStorage
+    : public std::enable_shared_from_this<
+          NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>>,
+      public Watcher {
+ public:
+  using element = Element;
+  using watcher_type = Watcher;
+  using key = decltype(get_id(std::declval<Element>()));
+  using wrapper_type = TransparentContainerElementWrapper<
+      NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>>;
+  using TransactionManager = TxManager;
+  using table_type = NativeTable<key, Element, Marshaller>;
+
+ public:
+  /**
+   * @brief Контруктор класса
+   * @param db открытая база данных Berkeley DB, в которой хранятся элементы
+   * @param env экземпляр окружения для db
+   * @param deleter объект, который выполняет удаление элементов из БД
+   * @param marshaller объект, который выполняет маршалинг элементов
+   */
+  NativeStorage(Db* db,
+                DbEnv* env,
+                Deleter&& deleter = Deleter(),
+                Marshaller marshaller = Marshaller());
+
+  /**
+   * @brief Контруктор класса
+   * @param db открытая база данных Berkeley DB, в которой хранятся элементы
+   * @param deleter объект, который выполняет удаление элементов из БД
+   * @param marshaller объект, который выполняет маршалинг элементов
+   */
+  explicit NativeStorage(Db* db,
+                         Deleter&& deleter = Deleter(),
+                         Marshaller marshaller = Marshaller());
+
+  /**
+   * @brief Контруктор класса, создает приватную базу данных в памяти
+   * @param deleter объект, который выполняет удаление элементов из БД
+   * @param marshaller объект, который выполняет маршалинг элементов
+   */
+  explicit NativeStorage(Deleter&& deleter = Deleter(),
+                         Marshaller marshaller = Marshaller());
+
+ public:
+  bool add(const element& elem);
+  bool remove(const key& id);
+  bool strictUpdate(const element& elem);
+  void update(const element& elem);
+  wrapper_type wrapper(const key& id);
+
+ public:
+  /**
+   * @throws std::range_error при отсутствии ключа
+   */
+  element get(const key& id) const;
+  bool has(const key& id) const;
+  std::vector<element> getAllElements() const;
+  /**
+   * @brief Подсчитывает элементы курсором без чтения значений
+   */
+  int size() const;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+
+  /**
+   * @brief Возвращает диапазон ключей хранилища без чтения значений
+   */
+  KeysRange<key> keys() const;
+
+  /**
+   * @brief Обходит ключи хранилища без чтения значений элементов
+   * @param callback функция bool(const key&), обход прекращается, когда она
+   * возвращает false
+   */
+  template <typename Callback>
+  void forEachKey(Callback&& callback) const;
+  std::vector<key> getAllKeys() const;
+
+ protected:
+  element find(std::function<bool(const element&)> is) const;
+  Deleter& getDeleter();
+  DbEnv* getEnv() const;
+  table_type& getTable() const;
+
+ private:
+  static Db* createPrivateDb();
+
+ private:
+  struct DbCloser {
+    void operator()(Db* db) const
+    {
+      db->close(0);
+      delete db;
+    }
+  };
+
+ private:
+  std::unique_ptr<Db, DbCloser> mPrivateDb;
+  mutable table_type mTable;
+  DbEnv* mEnv;
+  Deleter mDeleter;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    NativeStorage(Db* db,
+                  DbEnv* env,
+                  Deleter&& deleter,
+                  Marshaller marshaller) :
+    mTable(db, std::move(marshaller)),
+    mEnv(env), mDeleter(std::forward<Deleter>(deleter))
+{
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    NativeStorage(Db* db, Deleter&& deleter, Marshaller marshaller) :
+    NativeStorage(db,
+                  db->get_env(),
+                  std::forward<Deleter>(deleter),
+                  std::move(marshaller))
+{
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    NativeStorage(Deleter&& deleter, Marshaller marshaller) :
+    mPrivateDb(createPrivateDb()),
+    mTable(mPrivateDb.get(), std::move(marshaller)), mEnv(nullptr),
+    mDeleter(std::forward<Deleter>(deleter))
+{
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+bool prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::add(
+        const NativeStorage::element& elem)
+{
+  TransactionManager manager(mEnv);
+  if (mTable.insert(manager.txn(), get_id(elem), elem)) {
+    manager.commit();
+    watcher_type::elementAdded(elem);
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+bool prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::remove(
+        const key& id)
+{
+  TransactionManager manager(mEnv);
+  if constexpr (!removed_value_needed<Watcher>::value &&
+                !removed_value_needed<Deleter>::value) {
+    if (mDeleter.erase(mTable, manager.txn(), id)) {
+      manager.commit();
+      watcher_type::keyRemoved(id);
+      return true;
+    }
+  } else if (auto res = mDeleter(mTable, manager.txn(), id); res) {
+    manager.commit();
+    watcher_type::elementRemoved(*res);
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+bool prstorage::NativeStorage<Element,
+                              Marshaller,
+                              Watcher,
+                              TxManager,
+                              Deleter>::strictUpdate(const NativeStorage::
+                                                         element& elem)
+{
+  TransactionManager manager(mEnv);
+  if (mTable.replace(manager.txn(), get_id(elem), elem)) {
+    manager.commit();
+    watcher_type::elementUpdated(elem);
+    return true;
+  }
+  return false;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+void prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::update(
+        const NativeStorage::element& elem)
+{
+  TransactionManager manager(mEnv);
+  mTable.put(manager.txn(), get_id(elem), elem);
+  manager.commit();
+  watcher_type::elementUpdated(elem);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+typename prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+        wrapper_type
+        prstorage::
+            NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+                wrapper(const key& id)
+{
+  return wrapper_type(this->shared_from_this(), get(id));
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+typename prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::element
+    prstorage::
+        NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::get(
+            const key& id) const
+{
+  if (auto res = mTable.get(nullptr, id)) {
+    return *res;
+  }
+  throw std::range_error("not found element");
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+bool prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::has(
+        const key& id) const
+{
+  return mTable.exists(nullptr, id);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+std::vector<typename prstorage::
+                NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+                    element>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    getAllElements() const
+{
+  std::vector<element> res;
+  mTable.forEach(nullptr, [&res](const element& elem) {
+    res.push_back(elem);
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+int prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::size()
+        const
+{
+  return static_cast<int>(mTable.count(nullptr));
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+std::vector<typename prstorage::
+                NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+                    element>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    get_if(std::function<bool(const element&)> p) const
+{
+  std::vector<element> res;
+  mTable.forEach(nullptr, [&res, &p](const element& elem) {
+    if (p(elem)) {
+      res.push_back(elem);
+    }
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+prstorage::KeysRange<typename prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::key>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    keys() const
+{
+  return KeysRange<key>(mTable.db(), nullptr);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+template <typename Callback>
+void prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::forEachKey(
+        Callback&& callback) const
+{
+  for (const auto& id : keys()) {
+    if (!callback(id)) {
+      return;
+    }
+  }
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+std::vector<typename prstorage::
+                NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+                    key>
+prstorage::NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+    getAllKeys() const
+{
+  std::vector<key> res;
+  forEachKey([&res](const key& id) {
+    res.push_back(id);
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+typename prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::element
+    prstorage::
+        NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::find(
+            std::function<bool(const NativeStorage::element&)> is) const
+{
+  std::optional<element> res;
+  mTable.forEach(nullptr, [&res, &is](const element& elem) {
+    if (is(elem)) {
+      res = elem;
+      return false;
+    }
+    return true;
+  });
+
+  if (res) {
+    return *res;
+  }
+
+  throw std::range_error("not found element");
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+Deleter& prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+        getDeleter()
+{
+  return mDeleter;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+DbEnv* prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::getEnv()
+        const
+{
+  return mEnv;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+typename prstorage::
+    NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+        table_type&
+        prstorage::
+            NativeStorage<Element, Marshaller, Watcher, TxManager, Deleter>::
+                getTable() const
+{
+  return mTable;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter>
+Db* prstorage::NativeStorage<Element,
+                             Marshaller,
+                             Watcher,
+                             TxManager,
+                             Deleter>::createPrivateDb()
+{
+  auto db = std::make_unique<Db>(nullptr, DB_CXX_NO_EXCEPTIONS);
+  if (auto ret =
+          db->open(nullptr, nullptr, nullptr, DB_BTREE, DB_CREATE | DB_THREAD,
+                   0600);
+      ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+  return db.release();
+}
+
+#endif  // NATIVESTORAGE_H
@@ -0,0 +1,331 @@
+#ifndef NATIVETABLE_H
+#define NATIVETABLE_H
+
+#include <algorithm>
+#include <memory>
+
+#include <db_cxx.h>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "persistent-storage/utils/bulkscan.h"
+#include "persistent-storage/utils/keydbt.h"
+#include "persistent-storage/utils/page.h"
+
+namespace prstorage {
+/**
+ * Таблица ключ/значение поверх Db, работающая напрямую с Db/Dbc/DbTxn.
+ *
+ * Ключи кодируются так же, как их сохраняет dbstl (см. KeyDbt), поэтому
+ * таблица может работать с базой, заполненной через Storage. Значения
+ * кодируются экземпляром Marshaller, который принадлежит таблице, а не
+ * глобальному DbstlElemTraits.
+ *
+ * Точечные операции выполняются без курсоров и используют буферы потока,
+ * обход выполняется одним курсором с пакетным чтением DB_MULTIPLE_KEY.
+ */
+template <typename Key, typename Element, typename Marshaller>
+class NativeTable {
+ public:
+  static constexpr std::size_t INITIAL_BUFFER_SIZE = 4 * 1024;
+  static constexpr std::size_t BULK_BUFFER_SIZE = 1024 * 1024;
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param db открытая база данных
+   * @param marshaller объект, выполняющий маршалинг элементов
+   */
+  NativeTable(Db* db, Marshaller marshaller = Marshaller());
+
+ public:
+  /**
+   * @brief Добавляет элемент, если ключ отсутствует
+   * @return false, если элемент с таким ключом уже существует
+   */
+  bool insert(DbTxn* txn, const Key& key, const Element& elem);
+
+  /**
+   * @brief Добавляет или перезаписывает элемент
+   */
+  void put(DbTxn* txn, const Key& key, const Element& elem);
+
+  /**
+   * @brief Перезаписывает элемент, только если ключ присутствует
+   * @return false, если элемента с таким ключом нет
+   */
+  bool replace(DbTxn* txn, const Key& key, const Element& elem);
+
+  std::optional<Element> get(DbTxn* txn, const Key& key) const;
+  bool exists(DbTxn* txn, const Key& key) const;
+
+  /**
+   * @brief Удаляет элемент одной операцией DB->del
+   * @return true, если элемент существовал
+   */
+  bool del(DbTxn* txn, const Key& key);
+
+  /**
+   * @brief Удаляет элемент и возвращает его значение
+   */
+  std::optional<Element> take(DbTxn* txn, const Key& key);
+
+  /**
+   * @brief Обходит все элементы таблицы
+   * @param callback функция bool(const Element&), обход прекращается, когда
+   * она возвращает false
+   */
+  template <typename Callback>
+  void forEach(DbTxn* txn, Callback&& callback) const;
+
+  /**
+   * @brief Обходит все записи таблицы без декодирования значений
+   * @param callback функция bool(const Dbt& key, const Dbt& data), обход
+   * прекращается, когда она возвращает false
+   */
+  template <typename Callback>
+  void scan(DbTxn* txn, Callback&& callback) const;
+
+  /**
+   * @brief Подсчитывает записи курсором, который читает только ключи
+   */
+  std::size_t count(DbTxn* txn) const;
+
+  Db* db() const noexcept;
+  const Marshaller& marshaller() const noexcept;
+
+ private:
+  Dbt encode(const Element& elem) const;
+  Element decode(const Dbt& data) const;
+  static void check(int ret);
+  static std::vector<char>& encodeBuffer();
+  static std::vector<char>& readBuffer();
+
+ private:
+  Db* mDb;
+  Marshaller mMarshaller;
+};
+}  // namespace prstorage
+
+template <typename Key, typename Element, typename Marshaller>
+prstorage::NativeTable<Key, Element, Marshaller>::NativeTable(
+    Db* db,
+    Marshaller marshaller) :
+    mDb(db),
+    mMarshaller(std::move(marshaller))
+{
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::NativeTable<Key, Element, Marshaller>::insert(
+    DbTxn* txn,
+    const Key& key,
+    const Element& elem)
+{
+  KeyDbt<Key> keyDbt(key);
+  auto data = encode(elem);
+  auto ret = mDb->put(txn, keyDbt.get(), &data, DB_NOOVERWRITE);
+  if (ret == DB_KEYEXIST) {
+    return false;
+  }
+  check(ret);
+  return true;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+void prstorage::NativeTable<Key, Element, Marshaller>::put(DbTxn* txn,
+                                                           const Key& key,
+                                                           const Element& elem)
+{
+  KeyDbt<Key> keyDbt(key);
+  auto data = encode(elem);
+  check(mDb->put(txn, keyDbt.get(), &data, 0));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::NativeTable<Key, Element, Marshaller>::replace(
+    DbTxn* txn,
+    const Key& key,
+    const Element& elem)
+{
+  KeyDbt<Key> keyDbt(key);
+  auto ret = mDb->exists(txn, keyDbt.get(), txn ? DB_RMW : 0);
+  if (ret == DB_NOTFOUND) {
+    return false;
+  }
+  check(ret);
+  auto data = encode(elem);
+  check(mDb->put(txn, keyDbt.get(), &data, 0));
+  return true;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::optional<Element> prstorage::NativeTable<Key, Element, Marshaller>::get(
+    DbTxn* txn,
+    const Key& key) const
+{
+  KeyDbt<Key> keyDbt(key);
+  auto& buffer = readBuffer();
+  Dbt data;
+  data.set_flags(DB_DBT_USERMEM);
+  while (true) {
+    data.set_data(buffer.data());
+    data.set_ulen(static_cast<u_int32_t>(buffer.size()));
+    auto ret = read_into_buffer(
+        [&] { return mDb->get(txn, keyDbt.get(), &data, 0); });
+    if (ret == DB_NOTFOUND) {
+      return {};
+    }
+    if (ret == DB_BUFFER_SMALL) {
+      buffer.resize(data.get_size());
+      continue;
+    }
+    check(ret);
+    return {decode(data)};
+  }
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::NativeTable<Key, Element, Marshaller>::exists(
+    DbTxn* txn,
+    const Key& key) const
+{
+  KeyDbt<Key> keyDbt(key);
+  auto ret = mDb->exists(txn, keyDbt.get(), 0);
+  if (ret == DB_NOTFOUND) {
+    return false;
+  }
+  check(ret);
+  return true;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+bool prstorage::NativeTable<Key, Element, Marshaller>::del(DbTxn* txn,
+                                                           const Key& key)
+{
+  KeyDbt<Key> keyDbt(key);
+  auto ret = mDb->del(txn, keyDbt.get(), 0);
+  if (ret == DB_NOTFOUND) {
+    return false;
+  }
+  check(ret);
+  return true;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::optional<Element> prstorage::NativeTable<Key, Element, Marshaller>::take(
+    DbTxn* txn,
+    const Key& key)
+{
+  auto res = get(txn, key);
+  if (res) {
+    del(txn, key);
+  }
+  return res;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+template <typename Callback>
+void prstorage::NativeTable<Key, Element, Marshaller>::forEach(
+    DbTxn* txn,
+    Callback&& callback) const
+{
+  scan(txn, [this, &callback](const Dbt& /* key */, const Dbt& data) {
+    return callback(decode(data));
+  });
+}
+
+template <typename Key, typename Element, typename Marshaller>
+template <typename Callback>
+void prstorage::NativeTable<Key, Element, Marshaller>::scan(
+    DbTxn* txn,
+    Callback&& callback) const
+{
+  bulk_scan(mDb, txn, std::forward<Callback>(callback), BULK_BUFFER_SIZE);
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::size_t prstorage::NativeTable<Key, Element, Marshaller>::count(
+    DbTxn* txn) const
+{
+  Dbc* cursor = nullptr;
+  check(mDb->cursor(txn, &cursor, 0));
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  ReallocDbt key;
+  Dbt data;
+  // значения не читаются: dlen == 0
+  data.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+  std::size_t res = 0;
+  while (true) {
+    auto ret = cursor->get(&key, &data, DB_NEXT);
+    if (ret == DB_NOTFOUND) {
+      return res;
+    }
+    check(ret);
+    ++res;
+  }
+}
+
+template <typename Key, typename Element, typename Marshaller>
+Db* prstorage::NativeTable<Key, Element, Marshaller>::db() const noexcept
+{
+  return mDb;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+const Marshaller& prstorage::NativeTable<Key, Element, Marshaller>::marshaller()
+    const noexcept
+{
+  return mMarshaller;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+Dbt prstorage::NativeTable<Key, Element, Marshaller>::encode(
+    const Element& elem) const
+{
+  auto& buffer = encodeBuffer();
+  auto size = mMarshaller.size(elem);
+  if (buffer.size() < size) {
+    buffer.resize(size);
+  }
+  mMarshaller.store(buffer.data(), elem);
+  return Dbt(buffer.data(), static_cast<u_int32_t>(size));
+}
+
+template <typename Key, typename Element, typename Marshaller>
+Element prstorage::NativeTable<Key, Element, Marshaller>::decode(
+    const Dbt& data) const
+{
+  Element elem;
+  mMarshaller.restore(elem, data.get_data());
+  return elem;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+void prstorage::NativeTable<Key, Element, Marshaller>::check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::vector<char>&
+prstorage::NativeTable<Key, Element, Marshaller>::encodeBuffer()
+{
+  static thread_local std::vector<char> buffer(INITIAL_BUFFER_SIZE);
+  return buffer;
+}
+
+template <typename Key, typename Element, typename Marshaller>
+std::vector<char>&
+prstorage::NativeTable<Key, Element, Marshaller>::readBuffer()
+{
+  static thread_local std::vector<char> buffer(INITIAL_BUFFER_SIZE);
+  return buffer;
+}
+
+#endif  // NATIVETABLE_H
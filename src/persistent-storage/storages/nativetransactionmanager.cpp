@@ -0,0 +1,48 @@
+#include "nativetransactionmanager.h"
+#include <stdexcept>
+
+using namespace prstorage;
+
+NativeTransactionManager::NativeTransactionManager(DbEnv* env) :
+    mEnv(env), mTxn(nullptr)
+{
+  if (env) {
+    if (auto ret = env->txn_begin(nullptr, &mTxn, DB_TXN_SYNC | DB_TXN_WAIT);
+        ret != 0) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+  }
+}
+
+NativeTransactionManager::~NativeTransactionManager()
+{
+  if (mEnv && mTxn) {
+    mTxn->abort();
+  }
+}
+
+void NativeTransactionManager::commit()
+{
+  if (mEnv && mTxn) {
+    auto ret = mTxn->commit(0);
+    mEnv = nullptr;
+    mTxn = nullptr;
+    if (ret != 0) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+  }
+}
+
+void NativeTransactionManager::abort()
+{
+  if (mEnv && mTxn) {
+    mTxn->abort();
+    mEnv = nullptr;
+    mTxn = nullptr;
+  }
+}
+
+DbTxn* NativeTransactionManager::txn() const noexcept
+{
+  return mTxn;
+}
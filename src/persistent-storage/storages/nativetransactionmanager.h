@@ -0,0 +1,35 @@
+#ifndef NATIVETRANSACTIONMANAGER_H
+#define NATIVETRANSACTIONMANAGER_H
+
+#include <db_cxx.h>
+
+namespace prstorage {
+/**
+ * Менеджер транзакций для NativeStorage. Начинает транзакцию через
+ * DbEnv::txn_begin без участия dbstl и предоставляет ее дескриптор.
+ */
+class NativeTransactionManager {
+ public:
+  /**
+   * @brief Конструктор класса, начинает транзакцию
+   * @param env окружение, если nullptr - операции выполняются без транзакции
+   * @throws std::runtime_error если транзакцию начать не удалось
+   */
+  NativeTransactionManager(DbEnv* env);
+  ~NativeTransactionManager();
+  void commit();
+  void abort();
+  DbTxn* txn() const noexcept;
+
+ private:
+  NativeTransactionManager(const NativeTransactionManager&) = delete;
+  NativeTransactionManager& operator=(const NativeTransactionManager&) =
+      delete;
+
+ private:
+  DbEnv* mEnv;
+  DbTxn* mTxn;
+};
+}  // namespace prstorage
+
+#endif  // NATIVETRANSACTIONMANAGER_H
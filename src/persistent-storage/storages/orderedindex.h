@@ -0,0 +1,214 @@
+#ifndef ORDEREDINDEX_H
+#define ORDEREDINDEX_H
+
+#include <db_cxx.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "persistent-storage/utils/orderedkey.h"
+
+namespace prstorage {
+/**
+ * Направление обхода упорядоченного индекса
+ */
+enum class Direction { Forward, Backward };
+
+/**
+ * @brief Функция обратного вызова Db::associate для упорядоченного индекса.
+ * Index - тип-тег индекса, который определяет тип ключа и функцию его
+ * вычисления:
+ *
+ * struct ContactsByUpdated {
+ *   using key_type = std::pair<std::string, std::int64_t>;
+ *   static key_type key(const Contact& contact);
+ * };
+ *
+ * Ключ кодируется OrderedKeyCodec, поэтому записи индекса упорядочены так
+ * же, как значения key_type.
+ *
+ * Пример:
+ * auto secondary = factory.openSecondary(
+ *     db, "contacts.db", "by_updated",
+ *     ordered_index_key<ContactsByUpdated, Contact, ContactMarshaller>);
+ * storage->attachIndex<ContactsByUpdated>(secondary);
+ */
+template <typename Index, typename Element, typename Marshaller>
+int ordered_index_key(Db* /* secondary */,
+                      const Dbt* /* key */,
+                      const Dbt* data,
+                      Dbt* result)
+{
+  Element elem;
+  Marshaller::restore(elem, data->get_data());
+  auto encoded = encode_ordered_key(Index::key(elem));
+
+  if (auto bytes = malloc(encoded.size())) {
+    std::memcpy(bytes, encoded.data(), encoded.size());
+    result->set_flags(DB_DBT_APPMALLOC);
+    result->set_data(bytes);
+    result->set_size(static_cast<u_int32_t>(encoded.size()));
+    return 0;
+  }
+  return ENOMEM;
+}
+
+/**
+ * @brief Обходит упорядоченный вторичный индекс курсором, начиная с ключа
+ * from. Вперед обходятся ключи >= from, назад - ключи <= from; записи с
+ * одинаковым ключом при обходе назад возвращаются в обратном порядке.
+ * @param index вторичная база данных
+ * @param txn транзакция, в которой открывается курсор, или nullptr
+ * @param from закодированный ключ начала обхода или nullptr для обхода с
+ * начала (вперед) или с конца (назад)
+ * @param callback функция bool(const Dbt& data) для значения основной
+ * записи, обход прекращается, когда она возвращает false
+ * @throws std::runtime_error при ошибке Berkeley DB
+ */
+template <typename Callback>
+void ordered_index_scan(Db* index,
+                        DbTxn* txn,
+                        const std::string* from,
+                        Direction direction,
+                        Callback&& callback)
+{
+  auto check = [](int ret) {
+    if (ret != 0 && ret != DB_NOTFOUND) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+  };
+
+  Dbc* cursor = nullptr;
+  check(index->cursor(txn, &cursor, 0));
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  Dbt key, primary, data;
+  key.set_flags(DB_DBT_REALLOC);
+  primary.set_flags(DB_DBT_REALLOC);
+  data.set_flags(DB_DBT_REALLOC);
+  std::unique_ptr<void, decltype(&std::free)> keyData(nullptr, &std::free),
+      primaryData(nullptr, &std::free), dataData(nullptr, &std::free);
+  auto get = [&](u_int32_t flags) {
+    auto ret = cursor->pget(&key, &primary, &data, flags);
+    // DB_DBT_REALLOC мог переместить буферы
+    keyData.release();
+    keyData.reset(key.get_data());
+    primaryData.release();
+    primaryData.reset(primary.get_data());
+    dataData.release();
+    dataData.reset(data.get_data());
+    check(ret);
+    return ret == 0;
+  };
+
+  bool found = false;
+  if (!from) {
+    found = get(direction == Direction::Forward ? DB_FIRST : DB_LAST);
+  } else {
+    // буфер ключа должен принадлежать malloc из-за DB_DBT_REALLOC
+    auto bytes = malloc(from->size() ? from->size() : 1);
+    if (!bytes) {
+      throw std::bad_alloc();
+    }
+    std::memcpy(bytes, from->data(), from->size());
+    keyData.reset(bytes);
+    key.set_data(bytes);
+    key.set_size(static_cast<u_int32_t>(from->size()));
+    found = get(DB_SET_RANGE);
+    if (direction == Direction::Backward) {
+      if (!found) {
+        found = get(DB_LAST);
+      } else if (key.get_size() == from->size() &&
+                 std::memcmp(key.get_data(), from->data(), from->size()) ==
+                     0) {
+        // с последней записи с ключом from
+        found = get(DB_NEXT_NODUP) ? get(DB_PREV) : get(DB_LAST);
+      } else {
+        found = get(DB_PREV);
+      }
+    }
+  }
+
+  auto step = direction == Direction::Forward ? DB_NEXT : DB_PREV;
+  while (found && callback(static_cast<const Dbt&>(data))) {
+    found = get(step);
+  }
+}
+
+/**
+ * Ограниченная выборка первых limit элементов в порядке закодированных
+ * ключей для обхода без индекса. Хранит не более limit элементов.
+ */
+template <typename Element>
+class BoundedTopK {
+ public:
+  BoundedTopK(std::size_t limit, Direction direction) :
+      mLimit(limit), mQueue(Before{direction})
+  {
+  }
+
+ public:
+  /**
+   * @brief Предлагает элемент; элементы с одинаковым ключом упорядочены в
+   * порядке предложения (при обходе назад - в обратном)
+   */
+  void offer(std::string key, Element elem)
+  {
+    if (mLimit == 0) {
+      return;
+    }
+    mQueue.push({std::move(key), mSequence++, std::move(elem)});
+    if (mQueue.size() > mLimit) {
+      mQueue.pop();
+    }
+  }
+
+  /**
+   * @brief Возвращает выбранные элементы в порядке обхода
+   */
+  std::vector<Element> take()
+  {
+    std::vector<Element> res(mQueue.size());
+    for (auto it = res.rbegin(); it != res.rend(); ++it) {
+      *it = std::move(const_cast<Candidate&>(mQueue.top()).elem);
+      mQueue.pop();
+    }
+    return res;
+  }
+
+ private:
+  struct Candidate {
+    std::string key;
+    std::size_t sequence;
+    Element elem;
+  };
+
+  // вершина очереди - последний по порядку обхода элемент
+  struct Before {
+    Direction direction;
+    bool operator()(const Candidate& lhs, const Candidate& rhs) const
+    {
+      if (direction == Direction::Forward) {
+        return lhs.key < rhs.key ||
+               (lhs.key == rhs.key && lhs.sequence < rhs.sequence);
+      }
+      return lhs.key > rhs.key ||
+             (lhs.key == rhs.key && lhs.sequence > rhs.sequence);
+    }
+  };
+
+ private:
+  std::size_t mLimit;
+  std::size_t mSequence = 0;
+  std::priority_queue<Candidate, std::vector<Candidate>, Before> mQueue;
+};
+}  // namespace prstorage
+
+#endif  // ORDEREDINDEX_H
@@ -0,0 +1,484 @@
+#ifndef PARTITIONEDSTORAGE_H
+#define PARTITIONEDSTORAGE_H
+
+#include <db_cxx.h>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "partitioners.h"
+#include "persistent-storage/utils/aggregates.h"
+#include "registeredthreadpool.h"
+
+namespace prstorage {
+/**
+ * Хранилище, которое распределяет элементы по нескольким базам данных
+ * (секциям). Каждая секция - отдельный StorageType со своей базой данных,
+ * поэтому запись в разные секции не конкурирует за корень и листовые
+ * страницы одного B-дерева, а при размещении баз в разных файлах - и за
+ * очередь ввода-вывода одного файла.
+ *
+ * Операции с одним ключом выполняются в секции, которую выбирает
+ * Partitioner. Обходы (getAllElements, get_if) и агрегаты (reduce,
+ * count_if, min_by, max_by, group_count) выполняются во всех секциях
+ * параллельно: первая секция обрабатывается в вызывающем потоке, остальные -
+ * в потоках RegisteredThreadPool, который хранилище создает один раз.
+ * Результаты объединяются в порядке секций, поэтому предикаты и функции
+ * агрегатов вызываются одновременно из нескольких потоков. size()
+ * выполняется последовательно: передача задачи в поток дороже подсчета.
+ *
+ * Параметры шаблона:
+ * @tparam StorageType тип хранилища секции, например Storage<...>
+ * @tparam Partitioner функтор (key, количество секций) -> номер секции,
+ * например HashPartitioner или RangePartitioner
+ *
+ * Количество секций и Partitioner должны оставаться неизменными для
+ * существующих данных. Watcher каждой секции уведомляет о событиях только
+ * своей секции.
+ */
+template <typename StorageType,
+          typename Partitioner = HashPartitioner<typename StorageType::key>>
+class PartitionedStorage {
+ public:
+  using storage_type = StorageType;
+  using element = typename StorageType::element;
+  using key = typename StorageType::key;
+  using wrapper_type = typename StorageType::wrapper_type;
+  using PartitionFunction =
+      std::function<void(std::size_t index, StorageType& storage, Db* db)>;
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param databases базы данных секций, по одной на секцию
+   * @param env окружение, в котором открыты базы данных
+   * @param partitioner функтор выбора секции
+   * @throws std::invalid_argument, если не задано ни одной базы данных
+   */
+  PartitionedStorage(std::vector<Db*> databases,
+                     DbEnv* env,
+                     Partitioner partitioner = Partitioner());
+
+ public:
+  bool add(const element& elem);
+  bool remove(const key& id);
+  bool strictUpdate(const element& elem);
+  void update(const element& elem);
+  wrapper_type wrapper(const key& id);
+
+ public:
+  element get(const key& id) const;
+  bool has(const key& id) const;
+
+  /**
+   * @brief Возвращает элементы всех секций
+   */
+  std::vector<element> getAllElements() const;
+  int size() const;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+
+  /**
+   * @brief Обходит ключи секций по порядку без чтения значений элементов
+   * @param callback функция bool(const key&), обход прекращается, когда она
+   * возвращает false
+   */
+  template <typename Callback>
+  void forEachKey(Callback&& callback) const;
+
+  /**
+   * @brief Возвращает ключи всех секций, секции читаются параллельно
+   */
+  std::vector<key> getAllKeys() const;
+
+ public:
+  /**
+   * @brief Сворачивает элементы каждой секции начиная с init и объединяет
+   * результаты секций в порядке секций: res = combine(res, part)
+   * @param init начальное значение, должно быть нейтральным для combine
+   * @param op функция T(T, const element&)
+   * @param combine функция T(T, T)
+   */
+  template <typename T, typename BinaryOp, typename Combine>
+  T reduce(T init, BinaryOp op, Combine combine) const;
+  std::size_t count_if(std::function<bool(const element&)> p) const;
+  template <typename KeyFn>
+  std::optional<element> min_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  std::optional<element> max_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  GroupCounts<element, KeyFn> group_count(KeyFn keyFn) const;
+
+ public:
+  std::size_t partitionCount() const noexcept;
+
+  /**
+   * @brief Возвращает номер секции, в которой хранится ключ
+   */
+  std::size_t partitionOf(const key& id) const;
+  std::shared_ptr<StorageType> partition(std::size_t index) const;
+  const std::vector<Db*>& databases() const noexcept;
+
+  /**
+   * @brief Выполняет func для каждой секции в отдельном потоке, например
+   * сжатие или сбор статистики. Потоки пула регистрируют окружение и базы
+   * данных в dbstl. Первое исключение передается вызывающему после
+   * завершения func во всех секциях.
+   */
+  void forEachPartition(const PartitionFunction& func) const;
+
+ private:
+  template <typename Func>
+  void scatter(const Func& func) const;
+
+  template <typename KeyFn, typename Compare>
+  std::optional<element> bestBy(KeyFn& keyFn, Compare better) const;
+
+  StorageType& partitionFor(const key& id) const;
+
+ private:
+  std::vector<Db*> mDatabases;
+  DbEnv* mEnv;
+  Partitioner mPartitioner;
+  std::vector<std::shared_ptr<StorageType>> mPartitions;
+  // создается последним и уничтожается первым, пока базы данных открыты
+  std::unique_ptr<RegisteredThreadPool> mPool;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename StorageType, typename Partitioner>
+prstorage::PartitionedStorage<StorageType, Partitioner>::PartitionedStorage(
+    std::vector<Db*> databases,
+    DbEnv* env,
+    Partitioner partitioner) :
+    mDatabases(std::move(databases)),
+    mEnv(env), mPartitioner(std::move(partitioner))
+{
+  if (mDatabases.empty()) {
+    throw std::invalid_argument("partitioned storage needs a database");
+  }
+  for (auto db : mDatabases) {
+    mPartitions.push_back(std::make_shared<StorageType>(db, env));
+  }
+  if (mDatabases.size() > 1) {
+    mPool = std::make_unique<RegisteredThreadPool>(mDatabases.size() - 1,
+                                                   env, mDatabases);
+  }
+}
+
+template <typename StorageType, typename Partitioner>
+bool prstorage::PartitionedStorage<StorageType, Partitioner>::add(
+    const element& elem)
+{
+  return partitionFor(get_id(elem)).add(elem);
+}
+
+template <typename StorageType, typename Partitioner>
+bool prstorage::PartitionedStorage<StorageType, Partitioner>::remove(
+    const key& id)
+{
+  return partitionFor(id).remove(id);
+}
+
+template <typename StorageType, typename Partitioner>
+bool prstorage::PartitionedStorage<StorageType, Partitioner>::strictUpdate(
+    const element& elem)
+{
+  return partitionFor(get_id(elem)).strictUpdate(elem);
+}
+
+template <typename StorageType, typename Partitioner>
+void prstorage::PartitionedStorage<StorageType, Partitioner>::update(
+    const element& elem)
+{
+  partitionFor(get_id(elem)).update(elem);
+}
+
+template <typename StorageType, typename Partitioner>
+typename prstorage::PartitionedStorage<StorageType, Partitioner>::wrapper_type
+prstorage::PartitionedStorage<StorageType, Partitioner>::wrapper(const key& id)
+{
+  return partitionFor(id).wrapper(id);
+}
+
+template <typename StorageType, typename Partitioner>
+typename prstorage::PartitionedStorage<StorageType, Partitioner>::element
+prstorage::PartitionedStorage<StorageType, Partitioner>::get(
+    const key& id) const
+{
+  return partitionFor(id).get(id);
+}
+
+template <typename StorageType, typename Partitioner>
+bool prstorage::PartitionedStorage<StorageType, Partitioner>::has(
+    const key& id) const
+{
+  return partitionFor(id).has(id);
+}
+
+template <typename StorageType, typename Partitioner>
+std::vector<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::element>
+prstorage::PartitionedStorage<StorageType, Partitioner>::getAllElements() const
+{
+  std::vector<std::vector<element>> parts(mPartitions.size());
+  scatter([this, &parts](std::size_t index) {
+    parts[index] = mPartitions[index]->getAllElements();
+  });
+
+  std::vector<element> res;
+  for (auto& part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(res));
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+int prstorage::PartitionedStorage<StorageType, Partitioner>::size() const
+{
+  int res = 0;
+  for (const auto& partition : mPartitions) {
+    res += partition->size();
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+std::vector<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::element>
+prstorage::PartitionedStorage<StorageType, Partitioner>::get_if(
+    std::function<bool(const element&)> p) const
+{
+  std::vector<std::vector<element>> parts(mPartitions.size());
+  scatter([this, &parts, &p](std::size_t index) {
+    parts[index] = mPartitions[index]->get_if(p);
+  });
+
+  std::vector<element> res;
+  for (auto& part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(res));
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename Callback>
+void prstorage::PartitionedStorage<StorageType, Partitioner>::forEachKey(
+    Callback&& callback) const
+{
+  bool stopped = false;
+  for (std::size_t i = 0; i < mPartitions.size() && !stopped; ++i) {
+    mPartitions[i]->forEachKey([&callback, &stopped](const key& id) {
+      stopped = !callback(id);
+      return !stopped;
+    });
+  }
+}
+
+template <typename StorageType, typename Partitioner>
+std::vector<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::key>
+prstorage::PartitionedStorage<StorageType, Partitioner>::getAllKeys() const
+{
+  std::vector<std::vector<key>> parts(mPartitions.size());
+  scatter([this, &parts](std::size_t index) {
+    parts[index] = mPartitions[index]->getAllKeys();
+  });
+
+  std::vector<key> res;
+  for (auto& part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(res));
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename T, typename BinaryOp, typename Combine>
+T prstorage::PartitionedStorage<StorageType, Partitioner>::reduce(
+    T init,
+    BinaryOp op,
+    Combine combine) const
+{
+  std::vector<std::optional<T>> parts(mPartitions.size());
+  scatter([this, &parts, &init, &op](std::size_t index) {
+    parts[index] = mPartitions[index]->reduce(init, op);
+  });
+
+  for (auto& part : parts) {
+    init = combine(std::move(init), std::move(*part));
+  }
+  return init;
+}
+
+template <typename StorageType, typename Partitioner>
+std::size_t prstorage::PartitionedStorage<StorageType, Partitioner>::count_if(
+    std::function<bool(const element&)> p) const
+{
+  std::vector<std::size_t> counts(mPartitions.size());
+  scatter([this, &counts, &p](std::size_t index) {
+    counts[index] = mPartitions[index]->count_if(p);
+  });
+
+  std::size_t res = 0;
+  for (auto count : counts) {
+    res += count;
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename KeyFn>
+std::optional<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::element>
+prstorage::PartitionedStorage<StorageType, Partitioner>::min_by(
+    KeyFn keyFn) const
+{
+  return bestBy(keyFn, std::less<>());
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename KeyFn>
+std::optional<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::element>
+prstorage::PartitionedStorage<StorageType, Partitioner>::max_by(
+    KeyFn keyFn) const
+{
+  return bestBy(keyFn, std::greater<>());
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename KeyFn>
+prstorage::GroupCounts<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::element,
+    KeyFn>
+prstorage::PartitionedStorage<StorageType, Partitioner>::group_count(
+    KeyFn keyFn) const
+{
+  std::vector<GroupCounts<element, KeyFn>> parts(mPartitions.size());
+  scatter([this, &parts, &keyFn](std::size_t index) {
+    parts[index] = mPartitions[index]->group_count(keyFn);
+  });
+
+  auto res = std::move(parts.front());
+  for (std::size_t i = 1; i < parts.size(); ++i) {
+    for (const auto& [group, count] : parts[i]) {
+      res[group] += count;
+    }
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+std::size_t
+prstorage::PartitionedStorage<StorageType, Partitioner>::partitionCount()
+    const noexcept
+{
+  return mPartitions.size();
+}
+
+template <typename StorageType, typename Partitioner>
+std::size_t prstorage::PartitionedStorage<StorageType, Partitioner>::
+    partitionOf(const key& id) const
+{
+  return mPartitioner(id, mPartitions.size());
+}
+
+template <typename StorageType, typename Partitioner>
+std::shared_ptr<StorageType>
+prstorage::PartitionedStorage<StorageType, Partitioner>::partition(
+    std::size_t index) const
+{
+  return mPartitions.at(index);
+}
+
+template <typename StorageType, typename Partitioner>
+const std::vector<Db*>&
+prstorage::PartitionedStorage<StorageType, Partitioner>::databases()
+    const noexcept
+{
+  return mDatabases;
+}
+
+template <typename StorageType, typename Partitioner>
+void prstorage::PartitionedStorage<StorageType, Partitioner>::
+    forEachPartition(const PartitionFunction& func) const
+{
+  scatter([this, &func](std::size_t index) {
+    func(index, *mPartitions[index], mDatabases[index]);
+  });
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename Func>
+void prstorage::PartitionedStorage<StorageType, Partitioner>::scatter(
+    const Func& func) const
+{
+  if (mPartitions.size() == 1) {
+    func(0);
+    return;
+  }
+
+  std::vector<std::future<void>> results;
+  results.reserve(mPartitions.size() - 1);
+  for (std::size_t i = 1; i < mPartitions.size(); ++i) {
+    results.push_back(mPool->submit([&func, i] { func(i); }));
+  }
+  // первая секция обрабатывается в вызывающем потоке
+  std::exception_ptr error;
+  try {
+    func(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // func используется задачами по ссылке, поэтому дожидаемся всех
+  for (auto& result : results) {
+    try {
+      result.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+template <typename StorageType, typename Partitioner>
+template <typename KeyFn, typename Compare>
+std::optional<
+    typename prstorage::PartitionedStorage<StorageType, Partitioner>::element>
+prstorage::PartitionedStorage<StorageType, Partitioner>::bestBy(
+    KeyFn& keyFn,
+    Compare better) const
+{
+  std::vector<std::optional<element>> parts(mPartitions.size());
+  scatter([this, &parts, &keyFn, &better](std::size_t index) {
+    parts[index] = best_element_by(*mPartitions[index], keyFn, better);
+  });
+
+  // лучшие элементы секций сравниваются в порядке секций
+  std::optional<element> res;
+  for (auto& part : parts) {
+    if (part && (!res || better(keyFn(*part), keyFn(*res)))) {
+      res = std::move(part);
+    }
+  }
+  return res;
+}
+
+template <typename StorageType, typename Partitioner>
+StorageType&
+prstorage::PartitionedStorage<StorageType, Partitioner>::partitionFor(
+    const key& id) const
+{
+  return *mPartitions[mPartitioner(id, mPartitions.size())];
+}
+
+#endif  // PARTITIONEDSTORAGE_H
@@ -0,0 +1,62 @@
+#ifndef PARTITIONERS_H
+#define PARTITIONERS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "persistent-storage/utils/crc32.h"
+#include "persistent-storage/utils/keycodec.h"
+
+namespace prstorage {
+/**
+ * Распределяет ключи по секциям по CRC-32 от байтового представления
+ * ключа (KeyCodec). В отличие от std::hash результат не зависит от
+ * реализации стандартной библиотеки, поэтому ключ попадает в ту же секцию
+ * после пересборки приложения.
+ */
+template <typename Key>
+class HashPartitioner {
+ public:
+  std::size_t operator()(const Key& key, std::size_t partitions) const
+  {
+    auto bytes = KeyCodec<Key>::encode(key);
+    return crc32(bytes.data(), bytes.size()) % partitions;
+  }
+};
+
+/**
+ * Распределяет ключи по диапазонам: секция i содержит ключи из
+ * [bounds[i - 1], bounds[i]). Для N секций задается N - 1 граница, ключи
+ * за последней границей попадают в последнюю секцию.
+ *
+ * Соседние ключи остаются в одной секции, но равномерность распределения
+ * зависит от выбора границ.
+ */
+template <typename Key>
+class RangePartitioner {
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param bounds границы секций, сортируются при создании
+   */
+  explicit RangePartitioner(std::vector<Key> bounds) :
+      mBounds(std::move(bounds))
+  {
+    std::sort(mBounds.begin(), mBounds.end());
+  }
+
+  std::size_t operator()(const Key& key, std::size_t partitions) const
+  {
+    auto index = static_cast<std::size_t>(
+        std::upper_bound(mBounds.begin(), mBounds.end(), key) -
+        mBounds.begin());
+    return std::min(index, partitions - 1);
+  }
+
+ private:
+  std::vector<Key> mBounds;
+};
+}  // namespace prstorage
+
+#endif  // PARTITIONERS_H
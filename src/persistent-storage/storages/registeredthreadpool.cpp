@@ -0,0 +1,78 @@
+#include "registeredthreadpool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "threadregistry.h"
+
+using namespace prstorage;
+
+RegisteredThreadPool::RegisteredThreadPool(std::size_t threads,
+                                           DbEnv* env,
+                                           std::vector<Db*> databases) :
+    mEnv(env),
+    mDatabases(std::move(databases))
+{
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  mThreads.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    mThreads.emplace_back(&RegisteredThreadPool::workerLoop, this);
+  }
+}
+
+RegisteredThreadPool::~RegisteredThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopped = true;
+  }
+  mCondition.notify_all();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+std::size_t RegisteredThreadPool::threadCount() const noexcept
+{
+  return mThreads.size();
+}
+
+void RegisteredThreadPool::enqueue(Task task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mStopped) {
+      throw std::logic_error("thread pool is stopped");
+    }
+    mTasks.push_back(std::move(task));
+  }
+  mCondition.notify_one();
+}
+
+void RegisteredThreadPool::workerLoop()
+{
+  // исключение за пределами задачи привело бы к std::terminate
+  std::exception_ptr error;
+  try {
+    ThreadRegistry::registerAll(mEnv, mDatabases);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this] { return mStopped || !mTasks.empty(); });
+      if (mTasks.empty()) {
+        break;
+      }
+      task = std::move(mTasks.front());
+      mTasks.pop_front();
+    }
+    // исключения задачи сохраняются в ее future
+    task(error);
+  }
+  ThreadRegistry::threadExit();
+}
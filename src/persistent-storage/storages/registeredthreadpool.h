@@ -0,0 +1,103 @@
+#ifndef REGISTEREDTHREADPOOL_H
+#define REGISTEREDTHREADPOOL_H
+
+#include <db_cxx.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Пул потоков для работы с хранилищами. Каждый рабочий поток при запуске
+ * регистрирует окружение и базы данных в dbstl через ThreadRegistry, а при
+ * остановке освобождает ресурсы dbstl. Задачи не выполняют регистрацию и
+ * могут использовать любые менеджеры транзакций. Если регистрация потока
+ * завершилась ошибкой, задачи этого потока не выполняются, а ошибка
+ * передается в их future.
+ *
+ * Деструктор выполняет все поставленные задачи и дожидается завершения
+ * потоков.
+ */
+class RegisteredThreadPool {
+ public:
+  /**
+   * @brief Конструктор класса, запускает рабочие потоки
+   * @param threads количество потоков, 0 - std::thread::hardware_concurrency
+   * @param env окружение, которое регистрируется в потоках
+   * @param databases базы данных, которые регистрируются в потоках
+   */
+  RegisteredThreadPool(std::size_t threads,
+                       DbEnv* env,
+                       std::vector<Db*> databases = {});
+  ~RegisteredThreadPool();
+
+ private:
+  RegisteredThreadPool(const RegisteredThreadPool&) = delete;
+  RegisteredThreadPool& operator=(const RegisteredThreadPool&) = delete;
+
+ public:
+  /**
+   * @brief Ставит задачу в очередь
+   * @return future с результатом или исключением задачи
+   */
+  template <typename Func>
+  std::future<std::invoke_result_t<Func>> submit(Func&& func);
+
+  std::size_t threadCount() const noexcept;
+
+ private:
+  /// задача получает ошибку регистрации рабочего потока или nullptr
+  using Task = std::function<void(const std::exception_ptr& error)>;
+
+  void enqueue(Task task);
+  void workerLoop();
+
+ private:
+  DbEnv* mEnv;
+  std::vector<Db*> mDatabases;
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::deque<Task> mTasks;
+  bool mStopped = false;
+  std::vector<std::thread> mThreads;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename Func>
+std::future<std::invoke_result_t<Func>>
+prstorage::RegisteredThreadPool::submit(Func&& func)
+{
+  // std::function требует копируемый объект
+  using result_type = std::invoke_result_t<Func>;
+  auto promise = std::make_shared<std::promise<result_type>>();
+  auto callable =
+      std::make_shared<std::decay_t<Func>>(std::forward<Func>(func));
+  auto res = promise->get_future();
+  enqueue([promise, callable](const std::exception_ptr& error) {
+    try {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      if constexpr (std::is_void_v<result_type>) {
+        (*callable)();
+        promise->set_value();
+      } else {
+        promise->set_value((*callable)());
+      }
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+  return res;
+}
+
+#endif  // REGISTEREDTHREADPOOL_H
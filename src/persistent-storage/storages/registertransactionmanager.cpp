@@ -2,13 +2,15 @@
 
 #include <dbstl_common.h>
 
+#include "threadregistry.h"
+
 using namespace prstorage;
 
 RegisterTransactionManager::RegisterTransactionManager(DbEnv* env) :
     mEnv(env), mTxn(nullptr)
 {
   if (env) {
-    dbstl::register_db_env(env);
+    ThreadRegistry::registerEnv(env);
     mTxn = dbstl::begin_txn(DB_TXN_SYNC | DB_TXN_WAIT, env);
   }
 }
@@ -4,6 +4,12 @@
 #include <db_cxx.h>
 
 namespace prstorage {
+/**
+ * Менеджер транзакций для хранилищ, которые используются из нескольких
+ * потоков. Перед началом транзакции регистрирует окружение в dbstl для
+ * текущего потока через ThreadRegistry, поэтому dbstl вызывается только
+ * при первой транзакции потока.
+ */
 class RegisterTransactionManager {
  public:
   /**
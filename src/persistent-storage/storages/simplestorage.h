@@ -9,6 +9,8 @@
 #include <optional>
 #include "defaulttransactionmanager.h"
 #include "persistent-storage/deleters/defaultdeleter.h"
+#include "persistent-storage/utils/aggregates.h"
+#include "persistent-storage/watchers/watchertraits.h"
 #include "persistent-storage/wrappers/transparentcontainerelementwrapper.h"
 
 namespace prstorage {
@@ -24,8 +26,8 @@ namespace prstorage {
  * @tparam Marshaller тип, который обеспечивает функцилонал для
  * маршалинга/демаршалинга элементов Element в массив байт и обратно
 
- * @tparam Deleter отвечает за удаление элемента из контейнера, пример -
- * DefaultDeleter
+ * @tparam Deleter отвечает за удаление элемента из контейнера, по умолчанию
+ * KeyOnlyDeleter
  *
  * Пример Marshaller:
  * class ContactMarshaller {
@@ -47,7 +49,7 @@ template <
     typename Element,
     typename Marshaller,
     typename Deleter =
-        DefaultDeleter<decltype(get_id(std::declval<Element>())), Element>>
+        KeyOnlyDeleter<decltype(get_id(std::declval<Element>())), Element>>
 class SimpleStorage {
  public:
   using element = Element;
@@ -146,6 +148,34 @@ class SimpleStorage {
    */
   std::vector<element> get_if(std::function<bool(const element&)> p) const;
 
+ public:
+  /**
+   * @brief Сворачивает элементы хранилища: для каждого элемента
+   * init = op(std::move(init), elem). Элементы читаются и восстанавливаются
+   * по одному.
+   * @param init начальное значение
+   * @param op функция T(T, const element&)
+   */
+  template <typename T, typename BinaryOp>
+  T reduce(T init, BinaryOp op) const;
+
+  std::size_t count_if(std::function<bool(const element&)> p) const;
+
+  /**
+   * @brief Возвращают первый элемент с наименьшим (наибольшим) значением
+   * keyFn или пустое значение, если хранилище пусто
+   */
+  template <typename KeyFn>
+  std::optional<element> min_by(KeyFn keyFn) const;
+  template <typename KeyFn>
+  std::optional<element> max_by(KeyFn keyFn) const;
+
+  /**
+   * @brief Возвращает количество элементов для каждого значения keyFn
+   */
+  template <typename KeyFn>
+  GroupCounts<element, KeyFn> group_count(KeyFn keyFn) const;
+
  protected:
   element find(std::function<bool(const element&)> is) const;
   Deleter& getDeleter();
@@ -202,7 +232,9 @@ template <typename Element, typename Marshaller, typename Deleter>
 bool prstorage::SimpleStorage<Element, Marshaller, Deleter>::remove(
     const key& id)
 {
-  if (auto res = mDeleter(mElements, id); res) {
+  if constexpr (!removed_value_needed<Deleter>::value) {
+    return mDeleter.erase(mElements, id);
+  } else if (auto res = mDeleter(mElements, id); res) {
     return true;
   }
   return false;
@@ -306,4 +338,55 @@ prstorage::SimpleStorage<Element, Marshaller, Deleter>::get_if(
   return res;
 }
 
+template <typename Element, typename Marshaller, typename Deleter>
+template <typename T, typename BinaryOp>
+T prstorage::SimpleStorage<Element, Marshaller, Deleter>::reduce(
+    T init,
+    BinaryOp op) const
+{
+  for (auto it = mElements.begin(
+           dbstl::ReadModifyWriteOption::no_read_modify_write(), true);
+       it != mElements.end(); ++it) {
+    auto val = *it;
+    init = op(std::move(init), val.second);
+  }
+  return init;
+}
+
+template <typename Element, typename Marshaller, typename Deleter>
+std::size_t prstorage::SimpleStorage<Element, Marshaller, Deleter>::count_if(
+    std::function<bool(const element&)> p) const
+{
+  return count_elements_if(*this, p);
+}
+
+template <typename Element, typename Marshaller, typename Deleter>
+template <typename KeyFn>
+std::optional<
+    typename prstorage::SimpleStorage<Element, Marshaller, Deleter>::element>
+prstorage::SimpleStorage<Element, Marshaller, Deleter>::min_by(
+    KeyFn keyFn) const
+{
+  return best_element_by(*this, keyFn, std::less<>());
+}
+
+template <typename Element, typename Marshaller, typename Deleter>
+template <typename KeyFn>
+std::optional<
+    typename prstorage::SimpleStorage<Element, Marshaller, Deleter>::element>
+prstorage::SimpleStorage<Element, Marshaller, Deleter>::max_by(
+    KeyFn keyFn) const
+{
+  return best_element_by(*this, keyFn, std::greater<>());
+}
+
+template <typename Element, typename Marshaller, typename Deleter>
+template <typename KeyFn>
+prstorage::GroupCounts<Element, KeyFn>
+prstorage::SimpleStorage<Element, Marshaller, Deleter>::group_count(
+    KeyFn keyFn) const
+{
+  return group_count_elements(*this, keyFn);
+}
+
 #endif  // SIMPLESTORAGE_H
@@ -2,13 +2,26 @@
 #define STORAGE_H
 
 #include <algorithm>
+#include <cstdlib>
 #include <functional>
+#include <map>
+#include <typeindex>
 
 #include <db_cxx.h>
 #include <dbstl_map.h>
 #include <optional>
 #include "defaulttransactionmanager.h"
+#include "orderedindex.h"
 #include "persistent-storage/deleters/defaultdeleter.h"
+#include "persistent-storage/metrics/storagemetrics.h"
+#include "persistent-storage/utils/aggregates.h"
+#include "persistent-storage/utils/bulkscan.h"
+#include "persistent-storage/utils/keydbt.h"
+#include "persistent-storage/utils/keysrange.h"
+#include "persistent-storage/utils/lazyelement.h"
+#include "persistent-storage/utils/page.h"
+#include "persistent-storage/utils/recordformat.h"
+#include "persistent-storage/watchers/watchertraits.h"
 #include "persistent-storage/wrappers/transparentcontainerelementwrapper.h"
 
 namespace prstorage {
@@ -27,8 +40,10 @@ namespace prstorage {
  * изменения элементов контейнера
  * @tparam TxManager класс, который предоставляет функции для выполнения
  * транзакций - пример DefaultTransactionManager
- * @tparam Deleter отвечает за удаление элемента из контейнера, пример -
- * DefaultDeleter
+ * @tparam Deleter отвечает за удаление элемента из контейнера, по умолчанию
+ * KeyOnlyDeleter
+ * @tparam Metrics политика сбора метрик: NoMetrics (по умолчанию, без
+ * накладных расходов) или StorageMetrics
  *
  * Пример Marshaller:
  * class ContactMarshaller {
@@ -38,6 +53,11 @@ namespace prstorage {
  *     static void store(void* dest, const std::shared_ptr<Contact>& elem);
  *  };
  *
+ * Marshaller может дополнительно предоставить функцию peek<Field>(src) для
+ * чтения отдельных полей (см. LazyElement), тогда get_if_lazy и
+ * count_if_lazy принимают предикаты от lazy_element и восстанавливают
+ * только подходящие элементы.
+ *
  * При добавлении/удалении/обновлении элемента, контейнер использует функции,
  * которые предоставляет Watcher, для уведомления о событии. Необходимо
  * определение в этом классе следующих функций: class TestWatcher{ protected:
@@ -45,6 +65,10 @@ namespace prstorage {
  *   void elementRemoved(const Element &);
  *   void elementUpdated(const Element &);
  * };
+ *
+ * Если Watcher и Deleter не используют значение удаляемого элемента (см.
+ * removed_value_needed), remove выполняет удаление одной операцией DB->del
+ * без чтения элемента и уведомляет Watcher через keyRemoved(const Key&).
  */
 template <
     typename Element,
@@ -52,17 +76,23 @@ template <
     typename Watcher,
     typename TxManager = DefaultTransactionManager,
     typename Deleter =
-        DefaultDeleter<decltype(get_id(std::declval<Element>())), Element>>
-class Storage : public std::enable_shared_from_this<
-                    Storage<Element, Marshaller, Watcher, TxManager, Deleter>>,
-                public Watcher {
+        KeyOnlyDeleter<decltype(get_id(std::declval<Element>())), Element>,
+    typename Metrics = NoMetrics>
+class Storage
+    : public std::enable_shared_from_this<
+          Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>>,
+      public Watcher {
  public:
   using element = Element;
   using watcher_type = Watcher;
+  using marshaller_type = Marshaller;
   using key = decltype(get_id(std::declval<Element>()));
   using wrapper_type = TransparentContainerElementWrapper<
-      Storage<Element, Marshaller, Watcher, TxManager, Deleter>>;
+      Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>>;
   using TransactionManager = TxManager;
+  using metrics_type = Metrics;
+  using lazy_element = LazyElement<Element, Marshaller>;
+  using record_view = RecordView<Element>;
 
  public:
   /**
@@ -167,14 +197,177 @@ class Storage : public std::enable_shared_from_this<
    */
   std::vector<element> get_if(std::function<bool(const element&)> p) const;
 
+  /**
+   * @brief Возвращает список элементов, которые удовлетворяют предикату.
+   * Записи читаются пакетами без восстановления, Marshaller::restore
+   * вызывается только для элементов, которые прошли предикат, если
+   * предикат не запросил элемент сам через get().
+   * @param p предикат, который принимает представление сохраненного
+   * элемента
+   */
+  std::vector<element> get_if_lazy(
+      std::function<bool(const lazy_element&)> p) const;
+
+  /**
+   * @brief Возвращает страницу элементов в порядке хранения ключей
+   * (побайтовом порядке закодированных ключей B-дерева), который для
+   * чисел и других не строковых ключей может не совпадать с порядком их
+   * значений. Курсор устанавливается на продолжение через DB_SET_RANGE,
+   * поэтому стоимость страницы пропорциональна limit, а не ее номеру.
+   * Элементы, добавленные или удаленные между запросами страниц,
+   * учитываются по положению их ключей.
+   * @param afterToken маркер продолжения предыдущей страницы, пустая строка
+   * для первой страницы
+   * @param limit максимальное количество элементов на странице
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  Page<element> page(const std::string& afterToken, std::size_t limit) const;
+
+  /**
+   * @brief Возвращает диапазон ключей хранилища. Значения элементов не
+   * читаются и не восстанавливаются Marshaller. Курсор открывается в текущей
+   * транзакции dbstl, диапазон должен быть пройден до ее завершения.
+   * @return диапазон ключей в порядке их хранения
+   */
+  KeysRange<key> keys() const;
+
+  /**
+   * @brief Обходит ключи хранилища без чтения значений элементов
+   * @param callback функция bool(const key&), обход прекращается, когда она
+   * возвращает false
+   */
+  template <typename Callback>
+  void forEachKey(Callback&& callback) const;
+
+  /**
+   * @brief Возвращает все ключи хранилища без чтения значений элементов
+   */
+  std::vector<key> getAllKeys() const;
+
+ public:
+  /**
+   * @brief Сворачивает элементы хранилища: для каждого элемента
+   * init = op(std::move(init), elem). Элементы читаются и восстанавливаются
+   * по одному, результат get_if не создается.
+   * @param init начальное значение
+   * @param op функция T(T, const element&)
+   */
+  template <typename T, typename BinaryOp>
+  T reduce(T init, BinaryOp op) const;
+
+  /**
+   * @brief Возвращает количество элементов, которые удовлетворяют предикату
+   */
+  std::size_t count_if(std::function<bool(const element&)> p) const;
+
+  /**
+   * @brief Возвращает количество элементов, которые удовлетворяют
+   * предикату, без восстановления элементов
+   */
+  std::size_t count_if_lazy(
+      std::function<bool(const lazy_element&)> p) const;
+
+  /**
+   * @brief Передает запись элемента с ключом id в callback без
+   * восстановления элемента. Доступно только с RecordMarshaller<Element>.
+   * Запись читается в буфер потока, который переиспользуется между
+   * вызовами.
+   * @param callback функция void(const record_view&); представление
+   * ссылается на буфер чтения и действительно только во время вызова
+   * @return true, если элемент найден и callback был вызван
+   */
+  template <typename Callback>
+  bool view(const key& id, Callback&& callback) const;
+
+  /**
+   * @brief Обходит записи всех элементов пакетным чтением и передает их в
+   * callback без восстановления. Доступно только с
+   * RecordMarshaller<Element>.
+   * @param callback функция bool(const record_view&), обход прекращается,
+   * когда она возвращает false; представление ссылается на пакетный буфер и
+   * действительно только во время вызова
+   */
+  template <typename Callback>
+  void forEachView(Callback&& callback) const;
+
+  /**
+   * @brief Возвращает первый элемент с наименьшим значением keyFn
+   * @param keyFn функция, значения которой сравниваются оператором <
+   * @return элемент или пустое значение, если хранилище пусто
+   */
+  template <typename KeyFn>
+  std::optional<element> min_by(KeyFn keyFn) const;
+
+  /**
+   * @brief Возвращает первый элемент с наибольшим значением keyFn
+   */
+  template <typename KeyFn>
+  std::optional<element> max_by(KeyFn keyFn) const;
+
+  /**
+   * @brief Возвращает количество элементов для каждого значения keyFn
+   */
+  template <typename KeyFn>
+  GroupCounts<element, KeyFn> group_count(KeyFn keyFn) const;
+
+ public:
+  /**
+   * @brief Подключает упорядоченный вторичный индекс Index, связанный с базой
+   * данных хранилища функцией ordered_index_key<Index, Element, Marshaller>.
+   * Вызывается при настройке хранилища, до его использования из нескольких
+   * потоков.
+   * @param secondary вторичная база данных
+   */
+  template <typename Index>
+  void attachIndex(Db* secondary);
+
+  /**
+   * @brief Возвращает до limit элементов в порядке ключа Index::key,
+   * начиная с from. Если индекс подключен (attachIndex), обходится курсор
+   * индекса и читаются только возвращаемые элементы; иначе хранилище
+   * обходится целиком с выборкой, которая хранит не более limit элементов.
+   * @param from ключ начала обхода: вперед возвращаются элементы с ключом
+   * >= from, назад - с ключом <= from; если не задан - с начала или с конца
+   * @param limit максимальное количество элементов
+   * @param direction направление обхода
+   * @param inRange функция bool(const Index::key_type&), обход
+   * прекращается на первом ключе, для которого она возвращает false.
+   * Должна выделять непрерывный диапазон ключей от from, например элементы
+   * одного родителя в составном ключе.
+   */
+  template <typename Index>
+  std::vector<element> orderedBy(
+      const std::optional<typename Index::key_type>& from,
+      std::size_t limit,
+      Direction direction = Direction::Forward,
+      std::function<bool(const typename Index::key_type&)> inRange = {})
+      const;
+
+ public:
+  /**
+   * @brief Возвращает снимок метрик хранилища. Доступно только с политикой
+   * метрик, у которой enabled == true, например StorageMetrics.
+   * @return значения метрик, включая глубину очереди Watcher, если он ее
+   * предоставляет, и количество взаимоблокировок окружения
+   */
+  MetricsSnapshot metrics() const;
+
  protected:
   element find(std::function<bool(const element&)> is) const;
   Deleter& getDeleter();
+  DbEnv* getEnv() const;
+  Metrics& getMetrics() const;
+
+ private:
+  template <typename Callback>
+  void scanLazy(Callback&& callback) const;
 
  private:
   mutable dbstl::db_map<key, element> mElements;
   mutable DbEnv* mEnv;
   Deleter mDeleter;
+  mutable Metrics mMetrics;
+  std::map<std::type_index, Db*> mIndexes;
 };
 }  // namespace prstorage
 /*-----------------------------------------------------------------------------------------------------*/
@@ -183,11 +376,10 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::Storage(
-    Db* db,
-    DbEnv* env,
-    Deleter&& deleter) :
+          typename Deleter,
+          typename Metrics>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    Storage(Db* db, DbEnv* env, Deleter&& deleter) :
     mElements(db, env),
     mEnv(env), mDeleter(std::forward<Deleter>(deleter))
 {
@@ -201,10 +393,10 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::Storage(
-    Db* db,
-    Deleter&& deleter) :
+          typename Deleter,
+          typename Metrics>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    Storage(Db* db, Deleter&& deleter) :
     Storage(db, db->get_env(), std::forward<Deleter>(deleter))
 {
 }
@@ -213,9 +405,10 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::Storage(
-    Deleter&& deleter) :
+          typename Deleter,
+          typename Metrics>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    Storage(Deleter&& deleter) :
     Storage(nullptr, nullptr, std::forward<Deleter>(deleter))
 {
 }
@@ -224,17 +417,26 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-bool prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::add(
-    const Storage::element& elem)
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::add(
+        const Storage::element& elem)
 {
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Add);
+  if constexpr (Metrics::enabled) {
+    mMetrics.addBytes(Operation::Add, Marshaller::size(elem));
+  }
   TransactionManager manager(mEnv);
   if (auto [it, res] = mElements.insert(std::make_pair(get_id(elem), elem));
       res) {
     manager.commit();
+    mMetrics.committed();
     watcher_type::elementAdded(elem);
     return true;
   }
+  // элемент с таким ключом уже есть: это промах, а не сбой транзакции
+  mMetrics.missed(Operation::Add);
   return false;
 }
 
@@ -242,16 +444,29 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-bool prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    remove(const key& id)
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::remove(
+        const key& id)
 {
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Remove);
   TransactionManager manager(mEnv);
-  if (auto res = mDeleter(mElements, id); res) {
+  if constexpr (!removed_value_needed<Watcher>::value &&
+                !removed_value_needed<Deleter>::value) {
+    if (mDeleter.erase(mElements, id)) {
+      manager.commit();
+      mMetrics.committed();
+      watcher_type::keyRemoved(id);
+      return true;
+    }
+  } else if (auto res = mDeleter(mElements, id); res) {
     manager.commit();
+    mMetrics.committed();
     watcher_type::elementRemoved(*res);
     return true;
   }
+  mMetrics.missed(Operation::Remove);
   return false;
 }
 
@@ -259,17 +474,25 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-bool prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    strictUpdate(const Storage::element& elem)
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        strictUpdate(const Storage::element& elem)
 {
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Update);
+  if constexpr (Metrics::enabled) {
+    mMetrics.addBytes(Operation::Update, Marshaller::size(elem));
+  }
   TransactionManager manager(mEnv);
   if (auto iter = mElements.find(get_id(elem)); iter != mElements.end()) {
     *iter = std::make_pair(get_id(elem), elem);
     manager.commit();
+    mMetrics.committed();
     watcher_type::elementUpdated(elem);
     return true;
   }
+  mMetrics.missed(Operation::Update);
   return false;
 }
 
@@ -277,13 +500,20 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-void prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    update(const Storage::element& elem)
+          typename Deleter,
+          typename Metrics>
+void prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::update(
+        const Storage::element& elem)
 {
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Update);
+  if constexpr (Metrics::enabled) {
+    mMetrics.addBytes(Operation::Update, Marshaller::size(elem));
+  }
   TransactionManager manager(mEnv);
   mElements[get_id(elem)] = elem;
   manager.commit();
+  mMetrics.committed();
   watcher_type::elementUpdated(elem);
 }
 
@@ -291,11 +521,14 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-typename prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    wrapper_type
-    prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-        wrapper(const key& id)
+          typename Deleter,
+          typename Metrics>
+typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        wrapper_type
+        prstorage::
+            Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+                wrapper(const key& id)
 {
   return wrapper_type(this->shared_from_this(), get(id));
 }
@@ -304,14 +537,21 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-typename prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    element
-    prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::get(
-        const key& id) const
+          typename Deleter,
+          typename Metrics>
+typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::element
+    prstorage::
+        Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::get(
+            const key& id) const
 {
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Get);
   if (auto iter = mElements.find(id, true); iter != mElements.end()) {
-    return (*iter).second;
+    auto elem = (*iter).second;
+    if constexpr (Metrics::enabled) {
+      mMetrics.addBytes(Operation::Get, Marshaller::size(elem));
+    }
+    return elem;
   }
   throw std::range_error("not found element");
 }
@@ -320,25 +560,33 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-bool prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::has(
-    const key& id) const
+          typename Deleter,
+          typename Metrics>
+bool prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::has(
+        const key& id) const
 {
-  auto it = mElements.find(id, true);
-  return mElements.end() != it;
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Has);
+  if (mElements.find(id, true) != mElements.end()) {
+    return true;
+  }
+  mMetrics.missed(Operation::Has);
+  return false;
 }
 
 template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-std::vector<
-    typename prstorage::
-        Storage<Element, Marshaller, Watcher, TxManager, Deleter>::element>
-prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
     getAllElements() const
 {
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
   std::vector<element> res;
   std::transform(
       mElements.begin(dbstl::ReadModifyWriteOption::no_read_modify_write(),
@@ -352,9 +600,11 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-int prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::size()
-    const noexcept
+          typename Deleter,
+          typename Metrics>
+int prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::size()
+        const noexcept
 {
   return mElements.size();
 }
@@ -363,12 +613,228 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-typename prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    element
-    prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::find(
-        std::function<bool(const Storage::element&)> is) const
+          typename Deleter,
+          typename Metrics>
+prstorage::KeysRange<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::key>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    keys() const
+{
+  return KeysRange<key>(mElements.get_db_handle(),
+                        mEnv ? dbstl::current_txn(mEnv) : nullptr);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename Callback>
+void prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        forEachKey(Callback&& callback) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  for (const auto& id : keys()) {
+    if (!callback(id)) {
+      return;
+    }
+  }
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::key>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    getAllKeys() const
+{
+  std::vector<key> res;
+  forEachKey([&res](const key& id) {
+    res.push_back(id);
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename T, typename BinaryOp>
+T prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::reduce(
+        T init,
+        BinaryOp op) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  for (auto it = mElements.begin(
+           dbstl::ReadModifyWriteOption::no_read_modify_write(), true);
+       it != mElements.end(); ++it) {
+    auto val = *it;
+    init = op(std::move(init), val.second);
+  }
+  return init;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        count_if(std::function<bool(const element&)> p) const
+{
+  return count_elements_if(*this, p);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename KeyFn>
+std::optional<typename prstorage::
+                  Storage<Element, Marshaller, Watcher, TxManager, Deleter,
+                          Metrics>::element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    min_by(KeyFn keyFn) const
 {
+  return best_element_by(*this, keyFn, std::less<>());
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename KeyFn>
+std::optional<typename prstorage::
+                  Storage<Element, Marshaller, Watcher, TxManager, Deleter,
+                          Metrics>::element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    max_by(KeyFn keyFn) const
+{
+  return best_element_by(*this, keyFn, std::greater<>());
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename KeyFn>
+prstorage::GroupCounts<Element, KeyFn> prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        group_count(KeyFn keyFn) const
+{
+  return group_count_elements(*this, keyFn);
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename Index>
+void prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        attachIndex(Db* secondary)
+{
+  mIndexes[std::type_index(typeid(Index))] = secondary;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename Index>
+std::vector<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    orderedBy(const std::optional<typename Index::key_type>& from,
+              std::size_t limit,
+              Direction direction,
+              std::function<bool(const typename Index::key_type&)> inRange)
+        const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  std::vector<element> res;
+  if (limit == 0) {
+    return res;
+  }
+  std::optional<std::string> encodedFrom;
+  if (from) {
+    encodedFrom = encode_ordered_key(*from);
+  }
+
+  if (auto it = mIndexes.find(std::type_index(typeid(Index)));
+      it != mIndexes.end()) {
+    ordered_index_scan(
+        it->second, mEnv ? dbstl::current_txn(mEnv) : nullptr,
+        encodedFrom ? &*encodedFrom : nullptr, direction,
+        [&res, &inRange, limit](const Dbt& data) {
+          element elem;
+          Marshaller::restore(elem, data.get_data());
+          if (inRange && !inRange(Index::key(elem))) {
+            return false;
+          }
+          res.push_back(std::move(elem));
+          return res.size() < limit;
+        });
+    return res;
+  }
+
+  // индекса нет: обходятся все элементы, в памяти остается не более limit
+  BoundedTopK<element> top(limit, direction);
+  for (auto it = mElements.begin(
+           dbstl::ReadModifyWriteOption::no_read_modify_write(), true);
+       it != mElements.end(); ++it) {
+    auto val = *it;
+    auto key = Index::key(val.second);
+    if (inRange && !inRange(key)) {
+      continue;
+    }
+    auto encoded = encode_ordered_key(key);
+    if (encodedFrom && (direction == Direction::Forward
+                            ? encoded < *encodedFrom
+                            : encoded > *encodedFrom)) {
+      continue;
+    }
+    top.offer(std::move(encoded), std::move(val.second));
+  }
+  return top.take();
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::element
+    prstorage::
+        Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+            find(std::function<bool(const Storage::element&)> is) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
   auto it = std::find_if(
       mElements.begin(dbstl::ReadModifyWriteOption::no_read_modify_write(),
                       true),
@@ -385,9 +851,11 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-Deleter& prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::
-    getDeleter()
+          typename Deleter,
+          typename Metrics>
+Deleter& prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        getDeleter()
 {
   return mDeleter;
 }
@@ -396,13 +864,66 @@ template <typename Element,
           typename Marshaller,
           typename Watcher,
           typename TxManager,
-          typename Deleter>
-std::vector<
-    typename prstorage::
-        Storage<Element, Marshaller, Watcher, TxManager, Deleter>::element>
-prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::get_if(
-    std::function<bool(const element&)> p) const
+          typename Deleter,
+          typename Metrics>
+DbEnv* prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        getEnv() const
+{
+  return mEnv;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+Metrics& prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        getMetrics() const
+{
+  return mMetrics;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+prstorage::MetricsSnapshot prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        metrics() const
 {
+  static_assert(Metrics::enabled, "metrics policy is disabled");
+  auto res = mMetrics.snapshot();
+  if constexpr (has_queue_depth<Watcher>::value) {
+    res.watcherQueueDepth = Watcher::queueDepth();
+  }
+  // без подсистемы блокировок lock_stat завершается ошибкой, счетчик
+  // остается нулевым
+  DB_LOCK_STAT* lockStat = nullptr;
+  if (mEnv && mEnv->lock_stat(&lockStat, 0) == 0) {
+    res.deadlocks = lockStat->st_ndeadlocks;
+    std::free(lockStat);
+  }
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    get_if(std::function<bool(const element&)> p) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
   std::vector<element> res;
   for (auto it = mElements.begin(
            dbstl::ReadModifyWriteOption::no_read_modify_write(), true);
@@ -415,4 +936,198 @@ prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter>::get_if(
   return res;
 }
 
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::vector<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    get_if_lazy(std::function<bool(const lazy_element&)> p) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  std::vector<element> res;
+  scanLazy([&res, &p](lazy_element& elem) {
+    if (p(elem)) {
+      res.push_back(elem.release());
+    }
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+std::size_t prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        count_if_lazy(std::function<bool(const lazy_element&)> p) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  std::size_t res = 0;
+  scanLazy([&res, &p](lazy_element& elem) {
+    if (p(elem)) {
+      ++res;
+    }
+    return true;
+  });
+  return res;
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename Callback>
+void prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        scanLazy(Callback&& callback) const
+{
+  // записи читаются в обход dbstl, чтобы не восстанавливать каждый элемент
+  bulk_scan(mElements.get_db_handle(),
+            mEnv ? dbstl::current_txn(mEnv) : nullptr,
+            [&callback](const Dbt& /* key */, const Dbt& data) {
+              lazy_element elem(data.get_data(), data.get_size());
+              return callback(elem);
+            });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename Callback>
+bool prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::view(
+        const key& id,
+        Callback&& callback) const
+{
+  static_assert(std::is_same_v<Marshaller, RecordMarshaller<Element>>,
+                "view requires RecordMarshaller");
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Get);
+  static thread_local std::vector<char> buffer(4 * 1024);
+
+  KeyDbt<key> keyDbt(id);
+  Dbt data;
+  data.set_flags(DB_DBT_USERMEM);
+  auto txn = mEnv ? dbstl::current_txn(mEnv) : nullptr;
+  while (true) {
+    data.set_data(buffer.data());
+    data.set_ulen(static_cast<u_int32_t>(buffer.size()));
+    auto ret = read_into_buffer([&] {
+      return mElements.get_db_handle()->get(txn, keyDbt.get(), &data, 0);
+    });
+    if (ret == DB_NOTFOUND) {
+      mMetrics.missed(Operation::Get);
+      return false;
+    }
+    if (ret == DB_BUFFER_SMALL) {
+      buffer.resize(data.get_size());
+      continue;
+    }
+    if (ret != 0) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+    if constexpr (Metrics::enabled) {
+      mMetrics.addBytes(Operation::Get, data.get_size());
+    }
+    callback(record_view(data.get_data()));
+    return true;
+  }
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+template <typename Callback>
+void prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        forEachView(Callback&& callback) const
+{
+  static_assert(std::is_same_v<Marshaller, RecordMarshaller<Element>>,
+                "forEachView requires RecordMarshaller");
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  bulk_scan(mElements.get_db_handle(),
+            mEnv ? dbstl::current_txn(mEnv) : nullptr,
+            [&callback](const Dbt& /* key */, const Dbt& data) {
+              return callback(record_view(data.get_data()));
+            });
+}
+
+template <typename Element,
+          typename Marshaller,
+          typename Watcher,
+          typename TxManager,
+          typename Deleter,
+          typename Metrics>
+prstorage::Page<typename prstorage::
+    Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+        element>
+prstorage::Storage<Element, Marshaller, Watcher, TxManager, Deleter, Metrics>::
+    page(const std::string& afterToken, std::size_t limit) const
+{
+  [[maybe_unused]] auto scope = mMetrics.measure(Operation::Scan);
+  Page<element> res;
+  if (limit == 0) {
+    res.nextToken = afterToken;
+    return res;
+  }
+
+  Dbc* cursor = nullptr;
+  auto check = [](int ret) {
+    if (ret != 0 && ret != DB_NOTFOUND) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+    return ret == 0;
+  };
+  check(mElements.get_db_handle()->cursor(
+      mEnv ? dbstl::current_txn(mEnv) : nullptr, &cursor, 0));
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  ReallocDbt key, data;
+  bool found = false;
+  if (afterToken.empty()) {
+    found = check(cursor->get(&key, &data, DB_FIRST));
+  } else {
+    key.assign(afterToken);
+    found = check(cursor->get(&key, &data, DB_SET_RANGE));
+    if (found && key.equals(afterToken)) {
+      found = check(cursor->get(&key, &data, DB_NEXT));
+    }
+  }
+
+  while (found) {
+    element elem;
+    Marshaller::restore(elem, data.get_data());
+    res.elements.push_back(std::move(elem));
+    if (res.elements.size() == limit) {
+      // маркер возвращается, только если за страницей есть элементы
+      auto last = key.bytes();
+      Dbt peek;
+      // значения не читаются: dlen == 0
+      peek.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+      if (check(cursor->get(&key, &peek, DB_NEXT))) {
+        res.nextToken = std::move(last);
+      }
+      break;
+    }
+    found = check(cursor->get(&key, &data, DB_NEXT));
+  }
+  return res;
+}
+
 #endif  // STORAGE_H
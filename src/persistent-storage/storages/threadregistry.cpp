@@ -0,0 +1,107 @@
+#include "threadregistry.h"
+
+#include <dbstl_common.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+using namespace prstorage;
+
+namespace {
+/// статические объекты инициализируются в главном потоке
+const std::thread::id MAIN_THREAD = std::this_thread::get_id();
+
+/// увеличивается ThreadRegistry::invalidate при закрытии handle
+std::atomic<std::uint64_t> generation{0};
+
+struct ThreadState {
+  std::vector<DbEnv*> envs;
+  std::vector<Db*> databases;
+  std::uint64_t generation = 0;
+  /// поток обращался к dbstl после последнего dbstl_thread_exit
+  bool registered = false;
+
+  ~ThreadState()
+  {
+    // ресурсы главного потока освобождает dbstl::dbstl_exit()
+    if (registered && std::this_thread::get_id() != MAIN_THREAD) {
+      dbstl::dbstl_thread_exit();
+    }
+  }
+};
+
+ThreadState& thread_state()
+{
+  thread_local ThreadState state;
+  // новый handle может получить адрес закрытого, поэтому после закрытия
+  // любого handle список регистраций потока строится заново
+  auto current = generation.load(std::memory_order_acquire);
+  if (state.generation != current) {
+    state.envs.clear();
+    state.databases.clear();
+    state.generation = current;
+  }
+  return state;
+}
+
+template <typename T>
+bool contains(const std::vector<T*>& handles, T* handle)
+{
+  return std::find(handles.begin(), handles.end(), handle) != handles.end();
+}
+}  // namespace
+
+void ThreadRegistry::registerEnv(DbEnv* env)
+{
+  auto& state = thread_state();
+  if (env && !contains(state.envs, env)) {
+    dbstl::register_db_env(env);
+    state.envs.push_back(env);
+    state.registered = true;
+  }
+}
+
+void ThreadRegistry::registerDb(Db* db)
+{
+  auto& state = thread_state();
+  if (db && !contains(state.databases, db)) {
+    dbstl::register_db(db);
+    state.databases.push_back(db);
+    state.registered = true;
+  }
+}
+
+void ThreadRegistry::registerAll(DbEnv* env, const std::vector<Db*>& databases)
+{
+  registerEnv(env);
+  for (auto db : databases) {
+    registerDb(db);
+  }
+}
+
+bool ThreadRegistry::isRegistered(DbEnv* env)
+{
+  return contains(thread_state().envs, env);
+}
+
+bool ThreadRegistry::isRegistered(Db* db)
+{
+  return contains(thread_state().databases, db);
+}
+
+void ThreadRegistry::invalidate()
+{
+  generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void ThreadRegistry::threadExit()
+{
+  auto& state = thread_state();
+  state.envs.clear();
+  state.databases.clear();
+  if (state.registered) {
+    state.registered = false;
+    dbstl::dbstl_thread_exit();
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef THREADREGISTRY_H
+#define THREADREGISTRY_H
+
+#include <db_cxx.h>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Регистрирует окружения и базы данных в dbstl один раз для каждого потока.
+ *
+ * dbstl требует, чтобы каждый поток зарегистрировал используемые handle
+ * (dbstl::register_db_env, dbstl::register_db), а регистрация захватывает
+ * глобальный мьютекс dbstl. ThreadRegistry запоминает зарегистрированные
+ * handle в thread_local списке, поэтому повторные вызовы из того же потока
+ * не обращаются к dbstl. Handle сравниваются по адресу, поэтому перед
+ * закрытием зарегистрированного handle нужно вызвать invalidate: иначе
+ * handle, открытый по тому же адресу, будет считаться зарегистрированным.
+ *
+ * При завершении потока, который регистрировал handle, автоматически
+ * вызывается dbstl::dbstl_thread_exit(). Для главного потока этого не
+ * происходит: его ресурсы освобождает dbstl::dbstl_exit().
+ */
+class ThreadRegistry {
+ public:
+  /**
+   * @brief Регистрирует окружение в текущем потоке, если оно еще не
+   * зарегистрировано
+   */
+  static void registerEnv(DbEnv* env);
+
+  /**
+   * @brief Регистрирует базу данных в текущем потоке, если она еще не
+   * зарегистрирована
+   */
+  static void registerDb(Db* db);
+
+  /**
+   * @brief Регистрирует окружение и все базы данных
+   */
+  static void registerAll(DbEnv* env, const std::vector<Db*>& databases);
+
+  static bool isRegistered(DbEnv* env);
+  static bool isRegistered(Db* db);
+
+  /**
+   * @brief Сбрасывает списки регистраций всех потоков; каждый поток
+   * регистрирует handle заново при следующем обращении. Вызывается при
+   * закрытии окружения или базы данных (dbstl::close_db,
+   * dbstl::close_db_env).
+   */
+  static void invalidate();
+
+  /**
+   * @brief Освобождает ресурсы dbstl текущего потока
+   * (dbstl::dbstl_thread_exit) и очищает его список регистраций. Нужен,
+   * если handle закрываются раньше, чем завершается поток.
+   */
+  static void threadExit();
+};
+}  // namespace prstorage
+
+#endif  // THREADREGISTRY_H
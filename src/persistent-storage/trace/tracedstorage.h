@@ -0,0 +1,287 @@
+#ifndef TRACEDSTORAGE_H
+#define TRACEDSTORAGE_H
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "persistent-storage/deleters/cascadereport.h"
+#include "persistent-storage/utils/keycodec.h"
+#include "persistent-storage/utils/page.h"
+#include "tracewriter.h"
+
+namespace prstorage {
+/**
+ * Тип идентификатора родителя хранилища: ParentElementId для ChildStorage,
+ * для остальных хранилищ - их ключ, операции над потомками у них не
+ * вызываются
+ */
+template <typename StorageType, typename = void>
+struct trace_parent_key {
+  using type = typename StorageType::key;
+};
+
+template <typename StorageType>
+struct trace_parent_key<StorageType,
+                        std::void_t<typename StorageType::ParentElementId>> {
+  using type = typename StorageType::ParentElementId;
+};
+
+/**
+ * Хранилище, которое записывает свои операции в трассу TraceWriter.
+ *
+ * StorageType - Storage, ChildStorage или другое хранилище с тем же
+ * интерфейсом. Конструкторы наследуются от StorageType. Пока трасса не
+ * задана, операции выполняются без измерений.
+ *
+ * Записываются операции, вызванные через TracedStorage. Изменения через
+ * обертки wrapper() и каскадные удаления, вызванные удалением родителя, в
+ * трассу не попадают, так как выполняются через базовый класс. Для
+ * ChildStorage записываются страницы потомков childrenOf и page и
+ * removeChildrenOf; childrenOf(parentId) возвращает диапазон, который
+ * читается после возврата из TracedStorage, поэтому не записывается.
+ *
+ * Пример:
+ *   using ContactStorage =
+ *       TracedStorage<Storage<Contact, ContactMarshaller, ContactWatcher>>;
+ *   auto storage = factory.makeStorage<ContactStorage>("app.db", "contacts");
+ *   storage->setTraceWriter(std::make_shared<TraceWriter>("contacts.trace"));
+ */
+template <typename StorageType>
+class TracedStorage : public StorageType {
+ public:
+  using element = typename StorageType::element;
+  using key = typename StorageType::key;
+  using marshaller_type = typename StorageType::marshaller_type;
+  using parent_key = typename trace_parent_key<StorageType>::type;
+
+ public:
+  using StorageType::StorageType;
+
+ public:
+  /**
+   * @brief Задает трассу, nullptr выключает запись
+   */
+  void setTraceWriter(std::shared_ptr<TraceWriter> writer);
+  std::shared_ptr<TraceWriter> traceWriter() const;
+
+ public:
+  bool add(const element& elem);
+  bool remove(const key& id);
+  bool strictUpdate(const element& elem);
+  void update(const element& elem);
+
+  element get(const key& id) const;
+  bool has(const key& id) const;
+  std::vector<element> getAllElements() const;
+  std::vector<element> get_if(std::function<bool(const element&)> p) const;
+
+ public:
+  /**
+   * Операции над потомками, доступны, если StorageType - ChildStorage
+   */
+  auto childrenOf(const parent_key& parentId) const;
+  std::vector<element> childrenOf(
+      const parent_key& parentId,
+      std::size_t limit,
+      const std::optional<key>& afterKey = {}) const;
+  Page<element> page(const parent_key& parentId,
+                     const std::string& afterToken,
+                     std::size_t limit) const;
+  using StorageType::page;
+  CascadeReport removeChildrenOf(
+      const std::vector<parent_key>& parentIds,
+      std::size_t chunkSize = CascadeReport::DEFAULT_CHUNK_SIZE);
+
+ private:
+  std::shared_ptr<TraceWriter> mWriter;
+};
+}  // namespace prstorage
+
+template <typename StorageType>
+void prstorage::TracedStorage<StorageType>::setTraceWriter(
+    std::shared_ptr<TraceWriter> writer)
+{
+  mWriter = std::move(writer);
+}
+
+template <typename StorageType>
+std::shared_ptr<prstorage::TraceWriter>
+prstorage::TracedStorage<StorageType>::traceWriter() const
+{
+  return mWriter;
+}
+
+template <typename StorageType>
+bool prstorage::TracedStorage<StorageType>::add(const element& elem)
+{
+  if (!mWriter) {
+    return StorageType::add(elem);
+  }
+  TraceScope scope(*mWriter, TraceOperation::Add,
+                   KeyCodec<key>::encode(get_id(elem)));
+  scope.setValueSize(marshaller_type::size(elem));
+  auto res = StorageType::add(elem);
+  scope.setStatus(res ? TraceStatus::Ok : TraceStatus::Miss);
+  return res;
+}
+
+template <typename StorageType>
+bool prstorage::TracedStorage<StorageType>::remove(const key& id)
+{
+  if (!mWriter) {
+    return StorageType::remove(id);
+  }
+  TraceScope scope(*mWriter, TraceOperation::Remove,
+                   KeyCodec<key>::encode(id));
+  auto res = StorageType::remove(id);
+  scope.setStatus(res ? TraceStatus::Ok : TraceStatus::Miss);
+  return res;
+}
+
+template <typename StorageType>
+bool prstorage::TracedStorage<StorageType>::strictUpdate(const element& elem)
+{
+  if (!mWriter) {
+    return StorageType::strictUpdate(elem);
+  }
+  TraceScope scope(*mWriter, TraceOperation::StrictUpdate,
+                   KeyCodec<key>::encode(get_id(elem)));
+  scope.setValueSize(marshaller_type::size(elem));
+  auto res = StorageType::strictUpdate(elem);
+  scope.setStatus(res ? TraceStatus::Ok : TraceStatus::Miss);
+  return res;
+}
+
+template <typename StorageType>
+void prstorage::TracedStorage<StorageType>::update(const element& elem)
+{
+  if (!mWriter) {
+    return StorageType::update(elem);
+  }
+  TraceScope scope(*mWriter, TraceOperation::Update,
+                   KeyCodec<key>::encode(get_id(elem)));
+  scope.setValueSize(marshaller_type::size(elem));
+  StorageType::update(elem);
+}
+
+template <typename StorageType>
+typename prstorage::TracedStorage<StorageType>::element
+prstorage::TracedStorage<StorageType>::get(const key& id) const
+{
+  if (!mWriter) {
+    return StorageType::get(id);
+  }
+  TraceScope scope(*mWriter, TraceOperation::Get, KeyCodec<key>::encode(id));
+  try {
+    auto res = StorageType::get(id);
+    scope.setValueSize(marshaller_type::size(res));
+    return res;
+  } catch (const std::range_error&) {
+    scope.setStatus(TraceStatus::Miss);
+    throw;
+  }
+}
+
+template <typename StorageType>
+bool prstorage::TracedStorage<StorageType>::has(const key& id) const
+{
+  if (!mWriter) {
+    return StorageType::has(id);
+  }
+  TraceScope scope(*mWriter, TraceOperation::Has, KeyCodec<key>::encode(id));
+  auto res = StorageType::has(id);
+  scope.setStatus(res ? TraceStatus::Ok : TraceStatus::Miss);
+  return res;
+}
+
+template <typename StorageType>
+std::vector<typename prstorage::TracedStorage<StorageType>::element>
+prstorage::TracedStorage<StorageType>::getAllElements() const
+{
+  if (!mWriter) {
+    return StorageType::getAllElements();
+  }
+  TraceScope scope(*mWriter, TraceOperation::GetAll);
+  auto res = StorageType::getAllElements();
+  scope.setValueSize(res.size());
+  return res;
+}
+
+template <typename StorageType>
+std::vector<typename prstorage::TracedStorage<StorageType>::element>
+prstorage::TracedStorage<StorageType>::get_if(
+    std::function<bool(const element&)> p) const
+{
+  if (!mWriter) {
+    return StorageType::get_if(std::move(p));
+  }
+  TraceScope scope(*mWriter, TraceOperation::GetIf);
+  auto res = StorageType::get_if(std::move(p));
+  scope.setValueSize(res.size());
+  return res;
+}
+
+template <typename StorageType>
+auto prstorage::TracedStorage<StorageType>::childrenOf(
+    const parent_key& parentId) const
+{
+  return StorageType::childrenOf(parentId);
+}
+
+template <typename StorageType>
+std::vector<typename prstorage::TracedStorage<StorageType>::element>
+prstorage::TracedStorage<StorageType>::childrenOf(
+    const parent_key& parentId,
+    std::size_t limit,
+    const std::optional<key>& afterKey) const
+{
+  if (!mWriter) {
+    return StorageType::childrenOf(parentId, limit, afterKey);
+  }
+  TraceScope scope(*mWriter, TraceOperation::ChildrenOf,
+                   KeyCodec<parent_key>::encode(parentId));
+  auto res = StorageType::childrenOf(parentId, limit, afterKey);
+  scope.setValueSize(res.size());
+  return res;
+}
+
+template <typename StorageType>
+prstorage::Page<typename prstorage::TracedStorage<StorageType>::element>
+prstorage::TracedStorage<StorageType>::page(const parent_key& parentId,
+                                            const std::string& afterToken,
+                                            std::size_t limit) const
+{
+  if (!mWriter) {
+    return StorageType::page(parentId, afterToken, limit);
+  }
+  TraceScope scope(*mWriter, TraceOperation::ChildrenPage,
+                   KeyCodec<parent_key>::encode(parentId));
+  auto res = StorageType::page(parentId, afterToken, limit);
+  scope.setValueSize(res.elements.size());
+  return res;
+}
+
+template <typename StorageType>
+prstorage::CascadeReport
+prstorage::TracedStorage<StorageType>::removeChildrenOf(
+    const std::vector<parent_key>& parentIds,
+    std::size_t chunkSize)
+{
+  if (!mWriter) {
+    return StorageType::removeChildrenOf(parentIds, chunkSize);
+  }
+  // ключ записывается, только если родитель один
+  TraceScope scope(*mWriter, TraceOperation::RemoveChildrenOf,
+                   parentIds.size() == 1
+                       ? KeyCodec<parent_key>::encode(parentIds.front())
+                       : std::string());
+  auto res = StorageType::removeChildrenOf(parentIds, chunkSize);
+  scope.setValueSize(res.totalRemoved());
+  return res;
+}
+
+#endif  // TRACEDSTORAGE_H
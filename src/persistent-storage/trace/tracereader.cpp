@@ -0,0 +1,93 @@
+#include "tracereader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "tracewriter.h"
+
+using namespace prstorage;
+
+namespace {
+std::int64_t unzigzag(std::uint64_t value) noexcept
+{
+  return static_cast<std::int64_t>(value >> 1) ^
+         -static_cast<std::int64_t>(value & 1);
+}
+}  // namespace
+
+TraceReader::TraceReader(const std::string& path) :
+    mFile(std::fopen(path.c_str(), "rb"))
+{
+  if (!mFile) {
+    throw std::runtime_error("Failed to open trace " + path + ": " +
+                             std::strerror(errno));
+  }
+
+  char header[sizeof(TraceWriter::TRACE_MAGIC) + 4];
+  if (std::fread(header, 1, sizeof(header), mFile) != sizeof(header) ||
+      std::memcmp(header, TraceWriter::TRACE_MAGIC,
+                  sizeof(TraceWriter::TRACE_MAGIC)) != 0) {
+    std::fclose(mFile);
+    throw std::runtime_error("Not a trace file: " + path);
+  }
+  std::uint32_t version = 0;
+  for (int i = 0; i < 4; ++i) {
+    version |= static_cast<std::uint32_t>(static_cast<unsigned char>(
+                   header[sizeof(TraceWriter::TRACE_MAGIC) + i]))
+               << (8 * i);
+  }
+  // записи ранних версий читаются так же, в них нет только новых операций
+  if (version == 0 || version > TraceWriter::TRACE_VERSION) {
+    std::fclose(mFile);
+    throw std::runtime_error("Unsupported trace version " +
+                             std::to_string(version) + ": " + path);
+  }
+}
+
+TraceReader::~TraceReader()
+{
+  std::fclose(mFile);
+}
+
+bool TraceReader::next(TraceRecord& record)
+{
+  auto operation = std::fgetc(mFile);
+  auto status = std::fgetc(mFile);
+  std::uint64_t startDelta = 0, keySize = 0;
+  if (operation == EOF || status == EOF || !readVarint(startDelta) ||
+      !readVarint(record.durationNanoseconds) || !readVarint(keySize)) {
+    return false;
+  }
+  if (operation >= static_cast<int>(TRACE_OPERATION_COUNT) ||
+      status > static_cast<int>(TraceStatus::Error)) {
+    throw std::runtime_error("Corrupted trace record");
+  }
+
+  record.key.resize(keySize);
+  if (std::fread(record.key.data(), 1, keySize, mFile) != keySize ||
+      !readVarint(record.valueSize)) {
+    return false;
+  }
+  record.operation = static_cast<TraceOperation>(operation);
+  record.status = static_cast<TraceStatus>(status);
+  mLastStart += static_cast<std::uint64_t>(unzigzag(startDelta));
+  record.startNanoseconds = mLastStart;
+  return true;
+}
+
+bool TraceReader::readVarint(std::uint64_t& value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    auto byte = std::fgetc(mFile);
+    if (byte == EOF) {
+      return false;
+    }
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  throw std::runtime_error("Corrupted trace record");
+}
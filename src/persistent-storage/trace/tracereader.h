@@ -0,0 +1,44 @@
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+
+#include <cstdio>
+#include <string>
+
+#include "tracerecord.h"
+
+namespace prstorage {
+/**
+ * Последовательно читает трассу, записанную TraceWriter
+ */
+class TraceReader {
+ public:
+  /**
+   * @brief Открывает трассу и проверяет заголовок
+   * @throws std::runtime_error если файл не удалось открыть или он не
+   * является трассой поддерживаемой версии
+   */
+  explicit TraceReader(const std::string& path);
+  ~TraceReader();
+
+ private:
+  TraceReader(const TraceReader&) = delete;
+  TraceReader& operator=(const TraceReader&) = delete;
+
+ public:
+  /**
+   * @brief Читает следующую запись
+   * @return false в конце трассы. Недописанная последняя запись, например
+   * после аварийного завершения процесса, отбрасывается.
+   */
+  bool next(TraceRecord& record);
+
+ private:
+  bool readVarint(std::uint64_t& value);
+
+ private:
+  std::FILE* mFile;
+  std::uint64_t mLastStart = 0;
+};
+}  // namespace prstorage
+
+#endif  // TRACEREADER_H
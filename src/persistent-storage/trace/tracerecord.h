@@ -0,0 +1,60 @@
+#ifndef TRACERECORD_H
+#define TRACERECORD_H
+
+#include <cstdint>
+#include <string>
+
+namespace prstorage {
+/**
+ * Операции хранилища, которые записываются в трассу
+ */
+enum class TraceOperation : std::uint8_t {
+  Add,
+  Get,
+  Has,
+  Update,
+  StrictUpdate,
+  Remove,
+  GetAll,
+  GetIf,
+  /// страница childrenOf(parentId, limit, afterKey) ChildStorage
+  ChildrenOf,
+  /// страница page(parentId, afterToken, limit) ChildStorage
+  ChildrenPage,
+  RemoveChildrenOf
+};
+
+constexpr std::size_t TRACE_OPERATION_COUNT = 11;
+
+const char* traceOperationName(TraceOperation operation) noexcept;
+
+/**
+ * Результат операции
+ */
+enum class TraceStatus : std::uint8_t {
+  Ok,
+  /// элемент не найден: get бросил исключение или функция вернула false
+  Miss,
+  /// операция завершилась исключением
+  Error
+};
+
+/**
+ * Запись трассы об одной операции хранилища
+ */
+struct TraceRecord {
+  TraceOperation operation = TraceOperation::Get;
+  TraceStatus status = TraceStatus::Ok;
+  /// время начала операции от начала записи трассы
+  std::uint64_t startNanoseconds = 0;
+  std::uint64_t durationNanoseconds = 0;
+  /// ключ в представлении KeyCodec, пустой для обходов; для операций
+  /// над потомками - ключ родителя
+  std::string key;
+  /// размер элемента после маршалинга, для обходов - количество элементов,
+  /// для RemoveChildrenOf - количество удаленных элементов
+  std::uint64_t valueSize = 0;
+};
+}  // namespace prstorage
+
+#endif  // TRACERECORD_H
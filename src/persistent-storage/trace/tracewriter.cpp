@@ -0,0 +1,164 @@
+#include "tracewriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+void appendVarint(std::string& buffer, std::uint64_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+std::uint64_t zigzag(std::int64_t value) noexcept
+{
+  return (static_cast<std::uint64_t>(value) << 1) ^
+         static_cast<std::uint64_t>(value >> 63);
+}
+}  // namespace
+
+const char* prstorage::traceOperationName(TraceOperation operation) noexcept
+{
+  switch (operation) {
+    case TraceOperation::Add:
+      return "add";
+    case TraceOperation::Get:
+      return "get";
+    case TraceOperation::Has:
+      return "has";
+    case TraceOperation::Update:
+      return "update";
+    case TraceOperation::StrictUpdate:
+      return "strictUpdate";
+    case TraceOperation::Remove:
+      return "remove";
+    case TraceOperation::GetAll:
+      return "getAllElements";
+    case TraceOperation::GetIf:
+      return "get_if";
+    case TraceOperation::ChildrenOf:
+      return "childrenOf";
+    case TraceOperation::ChildrenPage:
+      return "childrenPage";
+    case TraceOperation::RemoveChildrenOf:
+      return "removeChildrenOf";
+  }
+  return "unknown";
+}
+
+TraceWriter::TraceWriter(const std::string& path) :
+    mStart(std::chrono::steady_clock::now()),
+    mFile(std::fopen(path.c_str(), "wb"))
+{
+  if (!mFile) {
+    throw std::runtime_error("Failed to create trace " + path + ": " +
+                             std::strerror(errno));
+  }
+  mBuffer.reserve(BUFFER_SIZE);
+  mBuffer.append(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  for (int i = 0; i < 4; ++i) {
+    mBuffer.push_back(static_cast<char>((TRACE_VERSION >> (8 * i)) & 0xff));
+  }
+}
+
+TraceWriter::~TraceWriter()
+{
+  flushBuffer();
+  std::fclose(mFile);
+}
+
+std::chrono::steady_clock::time_point TraceWriter::start() const noexcept
+{
+  return mStart;
+}
+
+void TraceWriter::write(const TraceRecord& record)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mBuffer.push_back(static_cast<char>(record.operation));
+  mBuffer.push_back(static_cast<char>(record.status));
+  // операции разных потоков завершаются не в порядке начала
+  appendVarint(mBuffer, zigzag(static_cast<std::int64_t>(
+                            record.startNanoseconds - mLastStart)));
+  appendVarint(mBuffer, record.durationNanoseconds);
+  appendVarint(mBuffer, record.key.size());
+  mBuffer.append(record.key);
+  appendVarint(mBuffer, record.valueSize);
+  mLastStart = record.startNanoseconds;
+  ++mRecords;
+
+  if (mBuffer.size() >= BUFFER_SIZE) {
+    flushBuffer();
+  }
+}
+
+void TraceWriter::flush()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  flushBuffer();
+  std::fflush(mFile);
+}
+
+std::uint64_t TraceWriter::records() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mRecords;
+}
+
+void TraceWriter::flushBuffer()
+{
+  if (!mBuffer.empty()) {
+    std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+    mBuffer.clear();
+  }
+}
+
+TraceScope::TraceScope(TraceWriter& writer,
+                       TraceOperation operation,
+                       std::string key) :
+    mWriter(writer),
+    mExceptions(std::uncaught_exceptions()),
+    mOperationStart(std::chrono::steady_clock::now())
+{
+  mRecord.operation = operation;
+  mRecord.key = std::move(key);
+}
+
+TraceScope::~TraceScope()
+{
+  auto end = std::chrono::steady_clock::now();
+  if (std::uncaught_exceptions() > mExceptions &&
+      mRecord.status == TraceStatus::Ok) {
+    mRecord.status = TraceStatus::Error;
+  }
+  mRecord.startNanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(mOperationStart -
+                                                           mWriter.start())
+          .count();
+  mRecord.durationNanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                           mOperationStart)
+          .count();
+  try {
+    mWriter.write(mRecord);
+  } catch (const std::exception&) {
+    // трасса не должна влиять на результат операции
+  }
+}
+
+void TraceScope::setStatus(TraceStatus status) noexcept
+{
+  mRecord.status = status;
+}
+
+void TraceScope::setValueSize(std::uint64_t size) noexcept
+{
+  mRecord.valueSize = size;
+}
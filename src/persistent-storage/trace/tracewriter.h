@@ -0,0 +1,95 @@
+#ifndef TRACEWRITER_H
+#define TRACEWRITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "tracerecord.h"
+
+namespace prstorage {
+/**
+ * Записывает трассу операций хранилища в компактный двоичный файл.
+ *
+ * Файл начинается с заголовка TRACE_MAGIC и номера версии, далее следуют
+ * записи: код операции, статус, смещение времени начала относительно
+ * предыдущей записи, длительность, ключ и размер значения. Числа хранятся
+ * в виде varint, поэтому запись с коротким ключом занимает около 10 байт.
+ *
+ * Записи буферизуются и сбрасываются на диск при заполнении буфера, вызове
+ * flush() и уничтожении объекта. Запись может выполняться из нескольких
+ * потоков.
+ */
+class TraceWriter {
+ public:
+  static constexpr char TRACE_MAGIC[8] = {'P', 'R', 'T', 'R',
+                                          'A', 'C', 'E', '\0'};
+  /// версия 2 добавила операции над потомками, формат записи не изменился
+  static constexpr std::uint32_t TRACE_VERSION = 2;
+  static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+ public:
+  /**
+   * @brief Создает файл трассы, существующий файл перезаписывается
+   * @throws std::runtime_error если файл не удалось создать
+   */
+  explicit TraceWriter(const std::string& path);
+  ~TraceWriter();
+
+ private:
+  TraceWriter(const TraceWriter&) = delete;
+  TraceWriter& operator=(const TraceWriter&) = delete;
+
+ public:
+  /**
+   * @brief Время, от которого отсчитывается начало операций
+   */
+  std::chrono::steady_clock::time_point start() const noexcept;
+
+  void write(const TraceRecord& record);
+  void flush();
+  std::uint64_t records() const;
+
+ private:
+  void flushBuffer();
+
+ private:
+  const std::chrono::steady_clock::time_point mStart;
+  mutable std::mutex mMutex;
+  std::FILE* mFile;
+  std::string mBuffer;
+  std::uint64_t mLastStart = 0;
+  std::uint64_t mRecords = 0;
+};
+
+/**
+ * Измеряет операцию от создания до уничтожения объекта и записывает ее в
+ * трассу. Если объект уничтожается при раскрутке стека, а статус не был
+ * задан явно, операция записывается со статусом Error.
+ */
+class TraceScope {
+ public:
+  TraceScope(TraceWriter& writer,
+             TraceOperation operation,
+             std::string key = std::string());
+  ~TraceScope();
+
+ private:
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ public:
+  void setStatus(TraceStatus status) noexcept;
+  void setValueSize(std::uint64_t size) noexcept;
+
+ private:
+  TraceWriter& mWriter;
+  TraceRecord mRecord;
+  int mExceptions;
+  std::chrono::steady_clock::time_point mOperationStart;
+};
+}  // namespace prstorage
+
+#endif  // TRACEWRITER_H
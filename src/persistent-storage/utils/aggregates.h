@@ -0,0 +1,76 @@
+#ifndef AGGREGATES_H
+#define AGGREGATES_H
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace prstorage {
+/**
+ * Результат group_count: количество элементов для каждого значения keyFn
+ */
+template <typename Element, typename KeyFn>
+using GroupCounts =
+    std::map<std::decay_t<std::invoke_result_t<KeyFn&, const Element&>>,
+             std::size_t>;
+
+/**
+ * Агрегаты, выраженные через reduce(init, op) хранилища. reduce передает
+ * элементы по одному по мере чтения из БД, поэтому агрегаты не
+ * накапливают элементы в памяти.
+ */
+template <typename StorageType, typename Predicate>
+std::size_t count_elements_if(const StorageType& storage, Predicate&& p)
+{
+  using element = typename StorageType::element;
+  return storage.reduce(std::size_t(0),
+                        [&p](std::size_t count, const element& elem) {
+                          return p(elem) ? count + 1 : count;
+                        });
+}
+
+/**
+ * @brief Возвращает первый элемент, значение keyFn которого лучше
+ * значений остальных элементов по better
+ */
+template <typename StorageType, typename KeyFn, typename Compare>
+std::optional<typename StorageType::element>
+best_element_by(const StorageType& storage, KeyFn&& keyFn, Compare better)
+{
+  using element = typename StorageType::element;
+  using value_type = std::decay_t<std::invoke_result_t<KeyFn&, const element&>>;
+  // значение keyFn лучшего элемента хранится, чтобы не вычислять его повторно
+  using best_type = std::optional<std::pair<value_type, element>>;
+
+  auto best = storage.reduce(
+      best_type(), [&keyFn, &better](best_type current, const element& elem) {
+        auto value = keyFn(elem);
+        if (!current || better(value, current->first)) {
+          current.emplace(std::move(value), elem);
+        }
+        return current;
+      });
+  if (!best) {
+    return {};
+  }
+  return std::move(best->second);
+}
+
+template <typename StorageType, typename KeyFn>
+GroupCounts<typename StorageType::element, KeyFn> group_count_elements(
+    const StorageType& storage,
+    KeyFn&& keyFn)
+{
+  using element = typename StorageType::element;
+  using result_type = GroupCounts<element, KeyFn>;
+  return storage.reduce(result_type(),
+                        [&keyFn](result_type groups, const element& elem) {
+                          ++groups[keyFn(elem)];
+                          return groups;
+                        });
+}
+}  // namespace prstorage
+
+#endif  // AGGREGATES_H
@@ -0,0 +1,127 @@
+#include "bloomfilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace prstorage;
+
+namespace {
+constexpr std::size_t WORD_BITS = 64;
+constexpr std::size_t MAX_HASHES = 30;
+
+/// FNV-1a
+std::uint64_t hash_bytes(const void* data, std::size_t size) noexcept
+{
+  auto bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t hash = 14695981039346656037ull;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/// финальное перемешивание splitmix64, дает вторую хеш-функцию
+std::uint64_t mix(std::uint64_t value) noexcept
+{
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ull;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebull;
+  value ^= value >> 31;
+  return value;
+}
+}  // namespace
+
+BloomFilter::BloomFilter(Options options)
+{
+  if (options.expectedKeys == 0) {
+    throw std::invalid_argument("expected keys must be positive");
+  }
+  if (!(options.falsePositiveRate > 0.0 && options.falsePositiveRate < 1.0)) {
+    throw std::invalid_argument("false positive rate must be in (0, 1)");
+  }
+
+  const double ln2 = std::log(2.0);
+  auto keys = static_cast<double>(options.expectedKeys);
+  auto bits = static_cast<std::size_t>(
+      std::ceil(-keys * std::log(options.falsePositiveRate) / (ln2 * ln2)));
+  if (options.maxBytes > 0) {
+    bits = std::min(bits, options.maxBytes * 8);
+  }
+  auto words = std::max<std::size_t>(1, (bits + WORD_BITS - 1) / WORD_BITS);
+  mBits = words * WORD_BITS;
+
+  // оптимальное количество хеш-функций для фактического размера фильтра
+  auto hashes = std::lround(static_cast<double>(mBits) / keys * ln2);
+  mHashes = std::clamp<std::size_t>(static_cast<std::size_t>(hashes), 1,
+                                    MAX_HASHES);
+
+  mWords = std::make_unique<std::atomic<std::uint64_t>[]>(words);
+  clear();
+}
+
+BloomFilter::BloomFilter() : BloomFilter(Options()) {}
+
+void BloomFilter::add(const void* data, std::size_t size) noexcept
+{
+  auto h1 = hash_bytes(data, size);
+  auto h2 = mix(h1) | 1;
+  for (std::size_t i = 0; i < mHashes; ++i) {
+    auto bit = (h1 + i * h2) % mBits;
+    mWords[bit / WORD_BITS].fetch_or(1ull << (bit % WORD_BITS),
+                                     std::memory_order_relaxed);
+  }
+  mAdded.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BloomFilter::mayContain(const void* data, std::size_t size) const noexcept
+{
+  auto h1 = hash_bytes(data, size);
+  auto h2 = mix(h1) | 1;
+  for (std::size_t i = 0; i < mHashes; ++i) {
+    auto bit = (h1 + i * h2) % mBits;
+    auto word = mWords[bit / WORD_BITS].load(std::memory_order_relaxed);
+    if ((word & (1ull << (bit % WORD_BITS))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BloomFilter::clear() noexcept
+{
+  for (std::size_t i = 0; i < mBits / WORD_BITS; ++i) {
+    mWords[i].store(0, std::memory_order_relaxed);
+  }
+  mAdded.store(0, std::memory_order_relaxed);
+}
+
+std::size_t BloomFilter::bitCount() const noexcept
+{
+  return mBits;
+}
+
+std::size_t BloomFilter::hashCount() const noexcept
+{
+  return mHashes;
+}
+
+std::size_t BloomFilter::memoryBytes() const noexcept
+{
+  return mBits / 8;
+}
+
+std::size_t BloomFilter::addedCount() const noexcept
+{
+  return mAdded.load(std::memory_order_relaxed);
+}
+
+double BloomFilter::estimatedFalsePositiveRate() const noexcept
+{
+  auto hashes = static_cast<double>(mHashes);
+  auto keys = static_cast<double>(addedCount());
+  return std::pow(1.0 - std::exp(-hashes * keys / static_cast<double>(mBits)),
+                  hashes);
+}
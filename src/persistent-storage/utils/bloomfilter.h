@@ -0,0 +1,83 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace prstorage {
+/**
+ * Фильтр Блума над последовательностями байт. Отвечает "ключа точно нет"
+ * или "ключ, возможно, есть" без обращения к базе данных.
+ *
+ * Биты хранятся в атомарных словах, поэтому add и mayContain можно вызывать
+ * из разных потоков без блокировок. Удаление ключей не поддерживается:
+ * удаленные ключи только увеличивают долю ложноположительных ответов до
+ * следующего clear() и повторного заполнения.
+ */
+class BloomFilter {
+ public:
+  struct Options {
+    /// ожидаемое количество ключей
+    std::size_t expectedKeys = 100000;
+    /// допустимая доля ложноположительных ответов при expectedKeys ключах
+    double falsePositiveRate = 0.01;
+    /// ограничение памяти фильтра в байтах, 0 - без ограничения
+    std::size_t maxBytes = 0;
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса, вычисляет размер фильтра и количество
+   * хеш-функций по ожидаемому количеству ключей и доле ложноположительных
+   * ответов
+   * @throws std::invalid_argument при недопустимых параметрах
+   */
+  explicit BloomFilter(Options options);
+  BloomFilter();
+
+ private:
+  BloomFilter(const BloomFilter&) = delete;
+  BloomFilter& operator=(const BloomFilter&) = delete;
+
+ public:
+  void add(const void* data, std::size_t size) noexcept;
+
+  /**
+   * @brief Проверяет ключ
+   * @return false - ключ не добавлялся, true - ключ, возможно, добавлялся
+   */
+  bool mayContain(const void* data, std::size_t size) const noexcept;
+
+  /**
+   * @brief Очищает фильтр. Не должен выполняться одновременно с проверками,
+   * иначе они могут вернуть false для существующих ключей.
+   */
+  void clear() noexcept;
+
+ public:
+  std::size_t bitCount() const noexcept;
+  std::size_t hashCount() const noexcept;
+  std::size_t memoryBytes() const noexcept;
+
+  /**
+   * @brief Возвращает количество вызовов add с момента последнего clear()
+   */
+  std::size_t addedCount() const noexcept;
+
+  /**
+   * @brief Оценивает долю ложноположительных ответов для addedCount()
+   * ключей
+   */
+  double estimatedFalsePositiveRate() const noexcept;
+
+ private:
+  std::size_t mBits;
+  std::size_t mHashes;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> mWords;
+  std::atomic<std::size_t> mAdded{0};
+};
+}  // namespace prstorage
+
+#endif  // BLOOMFILTER_H
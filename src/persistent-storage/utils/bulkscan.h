@@ -0,0 +1,90 @@
+#ifndef BULKSCAN_H
+#define BULKSCAN_H
+
+#include <db_cxx.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace prstorage {
+constexpr std::size_t BULK_SCAN_BUFFER_SIZE = 1024 * 1024;
+
+/**
+ * @brief Выполняет чтение read() в буфер DB_DBT_USERMEM и возвращает его
+ * код. Handle, открытый без DB_CXX_NO_EXCEPTIONS, сообщает о нехватке
+ * буфера исключением DbMemoryException, а не кодом DB_BUFFER_SMALL; в обоих
+ * случаях возвращается DB_BUFFER_SMALL, а размер Dbt содержит нужную длину.
+ */
+template <typename Read>
+int read_into_buffer(Read&& read)
+{
+  try {
+    return read();
+  } catch (const DbMemoryException&) {
+    return DB_BUFFER_SMALL;
+  }
+}
+
+/**
+ * @brief Обходит все записи базы данных одним курсором с пакетным чтением
+ * DB_MULTIPLE_KEY. Ключи и значения передаются в виде байт со страниц
+ * пакетного буфера и не декодируются.
+ * @param db база данных
+ * @param txn транзакция, в которой открывается курсор, или nullptr
+ * @param callback функция bool(const Dbt& key, const Dbt& data), обход
+ * прекращается, когда она возвращает false. Данные Dbt действительны только
+ * во время вызова.
+ * @param bufferSize начальный размер пакетного буфера, кратный 1024
+ * @throws std::runtime_error при ошибке Berkeley DB
+ */
+template <typename Callback>
+void bulk_scan(Db* db,
+               DbTxn* txn,
+               Callback&& callback,
+               std::size_t bufferSize = BULK_SCAN_BUFFER_SIZE)
+{
+  auto check = [](int ret) {
+    if (ret != 0) {
+      throw std::runtime_error(DbEnv::strerror(ret));
+    }
+  };
+
+  Dbc* cursor = nullptr;
+  check(db->cursor(txn, &cursor, 0));
+  auto closer = [](Dbc* c) { c->close(); };
+  std::unique_ptr<Dbc, decltype(closer)> guard(cursor, closer);
+
+  std::vector<char> buffer(bufferSize);
+  Dbt key, data;
+  data.set_flags(DB_DBT_USERMEM);
+  while (true) {
+    data.set_data(buffer.data());
+    data.set_ulen(static_cast<u_int32_t>(buffer.size()));
+    auto ret = read_into_buffer(
+        [&] { return cursor->get(&key, &data, DB_MULTIPLE_KEY | DB_NEXT); });
+    if (ret == DB_NOTFOUND) {
+      return;
+    }
+    if (ret == DB_BUFFER_SMALL) {
+      // размер пакетного буфера должен быть кратен 1024
+      auto size = std::max<std::size_t>(buffer.size() * 2, data.get_size());
+      buffer.resize((size + 1023) / 1024 * 1024);
+      continue;
+    }
+    check(ret);
+
+    DbMultipleKeyDataIterator it(data);
+    Dbt elemKey, elemData;
+    while (it.next(elemKey, elemData)) {
+      if (!callback(static_cast<const Dbt&>(elemKey),
+                    static_cast<const Dbt&>(elemData))) {
+        return;
+      }
+    }
+  }
+}
+}  // namespace prstorage
+
+#endif  // BULKSCAN_H
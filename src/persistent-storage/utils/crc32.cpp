@@ -0,0 +1,30 @@
+#include "crc32.h"
+#include <array>
+
+namespace {
+std::array<std::uint32_t, 256> make_crc_table()
+{
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t i = 0; i < table.size(); ++i) {
+    std::uint32_t value = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+    }
+    table[i] = value;
+  }
+  return table;
+}
+}  // namespace
+
+std::uint32_t prstorage::crc32(const void* data,
+                               std::size_t size,
+                               std::uint32_t crc)
+{
+  static const auto table = make_crc_table();
+  auto bytes = static_cast<const unsigned char*>(data);
+  crc = ~crc;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
@@ -0,0 +1,18 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prstorage {
+/**
+ * @brief Вычисляет CRC-32 (полином 0xEDB88320) блока данных
+ * @param data данные
+ * @param size размер данных в байтах
+ * @param crc значение CRC предыдущего блока, если контрольная сумма
+ * вычисляется по частям
+ */
+std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0);
+}  // namespace prstorage
+
+#endif  // CRC32_H
@@ -0,0 +1,92 @@
+#ifndef ELEMENTSRANGE_H
+#define ELEMENTSRANGE_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace prstorage {
+/**
+ * Диапазон элементов поверх пары итераторов контейнера dbstl.
+ *
+ * Итераторы контейнера указывают на пары ключ/значение, диапазон
+ * возвращает только значения. Элементы извлекаются из БД по мере
+ * продвижения итератора, поэтому весь диапазон не загружается в память.
+ */
+template <typename Iterator>
+class ElementsRange {
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type =
+        std::decay_t<decltype((*std::declval<Iterator&>()).second)>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = value_type;
+
+   public:
+    explicit const_iterator(const Iterator& it) : mIt(it) {}
+
+   public:
+    value_type operator*() const { return (*mIt).second; }
+    const_iterator& operator++()
+    {
+      ++mIt;
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const
+    {
+      return mIt == other.mIt;
+    }
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+   private:
+    mutable Iterator mIt;
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param begin итератор на первый элемент диапазона
+   * @param end итератор на элемент, следующий за последним
+   */
+  ElementsRange(Iterator begin, Iterator end);
+
+ public:
+  const_iterator begin() const;
+  const_iterator end() const;
+
+ private:
+  Iterator mBegin;
+  Iterator mEnd;
+};
+}  // namespace prstorage
+
+template <typename Iterator>
+prstorage::ElementsRange<Iterator>::ElementsRange(Iterator begin,
+                                                  Iterator end) :
+    mBegin(std::move(begin)),
+    mEnd(std::move(end))
+{
+}
+
+template <typename Iterator>
+typename prstorage::ElementsRange<Iterator>::const_iterator
+prstorage::ElementsRange<Iterator>::begin() const
+{
+  return const_iterator(mBegin);
+}
+
+template <typename Iterator>
+typename prstorage::ElementsRange<Iterator>::const_iterator
+prstorage::ElementsRange<Iterator>::end() const
+{
+  return const_iterator(mEnd);
+}
+
+#endif  // ELEMENTSRANGE_H
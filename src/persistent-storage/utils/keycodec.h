@@ -0,0 +1,41 @@
+#ifndef KEYCODEC_H
+#define KEYCODEC_H
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace prstorage {
+/**
+ * Преобразует ключ в последовательность байт и обратно для хранилищ,
+ * которые работают с ключами как с массивами байт.
+ *
+ * Строки хранятся без завершающего нуля, простые типы копируются побайтно.
+ */
+template <typename Key, typename = void>
+struct KeyCodec {
+  static_assert(std::is_trivially_copyable<Key>::value,
+                "key type must be trivially copyable or std::string");
+
+  static std::string encode(const Key& key)
+  {
+    return std::string(reinterpret_cast<const char*>(&key), sizeof(Key));
+  }
+
+  static Key decode(std::string_view bytes)
+  {
+    Key key;
+    std::memcpy(&key, bytes.data(), sizeof(Key));
+    return key;
+  }
+};
+
+template <typename Key>
+struct KeyCodec<Key, std::enable_if_t<std::is_same<Key, std::string>::value>> {
+  static std::string encode(const Key& key) { return key; }
+  static Key decode(std::string_view bytes) { return Key(bytes); }
+};
+}  // namespace prstorage
+
+#endif  // KEYCODEC_H
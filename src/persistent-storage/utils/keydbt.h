@@ -0,0 +1,68 @@
+#ifndef KEYDBT_H
+#define KEYDBT_H
+
+#include <db_cxx.h>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace prstorage {
+/**
+ * Представление ключа в виде Dbt в том же формате, в котором ключи
+ * сохраняет dbstl: простые типы копируются побайтно, строки хранятся вместе
+ * с завершающим нулем.
+ *
+ * Объект не копирует ключ, поэтому ключ должен существовать дольше объекта.
+ * decode выполняет обратное преобразование, например для первичных ключей,
+ * прочитанных курсором вторичного индекса.
+ */
+template <typename Key, typename = void>
+class KeyDbt {
+  static_assert(std::is_trivially_copyable<Key>::value,
+                "key type must be trivially copyable or std::string");
+
+ public:
+  explicit KeyDbt(const Key& key) :
+      mDbt(const_cast<Key*>(&key), static_cast<u_int32_t>(sizeof(Key)))
+  {
+  }
+
+ public:
+  Dbt* get() { return &mDbt; }
+
+  static Key decode(const Dbt& dbt)
+  {
+    Key key;
+    std::memcpy(&key, dbt.get_data(), sizeof(Key));
+    return key;
+  }
+
+ private:
+  Dbt mDbt;
+};
+
+template <typename Key>
+class KeyDbt<Key, std::enable_if_t<std::is_same<Key, std::string>::value>> {
+ public:
+  explicit KeyDbt(const Key& key) :
+      mDbt(const_cast<char*>(key.c_str()),
+           static_cast<u_int32_t>(key.size() + 1))
+  {
+  }
+
+ public:
+  Dbt* get() { return &mDbt; }
+
+  static Key decode(const Dbt& dbt)
+  {
+    // завершающий ноль не входит в строку
+    auto size = dbt.get_size();
+    return Key(static_cast<const char*>(dbt.get_data()), size ? size - 1 : 0);
+  }
+
+ private:
+  Dbt mDbt;
+};
+}  // namespace prstorage
+
+#endif  // KEYDBT_H
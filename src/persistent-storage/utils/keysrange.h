@@ -0,0 +1,178 @@
+#ifndef KEYSRANGE_H
+#define KEYSRANGE_H
+
+#include <db_cxx.h>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#include "keydbt.h"
+
+namespace prstorage {
+/**
+ * Диапазон ключей базы данных.
+ *
+ * Ключи читаются курсором по мере продвижения итератора, значения
+ * запрашиваются с нулевой длиной (DB_DBT_PARTIAL, dlen == 0), поэтому не
+ * копируются со страниц и не декодируются Marshaller. Ключи декодируются
+ * так же, как их сохраняет dbstl (см. KeyDbt).
+ *
+ * Курсор принадлежит итератору и закрывается, когда уничтожена последняя
+ * его копия; если курсор открыт в транзакции, диапазон должен быть пройден
+ * до ее завершения.
+ */
+template <typename Key>
+class KeysRange {
+  class Cursor;
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Key*;
+    using reference = const Key&;
+
+   public:
+    const_iterator() = default;
+    explicit const_iterator(std::shared_ptr<Cursor> cursor) :
+        mCursor(std::move(cursor))
+    {
+      if (mCursor && !mCursor->next()) {
+        mCursor.reset();
+      }
+    }
+
+   public:
+    reference operator*() const { return mCursor->key(); }
+    pointer operator->() const { return &mCursor->key(); }
+    const_iterator& operator++()
+    {
+      if (!mCursor->next()) {
+        mCursor.reset();
+      }
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const
+    {
+      return mCursor == other.mCursor;
+    }
+    bool operator!=(const const_iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+   private:
+    std::shared_ptr<Cursor> mCursor;
+  };
+
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param db база данных, ключи которой обходятся
+   * @param txn транзакция, в которой открывается курсор, или nullptr
+   */
+  KeysRange(Db* db, DbTxn* txn);
+
+ public:
+  /**
+   * @brief Открывает курсор и возвращает итератор на первый ключ
+   * @throws std::runtime_error при ошибке Berkeley DB
+   */
+  const_iterator begin() const;
+  const_iterator end() const;
+
+ private:
+  class Cursor {
+   public:
+    Cursor(Db* db, DbTxn* txn);
+    ~Cursor();
+
+   private:
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+
+   public:
+    /**
+     * @brief Переходит к следующему ключу
+     * @return false, если ключи закончились
+     */
+    bool next();
+    const Key& key() const noexcept { return mKey; }
+
+   private:
+    static void check(int ret);
+
+   private:
+    Dbc* mCursor = nullptr;
+    Dbt mKeyDbt;
+    Dbt mData;
+    Key mKey;
+  };
+
+ private:
+  Db* mDb;
+  DbTxn* mTxn;
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename Key>
+prstorage::KeysRange<Key>::KeysRange(Db* db, DbTxn* txn) : mDb(db), mTxn(txn)
+{
+}
+
+template <typename Key>
+typename prstorage::KeysRange<Key>::const_iterator
+prstorage::KeysRange<Key>::begin() const
+{
+  return const_iterator(std::make_shared<Cursor>(mDb, mTxn));
+}
+
+template <typename Key>
+typename prstorage::KeysRange<Key>::const_iterator
+prstorage::KeysRange<Key>::end() const
+{
+  return const_iterator();
+}
+
+template <typename Key>
+prstorage::KeysRange<Key>::Cursor::Cursor(Db* db, DbTxn* txn)
+{
+  check(db->cursor(txn, &mCursor, 0));
+  mKeyDbt.set_flags(DB_DBT_REALLOC);
+  // значение не читается: dlen == 0
+  mData.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+}
+
+template <typename Key>
+prstorage::KeysRange<Key>::Cursor::~Cursor()
+{
+  mCursor->close();
+  std::free(mKeyDbt.get_data());
+}
+
+template <typename Key>
+bool prstorage::KeysRange<Key>::Cursor::next()
+{
+  auto ret = mCursor->get(&mKeyDbt, &mData, DB_NEXT);
+  if (ret == DB_NOTFOUND) {
+    return false;
+  }
+  check(ret);
+  mKey = KeyDbt<Key>::decode(mKeyDbt);
+  return true;
+}
+
+template <typename Key>
+void prstorage::KeysRange<Key>::Cursor::check(int ret)
+{
+  if (ret != 0) {
+    throw std::runtime_error(DbEnv::strerror(ret));
+  }
+}
+
+#endif  // KEYSRANGE_H
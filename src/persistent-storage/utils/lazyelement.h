@@ -0,0 +1,98 @@
+#ifndef LAZYELEMENT_H
+#define LAZYELEMENT_H
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace prstorage {
+/**
+ * Представление сохраненного элемента без его восстановления.
+ *
+ * Предикат, принимающий LazyElement, может прочитать отдельные поля через
+ * peek<Field>(), не восстанавливая элемент целиком. Для этого Marshaller
+ * должен предоставить необязательное расширение - статическую функцию
+ * peek, специализированную для типов-тегов полей:
+ *
+ * struct ContactName {
+ *   using type = std::string_view;
+ * };
+ *
+ * class ContactMarshaller {
+ *   public:
+ *     ...
+ *     template <typename Field>
+ *     static typename Field::type peek(const void* src);
+ * };
+ *
+ * template <>
+ * std::string_view ContactMarshaller::peek<ContactName>(const void* src);
+ *
+ * Значение, которое возвращает peek, может ссылаться на байты записи и
+ * действительно только во время вызова предиката. Полное восстановление
+ * через Marshaller::restore выполняется при первом вызове get() и
+ * кешируется.
+ */
+template <typename Element, typename Marshaller>
+class LazyElement {
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param data байты элемента в формате Marshaller::store
+   * @param size размер данных
+   */
+  LazyElement(const void* data, std::size_t size) noexcept :
+      mData(data), mSize(size)
+  {
+  }
+
+ public:
+  /**
+   * @brief Читает поле Field без восстановления элемента
+   */
+  template <typename Field>
+  typename Field::type peek() const
+  {
+    return Marshaller::template peek<Field>(mData);
+  }
+
+  /**
+   * @brief Восстанавливает элемент, повторные вызовы не декодируют его
+   * заново
+   */
+  const Element& get() const
+  {
+    if (!mElement) {
+      mElement.emplace();
+      Marshaller::restore(*mElement, mData);
+    }
+    return *mElement;
+  }
+
+  /**
+   * @brief Возвращает восстановленный элемент, перемещая его из кеша
+   */
+  Element release()
+  {
+    get();
+    Element res = std::move(*mElement);
+    mElement.reset();
+    return res;
+  }
+
+  /**
+   * @brief Проверяет, был ли элемент уже восстановлен
+   */
+  bool restored() const noexcept { return mElement.has_value(); }
+
+  const void* data() const noexcept { return mData; }
+  std::size_t size() const noexcept { return mSize; }
+
+ private:
+  const void* mData;
+  std::size_t mSize;
+  mutable std::optional<Element> mElement;
+};
+}  // namespace prstorage
+
+#endif  // LAZYELEMENT_H
@@ -0,0 +1,80 @@
+#ifndef ORDEREDKEY_H
+#define ORDEREDKEY_H
+
+#include <chrono>
+#include <climits>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace prstorage {
+/**
+ * Кодирует ключ вторичного индекса так, что побайтовое сравнение
+ * закодированных ключей (порядок B-дерева Berkeley DB по умолчанию)
+ * совпадает с порядком самих ключей.
+ *
+ * Целые числа хранятся в порядке big-endian, у знаковых инвертируется
+ * знаковый бит. Строки хранятся с завершающим нулем, поэтому строка
+ * предшествует своим продолжениям и в составном ключе. Составные ключи
+ * задаются std::pair и кодируются по порядку компонентов.
+ */
+template <typename Key, typename = void>
+struct OrderedKeyCodec;
+
+template <typename Key>
+struct OrderedKeyCodec<Key, std::enable_if_t<std::is_integral_v<Key>>> {
+  static void encode(const Key& key, std::string& out)
+  {
+    using unsigned_type = std::make_unsigned_t<Key>;
+    auto value = static_cast<unsigned_type>(key);
+    if constexpr (std::is_signed_v<Key>) {
+      value ^= unsigned_type(1) << (sizeof(Key) * CHAR_BIT - 1);
+    }
+    for (auto shift = sizeof(Key) * CHAR_BIT; shift > 0;) {
+      shift -= CHAR_BIT;
+      out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+  }
+};
+
+template <>
+struct OrderedKeyCodec<std::string> {
+  static void encode(const std::string& key, std::string& out)
+  {
+    out.append(key);
+    out.push_back('\0');
+  }
+};
+
+template <typename Clock, typename Duration>
+struct OrderedKeyCodec<std::chrono::time_point<Clock, Duration>> {
+  static void encode(const std::chrono::time_point<Clock, Duration>& key,
+                     std::string& out)
+  {
+    OrderedKeyCodec<typename Duration::rep>::encode(
+        key.time_since_epoch().count(), out);
+  }
+};
+
+template <typename First, typename Second>
+struct OrderedKeyCodec<std::pair<First, Second>> {
+  static void encode(const std::pair<First, Second>& key, std::string& out)
+  {
+    OrderedKeyCodec<First>::encode(key.first, out);
+    OrderedKeyCodec<Second>::encode(key.second, out);
+  }
+};
+
+/**
+ * @brief Возвращает ключ в кодировке OrderedKeyCodec
+ */
+template <typename Key>
+std::string encode_ordered_key(const Key& key)
+{
+  std::string res;
+  OrderedKeyCodec<Key>::encode(key, res);
+  return res;
+}
+}  // namespace prstorage
+
+#endif  // ORDEREDKEY_H
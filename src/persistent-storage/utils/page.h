@@ -0,0 +1,70 @@
+#ifndef PAGE_H
+#define PAGE_H
+
+#include <db_cxx.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace prstorage {
+/**
+ * Страница элементов хранилища.
+ *
+ * nextToken - непрозрачный маркер продолжения (закодированный ключ
+ * последнего элемента страницы), который передается в page() для
+ * получения следующей страницы. Пустой маркер означает, что элементов
+ * больше нет. Маркер представляет собой массив байт и для передачи в
+ * текстовых протоколах должен кодироваться, например, в base64.
+ */
+template <typename Element>
+struct Page {
+  std::vector<Element> elements;
+  std::string nextToken;
+
+  bool hasMore() const noexcept { return !nextToken.empty(); }
+};
+
+/**
+ * Dbt с флагом DB_DBT_REALLOC, который владеет буфером, выделенным
+ * Berkeley DB.
+ */
+class ReallocDbt : public Dbt {
+ public:
+  ReallocDbt() { set_flags(DB_DBT_REALLOC); }
+  ~ReallocDbt() { std::free(get_data()); }
+
+ private:
+  ReallocDbt(const ReallocDbt&) = delete;
+  ReallocDbt& operator=(const ReallocDbt&) = delete;
+
+ public:
+  /**
+   * @brief Копирует bytes в буфер Dbt, например ключ для DB_SET_RANGE
+   */
+  void assign(const std::string& bytes)
+  {
+    auto data = std::realloc(get_data(), bytes.size() ? bytes.size() : 1);
+    if (!data) {
+      throw std::bad_alloc();
+    }
+    std::memcpy(data, bytes.data(), bytes.size());
+    set_data(data);
+    set_size(static_cast<u_int32_t>(bytes.size()));
+  }
+
+  std::string bytes() const
+  {
+    return std::string(static_cast<const char*>(get_data()), get_size());
+  }
+
+  bool equals(const std::string& bytes) const noexcept
+  {
+    return get_size() == bytes.size() &&
+           std::memcmp(get_data(), bytes.data(), bytes.size()) == 0;
+  }
+};
+}  // namespace prstorage
+
+#endif  // PAGE_H
@@ -0,0 +1,70 @@
+#include "recordformat.h"
+
+using namespace prstorage;
+
+namespace {
+constexpr std::size_t OFFSET_SIZE = sizeof(std::uint32_t);
+
+std::uint32_t read_offset(const char* src) noexcept
+{
+  std::uint32_t res;
+  std::memcpy(&res, src, OFFSET_SIZE);
+  return res;
+}
+}  // namespace
+
+prstorage::RecordWriter::RecordWriter(void* dest,
+                                      std::uint32_t fieldCount) noexcept :
+    mDest(static_cast<char*>(dest)),
+    mCapacity(fieldCount)
+{
+  std::memcpy(mDest, &fieldCount, OFFSET_SIZE);
+}
+
+void prstorage::RecordWriter::add(std::string_view bytes) noexcept
+{
+  auto end = mDataSize + static_cast<std::uint32_t>(bytes.size());
+  if (mDest) {
+    // данные начинаются после заголовка и таблицы смещений
+    auto data = mDest + OFFSET_SIZE * (1 + mCapacity);
+    std::memcpy(mDest + OFFSET_SIZE * (1 + mFieldCount), &end, OFFSET_SIZE);
+    std::memcpy(data + mDataSize, bytes.data(), bytes.size());
+  }
+  mDataSize = end;
+  ++mFieldCount;
+}
+
+std::uint32_t prstorage::RecordWriter::fieldCount() const noexcept
+{
+  return mFieldCount;
+}
+
+std::uint32_t prstorage::RecordWriter::size() const noexcept
+{
+  return static_cast<std::uint32_t>(OFFSET_SIZE * (1 + mFieldCount)) +
+         mDataSize;
+}
+
+prstorage::RecordReader::RecordReader(const void* data) noexcept :
+    mData(static_cast<const char*>(data)),
+    mFieldCount(read_offset(mData))
+{
+}
+
+std::uint32_t prstorage::RecordReader::fieldCount() const noexcept
+{
+  return mFieldCount;
+}
+
+std::string_view prstorage::RecordReader::field(std::uint32_t index) const
+{
+  if (index >= mFieldCount) {
+    throw std::out_of_range("record field not found");
+  }
+  auto offsets = mData + OFFSET_SIZE;
+  auto begin =
+      index == 0 ? 0 : read_offset(offsets + OFFSET_SIZE * (index - 1));
+  auto end = read_offset(offsets + OFFSET_SIZE * index);
+  auto data = offsets + OFFSET_SIZE * mFieldCount;
+  return std::string_view(data + begin, end - begin);
+}
@@ -0,0 +1,209 @@
+#ifndef RECORDFORMAT_H
+#define RECORDFORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace prstorage {
+/**
+ * Формат записи с таблицей смещений полей:
+ *
+ * [количество полей N: uint32][конец поля 0 .. конец поля N-1: uint32]
+ * [данные полей]
+ *
+ * Концы полей отсчитываются от начала данных. В отличие от save_str, поле
+ * с любым номером читается без разбора предыдущих полей, а строки
+ * читаются как std::string_view без копирования.
+ */
+
+/**
+ * Запись полей в формате с таблицей смещений. Конструктор без параметров
+ * создает объект, который только вычисляет размер записи и количество
+ * полей, поэтому размер и запись выполняются одной функцией:
+ *
+ * void to_record(RecordWriter& writer, const Contact& contact) {
+ *   writer.add(contact.id);
+ *   writer.add(contact.name);
+ *   writer.addValue(contact.age);
+ * }
+ */
+class RecordWriter {
+ public:
+  /**
+   * @brief Создает объект, вычисляющий размер записи
+   */
+  RecordWriter() noexcept = default;
+
+  /**
+   * @brief Создает объект, записывающий поля в dest
+   * @param dest буфер размером не меньше вычисленного размера записи
+   * @param fieldCount количество полей записи
+   */
+  RecordWriter(void* dest, std::uint32_t fieldCount) noexcept;
+
+ public:
+  /**
+   * @brief Добавляет поле из байт bytes
+   */
+  void add(std::string_view bytes) noexcept;
+
+  /**
+   * @brief Добавляет поле с байтовым представлением значения
+   */
+  template <typename T>
+  void addValue(const T& value) noexcept
+  {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "value must be trivially copyable");
+    add(std::string_view(reinterpret_cast<const char*>(&value), sizeof(T)));
+  }
+
+  std::uint32_t fieldCount() const noexcept;
+
+  /**
+   * @brief Возвращает размер записи с заголовком и таблицей смещений
+   */
+  std::uint32_t size() const noexcept;
+
+ private:
+  char* mDest = nullptr;
+  std::uint32_t mCapacity = 0;
+  std::uint32_t mFieldCount = 0;
+  std::uint32_t mDataSize = 0;
+};
+
+/**
+ * Чтение полей записи без копирования данных. Объект ссылается на буфер
+ * записи и действителен, пока существует буфер.
+ */
+class RecordReader {
+ public:
+  /**
+   * @brief Конструктор класса
+   * @param data начало записи, созданной RecordWriter
+   */
+  explicit RecordReader(const void* data) noexcept;
+
+ public:
+  std::uint32_t fieldCount() const noexcept;
+
+  /**
+   * @brief Возвращает байты поля
+   * @throws std::out_of_range, если поля с таким номером нет
+   */
+  std::string_view field(std::uint32_t index) const;
+
+  /**
+   * @brief Возвращает значение поля: std::string_view ссылается на буфер
+   * записи, std::string копирует байты, тривиально копируемые типы
+   * восстанавливаются из байтового представления
+   * @throws std::out_of_range, если поля нет или его размер не совпадает с
+   * размером T
+   */
+  template <typename T>
+  T value(std::uint32_t index) const;
+
+ private:
+  const char* mData;
+  std::uint32_t mFieldCount;
+};
+
+/**
+ * Представление записи элемента Element. Поля именуются типами-тегами с
+ * номером поля и типом значения:
+ *
+ * struct ContactName {
+ *   static constexpr std::uint32_t index = 1;
+ *   using type = std::string_view;
+ * };
+ *
+ * Для восстановления элемента должна быть определена свободная функция
+ * from_record(const RecordView<Element>&, Element&).
+ */
+template <typename Element>
+class RecordView : public RecordReader {
+ public:
+  using RecordReader::RecordReader;
+
+ public:
+  template <typename Field>
+  typename Field::type get() const
+  {
+    return value<typename Field::type>(Field::index);
+  }
+
+  /**
+   * @brief Восстанавливает элемент из записи
+   */
+  Element toElement() const
+  {
+    Element elem;
+    from_record(*this, elem);
+    return elem;
+  }
+};
+
+/**
+ * Marshaller для элементов в формате с таблицей смещений. Требует
+ * свободных функций to_record(RecordWriter&, const Element&) и
+ * from_record(const RecordView<Element>&, Element&). Предоставляет
+ * peek<Field>, поэтому предикаты lazy_element читают поля без
+ * восстановления элемента.
+ */
+template <typename Element>
+class RecordMarshaller {
+ public:
+  static void restore(Element& elem, const void* src)
+  {
+    from_record(RecordView<Element>(src), elem);
+  }
+
+  static std::uint32_t size(const Element& elem)
+  {
+    RecordWriter measure;
+    to_record(measure, elem);
+    return measure.size();
+  }
+
+  static void store(void* dest, const Element& elem)
+  {
+    RecordWriter measure;
+    to_record(measure, elem);
+    RecordWriter writer(dest, measure.fieldCount());
+    to_record(writer, elem);
+  }
+
+  template <typename Field>
+  static typename Field::type peek(const void* src)
+  {
+    return RecordView<Element>(src).template get<Field>();
+  }
+};
+}  // namespace prstorage
+/*-----------------------------------------------------------------------------------------------------*/
+
+template <typename T>
+T prstorage::RecordReader::value(std::uint32_t index) const
+{
+  auto bytes = field(index);
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    return bytes;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    return std::string(bytes);
+  } else {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "value must be trivially copyable");
+    if (bytes.size() != sizeof(T)) {
+      throw std::out_of_range("record field size mismatch");
+    }
+    T res;
+    std::memcpy(&res, bytes.data(), sizeof(T));
+    return res;
+  }
+}
+
+#endif  // RECORDFORMAT_H
@@ -19,3 +19,12 @@ const void* prstorage::restore_str(std::string& str, const void* src)
   str.insert(0, strSrc, size);
   return strSrc + size;
 }
+
+const void* prstorage::peek_str(std::string_view& str, const void* src)
+{
+  std::string::size_type size;
+  memcpy(&size, src, sizeof(size));
+  const char* strSrc = static_cast<const char*>(src) + sizeof(size);
+  str = std::string_view(strSrc, size);
+  return strSrc + size;
+}
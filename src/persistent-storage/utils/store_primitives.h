@@ -2,10 +2,19 @@
 #define STORE_PRIMITIVES_H
 
 #include <string>
+#include <string_view>
 
 namespace prstorage {
 const void* restore_str(std::string& str, const void* src);
 void* save_str(const std::string& str, void* dest);
+
+/**
+ * @brief Читает строку, сохраненную save_str, без копирования символов
+ * @param str представление строки внутри src, действительно, пока
+ * существует src
+ * @return указатель на данные, следующие за строкой
+ */
+const void* peek_str(std::string_view& str, const void* src);
 }  // namespace prstorage
 
 #endif  // STORE_PRIMITIVES_H
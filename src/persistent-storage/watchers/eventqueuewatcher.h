@@ -2,6 +2,7 @@
 #define EVENTQUEUEWATCHER_H
 
 #include <eventpp/eventqueue.h>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -43,6 +44,12 @@ class EventQueueWatcher {
   void appendPermanentListener(unsigned char eventMask,
                                const CallbackType& callback);
 
+  /**
+   * @brief Возвращает количество событий, которые поставлены в очередь, но
+   * еще не переданы подписчикам
+   */
+  std::size_t queueDepth() const noexcept;
+
  protected:
   void elementAdded(const Element& element);
   void elementRemoved(const Element& element);
@@ -55,6 +62,7 @@ class EventQueueWatcher {
 
  private:
   std::shared_ptr<EventQueueType> mEventQueue;
+  std::atomic<std::size_t> mQueueDepth{0};
   bool finished = false;
   std::thread mThread;
 };
@@ -64,6 +72,10 @@ template <typename Element>
 prstorage::EventQueueWatcher<Element>::EventQueueWatcher() :
     mEventQueue(std::make_shared<EventQueueType>())
 {
+  // слушатели добавляются первыми и вызываются до пользовательских
+  auto dequeued = [this](EnqueuedEvents, const Element&) { --mQueueDepth; };
+  appendPermanentListener(EnqueuedEvents::ALL_EVENTS, dequeued);
+
   auto thread_func = [& is_finished = this->finished](
                          const std::shared_ptr<EventQueueType>& sh_ptr) {
     auto queue_ptr = std::weak_ptr<EventQueueType>(sh_ptr);
@@ -176,9 +188,16 @@ void prstorage::EventQueueWatcher<Element>::appendPermanentListener(
   }
 }
 
+template <typename Element>
+std::size_t prstorage::EventQueueWatcher<Element>::queueDepth() const noexcept
+{
+  return mQueueDepth.load(std::memory_order_relaxed);
+}
+
 template <typename Element>
 void prstorage::EventQueueWatcher<Element>::elementAdded(const Element& element)
 {
+  ++mQueueDepth;
   mEventQueue->enqueue(EnqueuedEvents::ADDED, element);
 }
 
@@ -186,6 +205,7 @@ template <typename Element>
 void prstorage::EventQueueWatcher<Element>::elementRemoved(
     const Element& element)
 {
+  ++mQueueDepth;
   mEventQueue->enqueue(EnqueuedEvents::DELETED, element);
 }
 
@@ -193,6 +213,7 @@ template <typename Element>
 void prstorage::EventQueueWatcher<Element>::elementUpdated(
     const Element& element)
 {
+  ++mQueueDepth;
   mEventQueue->enqueue(EnqueuedEvents::UPDATED, element);
 }
 
@@ -0,0 +1,55 @@
+#ifndef WATCHERTRAITS_H
+#define WATCHERTRAITS_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace prstorage {
+/**
+ * Признак того, что Watcher принимает удаленные элементы порциями.
+ * Для включения в классе Watcher объявляется
+ *   static constexpr bool batch_removal = true;
+ * и защищенная функция
+ *   void elementsRemoved(const std::vector<Element>&);
+ */
+template <typename Watcher, typename = void>
+struct supports_batch_removal : std::false_type {};
+
+template <typename Watcher>
+struct supports_batch_removal<Watcher,
+                              std::void_t<decltype(Watcher::batch_removal)>>
+    : std::bool_constant<Watcher::batch_removal> {};
+
+/**
+ * Признак того, что при удалении элемента Watcher или Deleter нужно его
+ * значение. По умолчанию значение нужно. Для отказа в классе объявляется
+ *   static constexpr bool removed_value_needed = false;
+ * Watcher, который отказался от значения, вместо elementRemoved получает
+ * при вызове Storage::remove
+ *   void keyRemoved(const Key&);
+ */
+template <typename T, typename = void>
+struct removed_value_needed : std::true_type {};
+
+template <typename T>
+struct removed_value_needed<T, std::void_t<decltype(T::removed_value_needed)>>
+    : std::bool_constant<T::removed_value_needed> {};
+
+/**
+ * Признак того, что Watcher накапливает события в очереди и может сообщить
+ * ее текущую длину функцией
+ *   std::size_t queueDepth() const;
+ * Значение попадает в MetricsSnapshot::watcherQueueDepth.
+ */
+template <typename Watcher, typename = void>
+struct has_queue_depth : std::false_type {};
+
+template <typename Watcher>
+struct has_queue_depth<
+    Watcher,
+    std::void_t<decltype(std::declval<const Watcher&>().queueDepth())>>
+    : std::true_type {};
+}  // namespace prstorage
+
+#endif  // WATCHERTRAITS_H
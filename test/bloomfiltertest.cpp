@@ -0,0 +1,178 @@
+#include <QtTest>
+#include <string>
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/bloomfilteredstorage.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/utils/bloomfilter.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+class BloomFilterTest : public QObject {
+  Q_OBJECT
+
+ public:
+  BloomFilterTest();
+
+ private Q_SLOTS:
+  void testFalsePositiveRate();
+  void testMemoryLimit();
+  void testInvalidOptions();
+  void testFilteredStorage();
+  void cleanupTestCase();
+
+ private:
+  QTemporaryDir mHome;
+  DbEnv* mEnv = nullptr;
+};
+
+BloomFilterTest::BloomFilterTest()
+{
+  dbstl::dbstl_startup();
+  mEnv = EnvironmentBuilder(mHome.path().toStdString())
+             .privateEnvironment()
+             .open();
+}
+
+void BloomFilterTest::testFalsePositiveRate()
+{
+  BloomFilter::Options options;
+  options.expectedKeys = 10000;
+  options.falsePositiveRate = 0.01;
+  BloomFilter filter(options);
+  QCOMPARE(filter.hashCount(), std::size_t(7));
+
+  for (int i = 0; i < 10000; ++i) {
+    auto key = "key " + std::to_string(i);
+    filter.add(key.data(), key.size());
+  }
+  for (int i = 0; i < 10000; ++i) {
+    auto key = "key " + std::to_string(i);
+    QVERIFY(filter.mayContain(key.data(), key.size()));
+  }
+
+  int positives = 0;
+  for (int i = 0; i < 10000; ++i) {
+    auto key = "missing " + std::to_string(i);
+    positives += filter.mayContain(key.data(), key.size()) ? 1 : 0;
+  }
+  QVERIFY(positives < 200);
+  QVERIFY(filter.estimatedFalsePositiveRate() < 0.02);
+
+  filter.clear();
+  QCOMPARE(filter.addedCount(), std::size_t(0));
+  std::string key = "key 0";
+  QVERIFY(!filter.mayContain(key.data(), key.size()));
+}
+
+void BloomFilterTest::testMemoryLimit()
+{
+  BloomFilter::Options options;
+  options.expectedKeys = 1000000;
+  options.maxBytes = 1024;
+  BloomFilter filter(options);
+
+  QCOMPARE(filter.memoryBytes(), std::size_t(1024));
+  QCOMPARE(filter.bitCount(), std::size_t(8192));
+  QCOMPARE(filter.hashCount(), std::size_t(1));
+}
+
+void BloomFilterTest::testInvalidOptions()
+{
+  BloomFilter::Options options;
+  options.falsePositiveRate = 1.0;
+  QVERIFY_EXCEPTION_THROWN(BloomFilter invalid(options),
+                           std::invalid_argument);
+
+  options = BloomFilter::Options();
+  options.expectedKeys = 0;
+  QVERIFY_EXCEPTION_THROWN(BloomFilter invalid(options),
+                           std::invalid_argument);
+}
+
+void BloomFilterTest::testFilteredStorage()
+{
+  auto db =
+      StorageFactory(mEnv).openDatabase("BloomFilterTest.db", "elements");
+  auto store = std::make_shared<ContainerType>(db, mEnv);
+  for (int i = 0; i < 100; ++i) {
+    store->add({std::to_string(i), "name " + std::to_string(i)});
+  }
+
+  BloomFilter::Options options;
+  options.expectedKeys = 1000;
+  BloomFilteredStorage<ContainerType> filtered(store, db, options);
+  QCOMPARE(filtered.filter().addedCount(), std::size_t(100));
+
+  // ключи, добавленные до создания фильтра
+  QVERIFY(filtered.has("42"));
+  QCOMPARE(filtered.get("42").name, std::string("name 42"));
+  QVERIFY(!filtered.has("missing"));
+  QVERIFY(!filtered.tryGet("missing"));
+  QVERIFY_EXCEPTION_THROWN(filtered.get("missing"), std::range_error);
+
+  QVERIFY(filtered.add({"new", "new"}));
+  QVERIFY(filtered.has("new"));
+  QCOMPARE(filtered.tryGet("new")->name, std::string("new"));
+  filtered.update({"updated", "updated"});
+  QVERIFY(filtered.has("updated"));
+  QCOMPARE(filtered.size(), 102);
+
+  QVERIFY(filtered.remove("new"));
+  QVERIFY(!filtered.has("new"));
+  QVERIFY(!filtered.remove("missing"));
+
+  filtered.rebuild();
+  QCOMPARE(filtered.filter().addedCount(), std::size_t(101));
+  QVERIFY(filtered.has("updated"));
+}
+
+void BloomFilterTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(BloomFilterTest)
+
+#include "bloomfiltertest.moc"
@@ -1,6 +1,7 @@
 #include <QtTest>
 #include "persistent-storage/storages/childstorage.h"
 #include "persistent-storage/storages/storage.h"
+#include "persistent-storage/storages/threadregistry.h"
 #include "persistent-storage/utils/store_primitives.h"
 
 #include "persistent-storage/deleters/childthatisparentdeleter.h"
@@ -66,6 +67,11 @@ int get_dest_secdb_callback(Db* /* secondary */,
   return 1;
 }
 
+struct ByParent {
+  using key_type = std::pair<std::string, std::string>;
+  static key_type key(const TestElement& elem) { return {elem.name, elem.id}; }
+};
+
 class ChildStorageTest : public QObject {
   Q_OBJECT
 
@@ -78,6 +84,10 @@ class ChildStorageTest : public QObject {
   void testSeveralChilds();
   void testSeveralLevelsOfInheritance();
   void testWrapperInChildContainer();
+  void testChildrenLookup();
+  void testCascadeReport();
+  void testOrderedBy();
+  void testChildrenPage();
   void cleanup();
   void cleanupTestCase();
 
@@ -299,6 +309,206 @@ void ChildStorageTest::testWrapperInChildContainer()
   QCOMPARE(child_container->get("child id 1").name, std::string("test"));
 }
 
+void ChildStorageTest::testChildrenLookup()
+{
+  using ChildContainerType =
+      ChildStorage<TestElement, TestElement, TestMarshaller, TestWatcher>;
+
+  std::shared_ptr<ChildContainerType> child_container =
+      std::make_shared<ChildContainerType>(db, secdb, penv);
+
+  child_container->add({"child id 1", "parent id 1"});
+  child_container->add({"child id 1_2", "parent id 1"});
+  child_container->add({"child id 1_3", "parent id 1"});
+  child_container->add({"child id 2", "parent id 2"});
+
+  QCOMPARE(child_container->childCount("parent id 1"),
+           static_cast<std::size_t>(3));
+  QCOMPARE(child_container->childCount("parent id 2"),
+           static_cast<std::size_t>(1));
+  QCOMPARE(child_container->childCount("parent id 3"),
+           static_cast<std::size_t>(0));
+
+  std::vector<std::string> ids;
+  for (const auto& child : child_container->childrenOf("parent id 1")) {
+    ids.push_back(child.id);
+  }
+  QCOMPARE(ids.size(), static_cast<std::size_t>(3));
+
+  auto firstPage = child_container->childrenOf("parent id 1", 2);
+  QCOMPARE(firstPage.size(), static_cast<std::size_t>(2));
+
+  auto secondPage =
+      child_container->childrenOf("parent id 1", 2, firstPage.back().id);
+  QCOMPARE(secondPage.size(), static_cast<std::size_t>(1));
+  QVERIFY(secondPage.front().id != firstPage.front().id);
+  QVERIFY(secondPage.front().id != firstPage.back().id);
+
+  QVERIFY(child_container->remove(firstPage.back().id));
+  QVERIFY_EXCEPTION_THROWN(
+      child_container->childrenOf("parent id 1", 2, firstPage.back().id),
+      std::out_of_range);
+}
+
+void ChildStorageTest::testCascadeReport()
+{
+  using ChildContainerType =
+      ChildStorage<TestElement, TestElement, TestMarshaller, TestWatcher>;
+  using ParentDeleterType =
+      ParentsDeleter<decltype(get_id(std::declval<TestElement>())), TestElement,
+                     ChildContainerType>;
+  using ParentContainerType =
+      Storage<TestElement, TestMarshaller, TestWatcher,
+              DefaultTransactionManager, ParentDeleterType>;
+
+  std::size_t removedByParent = 0;
+  std::shared_ptr<ChildContainerType> child_container =
+      std::make_shared<ChildContainerType>(db, secdb, penv);
+  std::shared_ptr<ParentContainerType> parent_container =
+      std::make_shared<ParentContainerType>(
+          parent_db, penv,
+          ParentDeleterType(child_container, 1,
+                            [&removedByParent](const CascadeReport& report) {
+                              removedByParent = report.removedOnLevel(0);
+                            }));
+
+  parent_container->add({"parent id 1", "parent name 1"});
+
+  child_container->add({"child id 1", "parent id 1"});
+  child_container->add({"child id 1_2", "parent id 1"});
+  child_container->add({"child id 2", "parent id 2"});
+  child_container->add({"child id 3", "parent id 3"});
+
+  QVERIFY(parent_container->remove("parent id 1"));
+  QCOMPARE(removedByParent, static_cast<std::size_t>(2));
+
+  auto report = child_container->removeChildrenOf({"parent id 2"}, 1);
+  QCOMPARE(report.levels(), static_cast<std::size_t>(1));
+  QCOMPARE(report.totalRemoved(), static_cast<std::size_t>(1));
+
+  QVERIFY(!child_container->has("child id 2"));
+  QVERIFY(child_container->has("child id 3"));
+}
+
+void ChildStorageTest::testOrderedBy()
+{
+  using ChildContainerType =
+      ChildStorage<TestElement, TestElement, TestMarshaller, TestWatcher>;
+
+  auto ordered_db = new Db(penv, DB_CXX_NO_EXCEPTIONS);
+  // индекс связан с общей базой db, поэтому закрывается в конце теста:
+  // закрытие отменяет связь, и другие тесты не обновляют индекс. Очистка
+  // первичной базы до закрытия очищает и индекс
+  auto closer = [this](Db* index) {
+    db->truncate(nullptr, nullptr, 0);
+    ThreadRegistry::invalidate();
+    dbstl::close_db(index);
+  };
+  std::unique_ptr<Db, decltype(closer)> guard(ordered_db, closer);
+  ordered_db->set_flags(DB_DUP);
+  QCOMPARE(0, ordered_db->open(nullptr,
+                               "ChildStorageTest_testStorageCreation.db",
+                               "ordered", DB_BTREE,
+                               DB_CREATE | DB_THREAD | DB_AUTO_COMMIT, 0600));
+  dbstl::register_db(ordered_db);
+  QCOMPARE(0, db->associate(
+                  nullptr, ordered_db,
+                  ordered_index_key<ByParent, TestElement, TestMarshaller>,
+                  DB_CREATE));
+
+  auto indexed = std::make_shared<ChildContainerType>(db, secdb, penv);
+  indexed->attachIndex<ByParent>(ordered_db);
+  auto scanned = std::make_shared<ChildContainerType>(db, secdb, penv);
+
+  for (auto id : {"c3", "c1", "c5", "c2", "c4"}) {
+    indexed->add({id, "parent id 1"});
+  }
+  indexed->add({"d1", "parent id 2"});
+  indexed->add({"a1", "parent id 0"});
+
+  auto ids = [](const std::vector<TestElement>& elements) {
+    std::vector<std::string> res;
+    for (const auto& elem : elements) {
+      res.push_back(elem.id);
+    }
+    return res;
+  };
+  auto ofParent = [](const ByParent::key_type& key) {
+    return key.first == "parent id 1";
+  };
+
+  for (auto store : {indexed, scanned}) {
+    // последние элементы родителя
+    auto last = store->orderedBy<ByParent>(
+        ByParent::key_type{"parent id 1", "\xff"}, 3, Direction::Backward,
+        ofParent);
+    QCOMPARE(ids(last), std::vector<std::string>({"c5", "c4", "c3"}));
+
+    auto all = store->orderedBy<ByParent>(
+        ByParent::key_type{"parent id 1", ""}, 10, Direction::Forward,
+        ofParent);
+    QCOMPARE(ids(all),
+             std::vector<std::string>({"c1", "c2", "c3", "c4", "c5"}));
+
+    auto first = store->orderedBy<ByParent>({}, 2);
+    QCOMPARE(ids(first), std::vector<std::string>({"a1", "c1"}));
+
+    auto tail = store->orderedBy<ByParent>(
+        ByParent::key_type{"parent id 1", "c2"}, 10, Direction::Backward);
+    QCOMPARE(ids(tail), std::vector<std::string>({"c2", "c1", "a1"}));
+
+    QVERIFY(store->orderedBy<ByParent>({}, 0).empty());
+  }
+}
+
+void ChildStorageTest::testChildrenPage()
+{
+  using ChildContainerType =
+      ChildStorage<TestElement, TestElement, TestMarshaller, TestWatcher>;
+
+  auto child_container = std::make_shared<ChildContainerType>(db, secdb, penv);
+  for (int i = 0; i < 5; ++i) {
+    child_container->add({"child id " + std::to_string(i), "parent id 1"});
+  }
+  child_container->add({"child id 5", "parent id 2"});
+
+  std::vector<std::string> ids;
+  std::string token;
+  do {
+    auto page = child_container->page("parent id 1", token, 2);
+    for (const auto& child : page.elements) {
+      QCOMPARE(child.name, std::string("parent id 1"));
+      ids.push_back(child.id);
+    }
+    token = page.nextToken;
+  } while (!token.empty());
+  QCOMPARE(ids.size(), static_cast<std::size_t>(5));
+
+  auto first = child_container->page("parent id 1", {}, 2);
+  QVERIFY(first.hasMore());
+  auto second = child_container->page("parent id 1", first.nextToken, 2);
+  QCOMPARE(second.elements.size(), static_cast<std::size_t>(2));
+  QVERIFY(second.elements.front().id != first.elements.back().id);
+
+  QVERIFY(child_container->page("parent id 3", {}, 2).elements.empty());
+
+  // страницы всего хранилища доступны через Storage::page
+  std::size_t total = 0;
+  token.clear();
+  do {
+    auto page = child_container->page(token, 4);
+    total += page.elements.size();
+    token = page.nextToken;
+  } while (!token.empty());
+  QCOMPARE(total, static_cast<std::size_t>(6));
+
+  // без сортировки дубликатов удаленный элемент маркера не найти
+  QVERIFY(child_container->remove(first.elements.back().id));
+  QVERIFY_EXCEPTION_THROWN(
+      child_container->page("parent id 1", first.nextToken, 2),
+      std::out_of_range);
+}
+
 void ChildStorageTest::cleanup()
 {
   parent_db->truncate(nullptr, nullptr, 0);
@@ -0,0 +1,456 @@
+#include <QtTest>
+#include <cstring>
+#include "persistent-storage/environment/cachebudgetmanager.h"
+#include "persistent-storage/environment/cachepriorityguard.h"
+#include "persistent-storage/environment/databasecompactor.h"
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/hotbackup.h"
+#include "persistent-storage/environment/logmaintenance.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/childstorage.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+int get_parent_id_callback(Db* /* secondary */,
+                           const Dbt* /* key */,
+                           const Dbt* data,
+                           Dbt* result)
+{
+  TestElement el;
+  TestMarshaller::restore(el, data->get_data());
+
+  if (auto chars = static_cast<char*>(malloc(el.name.size() + 1))) {
+    result->set_flags(DB_DBT_APPMALLOC);
+    strncpy(chars, el.name.c_str(), el.name.size() + 1);
+    result->set_data(chars);
+    result->set_size(static_cast<u_int32_t>(el.name.size()) + 1);
+    return 0;
+  }
+
+  return 1;
+}
+
+class EnvironmentBuilderTest : public QObject {
+  Q_OBJECT
+
+ public:
+  EnvironmentBuilderTest();
+
+ private Q_SLOTS:
+  void testSettingsValidation();
+  void testPresets();
+  void testOpenEnvironment();
+  void testStorageFactory();
+  void testCachePriority();
+  void testCacheBudget();
+  void testLogMaintenance();
+  void testHotBackup();
+  void testDatabaseCompaction();
+  void cleanupTestCase();
+
+ private:
+  QTemporaryDir mHome;
+};
+
+EnvironmentBuilderTest::EnvironmentBuilderTest()
+{
+  dbstl::dbstl_startup();
+}
+
+void EnvironmentBuilderTest::testSettingsValidation()
+{
+  DatabaseSettings database;
+  database.pageSize = 3000;
+  QVERIFY_EXCEPTION_THROWN(database.validate(), std::invalid_argument);
+  database.pageSize = 128 * 1024;
+  QVERIFY_EXCEPTION_THROWN(database.validate(), std::invalid_argument);
+  database.pageSize = 8 * 1024;
+  database.validate();
+
+  database.fillFactor = 40;
+  QVERIFY_EXCEPTION_THROWN(database.validate(), std::invalid_argument);
+  database.type = DB_HASH;
+  database.validate();
+
+  EnvironmentSettings environment;
+  environment.cacheSize = 1024;
+  QVERIFY_EXCEPTION_THROWN(environment.validate(), std::invalid_argument);
+  environment.cacheSize = 64 * 1024 * 1024;
+  environment.logBufferSize = 8 * 1024 * 1024;
+  QVERIFY_EXCEPTION_THROWN(environment.validate(), std::invalid_argument);
+  environment.logFileSize = 32 * 1024 * 1024;
+  environment.validate();
+
+  QVERIFY_EXCEPTION_THROWN(
+      EnvironmentBuilder(mHome.path().toStdString()).cacheSize(0).open(),
+      std::invalid_argument);
+}
+
+void EnvironmentBuilderTest::testPresets()
+{
+  for (auto preset : {Preset::Default, Preset::ReadHeavy, Preset::WriteHeavy,
+                      Preset::LowMemory}) {
+    EnvironmentSettings::forPreset(preset).validate();
+    DatabaseSettings::forPreset(preset).validate();
+  }
+
+  QVERIFY(EnvironmentSettings::forPreset(Preset::Default).cacheSize >
+          256 * 1024);
+  QVERIFY(EnvironmentSettings::forPreset(Preset::ReadHeavy).cacheSize >
+          EnvironmentSettings::forPreset(Preset::LowMemory).cacheSize);
+}
+
+void EnvironmentBuilderTest::testOpenEnvironment()
+{
+  QTemporaryDir home;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .privateEnvironment()
+                 .registerInDbstl(false)
+                 .open();
+  QVERIFY(env);
+
+  u_int32_t gbytes = 0, bytes = 0;
+  int ncache = 0;
+  QCOMPARE(0, env->get_cachesize(&gbytes, &bytes, &ncache));
+  QCOMPARE(gbytes, u_int32_t(0));
+  QVERIFY(bytes >= 4 * 1024 * 1024);
+
+  env->close(0);
+  delete env;
+}
+
+void EnvironmentBuilderTest::testStorageFactory()
+{
+  using ChildContainerType =
+      ChildStorage<TestElement, TestElement, TestMarshaller, TestWatcher>;
+  using ParentContainerType =
+      Storage<TestElement, TestMarshaller, TestWatcher>;
+
+  auto env = EnvironmentBuilder(mHome.path().toStdString())
+                 .preset(Preset::ReadHeavy)
+                 .cacheSize(32 * 1024 * 1024)
+                 .privateEnvironment()
+                 .open();
+  StorageFactory factory(env, Preset::ReadHeavy);
+
+  auto parents = factory.makeStorage<ParentContainerType>(
+      "EnvironmentBuilderTest.db", "parents");
+  auto children = factory.makeChildStorage<ChildContainerType>(
+      "EnvironmentBuilderTest.db", "children", "children_by_parent",
+      get_parent_id_callback);
+
+  QVERIFY(parents->add({"parent id 1", "parent name 1"}));
+  QVERIFY(children->add({"child id 1", "parent id 1"}));
+  QVERIFY(children->add({"child id 2", "parent id 1"}));
+
+  QCOMPARE(parents->get("parent id 1").name, std::string("parent name 1"));
+  QCOMPARE(children->childCount("parent id 1"), static_cast<std::size_t>(2));
+
+  DatabaseSettings hash;
+  hash.type = DB_HASH;
+  hash.fillFactor = 40;
+  auto hashDb =
+      factory.openDatabase("EnvironmentBuilderTest.db", "hashed", hash);
+  ParentContainerType hashed(hashDb, env);
+  QVERIFY(hashed.add({"id", "name"}));
+  QVERIFY(hashed.has("id"));
+
+  // вторичная база данных не может быть основной для другого индекса
+  auto primary = factory.openDatabase("EnvironmentBuilderTest.db", "primary");
+  auto secondary = factory.openSecondary(primary, "EnvironmentBuilderTest.db",
+                                         "by_name", get_parent_id_callback);
+  QVERIFY_EXCEPTION_THROWN(
+      factory.openSecondary(secondary, "EnvironmentBuilderTest.db",
+                            "by_name_twice", get_parent_id_callback),
+      std::runtime_error);
+}
+
+void EnvironmentBuilderTest::testCachePriority()
+{
+  QTemporaryDir home;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .privateEnvironment()
+                 .open();
+  DatabaseSettings settings;
+  settings.priority = DB_PRIORITY_VERY_HIGH;
+  auto db = StorageFactory(env).openDatabase("EnvironmentBuilderTest.db",
+                                             "hot", settings);
+
+  DB_CACHE_PRIORITY priority = DB_PRIORITY_UNCHANGED;
+  QCOMPARE(0, db->get_priority(&priority));
+  QCOMPARE(priority, DB_PRIORITY_VERY_HIGH);
+  {
+    CachePriorityGuard guard(db);
+    QCOMPARE(0, db->get_priority(&priority));
+    QCOMPARE(priority, DB_PRIORITY_VERY_LOW);
+  }
+  QCOMPARE(0, db->get_priority(&priority));
+  QCOMPARE(priority, DB_PRIORITY_VERY_HIGH);
+}
+
+void EnvironmentBuilderTest::testCacheBudget()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+  QTemporaryDir home;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .cacheSize(1024 * 1024)
+                 .maxCacheSize(16 * 1024 * 1024)
+                 .privateEnvironment()
+                 .open();
+  StorageFactory factory(env, Preset::LowMemory);
+  auto store =
+      factory.makeStorage<ContainerType>("EnvironmentBuilderTest.db", "budget");
+
+  CacheBudgetManager::Options options;
+  options.targetHitRatio = 1.0;
+  CacheBudgetManager manager(env, options);
+  auto initialSize = manager.cacheSize();
+
+  for (int i = 0; i < 5000; ++i) {
+    store->add({std::to_string(i), std::string(200, 'x')});
+  }
+  for (int i = 0; i < 5000; ++i) {
+    store->get(std::to_string(i));
+  }
+
+  auto snapshot = manager.sample();
+  QVERIFY(snapshot.hits + snapshot.misses > 0);
+  QVERIFY(!snapshot.files.empty());
+  QVERIFY(snapshot.residentBytes > 0);
+
+  store->getAllElements();
+  if (auto size = manager.rebalance()) {
+    QVERIFY(*size > initialSize);
+    QVERIFY(*size <= 16 * 1024 * 1024 * 1.25);
+  }
+}
+
+void EnvironmentBuilderTest::testLogMaintenance()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+  QTemporaryDir home;
+  QTemporaryDir archive;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .logFileSize(256 * 1024)
+                 .privateEnvironment()
+                 .open();
+  auto store = StorageFactory(env, Preset::LowMemory)
+                   .makeStorage<ContainerType>("EnvironmentBuilderTest.db",
+                                               "logs");
+
+  LogMaintenance::Options options;
+  options.archiveMode = LogArchiveMode::Move;
+  options.archiveDirectory = archive.path().toStdString();
+  options.recoveryBytesPerSecond = 1024 * 1024;
+  options.maxRecoveryTime = std::chrono::milliseconds(100);
+  LogMaintenance maintenance(env, options);
+
+  for (int i = 0; i < 5000; ++i) {
+    store->add({std::to_string(i), std::string(200, 'x')});
+  }
+
+  auto before = maintenance.recoveryEstimate();
+  QVERIFY(before.logBytesSinceCheckpoint > 1024 * 1024);
+  QVERIFY(before.activeLogFiles > 1);
+  QVERIFY(before.expectedRecoveryTime > options.maxRecoveryTime);
+
+  // оценка превышает maxRecoveryTime, контрольная точка записывается
+  // раньше порогов по объему и времени
+  auto report = maintenance.maintain();
+  QVERIFY(report.checkpointed);
+  QVERIFY(report.archivedLogFiles > 0);
+  QCOMPARE(report.estimate.archivableLogFiles, std::size_t(0));
+  QVERIFY(report.estimate.logBytesSinceCheckpoint <
+          before.logBytesSinceCheckpoint);
+  QVERIFY(report.estimate.expectedRecoveryTime < before.expectedRecoveryTime);
+  QCOMPARE(QDir(archive.path())
+               .entryList(QStringList() << "log.*", QDir::Files)
+               .size(),
+           static_cast<int>(report.archivedLogFiles));
+
+  QVERIFY(!maintenance.checkpoint());
+  QVERIFY(maintenance.checkpoint(true));
+  QCOMPARE(store->get("10").name, std::string(200, 'x'));
+
+  // во время резервного копирования журнал не архивируется
+  for (int i = 5000; i < 10000; ++i) {
+    store->add({std::to_string(i), std::string(200, 'x')});
+  }
+  QVERIFY(maintenance.checkpoint(true));
+  {
+    LogArchiveGuard guard(env);
+    QCOMPARE(maintenance.archiveLogs(), std::size_t(0));
+    QVERIFY(maintenance.recoveryEstimate().archivableLogFiles > 0);
+  }
+  QVERIFY(maintenance.archiveLogs() > 0);
+
+  options.archiveDirectory.clear();
+  QVERIFY_EXCEPTION_THROWN(LogMaintenance invalid(env, options),
+                           std::invalid_argument);
+}
+
+void EnvironmentBuilderTest::testHotBackup()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+  QTemporaryDir home;
+  QTemporaryDir backup;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .privateEnvironment()
+                 .open();
+  auto store = StorageFactory(env, Preset::LowMemory)
+                   .makeStorage<ContainerType>("EnvironmentBuilderTest.db",
+                                               "backup");
+  for (int i = 0; i < 1000; ++i) {
+    store->add({std::to_string(i), "name " + std::to_string(i)});
+  }
+
+  HotBackup::Options options;
+  options.blockSize = 64 * 1024;
+  options.bytesPerSecond = 64 * 1024 * 1024;
+  HotBackup hotBackup(env, options);
+  LogMaintenance maintenance(env);
+  std::size_t notifications = 0, archivedDuringBackup = 0;
+  BackupProgress last;
+  hotBackup.setProgressHandler([&](const BackupProgress& progress) {
+    ++notifications;
+    if (progress.stage == BackupProgress::Stage::Databases) {
+      maintenance.checkpoint(true);
+      archivedDuringBackup += maintenance.archiveLogs();
+    }
+    QVERIFY(progress.bytesCopied <= progress.bytesTotal);
+    last = progress;
+  });
+
+  auto report = hotBackup.backup(backup.path().toStdString());
+  QVERIFY(report.databaseFiles > 0);
+  QVERIFY(report.logFiles > 0);
+  QVERIFY(report.bytes > 0);
+  QVERIFY(notifications > report.databaseFiles + report.logFiles);
+  QVERIFY(last.stage == BackupProgress::Stage::Done);
+  QCOMPARE(archivedDuringBackup, std::size_t(0));
+  QCOMPARE(last.filesCopied, report.databaseFiles + report.logFiles);
+
+  // запись после копирования не попадает в копию
+  store->add({"after backup", "name"});
+
+  auto copyEnv = EnvironmentBuilder(backup.path().toStdString())
+                     .preset(Preset::LowMemory)
+                     .privateEnvironment()
+                     .open();
+  auto copy = StorageFactory(copyEnv, Preset::LowMemory)
+                  .makeStorage<ContainerType>("EnvironmentBuilderTest.db",
+                                              "backup");
+  QCOMPARE(copy->getAllElements().size(), std::size_t(1000));
+  QCOMPARE(copy->get("999").name, std::string("name 999"));
+  QVERIFY(!copy->has("after backup"));
+
+  options.blockSize = 1000;
+  QVERIFY_EXCEPTION_THROWN(HotBackup invalid(env, options),
+                           std::invalid_argument);
+}
+
+void EnvironmentBuilderTest::testDatabaseCompaction()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+  QTemporaryDir home;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .privateEnvironment()
+                 .open();
+  auto db = StorageFactory(env, Preset::LowMemory)
+                .openDatabase("EnvironmentBuilderTest.db", "compaction");
+  ContainerType store(db, env);
+  for (int i = 0; i < 10000; ++i) {
+    store.add({std::to_string(i), std::string(100, 'x')});
+  }
+  // остается каждый десятый элемент, страницы становятся полупустыми
+  for (int i = 0; i < 10000; ++i) {
+    if (i % 10 != 0) {
+      store.remove(std::to_string(i));
+    }
+  }
+
+  DatabaseCompactor::Options options;
+  options.pagesPerSlice = 20;
+  options.pause = std::chrono::milliseconds(0);
+  DatabaseCompactor compactor(options);
+  auto report = compactor.compact(db);
+
+  QVERIFY(report.finished);
+  QVERIFY(report.slices > 1);
+  QVERIFY(report.pagesFreed > 0);
+  QVERIFY(report.before.fillFactor() < 0.5);
+  QVERIFY(report.after.fillFactor() > report.before.fillFactor());
+  QVERIFY(report.after.leafPages < report.before.leafPages);
+  QCOMPARE(report.after.records, report.before.records);
+
+  // части ограничены ключами, даже если освобождать нечего
+  options.keysPerSlice = 100;
+  options.pagesPerSlice = 0;
+  DatabaseCompactor keyBounded(options);
+  auto again = keyBounded.compact(db);
+  QVERIFY(again.finished);
+  QVERIFY(again.slices >= 10);
+
+  QCOMPARE(store.getAllElements().size(), std::size_t(1000));
+  QVERIFY(store.has("9990"));
+  QVERIFY(!store.has("9999"));
+}
+
+void EnvironmentBuilderTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(EnvironmentBuilderTest)
+
+#include "environmentbuildertest.moc"
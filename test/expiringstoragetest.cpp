@@ -0,0 +1,233 @@
+#include <QtTest>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/expiringstorage.h"
+#include "persistent-storage/storages/expiryreaper.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+using namespace std::chrono_literals;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+  std::chrono::system_clock::time_point expiry;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+std::chrono::system_clock::time_point get_expiry(const TestElement& elem)
+{
+  return elem.expiry;
+}
+
+class TestWatcher {
+ public:
+  static int removed;
+
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) { ++removed; }
+  void elementUpdated(const TestElement&) {}
+};
+
+int TestWatcher::removed = 0;
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+    std::chrono::system_clock::rep expiry;
+    std::memcpy(&expiry, src, sizeof(expiry));
+    elem.expiry = std::chrono::system_clock::time_point(
+        std::chrono::system_clock::duration(expiry));
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    size += sizeof(std::chrono::system_clock::rep);
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+    auto expiry = elem.expiry.time_since_epoch().count();
+    std::memcpy(dest, &expiry, sizeof(expiry));
+  }
+};
+
+using ContainerType = ExpiringStorage<TestElement, TestMarshaller, TestWatcher>;
+
+class ExpiringStorageTest : public QObject {
+  Q_OBJECT
+
+ public:
+  ExpiringStorageTest();
+
+ private Q_SLOTS:
+  void testExpiryKeyOrder();
+  void testLazyFiltering();
+  void testRemoveExpired();
+  void testReaper();
+  void cleanupTestCase();
+
+ private:
+  std::shared_ptr<ContainerType> makeStorage(const std::string& name);
+
+ private:
+  QTemporaryDir mHome;
+  DbEnv* mEnv = nullptr;
+};
+
+ExpiringStorageTest::ExpiringStorageTest()
+{
+  dbstl::dbstl_startup();
+  mEnv = EnvironmentBuilder(mHome.path().toStdString())
+             .privateEnvironment()
+             .open();
+}
+
+std::shared_ptr<ContainerType> ExpiringStorageTest::makeStorage(
+    const std::string& name)
+{
+  return StorageFactory(mEnv).makeChildStorage<ContainerType>(
+      "ExpiringStorageTest.db", name, name + "_expiry",
+      expiry_index_key<TestElement, TestMarshaller>);
+}
+
+void ExpiringStorageTest::testExpiryKeyOrder()
+{
+  auto now = std::chrono::system_clock::now();
+  unsigned char before[EXPIRY_KEY_SIZE], after[EXPIRY_KEY_SIZE],
+      old[EXPIRY_KEY_SIZE];
+  encode_expiry(now, before);
+  encode_expiry(now + 1ms, after);
+  encode_expiry(std::chrono::system_clock::time_point(-1h), old);
+
+  QVERIFY(std::memcmp(before, after, EXPIRY_KEY_SIZE) < 0);
+  QVERIFY(std::memcmp(old, before, EXPIRY_KEY_SIZE) < 0);
+  QVERIFY(decode_expiry(before) >= now);
+  QVERIFY(decode_expiry(before) < now + 1ms);
+}
+
+void ExpiringStorageTest::testLazyFiltering()
+{
+  auto store = makeStorage("lazy");
+  auto now = std::chrono::system_clock::now();
+
+  QVERIFY(store->add({"expired", "expired", now - 1s}));
+  QVERIFY(store->add({"alive", "alive", now + 1h}));
+  QVERIFY(store->add({"forever", "forever", {}}));
+
+  QVERIFY(!store->has("expired"));
+  QVERIFY(store->has("alive"));
+  QVERIFY(store->has("forever"));
+  QVERIFY_EXCEPTION_THROWN(store->get("expired"), std::range_error);
+  QCOMPARE(store->getAllElements().size(), std::size_t(2));
+  QCOMPARE(store->get_if([](const TestElement&) { return true; }).size(),
+           std::size_t(2));
+  // size учитывает еще не удаленные элементы
+  QCOMPARE(store->size(), 3);
+  QCOMPARE(store->count_if([](const TestElement&) { return true; }),
+           std::size_t(2));
+  using LazyElement = ContainerType::lazy_element;
+  QCOMPARE(store->get_if_lazy([](const LazyElement&) { return true; }).size(),
+           std::size_t(2));
+  QCOMPARE(store->count_if_lazy([](const LazyElement&) { return true; }),
+           std::size_t(2));
+  auto byName = [](const TestElement& elem) { return elem.name; };
+  QCOMPARE(store->min_by(byName)->id, std::string("alive"));
+  QCOMPARE(store->group_count(byName).count("expired"), std::size_t(0));
+
+  QVERIFY(!store->strictUpdate({"expired", "updated", now + 1h}));
+  QVERIFY(store->add({"expiring", "expiring", now + 50ms}));
+  auto wrapper = store->wrapper("expiring");
+  std::this_thread::sleep_for(100ms);
+  wrapper->name = "updated";
+  QVERIFY(!wrapper.save());
+  QVERIFY(store->remove("expiring"));
+  QVERIFY(store->add({"expired", "renewed", now + 1h}));
+  QCOMPARE(store->get("expired").name, std::string("renewed"));
+  QCOMPARE(store->size(), 3);
+}
+
+void ExpiringStorageTest::testRemoveExpired()
+{
+  auto store = makeStorage("batches");
+  auto now = std::chrono::system_clock::now();
+  for (int i = 0; i < 100; ++i) {
+    store->add({"expired " + std::to_string(i), "", now - 1s - i * 1ms});
+  }
+  for (int i = 0; i < 10; ++i) {
+    store->add({"alive " + std::to_string(i), "", now + 1h});
+    store->add({"forever " + std::to_string(i), "", {}});
+  }
+
+  TestWatcher::removed = 0;
+  QCOMPARE(store->removeExpired(30, now), std::size_t(30));
+  QCOMPARE(store->size(), 90);
+
+  std::size_t removed = 30;
+  while (auto batch = store->removeExpired(30, now)) {
+    removed += batch;
+  }
+  QCOMPARE(removed, std::size_t(100));
+  QCOMPARE(TestWatcher::removed, 100);
+  QCOMPARE(store->size(), 20);
+  QVERIFY(store->has("alive 0"));
+  QVERIFY(store->has("forever 0"));
+
+  std::size_t scanned = 0;
+  QCOMPARE(store->removeExpired(30, now + 2h, scanned), std::size_t(10));
+  QCOMPARE(scanned, std::size_t(10));
+  QCOMPARE(store->size(), 10);
+  QCOMPARE(store->removeExpired(30, now + 2h, scanned), std::size_t(0));
+  QCOMPARE(scanned, std::size_t(0));
+}
+
+void ExpiringStorageTest::testReaper()
+{
+  auto store = makeStorage("reaper");
+  auto now = std::chrono::system_clock::now();
+  for (int i = 0; i < 50; ++i) {
+    store->add({std::to_string(i), "", now + 100ms});
+  }
+  store->add({"forever", "", {}});
+
+  ExpiryReaper<ContainerType>::Options options;
+  options.batchSize = 20;
+  options.pause = 0ms;
+  options.interval = 50ms;
+  ExpiryReaper<ContainerType> reaper(store, options);
+
+  for (int i = 0; i < 100 && reaper.removedCount() < 50; ++i) {
+    std::this_thread::sleep_for(50ms);
+  }
+  QCOMPARE(reaper.removedCount(), std::uint64_t(50));
+  QCOMPARE(store->size(), 1);
+
+  ExpiryReaper<ContainerType>::Options invalid;
+  invalid.batchSize = 0;
+  QVERIFY_EXCEPTION_THROWN(ExpiryReaper<ContainerType> failed(store, invalid),
+                           std::invalid_argument);
+}
+
+void ExpiringStorageTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(ExpiringStorageTest)
+
+#include "expiringstoragetest.moc"
@@ -0,0 +1,281 @@
+#include <QtTest>
+#include <cstdio>
+#include "persistent-storage/storages/logstorage.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class KeyOnlyWatcher {
+ public:
+  static constexpr bool removed_value_needed = false;
+
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+  void keyRemoved(const std::string& id) { removedKeys.push_back(id); }
+
+ public:
+  std::vector<std::string> removedKeys;
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+class LogStorageTest : public QObject {
+  Q_OBJECT
+
+ public:
+ private Q_SLOTS:
+  void testStoreInsertAndFetch();
+  void testRemoveOperation();
+  void testUpdateOperation();
+  void testReopen();
+  void testCompaction();
+  void testInterruptedCompaction();
+  void testCompactionWithoutLiveRecords();
+  void testTornWrite();
+};
+
+using TestStorage = LogStorage<TestElement, TestMarshaller, KeyOnlyWatcher>;
+
+static LogStore::Options testOptions()
+{
+  LogStore::Options options;
+  options.syncWrites = false;
+  options.maxSegmentSize = 4 * 1024;
+  return options;
+}
+
+void LogStorageTest::testStoreInsertAndFetch()
+{
+  QTemporaryDir dir;
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+  QVERIFY(!store.add(elem1));
+  QCOMPARE(store.size(), 2);
+
+  auto res = store.get("test id 1");
+  QCOMPARE(res.name, elem1.name);
+  QVERIFY(store.has("test id 2"));
+  QVERIFY(!store.has("test id 3"));
+  QVERIFY_EXCEPTION_THROWN(store.get("test id 3"), std::range_error);
+  QCOMPARE(store.getAllElements().size(), size_t(2));
+}
+
+void LogStorageTest::testRemoveOperation()
+{
+  QTemporaryDir dir;
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  QVERIFY(store.add(TestElement{"test id 1", "test name 1"}));
+  QVERIFY(store.remove("test id 1"));
+  QVERIFY(!store.remove("test id 1"));
+  QVERIFY(!store.has("test id 1"));
+  QCOMPARE(store.size(), 0);
+  QCOMPARE(store.removedKeys, std::vector<std::string>{"test id 1"});
+}
+
+void LogStorageTest::testUpdateOperation()
+{
+  QTemporaryDir dir;
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  QVERIFY(!store.strictUpdate(TestElement{"test id 1", "test name 1"}));
+  store.update(TestElement{"test id 1", "test name 1"});
+  QVERIFY(store.strictUpdate(TestElement{"test id 1", "new name"}));
+  QCOMPARE(store.get("test id 1").name, std::string("new name"));
+  QCOMPARE(store.size(), 1);
+}
+
+void LogStorageTest::testReopen()
+{
+  QTemporaryDir dir;
+  {
+    TestStorage store(
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+    for (int i = 0; i < 100; ++i) {
+      store.add(TestElement{std::to_string(i), "name " + std::to_string(i)});
+    }
+    store.remove("10");
+    store.update(TestElement{"20", "updated"});
+  }
+
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  QCOMPARE(store.size(), 99);
+  QVERIFY(!store.has("10"));
+  QCOMPARE(store.get("20").name, std::string("updated"));
+  QCOMPARE(store.get("99").name, std::string("name 99"));
+}
+
+void LogStorageTest::testCompaction()
+{
+  QTemporaryDir dir;
+  {
+    auto log =
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions());
+    TestStorage store(log);
+    for (int round = 0; round < 5; ++round) {
+      for (int i = 0; i < 100; ++i) {
+        store.update(TestElement{std::to_string(i),
+                                 "round " + std::to_string(round)});
+      }
+    }
+    for (int i = 0; i < 50; ++i) {
+      store.remove(std::to_string(i));
+    }
+    QVERIFY(log->garbageRatio() > 0.5);
+    log->compact();
+    QVERIFY(log->garbageRatio() < 0.1);
+    QCOMPARE(store.size(), 50);
+    QCOMPARE(store.get("75").name, std::string("round 4"));
+  }
+
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  QCOMPARE(store.size(), 50);
+  QVERIFY(!store.has("0"));
+  QCOMPARE(store.get("99").name, std::string("round 4"));
+}
+
+void LogStorageTest::testInterruptedCompaction()
+{
+  QTemporaryDir dir;
+  QDir logDir(dir.path());
+  QString staleName;
+  QByteArray staleContent;
+  {
+    auto log =
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions());
+    TestStorage store(log);
+    for (int i = 0; i < 100; ++i) {
+      store.update(TestElement{std::to_string(i), "name"});
+    }
+    for (int i = 0; i < 50; ++i) {
+      store.remove(std::to_string(i));
+    }
+    auto segments = logDir.entryList({"*.seg"}, QDir::Files, QDir::Name);
+    QVERIFY(segments.size() > 1);
+    staleName = segments.first();
+    QFile stale(logDir.filePath(staleName));
+    QVERIFY(stale.open(QIODevice::ReadOnly));
+    staleContent = stale.readAll();
+    log->compact();
+  }
+
+  // имитирует сбой после переименования .cseg, но до удаления исходных
+  // сегментов и переименования .chint
+  auto hints = logDir.entryList({"*.hint"}, QDir::Files, QDir::Name);
+  QCOMPARE(hints.size(), 1);
+  auto hint = hints.first();
+  auto target = hint.left(hint.size() - 5);
+  QVERIFY(logDir.rename(hint, target + ".chint"));
+  QVERIFY(logDir.exists(target + ".seg"));
+  QVERIFY(!logDir.exists(target + ".cseg"));
+  if (staleName != target + ".seg") {
+    QFile stale(logDir.filePath(staleName));
+    QVERIFY(stale.open(QIODevice::WriteOnly));
+    stale.write(staleContent);
+  }
+
+  for (int reopen = 0; reopen < 2; ++reopen) {
+    TestStorage store(
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+    QCOMPARE(store.size(), 50);
+    QVERIFY(!store.has("0"));
+    QCOMPARE(store.get("99").name, std::string("name"));
+  }
+  QVERIFY(logDir.exists(hint));
+  QVERIFY(!logDir.exists(target + ".chint"));
+}
+
+void LogStorageTest::testCompactionWithoutLiveRecords()
+{
+  QTemporaryDir dir;
+  {
+    auto log =
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions());
+    TestStorage store(log);
+    store.add(TestElement{"test id 1", "test name 1"});
+    store.remove("test id 1");
+    log->compact();
+    QCOMPARE(store.size(), 0);
+  }
+  QDir logDir(dir.path());
+  QVERIFY(logDir.entryList({"*.hint"}, QDir::Files).isEmpty());
+
+  // идентификаторы сегментов после перезапуска начинаются заново
+  {
+    TestStorage store(
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+    QCOMPARE(store.size(), 0);
+    QVERIFY(store.add(TestElement{"test id 2", "test name 2"}));
+  }
+
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  QCOMPARE(store.size(), 1);
+  QCOMPARE(store.get("test id 2").name, std::string("test name 2"));
+}
+
+void LogStorageTest::testTornWrite()
+{
+  QTemporaryDir dir;
+  {
+    TestStorage store(
+        std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+    store.add(TestElement{"test id 1", "test name 1"});
+    store.add(TestElement{"test id 2", "test name 2"});
+  }
+
+  // имитирует сбой во время записи последней записи
+  QDir logDir(dir.path());
+  auto segments = logDir.entryList({"*.seg"}, QDir::Files, QDir::Name);
+  QVERIFY(!segments.isEmpty());
+  QFile last(logDir.filePath(segments.last()));
+  QVERIFY(last.size() > 0);
+  QVERIFY(last.resize(last.size() - 3));
+
+  TestStorage store(
+      std::make_shared<LogStore>(dir.path().toStdString(), testOptions()));
+  QCOMPARE(store.size(), 1);
+  QVERIFY(store.has("test id 1"));
+  QVERIFY(store.add(TestElement{"test id 2", "test name 2"}));
+}
+
+QTEST_APPLESS_MAIN(LogStorageTest)
+
+#include "logstoragetest.moc"
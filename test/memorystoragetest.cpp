@@ -0,0 +1,332 @@
+#include <QtTest>
+#include <unordered_map>
+#include "persistent-storage/storages/memorychildstorage.h"
+#include "persistent-storage/storages/memorystorage.h"
+
+#include "persistent-storage/deleters/childthatisparentdeleter.h"
+#include "persistent-storage/deleters/defaultchilddeleter.h"
+#include "persistent-storage/deleters/parentsdeleter.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+std::string get_parent_id(const TestElement& elem)
+{
+  return elem.name;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) { ++added; }
+  void elementRemoved(const TestElement&) { ++removed; }
+  void elementUpdated(const TestElement&) { ++updated; }
+
+ public:
+  int added = 0;
+  int removed = 0;
+  int updated = 0;
+};
+
+class KeyOnlyWatcher {
+ public:
+  static constexpr bool removed_value_needed = false;
+
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+  void keyRemoved(const std::string& id) { removedKeys.push_back(id); }
+
+ public:
+  std::vector<std::string> removedKeys;
+};
+
+class ReentrantWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement& elem)
+  {
+    if (onRemoved) {
+      onRemoved(elem);
+    }
+  }
+  void elementUpdated(const TestElement&) {}
+
+ public:
+  std::function<void(const TestElement&)> onRemoved;
+};
+
+class MemoryStorageTest : public QObject {
+  Q_OBJECT
+
+ public:
+ private Q_SLOTS:
+  void testStoreOperations();
+  void testHashIndex();
+  void testKeyOnlyRemove();
+  void testWrapper();
+  void testChildrenLookup();
+  void testParentRemoved();
+  void testKeyOnlyParentRemoved();
+  void testSeveralLevelsOfInheritance();
+  void testWatcherReadsContainer();
+};
+
+using KeyType = decltype(get_id(std::declval<TestElement>()));
+using TestStorage = MemoryStorage<TestElement, TestWatcher>;
+
+void MemoryStorageTest::testStoreOperations()
+{
+  TestStorage store;
+  QVERIFY(store.add({"test id 1", "test name 1"}));
+  QVERIFY(store.add({"test id 2", "test name 2"}));
+  QVERIFY(!store.add({"test id 1", "test name 3"}));
+  QCOMPARE(store.size(), 2);
+  QCOMPARE(store.get("test id 1").name, std::string("test name 1"));
+  QVERIFY_EXCEPTION_THROWN(store.get("test id 3"), std::range_error);
+
+  QVERIFY(!store.strictUpdate({"test id 3", "test name 3"}));
+  QVERIFY(store.strictUpdate({"test id 1", "new name"}));
+  store.update({"test id 3", "test name 3"});
+  QCOMPARE(store.get("test id 1").name, std::string("new name"));
+  QCOMPARE(store.size(), 3);
+
+  auto found = store.get_if(
+      [](const TestElement& elem) { return elem.name == "test name 3"; });
+  QCOMPARE(found.size(), static_cast<std::size_t>(1));
+
+  QVERIFY(store.remove("test id 2"));
+  QVERIFY(!store.remove("test id 2"));
+  QVERIFY(!store.has("test id 2"));
+  QCOMPARE(store.getAllElements().size(), static_cast<std::size_t>(2));
+
+  QCOMPARE(store.added, 2);
+  QCOMPARE(store.updated, 2);
+  QCOMPARE(store.removed, 1);
+}
+
+void MemoryStorageTest::testHashIndex()
+{
+  using HashStorage =
+      MemoryStorage<TestElement, TestWatcher, DefaultDeleter<KeyType, TestElement>,
+                    std::unordered_map<KeyType, TestElement>>;
+  HashStorage store;
+  for (int i = 0; i < 100; ++i) {
+    QVERIFY(store.add({std::to_string(i), "name"}));
+  }
+  QVERIFY(store.remove("50"));
+  QCOMPARE(store.size(), 99);
+  QVERIFY(store.has("99"));
+  QVERIFY(!store.has("50"));
+}
+
+void MemoryStorageTest::testKeyOnlyRemove()
+{
+  MemoryStorage<TestElement, KeyOnlyWatcher> store;
+  store.add({"test id 1", "test name 1"});
+  QVERIFY(store.remove("test id 1"));
+  QVERIFY(!store.remove("test id 1"));
+  QCOMPARE(store.removedKeys, std::vector<std::string>{"test id 1"});
+}
+
+void MemoryStorageTest::testWrapper()
+{
+  auto store = std::make_shared<TestStorage>();
+  store->add({"test id 1", "test name 1"});
+
+  auto wrapper = store->wrapper("test id 1");
+  wrapper->name = "test";
+  QVERIFY(wrapper.save());
+  QCOMPARE(store->get("test id 1").name, std::string("test"));
+}
+
+void MemoryStorageTest::testChildrenLookup()
+{
+  using ChildContainerType =
+      MemoryChildStorage<TestElement, TestElement, TestWatcher>;
+
+  ChildContainerType child_container(get_parent_id);
+  child_container.add({"child id 1", "parent id 1"});
+  child_container.add({"child id 1_2", "parent id 1"});
+  child_container.add({"child id 1_3", "parent id 1"});
+  child_container.add({"child id 2", "parent id 2"});
+
+  QCOMPARE(child_container.childCount("parent id 1"),
+           static_cast<std::size_t>(3));
+  QCOMPARE(child_container.childCount("parent id 3"),
+           static_cast<std::size_t>(0));
+
+  std::vector<std::string> ids;
+  for (const auto& child : child_container.childrenOf("parent id 1")) {
+    ids.push_back(child.id);
+  }
+  QCOMPARE(ids.size(), static_cast<std::size_t>(3));
+
+  auto firstPage = child_container.childrenOf("parent id 1", 2);
+  QCOMPARE(firstPage.size(), static_cast<std::size_t>(2));
+  auto secondPage =
+      child_container.childrenOf("parent id 1", 2, firstPage.back().id);
+  QCOMPARE(secondPage.size(), static_cast<std::size_t>(1));
+  QCOMPARE(secondPage.front().id, std::string("child id 1_3"));
+  QVERIFY(child_container.childrenOf("parent id 1", 2, "child id 1_3").empty());
+  QVERIFY_EXCEPTION_THROWN(
+      child_container.childrenOf("parent id 1", 2, "child id 2"),
+      std::out_of_range);
+
+  child_container.update({"child id 2", "parent id 1"});
+  QCOMPARE(child_container.childCount("parent id 1"),
+           static_cast<std::size_t>(4));
+  QCOMPARE(child_container.childCount("parent id 2"),
+           static_cast<std::size_t>(0));
+
+  QVERIFY(child_container.remove("child id 1"));
+  QCOMPARE(child_container.childCount("parent id 1"),
+           static_cast<std::size_t>(3));
+}
+
+void MemoryStorageTest::testParentRemoved()
+{
+  using ChildContainerType =
+      MemoryChildStorage<TestElement, TestElement, TestWatcher>;
+  using ParentDeleterType =
+      ParentsDeleter<KeyType, TestElement, ChildContainerType>;
+  using ParentContainerType =
+      MemoryStorage<TestElement, TestWatcher, ParentDeleterType>;
+
+  std::size_t removedByParent = 0;
+  auto child_container = std::make_shared<ChildContainerType>(get_parent_id);
+  auto parent_container = std::make_shared<ParentContainerType>(
+      ParentDeleterType(child_container, 1,
+                        [&removedByParent](const CascadeReport& report) {
+                          removedByParent = report.removedOnLevel(0);
+                        }));
+
+  parent_container->add({"parent id 1", "parent name 1"});
+  parent_container->add({"parent id 2", "parent name 2"});
+
+  child_container->add({"child id 1", "parent id 1"});
+  child_container->add({"child id 1_2", "parent id 1"});
+  child_container->add({"child id 2", "parent id 2"});
+
+  QVERIFY(parent_container->remove("parent id 1"));
+  QCOMPARE(removedByParent, static_cast<std::size_t>(2));
+  QCOMPARE(child_container->removed, 2);
+
+  QVERIFY(!child_container->has("child id 1"));
+  QVERIFY(!child_container->has("child id 1_2"));
+  QVERIFY(child_container->has("child id 2"));
+  QCOMPARE(child_container->childCount("parent id 1"),
+           static_cast<std::size_t>(0));
+}
+
+void MemoryStorageTest::testKeyOnlyParentRemoved()
+{
+  using ChildContainerType =
+      MemoryChildStorage<TestElement, TestElement, TestWatcher>;
+  using ParentDeleterType =
+      ParentsDeleter<KeyType, TestElement, ChildContainerType,
+                     KeyOnlyDeleter<KeyType, TestElement>>;
+  using ParentContainerType =
+      MemoryStorage<TestElement, KeyOnlyWatcher, ParentDeleterType>;
+  static_assert(!removed_value_needed<ParentDeleterType>::value);
+
+  auto child_container = std::make_shared<ChildContainerType>(get_parent_id);
+  auto parent_container = std::make_shared<ParentContainerType>(
+      ParentDeleterType(child_container));
+
+  parent_container->add({"parent id 1", "parent name 1"});
+  parent_container->add({"parent id 2", "parent name 2"});
+
+  child_container->add({"child id 1", "parent id 1"});
+  child_container->add({"child id 1_2", "parent id 1"});
+  child_container->add({"child id 2", "parent id 2"});
+
+  QVERIFY(parent_container->remove("parent id 1"));
+  QVERIFY(!parent_container->remove("parent id 1"));
+  QCOMPARE(parent_container->removedKeys,
+           std::vector<std::string>{"parent id 1"});
+  QCOMPARE(child_container->removed, 2);
+  QVERIFY(!child_container->has("child id 1"));
+  QVERIFY(child_container->has("child id 2"));
+}
+
+void MemoryStorageTest::testSeveralLevelsOfInheritance()
+{
+  using ChildContainerType =
+      MemoryChildStorage<TestElement, TestElement, TestWatcher>;
+  using ChildThatIsParentDeleterType =
+      ChildThatIsParentDeleter<KeyType, TestElement, TestElement,
+                               ChildContainerType>;
+  using ChildThatIsParentContainerType =
+      MemoryChildStorage<TestElement, TestElement, TestWatcher,
+                         ChildThatIsParentDeleterType>;
+  using ParentDeleterType =
+      ParentsDeleter<KeyType, TestElement, ChildThatIsParentContainerType>;
+  using ParentContainerType =
+      MemoryStorage<TestElement, TestWatcher, ParentDeleterType>;
+
+  auto child_container = std::make_shared<ChildContainerType>(get_parent_id);
+  auto child_that_is_parent = std::make_shared<ChildThatIsParentContainerType>(
+      get_parent_id, ChildThatIsParentDeleterType(child_container));
+  auto parent_container = std::make_shared<ParentContainerType>(
+      ParentDeleterType(child_that_is_parent));
+
+  parent_container->add({"parent id 1", "parent name 1"});
+  parent_container->add({"parent id 2", "parent name 2"});
+
+  child_that_is_parent->add({"child parent id 1", "parent id 1"});
+  child_that_is_parent->add({"child parent id 1_2", "parent id 1"});
+  child_that_is_parent->add({"child parent id 2", "parent id 2"});
+
+  child_container->add({"child id 1", "child parent id 1"});
+  child_container->add({"child id 1_2", "child parent id 1"});
+  child_container->add({"child id 1_2_1", "child parent id 1_2"});
+  child_container->add({"child id 2", "child parent id 2"});
+
+  QVERIFY(parent_container->remove("parent id 1"));
+
+  QVERIFY(!child_that_is_parent->has("child parent id 1"));
+  QVERIFY(!child_that_is_parent->has("child parent id 1_2"));
+  QVERIFY(child_that_is_parent->has("child parent id 2"));
+
+  QVERIFY(!child_container->has("child id 1"));
+  QVERIFY(!child_container->has("child id 1_2"));
+  QVERIFY(!child_container->has("child id 1_2_1"));
+  QVERIFY(child_container->has("child id 2"));
+}
+
+void MemoryStorageTest::testWatcherReadsContainer()
+{
+  using ChildContainerType =
+      MemoryChildStorage<TestElement, TestElement, ReentrantWatcher>;
+
+  ChildContainerType child_container(get_parent_id);
+  child_container.add({"child id 1", "parent id 1"});
+  child_container.add({"child id 1_2", "parent id 1"});
+  child_container.add({"child id 2", "parent id 2"});
+
+  // уведомления выполняются после снятия блокировки контейнера
+  std::vector<std::size_t> remaining;
+  child_container.onRemoved = [&child_container,
+                               &remaining](const TestElement& elem) {
+    QVERIFY(!child_container.has(elem.id));
+    remaining.push_back(child_container.childrenOf("parent id 2").size());
+  };
+  child_container.parentRemoved(TestElement{"parent id 1", "parent name 1"});
+
+  QCOMPARE(remaining, std::vector<std::size_t>({1, 1}));
+  QCOMPARE(child_container.size(), 1);
+}
+
+QTEST_APPLESS_MAIN(MemoryStorageTest)
+
+#include "memorystoragetest.moc"
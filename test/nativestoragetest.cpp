@@ -0,0 +1,232 @@
+#include <QtTest>
+#include "persistent-storage/storages/nativestorage.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class KeyOnlyWatcher {
+ public:
+  static constexpr bool removed_value_needed = false;
+
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+  void keyRemoved(const std::string& id) { removedKeys.push_back(id); }
+
+ public:
+  std::vector<std::string> removedKeys;
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+class NativeStorageTest : public QObject {
+  Q_OBJECT
+
+ public:
+ private Q_SLOTS:
+  void testStoreInsertAndFetch();
+  void testRemoveOperation();
+  void testUpdateOperation();
+  void testStrictUpdate();
+  void testElementsAccess();
+  void testWrapper();
+  void testKeyOnlyRemove();
+  void testKeysAccess();
+  void testExceptionHandle();
+};
+
+using TestStorage = NativeStorage<TestElement, TestMarshaller, TestWatcher>;
+
+void NativeStorageTest::testStoreInsertAndFetch()
+{
+  TestStorage store;
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+  QVERIFY(!store.add(elem2));
+
+  auto retrieve1 = store.get("test id 1");
+
+  QCOMPARE(elem1.id, retrieve1.id);
+  QCOMPARE(elem1.name, retrieve1.name);
+}
+
+void NativeStorageTest::testRemoveOperation()
+{
+  TestStorage store;
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+
+  QVERIFY(store.remove("test id 2"));
+  QVERIFY(!store.remove("test id 2"));
+
+  QVERIFY_EXCEPTION_THROWN(store.get("test id 2"), std::range_error);
+
+  auto retrieve1 = store.get("test id 1");
+
+  QCOMPARE(elem1.id, retrieve1.id);
+  QCOMPARE(elem1.name, retrieve1.name);
+}
+
+void NativeStorageTest::testUpdateOperation()
+{
+  TestStorage store;
+  TestElement elem3{"test id 3", "test name 3"};
+
+  store.update(elem3);
+
+  QVERIFY(store.has("test id 3"));
+  QCOMPARE(store.get("test id 3").name, elem3.name);
+
+  elem3.name = "new test 3";
+
+  store.update(elem3);
+
+  QCOMPARE(store.get("test id 3").name, elem3.name);
+}
+
+void NativeStorageTest::testStrictUpdate()
+{
+  TestStorage store;
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+
+  QVERIFY(!store.strictUpdate({"test id 3", "test name 3"}));
+  QVERIFY(!store.has("test id 3"));
+
+  elem2.name = "new name 2";
+
+  QVERIFY(store.strictUpdate(elem2));
+  QCOMPARE(store.get("test id 2").name, elem2.name);
+}
+
+void NativeStorageTest::testElementsAccess()
+{
+  TestStorage store;
+  QVERIFY(store.add({"test id 1", "test name 1"}));
+  QVERIFY(store.add({"test id 2", "test name 2"}));
+  QVERIFY(store.add({"test id 3", "test name 3"}));
+
+  QCOMPARE(3, store.size());
+  QCOMPARE(store.getAllElements().size(), static_cast<std::size_t>(3));
+
+  auto get_if = store.get_if([](const TestElement& el) {
+    return el.name == "test name 1" || el.name == "test name 3";
+  });
+
+  QCOMPARE(get_if.size(), static_cast<std::size_t>(2));
+}
+
+void NativeStorageTest::testWrapper()
+{
+  auto store = std::make_shared<TestStorage>();
+  QVERIFY(store->add({"test id 1", "test name 1"}));
+
+  auto wrapper = store->wrapper("test id 1");
+  wrapper->name = "new name 1";
+  QVERIFY(wrapper.save());
+
+  QCOMPARE(store->get("test id 1").name, std::string("new name 1"));
+
+  wrapper.remove();
+
+  QVERIFY(!store->has("test id 1"));
+}
+
+void NativeStorageTest::testKeyOnlyRemove()
+{
+  NativeStorage<TestElement, TestMarshaller, KeyOnlyWatcher> store;
+  QVERIFY(store.add({"test id 1", "test name 1"}));
+
+  QVERIFY(store.remove("test id 1"));
+  QVERIFY(!store.remove("test id 1"));
+  QCOMPARE(store.removedKeys.size(), static_cast<std::size_t>(1));
+}
+
+void NativeStorageTest::testKeysAccess()
+{
+  TestStorage store;
+  QVERIFY(store.add({"test id 1", "test name 1"}));
+  QVERIFY(store.add({"test id 2", "test name 2"}));
+
+  QCOMPARE(store.getAllKeys(),
+           std::vector<std::string>({"test id 1", "test id 2"}));
+
+  std::vector<std::string> ranged;
+  for (const auto& id : store.keys()) {
+    ranged.push_back(id);
+  }
+  QCOMPARE(ranged, store.getAllKeys());
+}
+
+void NativeStorageTest::testExceptionHandle()
+{
+  // без DB_CXX_NO_EXCEPTIONS нехватка буфера - исключение DbMemoryException
+  Db db(nullptr, 0);
+  db.open(nullptr, nullptr, nullptr, DB_BTREE, DB_CREATE, 0600);
+  {
+    NativeTable<std::string, TestElement, TestMarshaller> table(&db);
+    TestElement large{"large", std::string(64 * 1024, 'x')};
+    table.put(nullptr, large.id, large);
+    QVERIFY(table.insert(nullptr, "small", {"small", "small name"}));
+
+    auto retrieved = table.get(nullptr, "large");
+    QVERIFY(retrieved);
+    QCOMPARE(retrieved->name, large.name);
+    QCOMPARE(table.count(nullptr), std::size_t(2));
+
+    std::size_t scanned = 0;
+    table.forEach(nullptr, [&scanned](const TestElement&) {
+      ++scanned;
+      return true;
+    });
+    QCOMPARE(scanned, std::size_t(2));
+  }
+  db.close(0);
+}
+
+QTEST_APPLESS_MAIN(NativeStorageTest)
+
+#include "nativestoragetest.moc"
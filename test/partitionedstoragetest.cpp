@@ -0,0 +1,249 @@
+#include <QtTest>
+#include <algorithm>
+#include <atomic>
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/partitionedstorage.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+class PartitionedStorageTest : public QObject {
+  Q_OBJECT
+
+ public:
+  PartitionedStorageTest();
+
+ private Q_SLOTS:
+  void testOperations();
+  void testScatterGather();
+  void testRangePartitioner();
+  void testForEachPartition();
+  void cleanupTestCase();
+
+ private:
+  std::vector<Db*> openPartitions(const std::string& prefix, std::size_t count);
+
+ private:
+  QTemporaryDir mHome;
+  DbEnv* mEnv = nullptr;
+};
+
+PartitionedStorageTest::PartitionedStorageTest()
+{
+  dbstl::dbstl_startup();
+  mEnv = EnvironmentBuilder(mHome.path().toStdString())
+             .privateEnvironment()
+             .open();
+}
+
+std::vector<Db*> PartitionedStorageTest::openPartitions(
+    const std::string& prefix,
+    std::size_t count)
+{
+  StorageFactory factory(mEnv);
+  std::vector<Db*> res;
+  for (std::size_t i = 0; i < count; ++i) {
+    res.push_back(factory.openDatabase(
+        prefix + "-" + std::to_string(i) + ".db", "elements"));
+  }
+  return res;
+}
+
+void PartitionedStorageTest::testOperations()
+{
+  PartitionedStorage<ContainerType> store(openPartitions("operations", 4),
+                                          mEnv);
+  QCOMPARE(store.partitionCount(), std::size_t(4));
+
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+  QVERIFY(!store.add(elem1));
+  QVERIFY(store.has("test id 1"));
+  QVERIFY(!store.has("missing"));
+  QCOMPARE(store.get("test id 2").name, std::string("test name 2"));
+  QVERIFY_EXCEPTION_THROWN(store.get("missing"), std::range_error);
+
+  // элемент хранится только в своей секции
+  auto index = store.partitionOf("test id 1");
+  QVERIFY(store.partition(index)->has("test id 1"));
+  for (std::size_t i = 0; i < store.partitionCount(); ++i) {
+    if (i != index) {
+      QVERIFY(!store.partition(i)->has("test id 1"));
+    }
+  }
+
+  elem1.name = "changed";
+  QVERIFY(store.strictUpdate(elem1));
+  QCOMPARE(store.get("test id 1").name, std::string("changed"));
+  QVERIFY(!store.strictUpdate({"missing", "name"}));
+  store.update({"test id 3", "test name 3"});
+  QVERIFY(store.has("test id 3"));
+
+  {
+    auto wrapper = store.wrapper("test id 2");
+    wrapper->name = "wrapped";
+    wrapper.save();
+  }
+  QCOMPARE(store.get("test id 2").name, std::string("wrapped"));
+
+  QVERIFY(store.remove("test id 1"));
+  QVERIFY(!store.remove("test id 1"));
+  QVERIFY(!store.has("test id 1"));
+}
+
+void PartitionedStorageTest::testScatterGather()
+{
+  PartitionedStorage<ContainerType> store(openPartitions("scatter", 4), mEnv);
+  for (int i = 0; i < 1000; ++i) {
+    QVERIFY(store.add({std::to_string(i), "name " + std::to_string(i % 10)}));
+  }
+
+  QCOMPARE(store.size(), 1000);
+  auto all = store.getAllElements();
+  QCOMPARE(all.size(), std::size_t(1000));
+  std::vector<std::string> ids;
+  for (const auto& elem : all) {
+    ids.push_back(elem.id);
+  }
+  std::sort(ids.begin(), ids.end());
+  QVERIFY(std::unique(ids.begin(), ids.end()) == ids.end());
+
+  auto keys = store.getAllKeys();
+  std::sort(keys.begin(), keys.end());
+  QCOMPARE(keys, ids);
+  std::size_t visited = 0;
+  store.forEachKey([&visited](const std::string&) { return ++visited < 10; });
+  QCOMPARE(visited, std::size_t(10));
+
+  auto filtered = store.get_if(
+      [](const TestElement& elem) { return elem.name == "name 7"; });
+  QCOMPARE(filtered.size(), std::size_t(100));
+
+  QCOMPARE(store.count_if(
+               [](const TestElement& elem) { return elem.name == "name 7"; }),
+           std::size_t(100));
+  auto total = store.reduce(
+      std::size_t(0),
+      [](std::size_t sum, const TestElement& elem) {
+        return sum + std::stoul(elem.id);
+      },
+      [](std::size_t left, std::size_t right) { return left + right; });
+  QCOMPARE(total, std::size_t(999 * 1000 / 2));
+  auto byId = [](const TestElement& elem) { return std::stoi(elem.id); };
+  QCOMPARE(store.min_by(byId)->id, std::string("0"));
+  QCOMPARE(store.max_by(byId)->id, std::string("999"));
+  auto groups =
+      store.group_count([](const TestElement& elem) { return elem.name; });
+  QCOMPARE(groups.size(), std::size_t(10));
+  QCOMPARE(groups["name 3"], std::size_t(100));
+
+  // хеш распределяет ключи по всем секциям
+  for (std::size_t i = 0; i < store.partitionCount(); ++i) {
+    QVERIFY(store.partition(i)->size() > 100);
+  }
+}
+
+void PartitionedStorageTest::testRangePartitioner()
+{
+  using RangeStorage =
+      PartitionedStorage<ContainerType, RangePartitioner<std::string>>;
+  RangeStorage store(openPartitions("range", 3), mEnv,
+                     RangePartitioner<std::string>({"n", "g"}));
+
+  QCOMPARE(store.partitionOf("apple"), std::size_t(0));
+  QCOMPARE(store.partitionOf("g"), std::size_t(1));
+  QCOMPARE(store.partitionOf("melon"), std::size_t(1));
+  QCOMPARE(store.partitionOf("zucchini"), std::size_t(2));
+
+  QVERIFY(store.add({"apple", "fruit"}));
+  QVERIFY(store.add({"zucchini", "vegetable"}));
+  QVERIFY(store.partition(0)->has("apple"));
+  QVERIFY(store.partition(2)->has("zucchini"));
+  QCOMPARE(store.size(), 2);
+}
+
+void PartitionedStorageTest::testForEachPartition()
+{
+  PartitionedStorage<ContainerType> store(openPartitions("maintenance", 3),
+                                          mEnv);
+  for (int i = 0; i < 100; ++i) {
+    store.add({std::to_string(i), "name"});
+  }
+
+  std::atomic<int> total{0};
+  std::atomic<std::size_t> visited{0};
+  store.forEachPartition(
+      [&store, &total, &visited](std::size_t index, ContainerType& storage,
+                                 Db* db) {
+        total += storage.size();
+        if (db == store.databases()[index]) {
+          ++visited;
+        }
+      });
+  QCOMPARE(visited.load(), std::size_t(3));
+  QCOMPARE(total.load(), 100);
+
+  QVERIFY_EXCEPTION_THROWN(
+      store.forEachPartition([](std::size_t index, ContainerType&, Db*) {
+        if (index == 2) {
+          throw std::runtime_error("maintenance failed");
+        }
+      }),
+      std::runtime_error);
+
+  QVERIFY_EXCEPTION_THROWN(PartitionedStorage<ContainerType> empty({}, mEnv),
+                           std::invalid_argument);
+}
+
+void PartitionedStorageTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(PartitionedStorageTest)
+
+#include "partitionedstoragetest.moc"
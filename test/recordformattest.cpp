@@ -0,0 +1,161 @@
+#include <QtTest>
+#include <string>
+#include <vector>
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/utils/recordformat.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+  int age = 0;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+void to_record(RecordWriter& writer, const TestElement& elem)
+{
+  writer.add(elem.id);
+  writer.add(elem.name);
+  writer.addValue(elem.age);
+}
+
+void from_record(const RecordView<TestElement>& view, TestElement& elem)
+{
+  elem.id = view.value<std::string>(0);
+  elem.name = view.value<std::string>(1);
+  elem.age = view.value<int>(2);
+}
+
+struct TestName {
+  static constexpr std::uint32_t index = 1;
+  using type = std::string_view;
+};
+
+struct TestAge {
+  static constexpr std::uint32_t index = 2;
+  using type = int;
+};
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+using TestMarshaller = RecordMarshaller<TestElement>;
+
+class RecordFormatTest : public QObject {
+  Q_OBJECT
+
+ private Q_SLOTS:
+  void testRoundTrip();
+  void testFieldAccess();
+  void testLazyPredicates();
+  void testViews();
+};
+
+void RecordFormatTest::testRoundTrip()
+{
+  TestElement elem{"test id", "test name", 42};
+  std::vector<char> buffer(TestMarshaller::size(elem));
+  TestMarshaller::store(buffer.data(), elem);
+
+  TestElement restored;
+  TestMarshaller::restore(restored, buffer.data());
+  QCOMPARE(restored.id, elem.id);
+  QCOMPARE(restored.name, elem.name);
+  QCOMPARE(restored.age, elem.age);
+
+  TestElement empty;
+  buffer.assign(TestMarshaller::size(empty), 0);
+  TestMarshaller::store(buffer.data(), empty);
+  QCOMPARE(RecordView<TestElement>(buffer.data()).toElement().name,
+           std::string());
+}
+
+void RecordFormatTest::testFieldAccess()
+{
+  TestElement elem{"test id", "test name", 42};
+  std::vector<char> buffer(TestMarshaller::size(elem));
+  TestMarshaller::store(buffer.data(), elem);
+
+  RecordView<TestElement> view(buffer.data());
+  QCOMPARE(view.fieldCount(), std::uint32_t(3));
+  QCOMPARE(view.get<TestName>(), std::string_view("test name"));
+  QCOMPARE(view.get<TestAge>(), 42);
+  // строка читается из буфера записи без копирования
+  QVERIFY(view.field(0).data() >= buffer.data());
+  QVERIFY(view.field(0).data() < buffer.data() + buffer.size());
+  QCOMPARE(TestMarshaller::peek<TestName>(buffer.data()),
+           std::string_view("test name"));
+
+  QVERIFY_EXCEPTION_THROWN(view.field(3), std::out_of_range);
+  QVERIFY_EXCEPTION_THROWN(view.value<double>(2), std::out_of_range);
+}
+
+void RecordFormatTest::testLazyPredicates()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+  ContainerType store;
+  QVERIFY(store.add({"id 1", "a", 20}));
+  QVERIFY(store.add({"id 2", "b", 30}));
+  QVERIFY(store.add({"id 3", "a", 40}));
+
+  auto found = store.get_if_lazy([](const ContainerType::lazy_element& el) {
+    return el.peek<TestName>() == "a" && el.peek<TestAge>() > 30;
+  });
+  QCOMPARE(found.size(), std::size_t(1));
+  QCOMPARE(found.front().id, std::string("id 3"));
+  QCOMPARE(store.get("id 2").age, 30);
+}
+
+void RecordFormatTest::testViews()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+  ContainerType store;
+  QVERIFY(store.add({"id 1", "a", 20}));
+  QVERIFY(store.add({"id 2", "b", 30}));
+  QVERIFY(store.add({"id 3", "a", 40}));
+
+  std::string name;
+  int age = 0;
+  QVERIFY(store.view("id 2", [&](const ContainerType::record_view& view) {
+    name = std::string(view.get<TestName>());
+    age = view.get<TestAge>();
+  }));
+  QCOMPARE(name, std::string("b"));
+  QCOMPARE(age, 30);
+  bool called = false;
+  QVERIFY(!store.view(
+      "id 4", [&called](const ContainerType::record_view&) { called = true; }));
+  QVERIFY(!called);
+
+  int total = 0;
+  std::size_t visited = 0;
+  store.forEachView([&](const ContainerType::record_view& view) {
+    if (view.get<TestName>() == "a") {
+      total += view.get<TestAge>();
+    }
+    ++visited;
+    return true;
+  });
+  QCOMPARE(total, 60);
+  QCOMPARE(visited, std::size_t(3));
+
+  visited = 0;
+  store.forEachView([&visited](const ContainerType::record_view& view) {
+    ++visited;
+    return view.toElement().id != "id 1";
+  });
+  QCOMPARE(visited, std::size_t(1));
+}
+
+QTEST_APPLESS_MAIN(RecordFormatTest)
+
+#include "recordformattest.moc"
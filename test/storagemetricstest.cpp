@@ -0,0 +1,226 @@
+#include <QtTest>
+#include <map>
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/metrics/dbstatistics.h"
+#include "persistent-storage/metrics/storagemetrics.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class QueueWatcher : public TestWatcher {
+ public:
+  std::size_t queueDepth() const noexcept { return 7; }
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+using MeteredStorage = Storage<TestElement,
+                               TestMarshaller,
+                               TestWatcher,
+                               DefaultTransactionManager,
+                               DefaultDeleter<std::string, TestElement>,
+                               StorageMetrics>;
+
+class StorageMetricsTest : public QObject {
+  Q_OBJECT
+
+ public:
+ private Q_SLOTS:
+  void testHistogram();
+  void testOperationCounters();
+  void testErrors();
+  void testWatcherQueueDepth();
+  void testSnapshotVisit();
+  void testEnvironmentStats();
+  void cleanupTestCase();
+};
+
+void StorageMetricsTest::testHistogram()
+{
+  LatencyHistogram histogram;
+  QCOMPARE(histogram.percentileNanoseconds(50), std::uint64_t(0));
+
+  for (int i = 0; i < 90; ++i) {
+    histogram.record(std::chrono::nanoseconds(100));
+  }
+  for (int i = 0; i < 10; ++i) {
+    histogram.record(std::chrono::microseconds(100));
+  }
+  QCOMPARE(histogram.count(), std::uint64_t(100));
+  QCOMPARE(histogram.maxNanoseconds(), std::uint64_t(100000));
+  QCOMPARE(histogram.totalNanoseconds(),
+           std::uint64_t(90 * 100 + 10 * 100000));
+
+  auto p50 = histogram.percentileNanoseconds(50);
+  QVERIFY(p50 >= 100 && p50 < 200);
+  auto p99 = histogram.percentileNanoseconds(99);
+  QVERIFY(p99 >= 65536 && p99 <= 100000);
+
+  histogram.reset();
+  QCOMPARE(histogram.count(), std::uint64_t(0));
+  QCOMPARE(histogram.maxNanoseconds(), std::uint64_t(0));
+}
+
+void StorageMetricsTest::testOperationCounters()
+{
+  MeteredStorage store;
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+  QVERIFY(!store.add(elem1));
+  store.update(elem1);
+  QVERIFY(store.has("test id 1"));
+  QVERIFY(!store.has("missing"));
+  store.get("test id 2");
+  store.getAllElements();
+  QVERIFY(store.remove("test id 1"));
+  QVERIFY(!store.remove("test id 1"));
+
+  auto metrics = store.metrics();
+  QCOMPARE(metrics[Operation::Add].count, std::uint64_t(3));
+  QCOMPARE(metrics[Operation::Add].misses, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Add].bytes,
+           std::uint64_t(2 * TestMarshaller::size(elem1) +
+                         TestMarshaller::size(elem2)));
+  QCOMPARE(metrics[Operation::Update].count, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Get].count, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Has].count, std::uint64_t(2));
+  QCOMPARE(metrics[Operation::Has].misses, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Get].bytes,
+           std::uint64_t(TestMarshaller::size(elem2)));
+  QCOMPARE(metrics[Operation::Scan].count, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Remove].count, std::uint64_t(2));
+  QCOMPARE(metrics[Operation::Remove].misses, std::uint64_t(1));
+  QCOMPARE(metrics.commits, std::uint64_t(4));
+  QCOMPARE(metrics.aborts, std::uint64_t(0));
+  QVERIFY(metrics[Operation::Add].maxNanoseconds >=
+          metrics[Operation::Add].p50Nanoseconds);
+}
+
+void StorageMetricsTest::testErrors()
+{
+  MeteredStorage store;
+  QVERIFY_EXCEPTION_THROWN(store.get("missing"), std::range_error);
+
+  auto metrics = store.metrics();
+  QCOMPARE(metrics[Operation::Get].count, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Get].errors, std::uint64_t(1));
+  QCOMPARE(metrics[Operation::Get].bytes, std::uint64_t(0));
+}
+
+void StorageMetricsTest::testWatcherQueueDepth()
+{
+  static_assert(has_queue_depth<QueueWatcher>::value);
+  static_assert(!has_queue_depth<TestWatcher>::value);
+
+  Storage<TestElement, TestMarshaller, QueueWatcher, DefaultTransactionManager,
+          DefaultDeleter<std::string, TestElement>, StorageMetrics>
+      store;
+  QCOMPARE(store.metrics().watcherQueueDepth, std::uint64_t(7));
+}
+
+void StorageMetricsTest::testSnapshotVisit()
+{
+  MeteredStorage store;
+  store.add({"test id 1", "test name 1"});
+
+  std::map<std::string, std::uint64_t> values;
+  store.metrics().visit([&values](const std::string& name,
+                                  std::uint64_t value) {
+    values[name] = value;
+  });
+  QCOMPARE(values.size(), OPERATION_COUNT * 9 + 4);
+  QCOMPARE(values["add.count"], std::uint64_t(1));
+  QCOMPARE(values["txn.commits"], std::uint64_t(1));
+  QVERIFY(values.count("scan.p99_ns"));
+  QVERIFY(values.count("watcher.queue_depth"));
+}
+
+void StorageMetricsTest::testEnvironmentStats()
+{
+  using ContainerType = Storage<TestElement, TestMarshaller, TestWatcher>;
+
+  QTemporaryDir home;
+  auto env = EnvironmentBuilder(home.path().toStdString())
+                 .preset(Preset::LowMemory)
+                 .privateEnvironment()
+                 .open();
+  StorageFactory factory(env);
+  auto db = factory.openDatabase("StorageMetricsTest.db", "stats");
+  ContainerType store(db, env);
+  for (int i = 0; i < 100; ++i) {
+    store.add({std::to_string(i), "name"});
+  }
+
+  auto envStats = EnvironmentStats::collect(env);
+  QVERIFY(envStats.cacheSize > 0);
+  QVERIFY(envStats.txnCommits >= 100);
+  QVERIFY(envStats.logBytesWritten > 0);
+
+  std::map<std::string, std::uint64_t> values;
+  envStats.visit([&values](const std::string& name, std::uint64_t value) {
+    values[name] = value;
+  });
+  QVERIFY(values.count("lock.deadlocks"));
+
+  Storage<TestElement, TestMarshaller, TestWatcher, DefaultTransactionManager,
+          DefaultDeleter<std::string, TestElement>, StorageMetrics>
+      metered(db, env);
+  QVERIFY(!metered.strictUpdate({"missing", "name"}));
+  auto metrics = metered.metrics();
+  QCOMPARE(metrics[Operation::Update].misses, std::uint64_t(1));
+  QCOMPARE(metrics.aborts, std::uint64_t(0));
+  QCOMPARE(metrics.deadlocks, envStats.deadlocks);
+
+  auto dbStats = DatabaseStats::collect(db, false);
+  QCOMPARE(dbStats.keys, std::uint64_t(100));
+  QVERIFY(dbStats.pageSize > 0);
+}
+
+void StorageMetricsTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(StorageMetricsTest)
+
+#include "storagemetricstest.moc"
@@ -21,10 +21,49 @@ class TestWatcher {
   void elementUpdated(const TestElement&) {}
 };
 
+class KeyOnlyWatcher {
+ public:
+  static constexpr bool removed_value_needed = false;
+
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+  void keyRemoved(const std::string& id) { removedKeys.push_back(id); }
+
+ public:
+  std::vector<std::string> removedKeys;
+};
+
+struct NameLoggingDeleter : public DefaultDeleter<std::string, TestElement> {
+  template <typename Map>
+  std::optional<TestElement> operator()(Map& elements, const std::string& id)
+  {
+    auto res = DefaultDeleter::operator()(elements, id);
+    if (res) {
+      removedNames->push_back(res->name);
+    }
+    return res;
+  }
+
+  std::shared_ptr<std::vector<std::string>> removedNames =
+      std::make_shared<std::vector<std::string>>();
+};
+
+struct TestName {
+  using type = std::string_view;
+};
+
 class TestMarshaller {
  public:
+  static inline int restored = 0;
+
+  template <typename Field>
+  static typename Field::type peek(const void* src);
+
   static void restore(TestElement& elem, const void* src)
   {
+    ++restored;
     src = restore_str(elem.id, src);
     src = restore_str(elem.name, src);
   }
@@ -42,6 +81,15 @@ class TestMarshaller {
   }
 };
 
+template <>
+std::string_view TestMarshaller::peek<TestName>(const void* src)
+{
+  std::string_view str;
+  src = peek_str(str, src);
+  peek_str(str, src);
+  return str;
+}
+
 class StoreOperationsTest : public QObject {
   Q_OBJECT
 
@@ -53,6 +101,11 @@ class StoreOperationsTest : public QObject {
   void testStrictUpdate();
   void testElementsAccess();
   void testWrapper();
+  void testKeyOnlyRemove();
+  void testKeysAccess();
+  void testAggregates();
+  void testLazyPredicates();
+  void testPaging();
 };
 
 void StoreOperationsTest::testStoreInsertAndFetch()
@@ -196,6 +249,171 @@ void StoreOperationsTest::testWrapper()
   QCOMPARE(wrapper2->name, std::string("new name 2"));
 }
 
+void StoreOperationsTest::testKeyOnlyRemove()
+{
+  Storage<TestElement, TestMarshaller, KeyOnlyWatcher> store;
+  TestElement elem1{"test id 1", "test name 1"},
+      elem2{"test id 2", "test name 2"};
+  QVERIFY(store.add(elem1));
+  QVERIFY(store.add(elem2));
+
+  QVERIFY(store.remove("test id 2"));
+  QVERIFY(!store.remove("test id 2"));
+
+  QVERIFY(!store.has("test id 2"));
+  QVERIFY(store.has("test id 1"));
+  QCOMPARE(store.removedKeys.size(), static_cast<std::size_t>(1));
+  QCOMPARE(store.removedKeys.front(), std::string("test id 2"));
+
+  // удалитель-наследник DefaultDeleter получает значение элемента
+  using LoggingStorage =
+      Storage<TestElement, TestMarshaller, KeyOnlyWatcher,
+              DefaultTransactionManager, NameLoggingDeleter>;
+  static_assert(removed_value_needed<NameLoggingDeleter>::value);
+  NameLoggingDeleter deleter;
+  auto removedNames = deleter.removedNames;
+  LoggingStorage logging(std::move(deleter));
+  QVERIFY(logging.add(elem1));
+  QVERIFY(logging.remove("test id 1"));
+  QVERIFY(!logging.has("test id 1"));
+  QCOMPARE(*removedNames, std::vector<std::string>({"test name 1"}));
+}
+
+void StoreOperationsTest::testKeysAccess()
+{
+  Storage<TestElement, TestMarshaller, TestWatcher> store;
+  QVERIFY(store.add({"test id 1", "test name 1"}));
+  QVERIFY(store.add({"test id 2", "test name 2"}));
+  QVERIFY(store.add({"test id 3", "test name 3"}));
+
+  TestMarshaller::restored = 0;
+  auto keys = store.getAllKeys();
+  QCOMPARE(keys, std::vector<std::string>({"test id 1", "test id 2",
+                                           "test id 3"}));
+
+  std::vector<std::string> ranged;
+  for (const auto& id : store.keys()) {
+    ranged.push_back(id);
+  }
+  QCOMPARE(ranged, keys);
+
+  int visited = 0;
+  store.forEachKey([&visited](const std::string&) { return ++visited < 2; });
+  QCOMPARE(visited, 2);
+  // значения элементов не восстанавливаются
+  QCOMPARE(TestMarshaller::restored, 0);
+}
+
+void StoreOperationsTest::testAggregates()
+{
+  Storage<TestElement, TestMarshaller, TestWatcher> store;
+  QVERIFY(store.add({"id 1", "b"}));
+  QVERIFY(store.add({"id 2", "a"}));
+  QVERIFY(store.add({"id 3", "c"}));
+  QVERIFY(store.add({"id 4", "a"}));
+
+  QCOMPARE(store.count_if([](const TestElement& el) { return el.name == "a"; }),
+           std::size_t(2));
+
+  auto length = store.reduce(std::size_t(0), [](std::size_t sum,
+                                                const TestElement& el) {
+    return sum + el.name.size();
+  });
+  QCOMPARE(length, std::size_t(4));
+
+  auto byName = [](const TestElement& el) { return el.name; };
+  QCOMPARE(store.min_by(byName)->id, std::string("id 2"));
+  QCOMPARE(store.max_by(byName)->id, std::string("id 3"));
+
+  auto groups = store.group_count(byName);
+  QCOMPARE(groups.size(), std::size_t(3));
+  QCOMPARE(groups["a"], std::size_t(2));
+  QCOMPARE(groups["b"], std::size_t(1));
+
+  Storage<TestElement, TestMarshaller, TestWatcher> empty;
+  QVERIFY(!empty.min_by(byName));
+  QCOMPARE(empty.count_if([](const TestElement&) { return true; }),
+           std::size_t(0));
+}
+
+void StoreOperationsTest::testLazyPredicates()
+{
+  using LazyElement = Storage<TestElement, TestMarshaller,
+                              TestWatcher>::lazy_element;
+  Storage<TestElement, TestMarshaller, TestWatcher> store;
+  QVERIFY(store.add({"id 1", "b"}));
+  QVERIFY(store.add({"id 2", "a"}));
+  QVERIFY(store.add({"id 3", "c"}));
+  QVERIFY(store.add({"id 4", "a"}));
+
+  TestMarshaller::restored = 0;
+  auto found = store.get_if_lazy([](const LazyElement& el) {
+    return el.peek<TestName>() == "a";
+  });
+  QCOMPARE(found.size(), std::size_t(2));
+  QCOMPARE(found.front().id, std::string("id 2"));
+  QCOMPARE(found.back().name, std::string("a"));
+  // восстанавливаются только подходящие элементы
+  QCOMPARE(TestMarshaller::restored, 2);
+
+  TestMarshaller::restored = 0;
+  QCOMPARE(store.count_if_lazy([](const LazyElement& el) {
+    return el.peek<TestName>() != "a";
+  }),
+           std::size_t(2));
+  QCOMPARE(TestMarshaller::restored, 0);
+
+  // предикат может запросить элемент целиком, он не декодируется повторно
+  found = store.get_if_lazy(
+      [](const LazyElement& el) { return el.get().id == "id 3"; });
+  QCOMPARE(found.size(), std::size_t(1));
+  QCOMPARE(found.front().name, std::string("c"));
+  QCOMPARE(TestMarshaller::restored, 4);
+
+  // обобщенные предикаты get_if и count_if принимают элемент
+  QCOMPARE(store.get_if([](const auto& el) { return el.name == "a"; }).size(),
+           std::size_t(2));
+  QCOMPARE(store.count_if([](const auto& el) { return el.name != "a"; }),
+           std::size_t(2));
+}
+
+void StoreOperationsTest::testPaging()
+{
+  Storage<TestElement, TestMarshaller, TestWatcher> store;
+  for (int i = 0; i < 7; ++i) {
+    QVERIFY(store.add({"id " + std::to_string(i), "name"}));
+  }
+
+  std::vector<std::string> ids;
+  std::string token;
+  int pages = 0;
+  do {
+    auto page = store.page(token, 3);
+    QVERIFY(page.elements.size() <= 3);
+    for (const auto& elem : page.elements) {
+      ids.push_back(elem.id);
+    }
+    token = page.nextToken;
+    ++pages;
+  } while (!token.empty());
+  QCOMPARE(pages, 3);
+  QCOMPARE(ids, store.getAllKeys());
+
+  // элементы, удаленные между страницами, не нарушают продолжение
+  auto first = store.page({}, 2);
+  QVERIFY(first.hasMore());
+  QVERIFY(store.remove("id 1"));
+  QVERIFY(store.remove("id 2"));
+  auto second = store.page(first.nextToken, 2);
+  QCOMPARE(second.elements.front().id, std::string("id 3"));
+
+  // последняя полная страница не возвращает маркер
+  auto last = store.page(second.nextToken, 2);
+  QCOMPARE(last.elements.size(), std::size_t(2));
+  QVERIFY(!last.hasMore());
+  QVERIFY(store.page({}, 0).elements.empty());
+}
+
 QTEST_APPLESS_MAIN(StoreOperationsTest)
 
 #include "storeoperationstest.moc"
@@ -0,0 +1,183 @@
+#include <QtTest>
+#include <future>
+#include <thread>
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/registeredthreadpool.h"
+#include "persistent-storage/storages/registertransactionmanager.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/storages/threadregistry.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+using ContainerType = Storage<TestElement,
+                              TestMarshaller,
+                              TestWatcher,
+                              RegisterTransactionManager>;
+
+class ThreadRegistryTest : public QObject {
+  Q_OBJECT
+
+ public:
+  ThreadRegistryTest();
+
+ private Q_SLOTS:
+  void testRegisterOnce();
+  void testThreadPool();
+  void testTaskException();
+  void testInvalidate();
+  void cleanupTestCase();
+
+ private:
+  QTemporaryDir mHome;
+  DbEnv* mEnv = nullptr;
+  Db* mDb = nullptr;
+};
+
+ThreadRegistryTest::ThreadRegistryTest()
+{
+  dbstl::dbstl_startup();
+  mEnv = EnvironmentBuilder(mHome.path().toStdString())
+             .privateEnvironment()
+             .registerInDbstl(false)
+             .open();
+  ThreadRegistry::registerEnv(mEnv);
+  mDb = StorageFactory(mEnv).openDatabase("ThreadRegistryTest.db", "elements");
+}
+
+void ThreadRegistryTest::testRegisterOnce()
+{
+  QVERIFY(ThreadRegistry::isRegistered(mEnv));
+  ThreadRegistry::registerEnv(mEnv);
+
+  bool before = true, after = false, db = false;
+  std::thread thread([this, &before, &after, &db] {
+    before = ThreadRegistry::isRegistered(mEnv);
+    ThreadRegistry::registerAll(mEnv, {mDb});
+    ThreadRegistry::registerAll(mEnv, {mDb});
+    after = ThreadRegistry::isRegistered(mEnv);
+    db = ThreadRegistry::isRegistered(mDb);
+  });
+  thread.join();
+
+  QVERIFY(!before);
+  QVERIFY(after);
+  QVERIFY(db);
+}
+
+void ThreadRegistryTest::testThreadPool()
+{
+  auto store = std::make_shared<ContainerType>(mDb, mEnv);
+  std::vector<std::future<bool>> results;
+  {
+    RegisteredThreadPool pool(4, mEnv, {mDb});
+    QCOMPARE(pool.threadCount(), std::size_t(4));
+
+    auto registered = pool.submit([this] {
+      return ThreadRegistry::isRegistered(mEnv) &&
+             ThreadRegistry::isRegistered(mDb);
+    });
+    QVERIFY(registered.get());
+
+    for (int i = 0; i < 1000; ++i) {
+      results.push_back(pool.submit([store, i] {
+        return store->add({std::to_string(i), "name " + std::to_string(i)});
+      }));
+    }
+  }
+
+  for (auto& result : results) {
+    QVERIFY(result.get());
+  }
+  QCOMPARE(store->size(), 1000);
+  QCOMPARE(store->get("999").name, std::string("name 999"));
+}
+
+void ThreadRegistryTest::testTaskException()
+{
+  RegisteredThreadPool pool(2, mEnv, {mDb});
+  auto failed =
+      pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+  auto succeeded = pool.submit([] { return 42; });
+
+  QVERIFY_EXCEPTION_THROWN(failed.get(), std::runtime_error);
+  QCOMPARE(succeeded.get(), 42);
+}
+
+void ThreadRegistryTest::testInvalidate()
+{
+  ThreadRegistry::registerAll(mEnv, {mDb});
+
+  std::promise<void> registered, invalidated;
+  bool before = false, after = true;
+  std::thread thread([this, &registered, &invalidated, &before, &after] {
+    ThreadRegistry::registerDb(mDb);
+    before = ThreadRegistry::isRegistered(mDb);
+    registered.set_value();
+    invalidated.get_future().wait();
+    after = ThreadRegistry::isRegistered(mDb);
+  });
+  registered.get_future().wait();
+  ThreadRegistry::invalidate();
+  invalidated.set_value();
+  thread.join();
+
+  QVERIFY(before);
+  // регистрации других потоков тоже сброшены
+  QVERIFY(!after);
+  QVERIFY(!ThreadRegistry::isRegistered(mEnv));
+  QVERIFY(!ThreadRegistry::isRegistered(mDb));
+
+  ThreadRegistry::registerAll(mEnv, {mDb});
+  QVERIFY(ThreadRegistry::isRegistered(mDb));
+  ContainerType store(mDb, mEnv);
+  QVERIFY(store.add({"invalidated", "name"}));
+}
+
+void ThreadRegistryTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(ThreadRegistryTest)
+
+#include "threadregistrytest.moc"
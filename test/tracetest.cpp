@@ -0,0 +1,261 @@
+#include <QtTest>
+#include <unistd.h>
+#include <cstdio>
+#include "persistent-storage/environment/environmentbuilder.h"
+#include "persistent-storage/environment/storagefactory.h"
+#include "persistent-storage/storages/childstorage.h"
+#include "persistent-storage/storages/storage.h"
+#include "persistent-storage/trace/tracedstorage.h"
+#include "persistent-storage/trace/tracereader.h"
+#include "persistent-storage/trace/tracewriter.h"
+#include "persistent-storage/utils/store_primitives.h"
+
+using namespace prstorage;
+
+struct TestElement {
+  std::string id;
+  std::string name;
+};
+
+std::string get_id(const TestElement& elem)
+{
+  return elem.id;
+}
+
+class TestWatcher {
+ protected:
+  void elementAdded(const TestElement&) {}
+  void elementRemoved(const TestElement&) {}
+  void elementUpdated(const TestElement&) {}
+};
+
+class TestMarshaller {
+ public:
+  static void restore(TestElement& elem, const void* src)
+  {
+    src = restore_str(elem.id, src);
+    src = restore_str(elem.name, src);
+  }
+  static u_int32_t size(const TestElement& element)
+  {
+    u_int32_t size = 0;
+    size += sizeof(std::string::size_type) + element.id.length();
+    size += sizeof(std::string::size_type) + element.name.length();
+    return size;
+  }
+  static void store(void* dest, const TestElement& elem)
+  {
+    dest = save_str(elem.id, dest);
+    dest = save_str(elem.name, dest);
+  }
+};
+
+int get_parent_id_callback(Db* /* secondary */,
+                           const Dbt* /* key */,
+                           const Dbt* data,
+                           Dbt* result)
+{
+  TestElement el;
+  TestMarshaller::restore(el, data->get_data());
+
+  if (auto chars = static_cast<char*>(malloc(el.name.size() + 1))) {
+    result->set_flags(DB_DBT_APPMALLOC);
+    strncpy(chars, el.name.c_str(), el.name.size() + 1);
+    result->set_data(chars);
+    result->set_size(static_cast<u_int32_t>(el.name.size()) + 1);
+    return 0;
+  }
+
+  return 1;
+}
+
+class TraceTest : public QObject {
+  Q_OBJECT
+
+ public:
+ private Q_SLOTS:
+  void testWriteAndRead();
+  void testTruncatedTrace();
+  void testInvalidTrace();
+  void testTracedStorage();
+  void testTracedChildStorage();
+  void cleanupTestCase();
+
+ private:
+  QTemporaryDir mDir;
+};
+
+void TraceTest::testWriteAndRead()
+{
+  auto path = mDir.path().toStdString() + "/write.trace";
+  {
+    TraceWriter writer(path);
+    for (std::uint64_t i = 0; i < 10000; ++i) {
+      TraceRecord record;
+      record.operation = static_cast<TraceOperation>(i % TRACE_OPERATION_COUNT);
+      record.status = static_cast<TraceStatus>(i % 3);
+      // записи разных потоков приходят не по порядку начала
+      record.startNanoseconds = i % 2 ? 1000 * i : 1000 * i + 5000;
+      record.durationNanoseconds = i * 7;
+      record.key = "key " + std::to_string(i);
+      record.valueSize = i * 100;
+      writer.write(record);
+    }
+    QCOMPARE(writer.records(), std::uint64_t(10000));
+  }
+
+  TraceReader reader(path);
+  TraceRecord record;
+  std::uint64_t count = 0;
+  while (reader.next(record)) {
+    auto i = count++;
+    QCOMPARE(record.operation,
+             static_cast<TraceOperation>(i % TRACE_OPERATION_COUNT));
+    QCOMPARE(record.status, static_cast<TraceStatus>(i % 3));
+    QCOMPARE(record.startNanoseconds, i % 2 ? 1000 * i : 1000 * i + 5000);
+    QCOMPARE(record.durationNanoseconds, i * 7);
+    QCOMPARE(record.key, "key " + std::to_string(i));
+    QCOMPARE(record.valueSize, i * 100);
+  }
+  QCOMPARE(count, std::uint64_t(10000));
+}
+
+void TraceTest::testTruncatedTrace()
+{
+  auto path = mDir.path().toStdString() + "/truncated.trace";
+  {
+    TraceWriter writer(path);
+    TraceRecord record;
+    record.key = "first";
+    writer.write(record);
+    record.key = "second";
+    writer.write(record);
+  }
+  auto file = std::fopen(path.c_str(), "r+b");
+  QVERIFY(file);
+  std::fseek(file, 0, SEEK_END);
+  auto size = std::ftell(file);
+  std::fclose(file);
+  QCOMPARE(::truncate(path.c_str(), size - 3), 0);
+
+  TraceReader reader(path);
+  TraceRecord record;
+  QVERIFY(reader.next(record));
+  QCOMPARE(record.key, std::string("first"));
+  QVERIFY(!reader.next(record));
+}
+
+void TraceTest::testInvalidTrace()
+{
+  auto path = mDir.path().toStdString() + "/invalid.trace";
+  auto file = std::fopen(path.c_str(), "wb");
+  std::fputs("not a trace file", file);
+  std::fclose(file);
+
+  QVERIFY_EXCEPTION_THROWN(TraceReader reader(path), std::runtime_error);
+  QVERIFY_EXCEPTION_THROWN(TraceReader reader(path + ".missing"),
+                           std::runtime_error);
+}
+
+void TraceTest::testTracedStorage()
+{
+  using ContainerType =
+      TracedStorage<Storage<TestElement, TestMarshaller, TestWatcher>>;
+
+  auto path = mDir.path().toStdString() + "/storage.trace";
+  ContainerType store;
+  TestElement elem{"test id 1", "test name 1"};
+  QVERIFY(store.add({"untraced", "untraced"}));
+
+  store.setTraceWriter(std::make_shared<TraceWriter>(path));
+  QVERIFY(store.add(elem));
+  QVERIFY(!store.add(elem));
+  QCOMPARE(store.get("test id 1").name, elem.name);
+  QVERIFY_EXCEPTION_THROWN(store.get("missing"), std::range_error);
+  QVERIFY(store.has("test id 1"));
+  store.update(elem);
+  QCOMPARE(store.getAllElements().size(), std::size_t(2));
+  QVERIFY(store.remove("test id 1"));
+  store.setTraceWriter(nullptr);
+  QVERIFY(store.remove("untraced"));
+
+  std::vector<TraceRecord> records;
+  TraceReader reader(path);
+  for (TraceRecord record; reader.next(record);) {
+    records.push_back(record);
+  }
+
+  QCOMPARE(records.size(), std::size_t(8));
+  QCOMPARE(records[0].operation, TraceOperation::Add);
+  QCOMPARE(records[0].status, TraceStatus::Ok);
+  QCOMPARE(records[0].key, std::string("test id 1"));
+  QCOMPARE(records[0].valueSize, std::uint64_t(TestMarshaller::size(elem)));
+  QCOMPARE(records[1].status, TraceStatus::Miss);
+  QCOMPARE(records[2].operation, TraceOperation::Get);
+  QCOMPARE(records[2].valueSize, std::uint64_t(TestMarshaller::size(elem)));
+  QCOMPARE(records[3].status, TraceStatus::Miss);
+  QCOMPARE(records[3].key, std::string("missing"));
+  QCOMPARE(records[4].operation, TraceOperation::Has);
+  QCOMPARE(records[5].operation, TraceOperation::Update);
+  QCOMPARE(records[6].operation, TraceOperation::GetAll);
+  QCOMPARE(records[6].valueSize, std::uint64_t(2));
+  QCOMPARE(records[7].operation, TraceOperation::Remove);
+  for (std::size_t i = 1; i < records.size(); ++i) {
+    QVERIFY(records[i].startNanoseconds >= records[i - 1].startNanoseconds);
+  }
+}
+
+void TraceTest::testTracedChildStorage()
+{
+  using ContainerType = TracedStorage<
+      ChildStorage<TestElement, TestElement, TestMarshaller, TestWatcher>>;
+
+  auto env = EnvironmentBuilder(mDir.path().toStdString())
+                 .privateEnvironment()
+                 .open();
+  auto store = StorageFactory(env).makeChildStorage<ContainerType>(
+      "TraceTest.db", "children", "children_by_parent",
+      get_parent_id_callback);
+  for (int i = 0; i < 3; ++i) {
+    QVERIFY(store->add({"child id " + std::to_string(i), "parent id 1"}));
+  }
+  QVERIFY(store->add({"child id 3", "parent id 2"}));
+
+  auto path = mDir.path().toStdString() + "/children.trace";
+  store->setTraceWriter(std::make_shared<TraceWriter>(path));
+  QCOMPARE(store->childrenOf("parent id 1", 2).size(), std::size_t(2));
+  QCOMPARE(store->page("parent id 1", {}, 10).elements.size(),
+           std::size_t(3));
+  QCOMPARE(store->page({}, 10).elements.size(), std::size_t(4));
+  QCOMPARE(store->removeChildrenOf({"parent id 1"}).totalRemoved(),
+           std::size_t(3));
+  store->setTraceWriter(nullptr);
+
+  std::vector<TraceRecord> records;
+  TraceReader reader(path);
+  for (TraceRecord record; reader.next(record);) {
+    records.push_back(record);
+  }
+
+  // страница всего хранилища выполняется базовым классом без записи
+  QCOMPARE(records.size(), std::size_t(3));
+  QCOMPARE(records[0].operation, TraceOperation::ChildrenOf);
+  QCOMPARE(records[0].key, std::string("parent id 1"));
+  QCOMPARE(records[0].valueSize, std::uint64_t(2));
+  QCOMPARE(records[1].operation, TraceOperation::ChildrenPage);
+  QCOMPARE(records[1].valueSize, std::uint64_t(3));
+  QCOMPARE(records[2].operation, TraceOperation::RemoveChildrenOf);
+  QCOMPARE(records[2].key, std::string("parent id 1"));
+  QCOMPARE(records[2].valueSize, std::uint64_t(3));
+  QCOMPARE(std::string(traceOperationName(records[2].operation)),
+           std::string("removeChildrenOf"));
+}
+
+void TraceTest::cleanupTestCase()
+{
+  dbstl::dbstl_exit();
+}
+
+QTEST_APPLESS_MAIN(TraceTest)
+
+#include "tracetest.moc"